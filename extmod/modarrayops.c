@@ -0,0 +1,441 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021 The MicroPython project contributors
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "py/binary.h"
+#include "py/objint.h"
+#include "py/runtime.h"
+
+#if MICROPY_PY_ARRAYOPS
+
+// Bulk arithmetic on the elements of array.array, memoryview, bytearray and
+// other objects with the buffer protocol.  Each function switches on the
+// typecode once and then runs a plain C loop over the elements, which the
+// compiler is free to vectorise.  Results stored into integer arrays are
+// clamped to the range of the element type.
+
+// An array and the number of elements in it
+typedef struct _arrayops_buf_t {
+    void *buf;
+    size_t len;
+    char typecode;
+} arrayops_buf_t;
+
+STATIC void arrayops_get_buf(mp_obj_t obj, arrayops_buf_t *a, mp_uint_t flags) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(obj, &bufinfo, flags);
+    char typecode = bufinfo.typecode;
+    if (typecode == BYTEARRAY_TYPECODE) {
+        typecode = 'B';
+    }
+    size_t size = 0;
+    switch (typecode) {
+        case 'b':
+        case 'B':
+        case 'h':
+        case 'H':
+        case 'i':
+        case 'I':
+        case 'l':
+        case 'L':
+        #if MICROPY_PY_BUILTINS_FLOAT
+        case 'f':
+        case 'd':
+        #endif
+            size = mp_binary_get_size('@', typecode, NULL);
+            break;
+    }
+    if (size == 0 || (size > 4 && typecode != 'd')) {
+        mp_raise_ValueError(MP_ERROR_TEXT("unsupported typecode"));
+    }
+    a->buf = bufinfo.buf;
+    a->len = bufinfo.len / size;
+    a->typecode = typecode;
+}
+
+STATIC void arrayops_check_same(const arrayops_buf_t *a, const arrayops_buf_t *b) {
+    if (a->typecode != b->typecode) {
+        mp_raise_TypeError(MP_ERROR_TEXT("typecodes differ"));
+    }
+    if (a->len != b->len) {
+        mp_raise_ValueError(MP_ERROR_TEXT("lengths differ"));
+    }
+}
+
+#define CLAMP(v, lo, hi) ((v) < (lo) ? (lo) : (v) > (hi) ? (hi) : (v))
+
+// Converts float v to integer type T, saturating (and NaN to lo).  The limits
+// are compared as hi + 1 and lo - 1 because hi itself may not be representable
+// as a float (2^31 - 1 rounds up to 2^31), and converting anything out of range
+// of T is undefined.
+#define CLAMP_FLOAT(T, v, lo, hi) \
+    ((v) >= (mp_float_t)(hi) + 1 ? (T)(hi) : (v) > (mp_float_t)(lo) - 1 ? (T)(v) : (T)(lo))
+
+// Integer reductions are summed in int64_t over blocks of this many elements,
+// which can't overflow because every term is below 2^32 in magnitude, and the
+// partial sums are added up as int objects
+#define ARRAYOPS_BLOCK ((size_t)1 << 30)
+
+// 'l' and 'L' are only accepted above when long is 32 bits
+#define DISPATCH_INT(tc, M) \
+    switch (tc) { \
+        case 'b': \
+            M(int8_t, INT8_MIN, INT8_MAX); break; \
+        case 'B': \
+            M(uint8_t, 0, UINT8_MAX); break; \
+        case 'h': \
+            M(int16_t, INT16_MIN, INT16_MAX); break; \
+        case 'H': \
+            M(uint16_t, 0, UINT16_MAX); break; \
+        case 'i': \
+        case 'l': \
+            M(int32_t, INT32_MIN, INT32_MAX); break; \
+        case 'I': \
+        case 'L': \
+            M(uint32_t, 0, UINT32_MAX); break; \
+    }
+
+#if MICROPY_PY_BUILTINS_FLOAT
+#define DISPATCH_FLOAT(tc, M) \
+    switch (tc) { \
+        case 'f': \
+            M(float); break; \
+        case 'd': \
+            M(double); break; \
+    }
+#define IS_FLOAT_TYPECODE(tc) ((tc) == 'f' || (tc) == 'd')
+#else
+#define DISPATCH_FLOAT(tc, M)
+#define IS_FLOAT_TYPECODE(tc) (false)
+#endif
+
+// Scalar arguments to integer kernels are clamped so the 64-bit intermediate
+// results can't overflow; the results are clamped to the element range anyway.
+STATIC int64_t arrayops_get_scalar_int(mp_obj_t obj, int64_t limit) {
+    if (mp_obj_is_small_int(obj)) {
+        mp_int_t v = MP_OBJ_SMALL_INT_VALUE(obj);
+        return CLAMP((int64_t)v, -limit, limit);
+    }
+    #if MICROPY_LONGINT_IMPL != MICROPY_LONGINT_IMPL_NONE
+    if (mp_obj_is_type(obj, &mp_type_int)) {
+        return mp_obj_int_sign(obj) < 0 ? -limit : limit;
+    }
+    #endif
+    return mp_obj_get_int(obj);
+}
+
+/******************************************************************************/
+// In-place kernels
+
+// add(dest, src): dest[i] += src[i], or dest[i] += src if src is a number
+STATIC mp_obj_t arrayops_add(mp_obj_t dest_in, mp_obj_t src_in) {
+    arrayops_buf_t d;
+    arrayops_get_buf(dest_in, &d, MP_BUFFER_RW);
+    size_t n = d.len;
+
+    if (mp_obj_is_int(src_in) || mp_obj_is_float(src_in)) {
+        #if MICROPY_PY_BUILTINS_FLOAT
+        if (IS_FLOAT_TYPECODE(d.typecode) || mp_obj_is_float(src_in)) {
+            mp_float_t k = mp_obj_get_float(src_in);
+            #define ADD_SCALAR_F(T) { T *p = d.buf; T kt = (T)k; for (size_t i = 0; i < n; ++i) { p[i] += kt; } }
+            DISPATCH_FLOAT(d.typecode, ADD_SCALAR_F);
+            #define ADD_SCALAR_IF(T, LO, HI) { T *p = d.buf; for (size_t i = 0; i < n; ++i) { mp_float_t v = p[i] + k; p[i] = CLAMP_FLOAT(T, v, LO, HI); } }
+            DISPATCH_INT(d.typecode, ADD_SCALAR_IF);
+            return mp_const_none;
+        }
+        #endif
+        int64_t k = arrayops_get_scalar_int(src_in, (int64_t)1 << 33);
+        #define ADD_SCALAR_I(T, LO, HI) { T *p = d.buf; for (size_t i = 0; i < n; ++i) { int64_t v = p[i] + k; p[i] = (T)CLAMP(v, LO, HI); } }
+        DISPATCH_INT(d.typecode, ADD_SCALAR_I);
+        return mp_const_none;
+    }
+
+    arrayops_buf_t s;
+    arrayops_get_buf(src_in, &s, MP_BUFFER_READ);
+    arrayops_check_same(&d, &s);
+    #define ADD_F(T) { T *p = d.buf; const T *q = s.buf; for (size_t i = 0; i < n; ++i) { p[i] += q[i]; } }
+    DISPATCH_FLOAT(d.typecode, ADD_F);
+    #define ADD_I(T, LO, HI) { T *p = d.buf; const T *q = s.buf; for (size_t i = 0; i < n; ++i) { int64_t v = (int64_t)p[i] + q[i]; p[i] = (T)CLAMP(v, LO, HI); } }
+    DISPATCH_INT(d.typecode, ADD_I);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(arrayops_add_obj, arrayops_add);
+
+// mul(dest, k): dest[i] *= k
+STATIC mp_obj_t arrayops_mul(mp_obj_t dest_in, mp_obj_t k_in) {
+    arrayops_buf_t d;
+    arrayops_get_buf(dest_in, &d, MP_BUFFER_RW);
+    size_t n = d.len;
+
+    #if MICROPY_PY_BUILTINS_FLOAT
+    if (IS_FLOAT_TYPECODE(d.typecode) || mp_obj_is_float(k_in)) {
+        mp_float_t k = mp_obj_get_float(k_in);
+        #define MUL_SCALAR_F(T) { T *p = d.buf; T kt = (T)k; for (size_t i = 0; i < n; ++i) { p[i] *= kt; } }
+        DISPATCH_FLOAT(d.typecode, MUL_SCALAR_F);
+        #define MUL_SCALAR_IF(T, LO, HI) { T *p = d.buf; for (size_t i = 0; i < n; ++i) { mp_float_t v = p[i] * k; p[i] = CLAMP_FLOAT(T, v, LO, HI); } }
+        DISPATCH_INT(d.typecode, MUL_SCALAR_IF);
+        return mp_const_none;
+    }
+    #endif
+    // With |k| below 2^32 the product of k and any 32-bit signed element fits
+    // in 64 bits, and any larger k saturates every non-zero element anyway.
+    int64_t k = arrayops_get_scalar_int(k_in, ((int64_t)1 << 32) - 1);
+    if (d.typecode == 'I' || d.typecode == 'L') {
+        // Unsigned 32-bit elements need the full unsigned 64-bit product
+        uint32_t *p = d.buf;
+        uint64_t ku = k < 0 ? 0 : (uint64_t)k;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t v = p[i] * ku;
+            p[i] = v > UINT32_MAX ? UINT32_MAX : (uint32_t)v;
+        }
+        return mp_const_none;
+    }
+    #define MUL_SCALAR_I(T, LO, HI) { T *p = d.buf; for (size_t i = 0; i < n; ++i) { int64_t v = (int64_t)p[i] * k; p[i] = (T)CLAMP(v, LO, HI); } }
+    DISPATCH_INT(d.typecode, MUL_SCALAR_I);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(arrayops_mul_obj, arrayops_mul);
+
+// clip(dest, lo, hi): limit dest[i] to the range lo to hi
+STATIC mp_obj_t arrayops_clip(mp_obj_t dest_in, mp_obj_t lo_in, mp_obj_t hi_in) {
+    arrayops_buf_t d;
+    arrayops_get_buf(dest_in, &d, MP_BUFFER_RW);
+    size_t n = d.len;
+
+    #if MICROPY_PY_BUILTINS_FLOAT
+    if (IS_FLOAT_TYPECODE(d.typecode)) {
+        mp_float_t lo = mp_obj_get_float(lo_in);
+        mp_float_t hi = mp_obj_get_float(hi_in);
+        #define CLIP_F(T) { T *p = d.buf; T lo_t = (T)lo, hi_t = (T)hi; for (size_t i = 0; i < n; ++i) { p[i] = CLAMP(p[i], lo_t, hi_t); } }
+        DISPATCH_FLOAT(d.typecode, CLIP_F);
+        return mp_const_none;
+    }
+    #endif
+    int64_t lo = arrayops_get_scalar_int(lo_in, (int64_t)1 << 33);
+    int64_t hi = arrayops_get_scalar_int(hi_in, (int64_t)1 << 33);
+    #define CLIP_I(T, LO, HI) { \
+        T lo_t = (T)CLAMP(lo, LO, HI); \
+        T hi_t = (T)CLAMP(hi, LO, HI); \
+        T *p = d.buf; \
+        for (size_t i = 0; i < n; ++i) { p[i] = CLAMP(p[i], lo_t, hi_t); } \
+}
+    DISPATCH_INT(d.typecode, CLIP_I);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(arrayops_clip_obj, arrayops_clip);
+
+// Load and store a single element converting to and from a common type, for
+// convert() where the typecodes of the arrays differ.  Integers are converted
+// through int64_t so that they stay exact, mp_float_t may be single precision.
+STATIC int64_t arrayops_load_int(const arrayops_buf_t *a, size_t i) {
+    #define LOAD_I(T, LO, HI) return ((const T *)a->buf)[i]
+    DISPATCH_INT(a->typecode, LOAD_I);
+    return 0;
+}
+
+STATIC void arrayops_store_int(const arrayops_buf_t *a, size_t i, int64_t v) {
+    #define STORE_I(T, LO, HI) ((T *)a->buf)[i] = (T)CLAMP(v, LO, HI)
+    DISPATCH_INT(a->typecode, STORE_I);
+}
+
+#if MICROPY_PY_BUILTINS_FLOAT
+STATIC mp_float_t arrayops_load_float(const arrayops_buf_t *a, size_t i) {
+    #define LOAD_IF(T, LO, HI) return (mp_float_t)((const T *)a->buf)[i]
+    DISPATCH_INT(a->typecode, LOAD_IF);
+    #define LOAD_F(T) return (mp_float_t)((const T *)a->buf)[i]
+    DISPATCH_FLOAT(a->typecode, LOAD_F);
+    return 0;
+}
+
+STATIC void arrayops_store_float(const arrayops_buf_t *a, size_t i, mp_float_t v) {
+    #define STORE_IF(T, LO, HI) ((T *)a->buf)[i] = CLAMP_FLOAT(T, v, LO, HI)
+    DISPATCH_INT(a->typecode, STORE_IF);
+    #define STORE_F(T) ((T *)a->buf)[i] = (T)v
+    DISPATCH_FLOAT(a->typecode, STORE_F);
+}
+#endif
+
+// convert(dest, src): dest[i] = src[i], converting between typecodes
+STATIC mp_obj_t arrayops_convert(mp_obj_t dest_in, mp_obj_t src_in) {
+    arrayops_buf_t d, s;
+    arrayops_get_buf(dest_in, &d, MP_BUFFER_WRITE);
+    arrayops_get_buf(src_in, &s, MP_BUFFER_READ);
+    if (d.len != s.len) {
+        mp_raise_ValueError(MP_ERROR_TEXT("lengths differ"));
+    }
+    if (d.typecode == s.typecode) {
+        memmove(d.buf, s.buf, d.len * mp_binary_get_size('@', d.typecode, NULL));
+        return mp_const_none;
+    }
+    #if MICROPY_PY_BUILTINS_FLOAT
+    if (IS_FLOAT_TYPECODE(d.typecode) || IS_FLOAT_TYPECODE(s.typecode)) {
+        for (size_t i = 0; i < d.len; ++i) {
+            arrayops_store_float(&d, i, arrayops_load_float(&s, i));
+        }
+        return mp_const_none;
+    }
+    #endif
+    for (size_t i = 0; i < d.len; ++i) {
+        arrayops_store_int(&d, i, arrayops_load_int(&s, i));
+    }
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(arrayops_convert_obj, arrayops_convert);
+
+/******************************************************************************/
+// Reductions
+
+STATIC mp_obj_t arrayops_sum(mp_obj_t a_in) {
+    arrayops_buf_t a;
+    arrayops_get_buf(a_in, &a, MP_BUFFER_READ);
+    size_t n = a.len;
+    #if MICROPY_PY_BUILTINS_FLOAT
+    if (IS_FLOAT_TYPECODE(a.typecode)) {
+        mp_float_t acc = 0;
+        #define SUM_F(T) { const T *p = a.buf; for (size_t i = 0; i < n; ++i) { acc += (mp_float_t)p[i]; } }
+        DISPATCH_FLOAT(a.typecode, SUM_F);
+        return mp_obj_new_float(acc);
+    }
+    #endif
+    mp_obj_t result = MP_OBJ_NEW_SMALL_INT(0);
+    for (size_t j = 0; j < n; j += ARRAYOPS_BLOCK) {
+        size_t m = MIN(n - j, ARRAYOPS_BLOCK);
+        int64_t acc = 0;
+        #define SUM_I(T, LO, HI) { const T *p = (const T *)a.buf + j; for (size_t i = 0; i < m; ++i) { acc += p[i]; } }
+        DISPATCH_INT(a.typecode, SUM_I);
+        result = mp_binary_op(MP_BINARY_OP_ADD, result, mp_obj_new_int_from_ll(acc));
+    }
+    return result;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(arrayops_sum_obj, arrayops_sum);
+
+STATIC mp_obj_t arrayops_minmax(mp_obj_t a_in, bool want_max) {
+    arrayops_buf_t a;
+    arrayops_get_buf(a_in, &a, MP_BUFFER_READ);
+    size_t n = a.len;
+    if (n == 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("empty sequence"));
+    }
+    #define MINMAX(T, BT) { \
+        const T *p = a.buf; \
+        T lo = p[0], hi = p[0]; \
+        for (size_t i = 1; i < n; ++i) { lo = p[i] < lo ? p[i] : lo; hi = p[i] > hi ? p[i] : hi; } \
+        best = (BT)(want_max ? hi : lo); \
+}
+    #if MICROPY_PY_BUILTINS_FLOAT
+    if (IS_FLOAT_TYPECODE(a.typecode)) {
+        mp_float_t best = 0;
+        #define MINMAX_F(T) MINMAX(T, mp_float_t)
+        DISPATCH_FLOAT(a.typecode, MINMAX_F);
+        return mp_obj_new_float(best);
+    }
+    #endif
+    int64_t best = 0;
+    #define MINMAX_I(T, LO, HI) MINMAX(T, int64_t)
+    DISPATCH_INT(a.typecode, MINMAX_I);
+    return mp_obj_new_int_from_ll(best);
+}
+
+STATIC mp_obj_t arrayops_min(mp_obj_t a_in) {
+    return arrayops_minmax(a_in, false);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(arrayops_min_obj, arrayops_min);
+
+STATIC mp_obj_t arrayops_max(mp_obj_t a_in) {
+    return arrayops_minmax(a_in, true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(arrayops_max_obj, arrayops_max);
+
+// dot(a, b): sum of a[i] * b[i]
+STATIC mp_obj_t arrayops_dot(mp_obj_t a_in, mp_obj_t b_in) {
+    arrayops_buf_t a, b;
+    arrayops_get_buf(a_in, &a, MP_BUFFER_READ);
+    arrayops_get_buf(b_in, &b, MP_BUFFER_READ);
+    arrayops_check_same(&a, &b);
+    size_t n = a.len;
+    #if MICROPY_PY_BUILTINS_FLOAT
+    if (IS_FLOAT_TYPECODE(a.typecode)) {
+        mp_float_t acc = 0;
+        #define DOT_F(T) { const T *p = a.buf; const T *q = b.buf; for (size_t i = 0; i < n; ++i) { acc += (mp_float_t)(p[i] * q[i]); } }
+        DISPATCH_FLOAT(a.typecode, DOT_F);
+        return mp_obj_new_float(acc);
+    }
+    #endif
+    // Products of 32-bit elements take up to 64 bits, so they are summed as a
+    // high and a low 32-bit half which can't overflow within a block
+    mp_obj_t result = MP_OBJ_NEW_SMALL_INT(0);
+    for (size_t j = 0; j < n; j += ARRAYOPS_BLOCK) {
+        size_t m = MIN(n - j, ARRAYOPS_BLOCK);
+        int64_t hi = 0;
+        uint64_t lo = 0;
+        #define DOT_I(T, LO, HI) { \
+        const T *p = (const T *)a.buf + j; \
+        const T *q = (const T *)b.buf + j; \
+        for (size_t i = 0; i < m; ++i) { \
+            if (LO == 0) { \
+                uint64_t v = (uint64_t)p[i] * q[i]; \
+                hi += (int64_t)(v >> 32); \
+                lo += (uint32_t)v; \
+            } else { \
+                int64_t v = (int64_t)p[i] * q[i]; \
+                hi += v >> 32; \
+                lo += (uint32_t)v; \
+            } \
+        } \
+}
+        DISPATCH_INT(a.typecode, DOT_I);
+        if (hi != 0) {
+            mp_obj_t h = mp_binary_op(MP_BINARY_OP_LSHIFT, mp_obj_new_int_from_ll(hi), MP_OBJ_NEW_SMALL_INT(32));
+            result = mp_binary_op(MP_BINARY_OP_ADD, result, h);
+        }
+        result = mp_binary_op(MP_BINARY_OP_ADD, result, mp_obj_new_int_from_ull(lo));
+    }
+    return result;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(arrayops_dot_obj, arrayops_dot);
+
+STATIC const mp_rom_map_elem_t mp_module_arrayops_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_arrayops) },
+    { MP_ROM_QSTR(MP_QSTR_add), MP_ROM_PTR(&arrayops_add_obj) },
+    { MP_ROM_QSTR(MP_QSTR_mul), MP_ROM_PTR(&arrayops_mul_obj) },
+    { MP_ROM_QSTR(MP_QSTR_clip), MP_ROM_PTR(&arrayops_clip_obj) },
+    { MP_ROM_QSTR(MP_QSTR_convert), MP_ROM_PTR(&arrayops_convert_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sum), MP_ROM_PTR(&arrayops_sum_obj) },
+    { MP_ROM_QSTR(MP_QSTR_min), MP_ROM_PTR(&arrayops_min_obj) },
+    { MP_ROM_QSTR(MP_QSTR_max), MP_ROM_PTR(&arrayops_max_obj) },
+    { MP_ROM_QSTR(MP_QSTR_dot), MP_ROM_PTR(&arrayops_dot_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(mp_module_arrayops_globals, mp_module_arrayops_globals_table);
+
+const mp_obj_module_t mp_module_arrayops = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t *)&mp_module_arrayops_globals,
+};
+
+#endif // MICROPY_PY_ARRAYOPS
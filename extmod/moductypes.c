@@ -82,28 +82,75 @@ enum {
 // "struct" in uctypes context means "structural", i.e. aggregate, type.
 STATIC const mp_obj_type_t uctypes_struct_type;
 
+#if MICROPY_PY_UCTYPES_COMPILE
+// A descriptor dict compiled by uctypes.compile() into a table of fields
+// sorted by name, with the offset, type and bitfield mask of each scalar
+// field already decoded, so attribute access doesn't need a dict lookup and
+// decode of the field's packed integer.
+typedef struct _uctypes_field_t {
+    qstr name;
+    // For an aggregate field, its tuple descriptor, else MP_OBJ_NULL
+    mp_obj_t agg;
+    // For a struct field, its compiled descriptor, else NULL
+    struct _uctypes_compiled_t *sub;
+    uint32_t offset;
+    uint32_t mask;
+    uint8_t val_type;
+    uint8_t bit_offset;
+} uctypes_field_t;
+
+#define UCTYPES_LOOKUP_CACHE_SIZE (16)
+
+typedef struct _uctypes_compiled_t {
+    mp_obj_base_t base;
+    mp_obj_t desc;
+    size_t num_fields;
+    // Direct-mapped cache from the low bits of a field name to its index + 1
+    uint8_t lookup_cache[UCTYPES_LOOKUP_CACHE_SIZE];
+    uctypes_field_t fields[];
+} uctypes_compiled_t;
+
+STATIC const mp_obj_type_t uctypes_compiled_type;
+#endif
+
 typedef struct _mp_obj_uctypes_struct_t {
     mp_obj_base_t base;
     mp_obj_t desc;
     byte *addr;
     uint32_t flags;
+    #if MICROPY_PY_UCTYPES_COMPILE
+    uctypes_compiled_t *compiled;
+    #endif
 } mp_obj_uctypes_struct_t;
 
 STATIC NORETURN void syntax_error(void) {
     mp_raise_TypeError(MP_ERROR_TEXT("syntax error in uctypes descriptor"));
 }
 
+STATIC mp_obj_t uctypes_struct_new(mp_obj_t desc, byte *addr, uint32_t flags) {
+    mp_obj_uctypes_struct_t *o = m_new_obj(mp_obj_uctypes_struct_t);
+    o->base.type = &uctypes_struct_type;
+    o->desc = desc;
+    o->addr = addr;
+    o->flags = flags;
+    #if MICROPY_PY_UCTYPES_COMPILE
+    o->compiled = NULL;
+    if (mp_obj_is_type(desc, &uctypes_compiled_type)) {
+        o->compiled = MP_OBJ_TO_PTR(desc);
+        o->desc = o->compiled->desc;
+    }
+    #endif
+    return MP_OBJ_FROM_PTR(o);
+}
+
 STATIC mp_obj_t uctypes_struct_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    (void)type;
     mp_arg_check_num(n_args, n_kw, 2, 3, false);
-    mp_obj_uctypes_struct_t *o = m_new_obj(mp_obj_uctypes_struct_t);
-    o->base.type = type;
-    o->addr = (void *)(uintptr_t)mp_obj_int_get_truncated(args[0]);
-    o->desc = args[1];
-    o->flags = LAYOUT_NATIVE;
+    uint32_t flags = LAYOUT_NATIVE;
     if (n_args == 3) {
-        o->flags = mp_obj_get_int(args[2]);
+        flags = mp_obj_get_int(args[2]);
     }
-    return MP_OBJ_FROM_PTR(o);
+    return uctypes_struct_new(args[1], (void *)(uintptr_t)mp_obj_int_get_truncated(args[0]), flags);
 }
 
 STATIC void uctypes_struct_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
@@ -259,6 +306,11 @@ STATIC mp_obj_t uctypes_struct_sizeof(size_t n_args, const mp_obj_t *args) {
         if (n_args == 2) {
             layout_type = mp_obj_get_int(args[1]);
         }
+        #if MICROPY_PY_UCTYPES_COMPILE
+        if (mp_obj_is_type(obj_in, &uctypes_compiled_type)) {
+            obj_in = ((uctypes_compiled_t *)MP_OBJ_TO_PTR(obj_in))->desc;
+        }
+        #endif
     }
     mp_uint_t size = uctypes_struct_size(obj_in, layout_type, &max_field_size);
     return MP_OBJ_NEW_SMALL_INT(size);
@@ -380,96 +432,86 @@ STATIC void set_aligned(uint val_type, void *p, mp_int_t index, mp_obj_t val) {
     }
 }
 
-STATIC mp_obj_t uctypes_struct_attr_op(mp_obj_t self_in, qstr attr, mp_obj_t set_val) {
-    mp_obj_uctypes_struct_t *self = MP_OBJ_TO_PTR(self_in);
-
-    if (!mp_obj_is_dict_or_ordereddict(self->desc)) {
-        mp_raise_TypeError(MP_ERROR_TEXT("struct: no fields"));
-    }
-
-    mp_obj_t deref = mp_obj_dict_get(self->desc, MP_OBJ_NEW_QSTR(attr));
-    if (mp_obj_is_small_int(deref)) {
-        mp_int_t offset = MP_OBJ_SMALL_INT_VALUE(deref);
-        mp_uint_t val_type = GET_TYPE(offset, VAL_TYPE_BITS);
-        offset &= VALUE_MASK(VAL_TYPE_BITS);
-
-        if (val_type <= INT64 || val_type == FLOAT32 || val_type == FLOAT64) {
-            if (self->flags == LAYOUT_NATIVE) {
-                if (set_val == MP_OBJ_NULL) {
-                    return get_aligned(val_type, self->addr + offset, 0);
-                } else {
-                    set_aligned(val_type, self->addr + offset, 0, set_val);
-                    return set_val; // just !MP_OBJ_NULL
-                }
+// Load or store the scalar field of the given type at the given offset; for a
+// bitfield, mask is the mask of the field's bits before they are shifted to
+// bit_offset
+STATIC mp_obj_t uctypes_struct_scalar_op(mp_obj_uctypes_struct_t *self, mp_uint_t val_type, mp_uint_t offset, uint bit_offset, mp_uint_t mask, mp_obj_t set_val) {
+    if (val_type <= INT64 || val_type == FLOAT32 || val_type == FLOAT64) {
+        if (self->flags == LAYOUT_NATIVE) {
+            if (set_val == MP_OBJ_NULL) {
+                return get_aligned(val_type, self->addr + offset, 0);
             } else {
-                if (set_val == MP_OBJ_NULL) {
-                    return get_unaligned(val_type, self->addr + offset, self->flags);
-                } else {
-                    set_unaligned(val_type, self->addr + offset, self->flags, set_val);
-                    return set_val; // just !MP_OBJ_NULL
-                }
+                set_aligned(val_type, self->addr + offset, 0, set_val);
+                return set_val; // just !MP_OBJ_NULL
             }
-        } else if (val_type >= BFUINT8 && val_type <= BFINT32) {
-            uint bit_offset = (offset >> OFFSET_BITS) & 31;
-            uint bit_len = (offset >> LEN_BITS) & 31;
-            offset &= (1 << OFFSET_BITS) - 1;
-            mp_uint_t val;
-            if (self->flags == LAYOUT_NATIVE) {
-                val = get_aligned_basic(val_type & 6, self->addr + offset);
+        } else if (val_type < UINT64 && (set_val == MP_OBJ_NULL || mp_obj_is_small_int(set_val))) {
+            // Integers of up to 32 bits can be converted directly
+            mp_uint_t size = GET_SCALAR_SIZE(val_type);
+            if (set_val == MP_OBJ_NULL) {
+                long long val = mp_binary_get_int(size, val_type & 1, self->flags, self->addr + offset);
+                return (val_type & 1) ? mp_obj_new_int((mp_int_t)val) : mp_obj_new_int_from_uint((mp_uint_t)val);
             } else {
-                val = mp_binary_get_int(GET_SCALAR_SIZE(val_type & 7), val_type & 1, self->flags, self->addr + offset);
+                mp_binary_set_int(size, self->flags == LAYOUT_BIG_ENDIAN, self->addr + offset, MP_OBJ_SMALL_INT_VALUE(set_val));
+                return set_val; // just !MP_OBJ_NULL
             }
+        } else {
             if (set_val == MP_OBJ_NULL) {
-                val >>= bit_offset;
-                val &= (1 << bit_len) - 1;
-                // TODO: signed
-                assert((val_type & 1) == 0);
-                return mp_obj_new_int(val);
+                return get_unaligned(val_type, self->addr + offset, self->flags);
             } else {
-                mp_uint_t set_val_int = (mp_uint_t)mp_obj_get_int(set_val);
-                mp_uint_t mask = (1 << bit_len) - 1;
-                set_val_int &= mask;
-                set_val_int <<= bit_offset;
-                mask <<= bit_offset;
-                val = (val & ~mask) | set_val_int;
-
-                if (self->flags == LAYOUT_NATIVE) {
-                    set_aligned_basic(val_type & 6, self->addr + offset, val);
-                } else {
-                    mp_binary_set_int(GET_SCALAR_SIZE(val_type & 7), self->flags == LAYOUT_BIG_ENDIAN,
-                        self->addr + offset, val);
-                }
+                set_unaligned(val_type, self->addr + offset, self->flags, set_val);
                 return set_val; // just !MP_OBJ_NULL
             }
         }
+    } else if (val_type >= BFUINT8 && val_type <= BFINT32) {
+        mp_uint_t val;
+        if (self->flags == LAYOUT_NATIVE) {
+            val = get_aligned_basic(val_type & 6, self->addr + offset);
+        } else {
+            val = mp_binary_get_int(GET_SCALAR_SIZE(val_type & 7), val_type & 1, self->flags, self->addr + offset);
+        }
+        if (set_val == MP_OBJ_NULL) {
+            val >>= bit_offset;
+            val &= mask;
+            // TODO: signed
+            assert((val_type & 1) == 0);
+            return mp_obj_new_int(val);
+        } else {
+            mp_uint_t set_val_int = (mp_uint_t)mp_obj_get_int(set_val);
+            set_val_int &= mask;
+            set_val_int <<= bit_offset;
+            mask <<= bit_offset;
+            val = (val & ~mask) | set_val_int;
 
-        assert(0);
-        return MP_OBJ_NULL;
+            if (self->flags == LAYOUT_NATIVE) {
+                set_aligned_basic(val_type & 6, self->addr + offset, val);
+            } else {
+                mp_binary_set_int(GET_SCALAR_SIZE(val_type & 7), self->flags == LAYOUT_BIG_ENDIAN,
+                    self->addr + offset, val);
+            }
+            return set_val; // just !MP_OBJ_NULL
+        }
     }
 
-    if (!mp_obj_is_type(deref, &mp_type_tuple)) {
-        syntax_error();
-    }
+    assert(0);
+    return MP_OBJ_NULL;
+}
 
+// Load the aggregate field with the given tuple descriptor; sub_desc is the
+// descriptor to use for a struct field (the dict in the tuple, or a compiled
+// version of it)
+STATIC mp_obj_t uctypes_struct_agg_op(mp_obj_uctypes_struct_t *self, mp_obj_tuple_t *sub, mp_obj_t sub_desc, mp_obj_t set_val) {
     if (set_val != MP_OBJ_NULL) {
         // Cannot assign to aggregate
         syntax_error();
     }
 
-    mp_obj_tuple_t *sub = MP_OBJ_TO_PTR(deref);
     mp_int_t offset = MP_OBJ_SMALL_INT_VALUE(sub->items[0]);
     mp_uint_t agg_type = GET_TYPE(offset, AGG_TYPE_BITS);
     offset &= VALUE_MASK(AGG_TYPE_BITS);
 
     switch (agg_type) {
-        case STRUCT: {
-            mp_obj_uctypes_struct_t *o = m_new_obj(mp_obj_uctypes_struct_t);
-            o->base.type = &uctypes_struct_type;
-            o->desc = sub->items[1];
-            o->addr = self->addr + offset;
-            o->flags = self->flags;
-            return MP_OBJ_FROM_PTR(o);
-        }
+        case STRUCT:
+            return uctypes_struct_new(sub_desc, self->addr + offset, self->flags);
         case ARRAY: {
             mp_uint_t dummy;
             if (IS_SCALAR_ARRAY(sub) && IS_SCALAR_ARRAY_OF_BYTES(sub)) {
@@ -478,20 +520,84 @@ STATIC mp_obj_t uctypes_struct_attr_op(mp_obj_t self_in, qstr attr, mp_obj_t set
             // Fall thru to return uctypes struct object
             MP_FALLTHROUGH
         }
-        case PTR: {
-            mp_obj_uctypes_struct_t *o = m_new_obj(mp_obj_uctypes_struct_t);
-            o->base.type = &uctypes_struct_type;
-            o->desc = MP_OBJ_FROM_PTR(sub);
-            o->addr = self->addr + offset;
-            o->flags = self->flags;
-            return MP_OBJ_FROM_PTR(o);
-        }
+        case PTR:
+            return uctypes_struct_new(MP_OBJ_FROM_PTR(sub), self->addr + offset, self->flags);
     }
 
     // Should be unreachable once all cases are handled
     return MP_OBJ_NULL;
 }
 
+#if MICROPY_PY_UCTYPES_COMPILE
+STATIC const uctypes_field_t *uctypes_compiled_lookup(uctypes_compiled_t *c, qstr attr) {
+    uint8_t *cache = &c->lookup_cache[attr % UCTYPES_LOOKUP_CACHE_SIZE];
+    if (*cache != 0 && c->fields[*cache - 1].name == attr) {
+        return &c->fields[*cache - 1];
+    }
+    size_t lo = 0;
+    size_t hi = c->num_fields;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (c->fields[mid].name < attr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < c->num_fields && c->fields[lo].name == attr) {
+        if (lo < 255) {
+            *cache = lo + 1;
+        }
+        return &c->fields[lo];
+    }
+    return NULL;
+}
+#endif
+
+STATIC mp_obj_t uctypes_struct_attr_op(mp_obj_t self_in, qstr attr, mp_obj_t set_val) {
+    mp_obj_uctypes_struct_t *self = MP_OBJ_TO_PTR(self_in);
+
+    #if MICROPY_PY_UCTYPES_COMPILE
+    if (self->compiled != NULL) {
+        const uctypes_field_t *f = uctypes_compiled_lookup(self->compiled, attr);
+        if (f != NULL) {
+            if (f->agg != MP_OBJ_NULL) {
+                mp_obj_tuple_t *sub = MP_OBJ_TO_PTR(f->agg);
+                return uctypes_struct_agg_op(self, sub, f->sub != NULL ? MP_OBJ_FROM_PTR(f->sub) : sub->items[1], set_val);
+            }
+            return uctypes_struct_scalar_op(self, f->val_type, f->offset, f->bit_offset, f->mask, set_val);
+        }
+        // Not found, so fall through to raise the same error as a dict descriptor
+    }
+    #endif
+
+    if (!mp_obj_is_dict_or_ordereddict(self->desc)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("struct: no fields"));
+    }
+
+    mp_obj_t deref = mp_obj_dict_get(self->desc, MP_OBJ_NEW_QSTR(attr));
+    if (mp_obj_is_small_int(deref)) {
+        mp_int_t offset = MP_OBJ_SMALL_INT_VALUE(deref);
+        mp_uint_t val_type = GET_TYPE(offset, VAL_TYPE_BITS);
+        offset &= VALUE_MASK(VAL_TYPE_BITS);
+        uint bit_offset = 0;
+        mp_uint_t mask = 0;
+        if (val_type >= BFUINT8 && val_type <= BFINT32) {
+            bit_offset = (offset >> OFFSET_BITS) & 31;
+            mask = (1 << ((offset >> LEN_BITS) & 31)) - 1;
+            offset &= (1 << OFFSET_BITS) - 1;
+        }
+        return uctypes_struct_scalar_op(self, val_type, offset, bit_offset, mask, set_val);
+    }
+
+    if (!mp_obj_is_type(deref, &mp_type_tuple)) {
+        syntax_error();
+    }
+
+    mp_obj_tuple_t *sub = MP_OBJ_TO_PTR(deref);
+    return uctypes_struct_agg_op(self, sub, sub->items[1], set_val);
+}
+
 STATIC void uctypes_struct_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
     if (dest[0] == MP_OBJ_NULL) {
         // load attribute
@@ -552,12 +658,7 @@ STATIC mp_obj_t uctypes_struct_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_ob
             } else if (value == MP_OBJ_SENTINEL) {
                 mp_uint_t dummy = 0;
                 mp_uint_t size = uctypes_struct_size(t->items[2], self->flags, &dummy);
-                mp_obj_uctypes_struct_t *o = m_new_obj(mp_obj_uctypes_struct_t);
-                o->base.type = &uctypes_struct_type;
-                o->desc = t->items[2];
-                o->addr = self->addr + size * index;
-                o->flags = self->flags;
-                return MP_OBJ_FROM_PTR(o);
+                return uctypes_struct_new(t->items[2], self->addr + size * index, self->flags);
             } else {
                 return MP_OBJ_NULL; // op not supported
             }
@@ -570,12 +671,7 @@ STATIC mp_obj_t uctypes_struct_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_ob
             } else {
                 mp_uint_t dummy = 0;
                 mp_uint_t size = uctypes_struct_size(t->items[1], self->flags, &dummy);
-                mp_obj_uctypes_struct_t *o = m_new_obj(mp_obj_uctypes_struct_t);
-                o->base.type = &uctypes_struct_type;
-                o->desc = t->items[1];
-                o->addr = p + size * index;
-                o->flags = self->flags;
-                return MP_OBJ_FROM_PTR(o);
+                return uctypes_struct_new(t->items[1], p + size * index, self->flags);
             }
         }
 
@@ -639,6 +735,70 @@ STATIC mp_obj_t uctypes_struct_bytes_at(mp_obj_t ptr, mp_obj_t size) {
 }
 MP_DEFINE_CONST_FUN_OBJ_2(uctypes_struct_bytes_at_obj, uctypes_struct_bytes_at);
 
+#if MICROPY_PY_UCTYPES_COMPILE
+
+// compile()
+// Convert a descriptor dict into a compiled descriptor, which can be passed
+// to struct() in place of the dict for faster access to fields.
+STATIC mp_obj_t uctypes_compile(mp_obj_t desc_in) {
+    if (mp_obj_is_type(desc_in, &uctypes_compiled_type)) {
+        return desc_in;
+    }
+    if (!mp_obj_is_dict_or_ordereddict(desc_in)) {
+        syntax_error();
+    }
+    mp_map_t *map = mp_obj_dict_get_map(desc_in);
+    uctypes_compiled_t *c = m_new_obj_var(uctypes_compiled_t, uctypes_field_t, map->used);
+    c->base.type = &uctypes_compiled_type;
+    c->desc = desc_in;
+    c->num_fields = 0;
+    memset(c->lookup_cache, 0, sizeof(c->lookup_cache));
+
+    for (size_t i = 0; i < map->alloc; i++) {
+        if (!mp_map_slot_is_filled(map, i)) {
+            continue;
+        }
+        mp_obj_t v = map->table[i].value;
+        uctypes_field_t f = { mp_obj_str_get_qstr(map->table[i].key), MP_OBJ_NULL, NULL, 0, 0, 0, 0 };
+        if (mp_obj_is_small_int(v)) {
+            mp_uint_t offset = MP_OBJ_SMALL_INT_VALUE(v);
+            f.val_type = GET_TYPE(offset, VAL_TYPE_BITS);
+            offset &= VALUE_MASK(VAL_TYPE_BITS);
+            if (f.val_type >= BFUINT8 && f.val_type <= BFINT32) {
+                f.bit_offset = (offset >> OFFSET_BITS) & 31;
+                f.mask = (1 << ((offset >> LEN_BITS) & 31)) - 1;
+                offset &= (1 << OFFSET_BITS) - 1;
+            }
+            f.offset = offset;
+        } else {
+            if (!mp_obj_is_type(v, &mp_type_tuple)) {
+                syntax_error();
+            }
+            mp_obj_tuple_t *sub = MP_OBJ_TO_PTR(v);
+            f.agg = v;
+            if (GET_TYPE(MP_OBJ_SMALL_INT_VALUE(sub->items[0]), AGG_TYPE_BITS) == STRUCT) {
+                f.sub = MP_OBJ_TO_PTR(uctypes_compile(sub->items[1]));
+            }
+        }
+        // Insert in order of qstr, for lookup by binary search
+        size_t j = c->num_fields++;
+        for (; j > 0 && c->fields[j - 1].name > f.name; --j) {
+            c->fields[j] = c->fields[j - 1];
+        }
+        c->fields[j] = f;
+    }
+
+    return MP_OBJ_FROM_PTR(c);
+}
+MP_DEFINE_CONST_FUN_OBJ_1(uctypes_compile_obj, uctypes_compile);
+
+STATIC const mp_obj_type_t uctypes_compiled_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_descriptor,
+};
+
+#endif // MICROPY_PY_UCTYPES_COMPILE
+
 STATIC const mp_obj_type_t uctypes_struct_type = {
     { &mp_type_type },
     .name = MP_QSTR_struct,
@@ -657,6 +817,9 @@ STATIC const mp_rom_map_elem_t mp_module_uctypes_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_addressof), MP_ROM_PTR(&uctypes_struct_addressof_obj) },
     { MP_ROM_QSTR(MP_QSTR_bytes_at), MP_ROM_PTR(&uctypes_struct_bytes_at_obj) },
     { MP_ROM_QSTR(MP_QSTR_bytearray_at), MP_ROM_PTR(&uctypes_struct_bytearray_at_obj) },
+    #if MICROPY_PY_UCTYPES_COMPILE
+    { MP_ROM_QSTR(MP_QSTR_compile), MP_ROM_PTR(&uctypes_compile_obj) },
+    #endif
 
     { MP_ROM_QSTR(MP_QSTR_NATIVE), MP_ROM_INT(LAYOUT_NATIVE) },
     { MP_ROM_QSTR(MP_QSTR_LITTLE_ENDIAN), MP_ROM_INT(LAYOUT_LITTLE_ENDIAN) },
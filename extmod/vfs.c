@@ -156,6 +156,92 @@ mp_import_stat_t mp_vfs_import_stat(const char *path) {
     }
 }
 
+#if MICROPY_MODULE_IMPORT_CACHE
+mp_obj_t mp_vfs_import_dir_stamp(const char *path, bool *casefold) {
+    const char *path_out;
+    mp_vfs_mount_t *vfs = mp_vfs_lookup_path(path[0] == '\0' ? "." : path, &path_out);
+    if (vfs == MP_VFS_NONE || vfs == MP_VFS_ROOT) {
+        return MP_OBJ_NULL;
+    }
+    #if MICROPY_VFS_FAT
+    // FAT matches names regardless of case (also note that it doesn't update
+    // the modification time of directories, changes are only seen through
+    // the invalidation done by the functions below)
+    *casefold = mp_obj_is_type(vfs->obj, &mp_fat_vfs_type);
+    #endif
+    mp_obj_t dest[2];
+    mp_load_method_maybe(vfs->obj, MP_QSTR_ilistdir, dest);
+    if (dest[0] == MP_OBJ_NULL) {
+        // a filesystem that can't be listed is never cached, don't stat it
+        return MP_OBJ_NULL;
+    }
+    const mp_vfs_proto_t *proto = mp_obj_get_type(vfs->obj)->protocol;
+    if (proto != NULL && proto->import_dir_stamp != NULL) {
+        return proto->import_dir_stamp(MP_OBJ_TO_PTR(vfs->obj), path_out);
+    }
+    mp_obj_t path_o = mp_obj_new_str(path_out, strlen(path_out));
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_t *items;
+        mp_obj_get_array_fixed_n(mp_vfs_proxy_call(vfs, MP_QSTR_stat, 1, &path_o), 10, &items);
+        nlr_pop();
+        // st_mtime
+        return items[8];
+    } else {
+        return MP_OBJ_NULL;
+    }
+}
+
+bool mp_vfs_import_listdir(const char *path, mp_import_listdir_cb_t cb, void *arg) {
+    size_t path_len = strlen(path);
+    mp_obj_t path_o = mp_obj_new_str(path, path_len);
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_t iter = mp_vfs_ilistdir(1, &path_o);
+        mp_obj_t next;
+        while ((next = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
+            mp_obj_t *items;
+            mp_obj_get_array_fixed_n(next, 3, &items);
+            size_t name_len;
+            const char *name = mp_obj_str_get_data(items[0], &name_len);
+            mp_int_t type = mp_obj_get_int(items[1]);
+            mp_import_stat_t stat;
+            if (type == MP_S_IFDIR) {
+                stat = MP_IMPORT_STAT_DIR;
+            } else if (type == MP_S_IFREG) {
+                stat = MP_IMPORT_STAT_FILE;
+            } else {
+                // filesystem doesn't know the type, so stat the entry
+                vstr_t vstr;
+                vstr_init(&vstr, path_len + 1 + name_len + 1);
+                vstr_add_strn(&vstr, path, path_len);
+                if (path_len > 0 && path[path_len - 1] != '/') {
+                    vstr_add_char(&vstr, '/');
+                }
+                vstr_add_strn(&vstr, name, name_len);
+                stat = mp_vfs_import_stat(vstr_null_terminated_str(&vstr));
+                vstr_clear(&vstr);
+            }
+            if (stat != MP_IMPORT_STAT_NO_EXIST) {
+                cb(arg, name, name_len, stat);
+            }
+        }
+        nlr_pop();
+        return true;
+    } else {
+        // a missing directory has no entries, other errors fall back to stat
+        mp_obj_t exc = MP_OBJ_FROM_PTR(nlr.ret_val);
+        if (mp_obj_is_subclass_fast(MP_OBJ_FROM_PTR(mp_obj_get_type(exc)), MP_OBJ_FROM_PTR(&mp_type_OSError))) {
+            mp_obj_t errno_o = mp_obj_exception_get_value(exc);
+            return errno_o == MP_OBJ_NEW_SMALL_INT(MP_ENOENT)
+                   || errno_o == MP_OBJ_NEW_SMALL_INT(MP_ENOTDIR)
+                   || errno_o == MP_OBJ_NEW_SMALL_INT(MP_ENODEV);
+        }
+        return false;
+    }
+}
+#endif
+
 STATIC mp_obj_t mp_vfs_autodetect(mp_obj_t bdev_obj) {
     #if MICROPY_VFS_LFS1 || MICROPY_VFS_LFS2
     nlr_buf_t nlr;
@@ -199,6 +285,7 @@ STATIC mp_obj_t mp_vfs_autodetect(mp_obj_t bdev_obj) {
 }
 
 mp_obj_t mp_vfs_mount(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    mp_import_cache_invalidate();
     enum { ARG_readonly, ARG_mkfs };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_readonly, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_FALSE} },
@@ -262,6 +349,7 @@ mp_obj_t mp_vfs_mount(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args
 MP_DEFINE_CONST_FUN_OBJ_KW(mp_vfs_mount_obj, 2, mp_vfs_mount);
 
 mp_obj_t mp_vfs_umount(mp_obj_t mnt_in) {
+    mp_import_cache_invalidate();
     // remove vfs from the mount table
     mp_vfs_mount_t *vfs = NULL;
     size_t mnt_len;
@@ -307,6 +395,13 @@ mp_obj_t mp_vfs_open(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
+    #if MICROPY_MODULE_IMPORT_CACHE
+    // opening a file for writing may create a module
+    if (strpbrk(mp_obj_str_get_str(args[ARG_mode].u_obj), "wax+") != NULL) {
+        mp_import_cache_invalidate();
+    }
+    #endif
+
     #if MICROPY_VFS_POSIX
     // If the file is an integer then delegate straight to the POSIX handler
     if (mp_obj_is_small_int(args[ARG_file].u_obj)) {
@@ -320,6 +415,7 @@ mp_obj_t mp_vfs_open(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
 MP_DEFINE_CONST_FUN_OBJ_KW(mp_vfs_open_obj, 0, mp_vfs_open);
 
 mp_obj_t mp_vfs_chdir(mp_obj_t path_in) {
+    mp_import_cache_invalidate();
     mp_obj_t path_out;
     mp_vfs_mount_t *vfs = lookup_path(path_in, &path_out);
     if (vfs == MP_VFS_ROOT) {
@@ -442,6 +538,7 @@ mp_obj_t mp_vfs_listdir(size_t n_args, const mp_obj_t *args) {
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_vfs_listdir_obj, 0, 1, mp_vfs_listdir);
 
 mp_obj_t mp_vfs_mkdir(mp_obj_t path_in) {
+    mp_import_cache_invalidate();
     mp_obj_t path_out;
     mp_vfs_mount_t *vfs = lookup_path(path_in, &path_out);
     if (vfs == MP_VFS_ROOT || (vfs != MP_VFS_NONE && !strcmp(mp_obj_str_get_str(path_out), "/"))) {
@@ -452,6 +549,7 @@ mp_obj_t mp_vfs_mkdir(mp_obj_t path_in) {
 MP_DEFINE_CONST_FUN_OBJ_1(mp_vfs_mkdir_obj, mp_vfs_mkdir);
 
 mp_obj_t mp_vfs_remove(mp_obj_t path_in) {
+    mp_import_cache_invalidate();
     mp_obj_t path_out;
     mp_vfs_mount_t *vfs = lookup_path(path_in, &path_out);
     return mp_vfs_proxy_call(vfs, MP_QSTR_remove, 1, &path_out);
@@ -459,6 +557,7 @@ mp_obj_t mp_vfs_remove(mp_obj_t path_in) {
 MP_DEFINE_CONST_FUN_OBJ_1(mp_vfs_remove_obj, mp_vfs_remove);
 
 mp_obj_t mp_vfs_rename(mp_obj_t old_path_in, mp_obj_t new_path_in) {
+    mp_import_cache_invalidate();
     mp_obj_t args[2];
     mp_vfs_mount_t *old_vfs = lookup_path(old_path_in, &args[0]);
     mp_vfs_mount_t *new_vfs = lookup_path(new_path_in, &args[1]);
@@ -471,6 +570,7 @@ mp_obj_t mp_vfs_rename(mp_obj_t old_path_in, mp_obj_t new_path_in) {
 MP_DEFINE_CONST_FUN_OBJ_2(mp_vfs_rename_obj, mp_vfs_rename);
 
 mp_obj_t mp_vfs_rmdir(mp_obj_t path_in) {
+    mp_import_cache_invalidate();
     mp_obj_t path_out;
     mp_vfs_mount_t *vfs = lookup_path(path_in, &path_out);
     return mp_vfs_proxy_call(vfs, MP_QSTR_rmdir, 1, &path_out);
@@ -55,6 +55,10 @@
 // At the moment the VFS protocol just has import_stat, but could be extended to other methods
 typedef struct _mp_vfs_proto_t {
     mp_import_stat_t (*import_stat)(void *self, const char *path);
+    #if MICROPY_MODULE_IMPORT_CACHE
+    // optional, see mp_import_dir_stamp; VFS.stat() is used if not given
+    mp_obj_t (*import_dir_stamp)(void *self, const char *path);
+    #endif
 } mp_vfs_proto_t;
 
 typedef struct _mp_vfs_blockdev_t {
@@ -88,6 +92,10 @@ mp_obj_t mp_vfs_blockdev_ioctl(mp_vfs_blockdev_t *self, uintptr_t cmd, uintptr_t
 
 mp_vfs_mount_t *mp_vfs_lookup_path(const char *path, const char **path_out);
 mp_import_stat_t mp_vfs_import_stat(const char *path);
+#if MICROPY_MODULE_IMPORT_CACHE
+bool mp_vfs_import_listdir(const char *path, mp_import_listdir_cb_t cb, void *arg);
+mp_obj_t mp_vfs_import_dir_stamp(const char *path, bool *casefold);
+#endif
 mp_obj_t mp_vfs_mount(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args);
 mp_obj_t mp_vfs_umount(mp_obj_t mnt_in);
 mp_obj_t mp_vfs_open(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args);
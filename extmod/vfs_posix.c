@@ -92,6 +92,29 @@ STATIC mp_import_stat_t mp_vfs_posix_import_stat(void *self_in, const char *path
     return MP_IMPORT_STAT_NO_EXIST;
 }
 
+#if MICROPY_MODULE_IMPORT_CACHE
+STATIC mp_obj_t mp_vfs_posix_import_dir_stamp(void *self_in, const char *path) {
+    mp_obj_vfs_posix_t *self = self_in;
+    if (self->root_len != 0) {
+        self->root.len = self->root_len;
+        vstr_add_str(&self->root, path);
+        path = vstr_null_terminated_str(&self->root);
+    }
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return MP_OBJ_NULL;
+    }
+    // modification time with the full resolution of the filesystem, st_mtime
+    // as returned by stat() only has seconds
+    #if defined(__APPLE__)
+    struct timespec ts = st.st_mtimespec;
+    #else
+    struct timespec ts = st.st_mtim;
+    #endif
+    return mp_obj_new_int_from_ll((long long)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+#endif
+
 STATIC mp_obj_t vfs_posix_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     mp_arg_check_num(n_args, n_kw, 0, 1, false);
 
@@ -368,6 +391,9 @@ STATIC MP_DEFINE_CONST_DICT(vfs_posix_locals_dict, vfs_posix_locals_dict_table);
 
 STATIC const mp_vfs_proto_t vfs_posix_proto = {
     .import_stat = mp_vfs_posix_import_stat,
+    #if MICROPY_MODULE_IMPORT_CACHE
+    .import_dir_stamp = mp_vfs_posix_import_dir_stamp,
+    #endif
 };
 
 const mp_obj_type_t mp_type_vfs_posix = {
@@ -55,6 +55,14 @@ STATIC void stderr_print_strn(void *env, const char *str, size_t len) {
 
 STATIC const mp_print_t mp_stderr_print = {NULL, stderr_print_strn};
 
+// An input file to compile, along with the options that apply only to it
+typedef struct _compile_job_t {
+    const char *input_file;
+    const char *output_file;
+    const char *source_file;
+    uint8_t opt_level;
+} compile_job_t;
+
 STATIC int compile_and_save(const char *file, const char *output_file, const char *source_file) {
     nlr_buf_t nlr;
     if (nlr_push(&nlr) == 0) {
@@ -97,7 +105,7 @@ STATIC int compile_and_save(const char *file, const char *output_file, const cha
 
 STATIC int usage(char **argv) {
     printf(
-        "usage: %s [<opts>] [-X <implopt>] <input filename>\n"
+        "usage: %s [<opts>] [-X <implopt>] <input filename>...\n"
         "Options:\n"
         "--version : show version information\n"
         "-o : output file for compiled bytecode (defaults to input with .mpy extension)\n"
@@ -108,14 +116,20 @@ STATIC int usage(char **argv) {
         "Target specific options:\n"
         "-msmall-int-bits=number : set the maximum bits used to encode a small-int\n"
         "-mno-unicode : don't support unicode in compiled strings\n"
+        "-mxip : save bytecode that can execute in place from memory-mapped storage\n"
         "-march=<arch> : set architecture for native emitter; x86, x64, armv6, armv7m, armv7em, armv7emsp, armv7emdp, xtensa, xtensawin\n"
         "\n"
+        "Multiple input files are compiled in one batch, with -o and -s applying to\n"
+        "the input file that follows them.  An argument @<file> is replaced by the\n"
+        "whitespace-separated arguments read from <file>.\n"
+        "\n"
         "Implementation specific options:\n", argv[0]
         );
     int impl_opts_cnt = 0;
     printf(
         #if MICROPY_EMIT_NATIVE
         "  emit={bytecode,native,viper} -- set the default code emitter\n"
+        "  emit=auto -- native code for functions that loop, else bytecode\n"
         #else
         "  emit=bytecode -- set the default code emitter\n"
         #endif
@@ -133,6 +147,65 @@ STATIC int usage(char **argv) {
     return 1;
 }
 
+// Replace any @<file> arguments with the arguments read from that file.  The
+// returned strings live until the process exits, as the jobs refer to them.
+STATIC char **expand_response_files(int *argc_in, char **argv) {
+    int argc = *argc_in;
+    size_t alloc = argc + 1;
+    size_t n = 0;
+    char **args = malloc(alloc * sizeof(char *));
+    for (int a = 0; a < argc; a++) {
+        if (a == 0 || argv[a][0] != '@') {
+            args[n++] = argv[a];
+            continue;
+        }
+        FILE *f = fopen(argv[a] + 1, "rb");
+        if (f == NULL) {
+            mp_printf(&mp_stderr_print, "can't open response file %s\n", argv[a] + 1);
+            exit(1);
+        }
+        fseek(f, 0, SEEK_END);
+        long len = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        char *buf = malloc(len + 1);
+        if (fread(buf, 1, len, f) != (size_t)len) {
+            mp_printf(&mp_stderr_print, "can't read response file %s\n", argv[a] + 1);
+            exit(1);
+        }
+        fclose(f);
+        buf[len] = '\0';
+        // split into arguments in place; double quotes group whitespace
+        for (char *p = buf; *p;) {
+            if (unichar_isspace(*p)) {
+                ++p;
+                continue;
+            }
+            char *arg = p;
+            char *out = p;
+            bool quoted = false;
+            for (; *p && (quoted || !unichar_isspace(*p)); ++p) {
+                if (*p == '"') {
+                    quoted = !quoted;
+                } else {
+                    *out++ = *p;
+                }
+            }
+            if (*p) {
+                ++p;
+            }
+            *out = '\0';
+            if (n + 1 >= alloc) {
+                alloc *= 2;
+                args = realloc(args, alloc * sizeof(char *));
+            }
+            args[n++] = arg;
+        }
+    }
+    args[n] = NULL;
+    *argc_in = n;
+    return args;
+}
+
 // Process options which set interpreter init options
 STATIC void pre_process_options(int argc, char **argv) {
     for (int a = 1; a < argc; a++) {
@@ -148,6 +221,8 @@ STATIC void pre_process_options(int argc, char **argv) {
                     emit_opt = MP_EMIT_OPT_NATIVE_PYTHON;
                 } else if (strcmp(argv[a + 1], "emit=viper") == 0) {
                     emit_opt = MP_EMIT_OPT_VIPER;
+                } else if (strcmp(argv[a + 1], "emit=auto") == 0) {
+                    emit_opt = MP_EMIT_OPT_NATIVE_AUTO;
                 #endif
                 } else if (strncmp(argv[a + 1], "heapsize=", sizeof("heapsize=") - 1) == 0) {
                     char *end;
@@ -183,6 +258,7 @@ STATIC void pre_process_options(int argc, char **argv) {
 MP_NOINLINE int main_(int argc, char **argv) {
     mp_stack_set_limit(40000 * (sizeof(void *) / 4));
 
+    argv = expand_response_files(&argc, argv);
     pre_process_options(argc, argv);
 
     char *heap = malloc(heap_size);
@@ -205,6 +281,7 @@ MP_NOINLINE int main_(int argc, char **argv) {
     // set default compiler configuration
     mp_dynamic_compiler.small_int_bits = 31;
     mp_dynamic_compiler.py_builtins_str_unicode = 1;
+    mp_dynamic_compiler.xip = false;
     #if defined(__i386__)
     mp_dynamic_compiler.native_arch = MP_NATIVE_ARCH_X86;
     mp_dynamic_compiler.nlr_buf_num_regs = MICROPY_NLR_NUM_REGS_X86;
@@ -219,7 +296,8 @@ MP_NOINLINE int main_(int argc, char **argv) {
     mp_dynamic_compiler.nlr_buf_num_regs = 0;
     #endif
 
-    const char *input_file = NULL;
+    compile_job_t *jobs = malloc(argc * sizeof(compile_job_t));
+    size_t num_jobs = 0;
     const char *output_file = NULL;
     const char *source_file = NULL;
 
@@ -266,6 +344,8 @@ MP_NOINLINE int main_(int argc, char **argv) {
                 mp_dynamic_compiler.py_builtins_str_unicode = 0;
             } else if (strcmp(argv[a], "-municode") == 0) {
                 mp_dynamic_compiler.py_builtins_str_unicode = 1;
+            } else if (strcmp(argv[a], "-mxip") == 0) {
+                mp_dynamic_compiler.xip = true;
             } else if (strncmp(argv[a], "-march=", sizeof("-march=") - 1) == 0) {
                 const char *arch = argv[a] + sizeof("-march=") - 1;
                 if (strcmp(arch, "x86") == 0) {
@@ -302,20 +382,41 @@ MP_NOINLINE int main_(int argc, char **argv) {
                 return usage(argv);
             }
         } else {
-            if (input_file != NULL) {
-                mp_printf(&mp_stderr_print, "multiple input files\n");
-                exit(1);
-            }
-            input_file = argv[a];
+            compile_job_t *job = &jobs[num_jobs++];
+            job->input_file = argv[a];
+            job->output_file = output_file;
+            job->source_file = source_file;
+            job->opt_level = MP_STATE_VM(mp_optimise_value);
+            output_file = NULL;
+            source_file = NULL;
         }
     }
 
-    if (input_file == NULL) {
+    if (num_jobs == 0) {
         mp_printf(&mp_stderr_print, "no input file\n");
         exit(1);
     }
 
-    int ret = compile_and_save(input_file, output_file, source_file);
+    if (num_jobs == 1) {
+        // with a single input file the options may come in any order
+        if (output_file != NULL) {
+            jobs[0].output_file = output_file;
+        }
+        if (source_file != NULL) {
+            jobs[0].source_file = source_file;
+        }
+        jobs[0].opt_level = MP_STATE_VM(mp_optimise_value);
+    } else if (output_file != NULL || source_file != NULL) {
+        mp_printf(&mp_stderr_print, "-o and -s must come before their input file\n");
+        exit(1);
+    }
+
+    // compile all inputs in this process, sharing the qstr pool and heap
+    int ret = 0;
+    for (size_t i = 0; i < num_jobs; ++i) {
+        MP_STATE_VM(mp_optimise_value) = jobs[i].opt_level;
+        ret |= compile_and_save(jobs[i].input_file, jobs[i].output_file, jobs[i].source_file);
+    }
 
     #if MICROPY_PY_MICROPYTHON_MEM_INFO
     if (mp_verbose_flag) {
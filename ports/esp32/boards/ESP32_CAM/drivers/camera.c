@@ -29,6 +29,7 @@
 #include "driver/periph_ctrl.h"
 #include "esp_intr_alloc.h"
 #include "esp_system.h"
+#include "esp_heap_caps.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 #include "sensor.h"
@@ -37,6 +38,8 @@
 #include "camera_common.h"
 #include "xclk.h"
 #include "ov2640.h"
+#include "camera_ring.h"
+#include "jpeg_eoi.h"
 
 typedef enum
 {
@@ -56,6 +59,10 @@ typedef enum
 #define REG16_CHIDH     0x300A
 #define REG16_CHIDL     0x300B
 
+// Special values queued to the DMA filter task instead of a buffer index
+#define DMA_FRAME_END   SIZE_MAX        // End of the frame
+#define DMA_FILTER_STOP (SIZE_MAX - 1)  // Stream stops, see esp_camera_stream_stop
+
 #if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
 #include "esp32-hal-log.h"
 #define TAG ""
@@ -96,6 +103,7 @@ typedef struct
     size_t dma_per_line;
     size_t dma_buf_width;
     size_t dma_sample_count;
+    struct jpeg_eoi_t jpeg_eoi;         // End of JPEG frame, found while filtering
     
     lldesc_t* dma_desc;
     dma_elem_t** dma_buf;
@@ -110,11 +118,24 @@ typedef struct
     QueueHandle_t fb_out;
     
     SemaphoreHandle_t frame_ready;
+    SemaphoreHandle_t filter_stopped;   // Given by DMA filter task on DMA_FILTER_STOP
     TaskHandle_t dma_filter_task;
+    
+    // Continuous capture, see esp_camera_stream_start
+    bool streaming;
+    struct camera_ring_t ring;
+    struct campy_FrameBuffer* ring_fb;  // Frame of each slot, outside GC heap
+    int ring_slot;                      // Slot being filled, -1 when capture stalled
 } camera_state_t;
 
 camera_state_t* s_state = NULL;
 
+// Guards ring, shared by DMA filter task and application
+static portMUX_TYPE s_ring_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Changes with every stream so frames of old streams can't be released
+static uint16_t s_ring_gen;
+
 static void i2s_init();
 static int i2s_run();
 static void IRAM_ATTR vsync_isr(void* arg);
@@ -128,6 +149,7 @@ static void dma_filter_yuyv(const dma_elem_t* src, lldesc_t* dma_desc, uint8_t*
 static void dma_filter_yuyv_highspeed(const dma_elem_t* src, lldesc_t* dma_desc, uint8_t* dst);
 static void dma_filter_jpeg(const dma_elem_t* src, lldesc_t* dma_desc, uint8_t* dst);
 static void i2s_stop(bool* need_yield);
+static void esp_camera_stream_free();
 
 static bool is_hs_mode()
 {
@@ -466,7 +488,7 @@ static void IRAM_ATTR i2s_stop(bool* need_yield)
         s_state->dma_received_count = 0;
     }
     
-    size_t val = SIZE_MAX;
+    size_t val = DMA_FRAME_END;
     BaseType_t higher_priority_task_woken;
     BaseType_t ret = xQueueSendFromISR(s_state->data_ready, &val, &higher_priority_task_woken);
     if (need_yield && !*need_yield)
@@ -559,6 +581,27 @@ static void IRAM_ATTR camera_fb_done()
     xSemaphoreGive(s_state->frame_ready);
 }
 
+static void IRAM_ATTR stream_fb_done()
+{
+    portENTER_CRITICAL(&s_ring_mux);
+    if (s_state->streaming)
+    {
+        camera_ring_commit(&s_state->ring, s_state->ring_slot);
+        
+        // Capture of next frame starts right away, unless the application
+        // holds all slots.  Then it is restarted by esp_camera_fb_latest.
+        s_state->ring_slot = camera_ring_begin(&s_state->ring);
+        if (s_state->ring_slot >= 0)
+        {
+            s_state->fb = &s_state->ring_fb[s_state->ring_slot];
+            i2s_start_bus();
+        }
+    }
+    portEXIT_CRITICAL(&s_ring_mux);
+    
+    camera_fb_done();
+}
+
 static void IRAM_ATTR dma_finish_frame()
 {
     size_t buf_len = s_state->width * s_state->fb_bytes_per_pixel / s_state->dma_per_line;
@@ -579,31 +622,28 @@ static void IRAM_ATTR dma_finish_frame()
             
             if (0 != s_state->fb->len)
             {
-                //find the end marker for JPEG. Data after that can be discarded
-                if (s_state->fb->format == PIXFORMAT_JPEG)
+                //end marker for JPEG was found while filtering. Data after that is discarded
+                if (s_state->fb->format == PIXFORMAT_JPEG && s_state->jpeg_eoi.end)
                 {
-                    uint8_t* dptr = &s_state->fb->buf[s_state->fb->len - 1];
-                    while (dptr > s_state->fb->buf)
+                    s_state->fb->len = s_state->jpeg_eoi.end;
+                    if ((s_state->fb->len & 0x1FF) == 0)
                     {
-                        if (dptr[0] == 0xFF && dptr[1] == 0xD9 && dptr[2] == 0x00 && dptr[3] == 0x00)
-                        {
-                            dptr += 2;
-                            s_state->fb->len = dptr - s_state->fb->buf;
-                            if ((s_state->fb->len & 0x1FF) == 0)
-                            {
-                                s_state->fb->len += 1;
-                            }
-                            if ((s_state->fb->len % 100) == 0)
-                            {
-                                s_state->fb->len += 1;
-                            }
-                            break;
-                        }
-                        dptr--;
+                        s_state->fb->len += 1;
+                    }
+                    if ((s_state->fb->len % 100) == 0)
+                    {
+                        s_state->fb->len += 1;
                     }
                 }
                 //send out the frame
-                camera_fb_done();
+                if (s_state->streaming)
+                {
+                    stream_fb_done();
+                }
+                else
+                {
+                    camera_fb_done();
+                }
             }
             else
             {
@@ -627,6 +667,20 @@ static void IRAM_ATTR dma_filter_buffer(size_t buf_idx)
         return;
     }
     
+    bool jpeg = (s_state->sensor.pixformat == PIXFORMAT_JPEG);
+    if (jpeg)
+    {
+        if (!s_state->dma_filtered_count)
+        {
+            jpeg_eoi_reset(&s_state->jpeg_eoi);
+        }
+        else if (s_state->jpeg_eoi.end)
+        {
+            //rest of the frame is padding after the end marker
+            return;
+        }
+    }
+    
     //check if there is enough space in the frame buffer for the new data
     size_t buf_len = s_state->width * s_state->fb_bytes_per_pixel / s_state->dma_per_line;
     size_t fb_pos = s_state->dma_filtered_count * buf_len;
@@ -640,11 +694,17 @@ static void IRAM_ATTR dma_filter_buffer(size_t buf_idx)
     //convert I2S DMA buffer to pixel data
     (*s_state->dma_filter)(s_state->dma_buf[buf_idx], &s_state->dma_desc[buf_idx], s_state->fb->buf + fb_pos);
     
+    //look for the end marker while the chunk is still in cache
+    if (jpeg)
+    {
+        jpeg_eoi_scan(&s_state->jpeg_eoi, s_state->fb->buf + fb_pos, buf_len);
+    }
+    
     //first frame buffer
     if (!s_state->dma_filtered_count)
     {
         //check for correct JPEG header
-        if (s_state->sensor.pixformat == PIXFORMAT_JPEG)
+        if (jpeg)
         {
             uint32_t sig = *((uint32_t*)s_state->fb->buf) & 0xFFFFFF;
             if (sig != 0xffd8ff)
@@ -674,11 +734,17 @@ static void IRAM_ATTR dma_filter_task(void* pvParameters)
         size_t buf_idx;
         if (xQueueReceive(s_state->data_ready, &buf_idx, portMAX_DELAY) == pdTRUE)
         {
-            if (buf_idx == SIZE_MAX)
+            if (buf_idx == DMA_FRAME_END)
             {
                 //this is the end of the frame
                 dma_finish_frame();
             }
+            else if (buf_idx == DMA_FILTER_STOP)
+            {
+                //stream is stopping, stay away from its frame buffers until they are freed
+                xSemaphoreGive(s_state->filter_stopped);
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
             else
             {
                 dma_filter_buffer(buf_idx);
@@ -1108,8 +1174,9 @@ void esp_camera_init(const camera_config_t* config)
     }
     
     s_state->frame_ready = xSemaphoreCreateBinary();
+    s_state->filter_stopped = xSemaphoreCreateBinary();
     
-    if (s_state->frame_ready == NULL)
+    if ((s_state->frame_ready == NULL) || (s_state->filter_stopped == NULL))
     {
         esp_camera_deinit();
         MP_RAISE(Exception, "Failed to create semaphore");
@@ -1264,6 +1331,11 @@ void esp_camera_deinit()
         vSemaphoreDelete(s_state->frame_ready);
     }
     
+    if (s_state->filter_stopped)
+    {
+        vSemaphoreDelete(s_state->filter_stopped);
+    }
+    
     gpio_isr_handler_remove(s_state->config.pin_vsync);
     
     if (s_state->i2s_intr_handle)
@@ -1273,6 +1345,13 @@ void esp_camera_deinit()
     }
     
     dma_desc_deinit();
+    
+    if (s_state->streaming)
+    {
+        s_state->streaming = false;
+        esp_camera_stream_free();
+    }
+    
     s_state = NULL;
     
     camera_disable_out_clock();
@@ -1291,6 +1370,11 @@ struct campy_FrameBuffer* esp_camera_fb_get()
         MP_RAISE(Exception, "Camera not initialized");
     }
     
+    if (s_state->streaming)
+    {
+        MP_RAISE(Exception, "Camera is streaming, use latest()");
+    }
+    
     /*
      * Is transfer already running?
      */
@@ -1324,6 +1408,203 @@ struct campy_FrameBuffer* esp_camera_fb_get()
     return s_state->fb;
 }
 
+static void esp_camera_stream_free()
+{
+    if (s_state->ring_fb)
+    {
+        for (int i = 0; i < s_state->ring.cnt; ++i)
+        {
+            heap_caps_free(s_state->ring_fb[i].buf);
+        }
+        heap_caps_free(s_state->ring_fb);
+    }
+    
+    s_state->ring_fb   = NULL;
+    s_state->ring_slot = -1;
+    s_state->fb        = NULL;
+}
+
+void esp_camera_stream_start(size_t aCount)
+{
+    if (s_state == NULL)
+    {
+        MP_RAISE(Exception, "Camera not initialized");
+    }
+    
+    if ((aCount < 1) || (aCount > CAMERA_RING_MAX))
+    {
+        MP_RAISE(ValueError, "Unsupported count of frame buffers");
+    }
+    
+    esp_camera_stream_stop();
+    
+    /*
+     * Frame buffers are allocated once, from PSRAM when possible, so the
+     * capture doesn't allocate anything from GC heap
+     */
+    s_state->ring_fb = heap_caps_calloc(aCount, sizeof(struct campy_FrameBuffer), MALLOC_CAP_8BIT);
+    
+    if (s_state->ring_fb == NULL)
+    {
+        MP_RAISE(MemoryError, "Failed to allocate frame buffers");
+    }
+    
+    camera_ring_init(&s_state->ring, aCount);
+    
+    for (int i = 0; i < aCount; ++i)
+    {
+        struct campy_FrameBuffer* fb = &s_state->ring_fb[i];
+        
+        fb->base.type = &MP_NAMESPACE2(campy, FrameBuffer);
+        fb->slot      = i;
+        fb->buf       = heap_caps_malloc(s_state->fb_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        
+        if (fb->buf == NULL)
+        {
+            fb->buf = heap_caps_malloc(s_state->fb_size, MALLOC_CAP_8BIT);
+        }
+        
+        if (fb->buf == NULL)
+        {
+            esp_camera_stream_free();
+            MP_RAISE(MemoryError, "Failed to allocate frame buffers");
+        }
+    }
+    
+    ++s_ring_gen;
+    s_state->ring_slot = camera_ring_begin(&s_state->ring);
+    s_state->fb        = &s_state->ring_fb[s_state->ring_slot];
+    s_state->streaming = true;
+    
+    xSemaphoreTake(s_state->frame_ready, 0);
+    
+    if (i2s_run())
+    {
+        esp_camera_stream_stop();
+        MP_RAISE(Exception, "Transfer error");
+    }
+}
+
+void esp_camera_stream_stop()
+{
+    if ((s_state == NULL) || !s_state->streaming)
+    {
+        return;
+    }
+    
+    portENTER_CRITICAL(&s_ring_mux);
+    s_state->streaming = false;
+    i2s_stop_bus();
+    portEXIT_CRITICAL(&s_ring_mux);
+    
+    /*
+     * DMA filter task finishes buffers it already got, acknowledges the stop
+     * queued after them and waits until frame buffers are freed.  Whatever
+     * the interrupt queued meanwhile is dropped, as is a partly filtered
+     * frame.
+     */
+    size_t stop = DMA_FILTER_STOP;
+    
+    xQueueSend(s_state->data_ready, &stop, portMAX_DELAY);
+    xSemaphoreTake(s_state->filter_stopped, portMAX_DELAY);
+    xQueueReset(s_state->data_ready);
+    
+    s_state->dma_filtered_count = 0;
+    esp_camera_stream_free();
+    
+    xTaskNotifyGive(s_state->dma_filter_task);
+}
+
+struct campy_FrameBuffer* esp_camera_fb_latest(int aTimeoutMs)
+{
+    if ((s_state == NULL) || !s_state->streaming)
+    {
+        MP_RAISE(Exception, "Camera is not streaming");
+    }
+    
+    /*
+     * Allocated before the frame is taken, so failing allocation doesn't
+     * leave the slot held
+     */
+    struct campy_FrameBuffer* self = m_new_obj_with_finaliser(struct campy_FrameBuffer);
+    
+    while (true)
+    {
+        bool restart = false;
+        
+        portENTER_CRITICAL(&s_ring_mux);
+        int slot = camera_ring_take(&s_state->ring);
+        if (s_state->ring_slot < 0)
+        {
+            s_state->ring_slot = camera_ring_begin(&s_state->ring);
+            if (s_state->ring_slot >= 0)
+            {
+                s_state->fb = &s_state->ring_fb[s_state->ring_slot];
+                restart     = true;
+            }
+        }
+        portEXIT_CRITICAL(&s_ring_mux);
+        
+        if (restart && i2s_run())
+        {
+            MP_RAISE(Exception, "Transfer error");
+        }
+        
+        if (slot >= 0)
+        {
+            memcpy(self, &s_state->ring_fb[slot], sizeof(*self));
+            self->gen  = s_ring_gen;
+            self->next = NULL;
+            return self;
+        }
+        
+        if (xSemaphoreTake(s_state->frame_ready, aTimeoutMs / portTICK_PERIOD_MS) != pdTRUE)
+        {
+            self->buf  = NULL;
+            self->slot = -1;
+            return NULL;
+        }
+    }
+}
+
+bool esp_camera_fb_valid(const struct campy_FrameBuffer* aFb)
+{
+    if (aFb->buf == NULL)
+    {
+        return false;
+    }
+    
+    return (aFb->slot < 0) ||
+           ((s_state != NULL) && s_state->streaming && (aFb->gen == s_ring_gen));
+}
+
+void esp_camera_fb_release(struct campy_FrameBuffer* aFb)
+{
+    if ((aFb->slot >= 0) && esp_camera_fb_valid(aFb))
+    {
+        portENTER_CRITICAL(&s_ring_mux);
+        camera_ring_release(&s_state->ring, aFb->slot);
+        portEXIT_CRITICAL(&s_ring_mux);
+    }
+    
+    aFb->slot = -1;
+    aFb->buf  = NULL;
+}
+
+void esp_camera_stream_info(unsigned long aInfo[3])
+{
+    if (s_state == NULL)
+    {
+        MP_RAISE(Exception, "Camera not initialized");
+    }
+    
+    portENTER_CRITICAL(&s_ring_mux);
+    aInfo[0] = s_state->ring.captured;
+    aInfo[1] = s_state->ring.dropped;
+    aInfo[2] = s_state->ring.stalls;
+    portEXIT_CRITICAL(&s_ring_mux);
+}
+
 sensor_t* esp_camera_sensor_get()
 {
     if (s_state == NULL)
@@ -1363,6 +1644,7 @@ struct campy_FrameBuffer* campy_FrameBuffer_new(void)
     
     self->base.type = &MP_NAMESPACE2(campy, FrameBuffer);
     self->buf       = (uint8_t*)m_malloc(s_state->fb_size);
+    self->slot      = -1;
     
     return self;
 }
@@ -0,0 +1,141 @@
+/**
+ * @brief   Ring of preallocated frame buffers for continuous capture
+ * 
+ * @file    camera_ring.c
+ */
+#include "camera_ring.h"
+#include <string.h>
+
+
+/*
+ * Finds the oldest or the newest slot in state `aState`
+ */
+static int _find(const struct camera_ring_t* aRing,
+                 uint8_t                     aState,
+                 bool                        aNewest)
+{
+    int found = -1;
+    
+    for (int i = 0; i < aRing->cnt; ++i)
+    {
+        if (aRing->state[i] != aState)
+        {
+            continue;
+        }
+        
+        /*
+         * Sequence numbers are compared by difference so they can wrap
+         */
+        if ((found < 0) ||
+            (aNewest == ((int32_t)(aRing->seq[i] - aRing->seq[found]) > 0)))
+        {
+            found = i;
+        }
+    }
+    
+    return found;
+}
+
+
+/*
+ * See description with declaration
+ */
+void camera_ring_init(struct camera_ring_t* aRing,
+                      unsigned              aCnt)
+{
+    memset(aRing, 0, sizeof(*aRing));
+    aRing->cnt = aCnt < CAMERA_RING_MAX ? aCnt : CAMERA_RING_MAX;
+}
+
+
+/*
+ * See description with declaration
+ */
+int camera_ring_begin(struct camera_ring_t* aRing)
+{
+    int slot = _find(aRing, CAMERA_SLOT_FREE, false);
+    
+    if (slot < 0)
+    {
+        /*
+         * The latest frame is never overwritten, otherwise application
+         * holding all but one slot would never get a new frame
+         */
+        slot = _find(aRing, CAMERA_SLOT_READY, false);
+        
+        if ((slot < 0) || (slot == _find(aRing, CAMERA_SLOT_READY, true)))
+        {
+            ++aRing->stalls;
+            return -1;
+        }
+        
+        ++aRing->dropped;
+    }
+    
+    aRing->state[slot] = CAMERA_SLOT_FILLING;
+    return slot;
+}
+
+
+/*
+ * See description with declaration
+ */
+void camera_ring_commit(struct camera_ring_t* aRing,
+                        int                   aSlot)
+{
+    aRing->state[aSlot] = CAMERA_SLOT_READY;
+    aRing->seq[aSlot]   = aRing->next_seq++;
+    ++aRing->captured;
+}
+
+
+/*
+ * See description with declaration
+ */
+void camera_ring_abort(struct camera_ring_t* aRing,
+                       int                   aSlot)
+{
+    aRing->state[aSlot] = CAMERA_SLOT_FREE;
+}
+
+
+/*
+ * See description with declaration
+ */
+int camera_ring_take(struct camera_ring_t* aRing)
+{
+    int slot = _find(aRing, CAMERA_SLOT_READY, true);
+    
+    if (slot < 0)
+    {
+        return -1;
+    }
+    
+    for (int i = 0; i < aRing->cnt; ++i)
+    {
+        if (aRing->state[i] == CAMERA_SLOT_READY && i != slot)
+        {
+            aRing->state[i] = CAMERA_SLOT_FREE;
+            ++aRing->dropped;
+        }
+    }
+    
+    aRing->state[slot] = CAMERA_SLOT_HELD;
+    return slot;
+}
+
+
+/*
+ * See description with declaration
+ */
+bool camera_ring_release(struct camera_ring_t* aRing,
+                         int                   aSlot)
+{
+    if ((aSlot < 0) || (aSlot >= aRing->cnt) || (aRing->state[aSlot] != CAMERA_SLOT_HELD))
+    {
+        return false;
+    }
+    
+    aRing->state[aSlot] = CAMERA_SLOT_FREE;
+    return true;
+}
@@ -0,0 +1,106 @@
+/**
+ * @brief   Ring of preallocated frame buffers for continuous capture
+ * 
+ * Every buffer (slot) is owned either by the capture, which fills it, or by
+ * the application, which processes it.  Capture fills a free slot, or the
+ * oldest completed one which was not taken yet, so the application gets the
+ * latest frame while capture of next one is already running.
+ * 
+ * Ring only tracks ownership of slots, buffers are managed by the caller.
+ * It does no locking, calls from capture and application have to be
+ * serialized by the caller.
+ * 
+ * @file    camera_ring.h
+ */
+#pragma once
+
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/**
+ * @brief   Maximal number of slots
+ */
+#define CAMERA_RING_MAX 8
+
+
+/**
+ * @brief   Owner of slot
+ */
+enum camera_slot_state_t
+{
+    CAMERA_SLOT_FREE,       /**< @brief Available for capture */
+    CAMERA_SLOT_FILLING,    /**< @brief Being filled by capture */
+    CAMERA_SLOT_READY,      /**< @brief Completed frame not taken yet */
+    CAMERA_SLOT_HELD        /**< @brief Taken by application */
+};
+
+
+/**
+ * @brief   Ring state
+ */
+struct camera_ring_t
+{
+    uint8_t       cnt;                      /**< @brief Number of slots */
+    uint8_t       state[CAMERA_RING_MAX];   /**< @brief Owner of each slot */
+    uint32_t      seq[CAMERA_RING_MAX];     /**< @brief Order of completed frames */
+    uint32_t      next_seq;                 /**< @brief Sequence number of next frame */
+    unsigned long captured;                 /**< @brief Completed frames */
+    unsigned long dropped;                  /**< @brief Completed frames never taken */
+    unsigned long stalls;                   /**< @brief Capture found no slot to fill */
+};
+
+
+/**
+ * @brief   Initializes ring with all slots free
+ * 
+ * @param aRing     Ring
+ * @param aCnt      Number of slots, at most CAMERA_RING_MAX
+ */
+extern void camera_ring_init(struct camera_ring_t* aRing,
+                             unsigned              aCnt);
+
+
+/**
+ * @brief   Gets slot to fill by capture
+ * 
+ * Free slot is preferred, otherwise the oldest ready frame is dropped.
+ * The latest ready frame is kept for application.
+ * 
+ * @return  Slot or -1 when there is no slot to fill
+ */
+extern int camera_ring_begin(struct camera_ring_t* aRing);
+
+
+/**
+ * @brief   Marks filled slot as completed frame
+ */
+extern void camera_ring_commit(struct camera_ring_t* aRing,
+                               int                   aSlot);
+
+
+/**
+ * @brief   Returns slot which could not be filled (bad frame)
+ */
+extern void camera_ring_abort(struct camera_ring_t* aRing,
+                              int                   aSlot);
+
+
+/**
+ * @brief   Takes the latest completed frame
+ * 
+ * Older completed frames are dropped, they would only be stale.
+ * 
+ * @return  Slot held by application or -1 if no frame is completed
+ */
+extern int camera_ring_take(struct camera_ring_t* aRing);
+
+
+/**
+ * @brief   Returns slot held by application
+ * 
+ * @return  false if slot was not held
+ */
+extern bool camera_ring_release(struct camera_ring_t* aRing,
+                                int                   aSlot);
@@ -0,0 +1,474 @@
+/**
+ * @brief   Image processing kernels for frame buffers
+ *
+ * @file    campy_image.c
+ */
+#include "campy_image.h"
+#include <string.h>
+
+
+/*
+ * Lanes of words are mapped to pixels assuming little endian byte order,
+ * big endian targets use per pixel loops only
+ */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define CAMPY_IMAGE_SWAR 1
+#else
+#define CAMPY_IMAGE_SWAR 0
+#endif
+
+
+#define LANES_8     0x00FF00FFu     // Even bytes of word in 16 bit lanes
+#define LANES_BIAS  0x01000100u     // 256 in every 16 bit lane
+#define LANES_SIGN  0x80008000u     // Top bit of every 16 bit lane
+
+
+typedef uint32_t __attribute__((__may_alias__)) _word_t;
+
+
+static inline bool _aligned(const void* aPtr)
+{
+    return 0 == ((uintptr_t)aPtr & 3);
+}
+
+
+static inline uint8_t _gray565(uint8_t aHi,
+                               uint8_t aLo)
+{
+    unsigned p = (unsigned)aHi << 8 | aLo;
+
+    /*
+     * Weights are 77, 150 and 29 (of 256) scaled to 5 and 6 bit channels
+     */
+    return ((p >> 11) * 633 + ((p >> 5) & 0x3F) * 607 + (p & 0x1F) * 239 + 128) >> 8;
+}
+
+
+void campy_image_gray_yuyv(uint8_t*       aDst,
+                           const uint8_t* aSrc,
+                           size_t         aPixels)
+{
+    size_t i = 0;
+
+#if CAMPY_IMAGE_SWAR
+    if (_aligned(aDst) && _aligned(aSrc))
+    {
+        const _word_t* src = (const _word_t*)aSrc;
+        _word_t*       dst = (_word_t*)aDst;
+
+        for (; i + 4 <= aPixels; i += 4, src += 2)
+        {
+            uint32_t lo = src[0] & LANES_8;     // Y0 | Y1 << 16
+            uint32_t hi = src[1] & LANES_8;     // Y2 | Y3 << 16
+
+            *dst++ = ((lo | lo >> 8) & 0xFFFFu) | (hi | hi >> 8) << 16;
+        }
+    }
+#endif
+
+    for (; i < aPixels; ++i)
+    {
+        aDst[i] = aSrc[2 * i];
+    }
+}
+
+
+void campy_image_gray_rgb565(uint8_t*       aDst,
+                             const uint8_t* aSrc,
+                             size_t         aPixels)
+{
+    size_t i = 0;
+
+#if CAMPY_IMAGE_SWAR
+    if (_aligned(aDst) && _aligned(aSrc))
+    {
+        const _word_t* src = (const _word_t*)aSrc;
+        _word_t*       dst = (_word_t*)aDst;
+
+        for (; i + 4 <= aPixels; i += 4)
+        {
+            uint32_t gray[2];
+
+            /*
+             * Two pixels per word, each in its 16 bit lane.  Sum of weighted
+             * channels stays below 65536, so lanes never carry.
+             */
+            for (int j = 0; j < 2; ++j)
+            {
+                uint32_t w = *src++;
+                uint32_t p = ((w & LANES_8) << 8) | ((w >> 8) & LANES_8);
+                uint32_t r = (p >> 11) & 0x001F001Fu;
+                uint32_t g = (p >> 5)  & 0x003F003Fu;
+                uint32_t b = p         & 0x001F001Fu;
+
+                gray[j] = ((r * 633 + g * 607 + b * 239 + 0x00800080u) >> 8) & LANES_8;
+            }
+
+            *dst++ = ((gray[0] | gray[0] >> 8) & 0xFFFFu) | (gray[1] | gray[1] >> 8) << 16;
+        }
+    }
+#endif
+
+    for (; i < aPixels; ++i)
+    {
+        aDst[i] = _gray565(aSrc[2 * i], aSrc[2 * i + 1]);
+    }
+}
+
+
+/*
+ * Column sums of box downscale are kept in 16 bit lanes, 2 words per 4
+ * columns.  First word holds even and second word odd columns, so a row
+ * word is added by 2 masked additions.
+ */
+static inline void _box_add(uint32_t* aAcc,
+                            unsigned  aCol,
+                            uint8_t   aPixel)
+{
+    aAcc[(aCol >> 2) * 2 + (aCol & 1)] += (uint32_t)aPixel << ((aCol & 2) << 3);
+}
+
+
+bool campy_image_downscale_box(uint8_t*       aDst,
+                               unsigned       aDstWidth,
+                               unsigned       aDstHeight,
+                               const uint8_t* aSrc,
+                               unsigned       aSrcWidth,
+                               unsigned       aSrcHeight,
+                               uint32_t*      aScratch)
+{
+    if ((0 == aDstWidth) || (0 == aDstHeight) ||
+        (aDstWidth > aSrcWidth) || (aDstHeight > aSrcHeight) ||
+        ((aSrcHeight + aDstHeight - 1) / aDstHeight > CAMPY_IMAGE_BOX_MAX_ROWS))
+    {
+        return false;
+    }
+
+    const size_t words = CAMPY_IMAGE_BOX_SCRATCH(aSrcWidth);
+    const bool   swar  = CAMPY_IMAGE_SWAR && _aligned(aSrc) && (0 == aSrcWidth % 4);
+
+    for (unsigned y = 0; y < aDstHeight; ++y)
+    {
+        unsigned row0 = (unsigned)((uint64_t)y       * aSrcHeight / aDstHeight);
+        unsigned row1 = (unsigned)((uint64_t)(y + 1) * aSrcHeight / aDstHeight);
+
+        memset(aScratch, 0, words * sizeof(*aScratch));
+
+        for (unsigned row = row0; row < row1; ++row)
+        {
+            const uint8_t* src = aSrc + (size_t)row * aSrcWidth;
+
+            if (swar)
+            {
+                const _word_t* w = (const _word_t*)src;
+
+                for (size_t i = 0; i < words; i += 2, ++w)
+                {
+                    aScratch[i]     += *w & LANES_8;
+                    aScratch[i + 1] += (*w >> 8) & LANES_8;
+                }
+            }
+            else
+            {
+                for (unsigned col = 0; col < aSrcWidth; ++col)
+                {
+                    _box_add(aScratch, col, src[col]);
+                }
+            }
+        }
+
+        /*
+         * Columns are summed 4 at a time in order, output pixel is emitted
+         * once its last column was added
+         */
+        const uint32_t rows = row1 - row0;
+        unsigned       x    = 0;
+        unsigned       col1 = aSrcWidth / aDstWidth;
+        unsigned       cols = col1;
+        uint32_t       sum  = 0;
+
+        for (unsigned col = 0; col < aSrcWidth; col += 4)
+        {
+            const uint32_t* acc = aScratch + col / 2;
+            const uint32_t  v[4] = { acc[0] & 0xFFFFu, acc[1] & 0xFFFFu, acc[0] >> 16, acc[1] >> 16 };
+
+            for (unsigned j = 0; (j < 4) && (col + j < aSrcWidth); ++j)
+            {
+                sum += v[j];
+
+                if (col + j + 1 == col1)
+                {
+                    uint32_t area = cols * rows;
+
+                    *aDst++ = (sum + area / 2) / area;
+                    sum     = 0;
+                    cols    = (unsigned)((uint64_t)(++x + 1) * aSrcWidth / aDstWidth) - col1;
+                    col1   += cols;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+
+bool campy_image_downscale_bilinear(uint8_t*       aDst,
+                                    unsigned       aDstWidth,
+                                    unsigned       aDstHeight,
+                                    const uint8_t* aSrc,
+                                    unsigned       aSrcWidth,
+                                    unsigned       aSrcHeight)
+{
+    if ((0 == aDstWidth) || (0 == aDstHeight) || (0 == aSrcWidth) || (0 == aSrcHeight) ||
+        (aSrcWidth > 0x7FFF) || (aSrcHeight > 0x7FFF))
+    {
+        return false;
+    }
+
+    /*
+     * Source positions are in 16.16 fixed point, weights in 8 bits
+     */
+    const int32_t stepX = ((uint32_t)aSrcWidth << 16)  / aDstWidth;
+    const int32_t stepY = ((uint32_t)aSrcHeight << 16) / aDstHeight;
+
+    for (unsigned y = 0; y < aDstHeight; ++y)
+    {
+        int32_t  sy = (int32_t)y * stepY + stepY / 2 - 0x8000;
+        unsigned iy = sy < 0 ? 0 : sy >> 16;
+        uint32_t fy = sy < 0 ? 0 : (sy >> 8) & 0xFF;
+
+        if (iy >= aSrcHeight - 1)
+        {
+            iy = aSrcHeight - 1;
+            fy = 0;
+        }
+
+        const uint8_t* row0 = aSrc + (size_t)iy * aSrcWidth;
+        const uint8_t* row1 = fy ? row0 + aSrcWidth : row0;
+
+        for (unsigned x = 0; x < aDstWidth; ++x)
+        {
+            int32_t  sx = (int32_t)x * stepX + stepX / 2 - 0x8000;
+            unsigned ix = sx < 0 ? 0 : sx >> 16;
+            uint32_t fx = sx < 0 ? 0 : (sx >> 8) & 0xFF;
+            unsigned nx = ix + 1;
+
+            if (ix >= aSrcWidth - 1)
+            {
+                ix = nx = aSrcWidth - 1;
+                fx = 0;
+            }
+
+            uint32_t top    = row0[ix] * (256 - fx) + row0[nx] * fx;
+            uint32_t bottom = row1[ix] * (256 - fx) + row1[nx] * fx;
+
+            *aDst++ = (top * (256 - fy) + bottom * fy + 0x8000) >> 16;
+        }
+    }
+
+    return true;
+}
+
+
+/*
+ * Returns top bit of every byte set where pixels of `aA` and `aB` differ
+ * by more than threshold.  Differences of even and odd pixels are computed
+ * in 16 bit lanes biased by 256, so they never borrow, then `aK` moves the
+ * threshold to the top bit of the lane.
+ */
+static inline uint32_t _changed(uint32_t aA,
+                                uint32_t aB,
+                                uint32_t aK)
+{
+    uint32_t ae   = aA & LANES_8;
+    uint32_t be   = aB & LANES_8;
+    uint32_t ao   = (aA >> 8) & LANES_8;
+    uint32_t bo   = (aB >> 8) & LANES_8;
+    uint32_t even = (((ae | LANES_BIAS) - be + aK) | ((be | LANES_BIAS) - ae + aK)) & LANES_SIGN;
+    uint32_t odd  = (((ao | LANES_BIAS) - bo + aK) | ((bo | LANES_BIAS) - ao + aK)) & LANES_SIGN;
+
+    return (even >> 8) | odd;
+}
+
+
+size_t campy_image_diff(const uint8_t*             aA,
+                        const uint8_t*             aB,
+                        unsigned                   aWidth,
+                        unsigned                   aHeight,
+                        uint8_t                    aThreshold,
+                        uint8_t*                   aMask,
+                        struct campy_image_bbox_t* aBox)
+{
+    const uint32_t k    = (0x8000u - 257 - aThreshold) * 0x00010001u;
+    const bool     swar = CAMPY_IMAGE_SWAR && (0 == aWidth % 4) &&
+                          _aligned(aA) && _aligned(aB) && (!aMask || _aligned(aMask));
+    size_t         cnt  = 0;
+
+    aBox->x0 = aWidth;
+    aBox->y0 = aHeight;
+    aBox->x1 = 0;
+    aBox->y1 = 0;
+
+    for (unsigned y = 0; y < aHeight; ++y)
+    {
+        const size_t row   = (size_t)y * aWidth;
+        unsigned     first = aWidth;
+        unsigned     last  = 0;
+        unsigned     x     = 0;
+
+        if (swar)
+        {
+            const _word_t* a = (const _word_t*)(aA + row);
+            const _word_t* b = (const _word_t*)(aB + row);
+            _word_t*       m = aMask ? (_word_t*)(aMask + row) : NULL;
+
+            for (; x < aWidth; x += 4)
+            {
+                uint32_t changed = (*a == *b) ? 0 : _changed(*a, *b, k);
+
+                ++a;
+                ++b;
+
+                if (aMask)
+                {
+                    *m++ = (changed >> 7) * 0xFF;
+                }
+
+                if (changed)
+                {
+                    unsigned l = x + __builtin_ctz(changed) / 8;
+                    unsigned r = x + (31 - __builtin_clz(changed)) / 8;
+
+                    cnt   += __builtin_popcount(changed);
+                    first  = l < first ? l : first;
+                    last   = r;
+                }
+            }
+        }
+
+        for (; x < aWidth; ++x)
+        {
+            uint8_t a = aA[row + x];
+            uint8_t b = aB[row + x];
+            bool    c = (a > b ? a - b : b - a) > aThreshold;
+
+            if (aMask)
+            {
+                aMask[row + x] = c ? 0xFF : 0;
+            }
+
+            if (c)
+            {
+                ++cnt;
+                first = x < first ? x : first;
+                last  = x;
+            }
+        }
+
+        if (first < aWidth)
+        {
+            aBox->x0 = first < aBox->x0 ? first : aBox->x0;
+            aBox->x1 = last  > aBox->x1 ? last  : aBox->x1;
+            aBox->y0 = y     < aBox->y0 ? y     : aBox->y0;
+            aBox->y1 = y;
+        }
+    }
+
+    return cnt;
+}
+
+
+void campy_image_histogram(uint32_t       aHist[256],
+                           const uint8_t* aSrc,
+                           size_t         aPixels)
+{
+    size_t i = 0;
+
+    memset(aHist, 0, 256 * sizeof(*aHist));
+
+#if CAMPY_IMAGE_SWAR
+    if (_aligned(aSrc))
+    {
+        /*
+         * Every byte of word counts into its own table, so flat areas do
+         * not increment the same counter back to back.  Tables are 16 bit
+         * to stay small on stack and are summed before they can overflow.
+         */
+        uint16_t       part[4][256];
+        const _word_t* src = (const _word_t*)aSrc;
+
+        while (i + 4 <= aPixels)
+        {
+            size_t words = (aPixels - i) / 4;
+
+            if (words > 0xFFFF)
+            {
+                words = 0xFFFF;
+            }
+
+            memset(part, 0, sizeof(part));
+
+            for (size_t n = 0; n < words; ++n)
+            {
+                uint32_t w = *src++;
+
+                ++part[0][w & 0xFF];
+                ++part[1][(w >> 8) & 0xFF];
+                ++part[2][(w >> 16) & 0xFF];
+                ++part[3][w >> 24];
+            }
+
+            for (int v = 0; v < 256; ++v)
+            {
+                aHist[v] += (uint32_t)part[0][v] + part[1][v] + part[2][v] + part[3][v];
+            }
+
+            i += words * 4;
+        }
+    }
+#endif
+
+    for (; i < aPixels; ++i)
+    {
+        ++aHist[aSrc[i]];
+    }
+}
+
+
+void campy_image_integral(uint32_t*      aDst,
+                          const uint8_t* aSrc,
+                          unsigned       aWidth,
+                          unsigned       aHeight)
+{
+    /*
+     * Each output depends on the previous one, so it stays per pixel
+     */
+    const uint32_t* above = NULL;
+
+    for (unsigned y = 0; y < aHeight; ++y)
+    {
+        uint32_t sum = 0;
+
+        if (above)
+        {
+            for (unsigned x = 0; x < aWidth; ++x)
+            {
+                sum     += aSrc[x];
+                aDst[x]  = sum + above[x];
+            }
+        }
+        else
+        {
+            for (unsigned x = 0; x < aWidth; ++x)
+            {
+                sum     += aSrc[x];
+                aDst[x]  = sum;
+            }
+        }
+
+        above  = aDst;
+        aDst  += aWidth;
+        aSrc  += aWidth;
+    }
+}
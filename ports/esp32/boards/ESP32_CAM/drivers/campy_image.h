@@ -0,0 +1,170 @@
+/**
+ * @brief   Image processing kernels for frame buffers
+ *
+ * Kernels work on plain pixel buffers so they serve frame buffers of the
+ * camera as well as any other buffer.  Grayscale images are 8 bits per
+ * pixel, rows follow each other without padding.
+ *
+ * Inner loops process 4 pixels per 32 bit word (SWAR) when buffers are word
+ * aligned and rows are a multiple of 4 pixels, which is the case of all
+ * camera frame sizes.  Other buffers fall back to the same computation done
+ * per pixel, so results never depend on alignment.
+ *
+ * Kernels have no dependencies on MicroPython, so they are built into the
+ * unix port as well.
+ *
+ * @file    campy_image.h
+ */
+#pragma once
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @brief   Words of scratch needed by campy_image_downscale_box
+ */
+#define CAMPY_IMAGE_BOX_SCRATCH(_srcWidth_) (((_srcWidth_) + 3) / 4 * 2)
+
+
+/**
+ * @brief   Maximal number of source rows summed into one output row by box
+ *          downscale
+ */
+#define CAMPY_IMAGE_BOX_MAX_ROWS 257
+
+
+/**
+ * @brief   Changed area found by campy_image_diff
+ */
+struct campy_image_bbox_t
+{
+    unsigned x0;    /**< @brief Left column */
+    unsigned y0;    /**< @brief Top row */
+    unsigned x1;    /**< @brief Right column (inclusive) */
+    unsigned y1;    /**< @brief Bottom row (inclusive) */
+};
+
+
+/**
+ * @brief   Converts YUYV (YUV422) pixels to grayscale
+ *
+ * Gray level is the luma (Y) of every pixel.
+ *
+ * @param aDst      Grayscale output, `aPixels` bytes
+ * @param aSrc      YUYV input, `2 * aPixels` bytes
+ * @param aPixels   Number of pixels
+ */
+void campy_image_gray_yuyv(uint8_t*       aDst,
+                           const uint8_t* aSrc,
+                           size_t         aPixels);
+
+
+/**
+ * @brief   Converts RGB565 pixels to grayscale
+ *
+ * Pixels are big endian, as the camera sends them.  Gray level is
+ * `0.30 R + 0.59 G + 0.11 B` computed in fixed point.
+ *
+ * @param aDst      Grayscale output, `aPixels` bytes
+ * @param aSrc      RGB565 input, `2 * aPixels` bytes
+ * @param aPixels   Number of pixels
+ */
+void campy_image_gray_rgb565(uint8_t*       aDst,
+                             const uint8_t* aSrc,
+                             size_t         aPixels);
+
+
+/**
+ * @brief   Downscales grayscale image by averaging boxes of source pixels
+ *
+ * Every output pixel is the rounded mean of the source pixels it covers,
+ * ratio between sizes does not need to be integral.
+ *
+ * @param aDst          Output, `aDstWidth * aDstHeight` bytes
+ * @param aSrc          Input, `aSrcWidth * aSrcHeight` bytes
+ * @param aScratch      `CAMPY_IMAGE_BOX_SCRATCH(aSrcWidth)` words of scratch
+ *
+ * @return  false if sizes are zero, output is larger than input, or more
+ *          than CAMPY_IMAGE_BOX_MAX_ROWS rows fall into one output row
+ */
+bool campy_image_downscale_box(uint8_t*       aDst,
+                               unsigned       aDstWidth,
+                               unsigned       aDstHeight,
+                               const uint8_t* aSrc,
+                               unsigned       aSrcWidth,
+                               unsigned       aSrcHeight,
+                               uint32_t*      aScratch);
+
+
+/**
+ * @brief   Scales grayscale image with bilinear interpolation
+ *
+ * Pixel centers are aligned, so it both downscales (without averaging
+ * pixels between samples, use box for large ratios) and upscales.
+ *
+ * @param aDst      Output, `aDstWidth * aDstHeight` bytes
+ * @param aSrc      Input, `aSrcWidth * aSrcHeight` bytes
+ *
+ * @return  false if any size is zero or source is larger than 32767
+ */
+bool campy_image_downscale_bilinear(uint8_t*       aDst,
+                                    unsigned       aDstWidth,
+                                    unsigned       aDstHeight,
+                                    const uint8_t* aSrc,
+                                    unsigned       aSrcWidth,
+                                    unsigned       aSrcHeight);
+
+
+/**
+ * @brief   Compares two grayscale images
+ *
+ * Pixel is changed when its levels in both images differ by more than
+ * `aThreshold`.
+ *
+ * @param aA            First image, `aWidth * aHeight` bytes
+ * @param aB            Second image, `aWidth * aHeight` bytes
+ * @param aThreshold    Allowed difference
+ * @param aMask         Receives 255 for changed and 0 for other pixels,
+ *                      `aWidth * aHeight` bytes, can be NULL
+ * @param aBox          Receives bounding box of changed pixels, valid only
+ *                      if some pixel changed
+ *
+ * @return  Number of changed pixels
+ */
+size_t campy_image_diff(const uint8_t*             aA,
+                        const uint8_t*             aB,
+                        unsigned                   aWidth,
+                        unsigned                   aHeight,
+                        uint8_t                    aThreshold,
+                        uint8_t*                   aMask,
+                        struct campy_image_bbox_t* aBox);
+
+
+/**
+ * @brief   Counts pixels of every gray level
+ *
+ * @param aHist     Receives 256 counts
+ * @param aSrc      Grayscale pixels
+ * @param aPixels   Number of pixels
+ */
+void campy_image_histogram(uint32_t       aHist[256],
+                           const uint8_t* aSrc,
+                           size_t         aPixels);
+
+
+/**
+ * @brief   Computes integral image (summed area table)
+ *
+ * Every output value is the sum of source pixels above and left of it,
+ * including the pixel itself, so sum of any rectangle takes 4 lookups.
+ *
+ * @param aDst      Output, `aWidth * aHeight` words
+ * @param aSrc      Grayscale input, `aWidth * aHeight` bytes
+ */
+void campy_image_integral(uint32_t*      aDst,
+                          const uint8_t* aSrc,
+                          unsigned       aWidth,
+                          unsigned       aHeight);
@@ -0,0 +1,121 @@
+/**
+ * @brief   Chunked scanner for end of JPEG frame
+ *
+ * @file    jpeg_eoi.c
+ */
+#include "jpeg_eoi.h"
+
+
+#define BYTES_LOW   0x01010101u     // 1 in every byte
+#define BYTES_HIGH  0x80808080u     // Top bit of every byte
+
+
+typedef uint32_t __attribute__((__may_alias__)) _word_t;
+
+
+/*
+ * Finds the first 0xFF byte in [`aPtr`, `aEnd`), or returns `aEnd`.  Word
+ * at a time, as 0xFF is rare in compressed data and absent in padding.
+ */
+static const uint8_t* _find_ff(const uint8_t* aPtr,
+                               const uint8_t* aEnd)
+{
+    while ((aPtr < aEnd) && ((uintptr_t)aPtr & 3))
+    {
+        if (0xFF == *aPtr)
+        {
+            return aPtr;
+        }
+        ++aPtr;
+    }
+
+    for (; aPtr + 4 <= aEnd; aPtr += 4)
+    {
+        /*
+         * Zero byte test on inverted word, exact for any byte order
+         */
+        uint32_t w = *(const _word_t*)aPtr;
+
+        if ((~w - BYTES_LOW) & w & BYTES_HIGH)
+        {
+            break;
+        }
+    }
+
+    while ((aPtr < aEnd) && (0xFF != *aPtr))
+    {
+        ++aPtr;
+    }
+
+    return aPtr;
+}
+
+
+/*
+ * See description with declaration
+ */
+void jpeg_eoi_reset(struct jpeg_eoi_t* aScanner)
+{
+    aScanner->pos     = 0;
+    aScanner->end     = 0;
+    aScanner->matched = 0;
+}
+
+
+/*
+ * See description with declaration
+ */
+bool jpeg_eoi_scan(struct jpeg_eoi_t* aScanner,
+                   const uint8_t*     aChunk,
+                   size_t             aLen)
+{
+    static const uint8_t pattern[4] = { 0xFF, 0xD9, 0x00, 0x00 };
+
+    if (aScanner->end)
+    {
+        return true;
+    }
+
+    const uint8_t* ptr     = aChunk;
+    const uint8_t* end     = aChunk + aLen;
+    unsigned       matched = aScanner->matched;
+
+    while (ptr < end)
+    {
+        if (0 == matched)
+        {
+            ptr = _find_ff(ptr, end);
+
+            if (ptr == end)
+            {
+                break;
+            }
+        }
+
+        uint8_t b = *ptr++;
+
+        if (b == pattern[matched])
+        {
+            if (4 == ++matched)
+            {
+                /*
+                 * Frame ends after D9, the two zeros are padding
+                 */
+                aScanner->end     = aScanner->pos + (ptr - aChunk) - 2;
+                aScanner->matched = 0;
+                return true;
+            }
+        }
+        else
+        {
+            /*
+             * No prefix of the pattern ends inside it, only 0xFF restarts
+             */
+            matched = (0xFF == b) ? 1 : 0;
+        }
+    }
+
+    aScanner->pos    += aLen;
+    aScanner->matched = matched;
+    return false;
+}
@@ -0,0 +1,55 @@
+/**
+ * @brief   Chunked scanner for end of JPEG frame
+ *
+ * Sensor in JPEG mode keeps sending zeros after the EOI marker until the
+ * frame ends, so most of a large frame buffer is padding.  Scanner is fed
+ * with every chunk right after the DMA filter task wrote it and finds the
+ * EOI marker followed by padding (`FF D9 00 00`), also when the sequence
+ * is split across chunks, so the length of JPEG data is known when the
+ * frame completes and the padding needs neither copying nor scanning.
+ *
+ * The first EOI is taken, marker can't appear earlier in JPEG data as
+ * 0xFF is always stuffed with 0x00 in entropy coded segments.
+ *
+ * @file    jpeg_eoi.h
+ */
+#pragma once
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/**
+ * @brief   Scanner state, carried between chunks of one frame
+ */
+struct jpeg_eoi_t
+{
+    size_t  pos;        /**< @brief Offset of next chunk in frame */
+    size_t  end;        /**< @brief Offset just after EOI marker, 0 until found */
+    uint8_t matched;    /**< @brief Bytes of `FF D9 00 00` matched at end of last chunk */
+};
+
+
+/**
+ * @brief   Prepares scanner for new frame
+ */
+extern void jpeg_eoi_reset(struct jpeg_eoi_t* aScanner);
+
+
+/**
+ * @brief   Scans next chunk of frame
+ *
+ * Chunks have to be passed in order and without gaps.  Nothing is scanned
+ * once the marker was found.
+ *
+ * @param aScanner  Scanner
+ * @param aChunk    Chunk data
+ * @param aLen      Chunk length in bytes
+ *
+ * @return  true if marker was found, its end is in `aScanner->end`
+ */
+extern bool jpeg_eoi_scan(struct jpeg_eoi_t* aScanner,
+                          const uint8_t*     aChunk,
+                          size_t             aLen);
@@ -0,0 +1,13 @@
+# Image processing and MJPEG streaming of campy as user C module, so they
+# can be built into other ports (the ESP32 build picks up all sources of
+# this directory on its own).  For the unix port:
+#
+#     make -C ports/unix USER_C_MODULES=../esp32/boards/ESP32_CAM
+
+CAMPY_IMAGE_DIR := $(USERMOD_DIR)
+
+SRC_USERMOD += $(CAMPY_IMAGE_DIR)/campy_image.c
+SRC_USERMOD += $(CAMPY_IMAGE_DIR)/modcampy_image.c
+SRC_USERMOD += $(CAMPY_IMAGE_DIR)/modcampy_mjpeg.c
+
+CFLAGS_USERMOD += -I$(CAMPY_IMAGE_DIR)
@@ -243,7 +243,7 @@ STATIC mp_obj_t MP_NAMESPACE3(campy__FrameBuffer, data, __load__)(mp_obj_t aSelf
 {
     struct campy_FrameBuffer* self  = MP_OBJ_TO_PTR(aSelf);
     
-    if (NULL == self->buf)
+    if (!esp_camera_fb_valid(self))
     {
         mp_raise_ValueError(MP_ERROR_TEXT("Frame buffer invalidated (called reducto)"));
     }
@@ -287,7 +287,17 @@ MP_FN_1(campy__FrameBuffer, reducto, aSelf)
 {
     struct campy_FrameBuffer* self  = MP_OBJ_TO_PTR(aSelf);
     
-    if (self->len != 0)
+    if (self->slot >= 0)
+    {
+        /*
+         * Frame from continuous capture, its buffer returns to camera
+         */
+        esp_camera_fb_release(self);
+        self->len    = 0;
+        self->width  = 0;
+        self->height = 0;
+    }
+    else if (self->len != 0)
     {
         m_free(self->buf);
         self->buf    = NULL;
@@ -301,6 +311,24 @@ MP_FN_1(campy__FrameBuffer, reducto, aSelf)
 
 
 
+/*
+ * Frames of continuous capture are returned to camera by `release` (alias
+ * of `reducto`), or once they are collected
+ */
+MP_FN_1(campy__FrameBuffer, __del__, aSelf)
+{
+    struct campy_FrameBuffer* self  = MP_OBJ_TO_PTR(aSelf);
+    
+    if (self->slot >= 0)
+    {
+        esp_camera_fb_release(self);
+    }
+    
+    return mp_const_none;
+}
+
+
+
 STATIC void MP_NAMESPACE3(campy, FrameBuffer, __attr__)(mp_obj_t  aSelf,
                                                         qstr      aAttribute,
                                                         mp_obj_t* aDestination)
@@ -309,9 +337,15 @@ STATIC void MP_NAMESPACE3(campy, FrameBuffer, __attr__)(mp_obj_t  aSelf,
     {
         MP_ATTR_PROPERTY( campy, FrameBuffer, data    );
         MP_ATTR_METHOD(   campy, FrameBuffer, reducto );
+        MP_ATTR_METHOD(   campy, FrameBuffer, __del__ );
         MP_ATTR_PROPERTY( campy, FrameBuffer, width   );
         MP_ATTR_PROPERTY( campy, FrameBuffer, height  );
         MP_ATTR_PROPERTY( campy, FrameBuffer, format  );
+        
+        case MP_QSTR_release:
+            aDestination[0] = (mp_obj_t)&MP_NAMESPACE3(campy__FrameBuffer, reducto, __load__);
+            aDestination[1] = aSelf;
+            break;
     }
 }
 
@@ -716,6 +750,68 @@ MP_FN_1(campy__Camera, capture, aSelf)
 
 
 
+/*
+ * stream(count) starts continuous capture into `count` frame buffers,
+ * stream(0) stops it
+ */
+MP_FN_2(campy__Camera, stream, aSelf, aCount)
+{
+    _get_camera(aSelf);
+    
+    mp_int_t count = mp_obj_get_int(aCount);
+    
+    if (0 == count)
+    {
+        esp_camera_stream_stop();
+    }
+    else
+    {
+        esp_camera_stream_start(count);
+    }
+    
+    return mp_const_none;
+}
+
+
+
+/*
+ * latest([timeout_ms]) returns the latest frame of continuous capture or
+ * None on timeout.  Frame has to be returned by its release().
+ */
+MP_FN_VAR(campy__Camera, latest, 1, 2)
+{
+    _get_camera(aArgs[0]);
+    
+    int                       timeout = aArgsCnt > 1 ? mp_obj_get_int(aArgs[1]) : 4000;
+    struct campy_FrameBuffer* fb      = esp_camera_fb_latest(timeout);
+    
+    return fb ? MP_OBJ_FROM_PTR(fb) : mp_const_none;
+}
+
+
+
+/*
+ * stream_info() returns (captured, dropped, stalled) frames
+ */
+MP_FN_1(campy__Camera, stream_info, aSelf)
+{
+    _get_camera(aSelf);
+    
+    unsigned long info[3];
+    esp_camera_stream_info(info);
+    
+    mp_obj_t tuple[] =
+    {
+        mp_obj_new_int_from_uint(info[0]),
+        mp_obj_new_int_from_uint(info[1]),
+        mp_obj_new_int_from_uint(info[2]),
+    };
+    
+    return mp_obj_new_tuple(3, tuple);
+}
+
+
+
 STATIC void MP_NAMESPACE3(campy, Camera, __attr__)(mp_obj_t  aSelf,
                                                    qstr      aAttribute,
                                                    mp_obj_t* aDestination)
@@ -723,6 +819,9 @@ STATIC void MP_NAMESPACE3(campy, Camera, __attr__)(mp_obj_t  aSelf,
     MP_LOAD
     {
         MP_ATTR_METHOD(       campy, Camera, capture      )
+        MP_ATTR_METHOD(       campy, Camera, stream       )
+        MP_ATTR_METHOD(       campy, Camera, latest       )
+        MP_ATTR_METHOD(       campy, Camera, stream_info  )
         MP_ATTR_PROPERTY(     campy, Camera, model        )
         MP_ATTR_PROPERTY(     campy, Camera, jpeg_quality )
         MP_ATTR_PROPERTY(     campy, Camera, frame_size   )
@@ -37,6 +37,8 @@ struct campy_FrameBuffer
     size_t size;
     uint8_t ref;
     uint8_t bad;
+    int8_t         slot;        /*!< Ring slot owning the pixel data, -1 if data are in GC heap */
+    uint16_t       gen;         /*!< Stream the slot belongs to */
     struct campy_FrameBuffer* next;
 };
 
@@ -126,3 +128,56 @@ extern const mp_obj_type_t MP_NAMESPACE2(campy, Camera);
  * @return pointer to the frame buffer
  */
 struct campy_FrameBuffer* esp_camera_fb_get();
+
+
+/**
+ * @brief   Starts continuous capture
+ * 
+ * Allocates `aCount` frame buffers outside of GC heap and keeps filling
+ * them with frames.  Frames are then taken by esp_camera_fb_latest and
+ * returned by esp_camera_fb_release.
+ * 
+ * @param aCount    Number of frame buffers
+ */
+void esp_camera_stream_start(size_t aCount);
+
+
+/**
+ * @brief   Stops continuous capture and frees its frame buffers
+ */
+void esp_camera_stream_stop();
+
+
+/**
+ * @brief   Takes the latest captured frame
+ * 
+ * Frame stays owned by application until it is returned by
+ * esp_camera_fb_release, frames captured before it are dropped.
+ * 
+ * @param aTimeoutMs    Time to wait for a frame
+ * 
+ * @return  Frame or NULL on timeout
+ */
+struct campy_FrameBuffer* esp_camera_fb_latest(int aTimeoutMs);
+
+
+/**
+ * @brief   Returns frame taken by esp_camera_fb_latest
+ * 
+ * Pixel data of the frame are invalid since then.
+ */
+void esp_camera_fb_release(struct campy_FrameBuffer* aFb);
+
+
+/**
+ * @brief   Checks that pixel data of frame are still valid
+ */
+bool esp_camera_fb_valid(const struct campy_FrameBuffer* aFb);
+
+
+/**
+ * @brief   Gets statistics of continuous capture
+ * 
+ * @param aInfo     Receives captured, dropped and stalled frames
+ */
+void esp_camera_stream_info(unsigned long aInfo[3]);
@@ -0,0 +1,390 @@
+/**
+ * @brief   Python bindings of image processing kernels
+ *
+ * Module `campy_image` runs kernels of campy_image.c on frame buffers of
+ * the camera or on any object supporting buffer protocol (bytearray,
+ * memoryview, array, ...).  Grayscale images are given by buffer and width,
+ * height follows from length.  Frame buffers carry their own size and
+ * format.
+ *
+ * Module has no dependencies on the camera driver, apart from accepting
+ * frame buffers, so it is also built into the unix port (as user C module,
+ * see micropython.mk).
+ *
+ * @file    modcampy_image.c
+ */
+#include "py/obj.h"
+#include "py/runtime.h"
+
+#include "campy_image.h"
+#include "mp_namespace.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_camera.h"
+#include "modcampy.h"
+#endif
+
+#include <string.h>
+
+
+/**
+ * @brief   Pixel formats accepted by kernels
+ */
+enum _format_t
+{
+    FORMAT_GRAY,
+    FORMAT_YUYV,
+    FORMAT_RGB565
+};
+
+
+/**
+ * @brief   Image taken from python object
+ */
+struct _image_t
+{
+    uint8_t*       buf;     /**< @brief Pixel data */
+    size_t         len;     /**< @brief Length of pixel data in bytes */
+    unsigned       width;   /**< @brief Width in pixels */
+    unsigned       height;  /**< @brief Height in pixels */
+    enum _format_t format;  /**< @brief Pixel format */
+};
+
+
+
+STATIC enum _format_t _qstr2format(mp_obj_t aStr)
+{
+    switch (mp_obj_str_get_qstr(aStr))
+    {
+        case MP_QSTR_GRAYSCALE: return FORMAT_GRAY;
+        case MP_QSTR_YUV422:    return FORMAT_YUYV;
+        case MP_QSTR_RGB565:    return FORMAT_RGB565;
+        default: mp_raise_ValueError(MP_ERROR_TEXT("Unsupported pixel format"));
+    }
+}
+
+
+
+/*
+ * Gets image from frame buffer, or from buffer of width `aWidth` (which
+ * may be None for frame buffers) and format `aFormat`
+ */
+STATIC void _get_image(mp_obj_t         aObj,
+                       mp_obj_t         aWidth,
+                       enum _format_t   aFormat,
+                       int              aFlags,
+                       struct _image_t* aImage)
+{
+#ifdef ESP_PLATFORM
+    if (mp_obj_is_type(aObj, &MP_NAMESPACE2(campy, FrameBuffer)))
+    {
+        struct campy_FrameBuffer* fb = MP_OBJ_TO_PTR(aObj);
+
+        if (!esp_camera_fb_valid(fb))
+        {
+            mp_raise_ValueError(MP_ERROR_TEXT("Frame buffer invalidated (called reducto)"));
+        }
+
+        switch (fb->format)
+        {
+            case PIXFORMAT_GRAYSCALE: aImage->format = FORMAT_GRAY;   break;
+            case PIXFORMAT_YUV422:    aImage->format = FORMAT_YUYV;   break;
+            case PIXFORMAT_RGB565:    aImage->format = FORMAT_RGB565; break;
+            default: mp_raise_ValueError(MP_ERROR_TEXT("Unsupported pixel format"));
+        }
+
+        aImage->buf    = fb->buf;
+        aImage->len    = fb->len;
+        aImage->width  = fb->width;
+        aImage->height = fb->height;
+        return;
+    }
+#endif
+
+    mp_buffer_info_t info;
+    mp_get_buffer_raise(aObj, &info, aFlags);
+
+    mp_int_t width = (mp_const_none == aWidth) ? 0 : mp_obj_get_int(aWidth);
+
+    if (width <= 0)
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("Invalid width"));
+    }
+
+    size_t bpp = (FORMAT_GRAY == aFormat) ? 1 : 2;
+
+    aImage->buf    = info.buf;
+    aImage->len    = info.len;
+    aImage->width  = width;
+    aImage->height = info.len / bpp / width;
+    aImage->format = aFormat;
+}
+
+
+
+STATIC void _get_gray(mp_obj_t         aObj,
+                      mp_obj_t         aWidth,
+                      int              aFlags,
+                      struct _image_t* aImage)
+{
+    _get_image(aObj, aWidth, FORMAT_GRAY, aFlags, aImage);
+
+    if (FORMAT_GRAY != aImage->format)
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("Grayscale image expected"));
+    }
+
+    if (0 == aImage->height)
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("Image is smaller than one row"));
+    }
+}
+
+
+
+/*
+ * Gets buffer of at least `aWords` 32 bit words to store into.  ESP32 faults
+ * on unaligned word stores, so buffers such as bytearray slices are refused.
+ */
+STATIC uint32_t* _get_words(mp_obj_t            aObj,
+                            size_t              aWords,
+                            mp_rom_error_text_t aTooSmall)
+{
+    mp_buffer_info_t info;
+    mp_get_buffer_raise(aObj, &info, MP_BUFFER_WRITE);
+
+    if (info.len / sizeof(uint32_t) < aWords)
+    {
+        mp_raise_ValueError(aTooSmall);
+    }
+
+    if (0 != (uintptr_t)info.buf % sizeof(uint32_t))
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("Destination is not word aligned"));
+    }
+
+    return info.buf;
+}
+
+
+
+/**
+ * gray(dst, src[, format='YUV422']) -> dst
+ *
+ * Converts pixels of `src` to grayscale into `dst`.  Frame buffers bring
+ * their own format, plain buffers hold `len(dst)` pixels.
+ */
+MP_FN_VAR(campy_image, gray, 2, 3)
+{
+    mp_buffer_info_t dst;
+    struct _image_t  src;
+
+    mp_get_buffer_raise(aArgs[0], &dst, MP_BUFFER_WRITE);
+    _get_image(aArgs[1],
+               MP_OBJ_NEW_SMALL_INT(dst.len ? dst.len : 1),
+               (aArgsCnt > 2) ? _qstr2format(aArgs[2]) : FORMAT_YUYV,
+               MP_BUFFER_READ,
+               &src);
+
+    size_t pixels = (size_t)src.width * src.height;
+
+    if (0 == pixels)
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("Source is too small"));
+    }
+
+    if (dst.len < pixels)
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("Destination is too small"));
+    }
+
+    switch (src.format)
+    {
+        case FORMAT_GRAY:   memmove(dst.buf, src.buf, pixels);                break;
+        case FORMAT_YUYV:   campy_image_gray_yuyv(dst.buf, src.buf, pixels);   break;
+        case FORMAT_RGB565: campy_image_gray_rgb565(dst.buf, src.buf, pixels); break;
+    }
+
+    return aArgs[0];
+}
+
+
+
+/**
+ * downscale(dst, dst_width, src, src_width[, bilinear=False]) -> dst
+ *
+ * Scales grayscale `src` to size of `dst`, averaging source pixels (box
+ * filter) or interpolating them.
+ */
+MP_FN_VAR(campy_image, downscale, 4, 5)
+{
+    struct _image_t dst;
+    struct _image_t src;
+
+    _get_gray(aArgs[0], aArgs[1], MP_BUFFER_WRITE, &dst);
+    _get_gray(aArgs[2], aArgs[3], MP_BUFFER_READ,  &src);
+
+    bool ok;
+
+    if ((aArgsCnt > 4) && mp_obj_is_true(aArgs[4]))
+    {
+        ok = campy_image_downscale_bilinear(dst.buf, dst.width, dst.height,
+                                            src.buf, src.width, src.height);
+    }
+    else
+    {
+        size_t    words   = CAMPY_IMAGE_BOX_SCRATCH(src.width);
+        uint32_t* scratch = m_new(uint32_t, words);
+
+        ok = campy_image_downscale_box(dst.buf, dst.width, dst.height,
+                                       src.buf, src.width, src.height,
+                                       scratch);
+        m_del(uint32_t, scratch, words);
+    }
+
+    if (!ok)
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("Unsupported scale"));
+    }
+
+    return aArgs[0];
+}
+
+
+
+/**
+ * diff(a, b, width[, threshold=16[, mask]]) -> (count, (x0, y0, x1, y1))
+ *
+ * Counts pixels of grayscale images `a` and `b` differing by more than
+ * `threshold` and returns them with their bounding box (inclusive), or
+ * with None when there are none.  Changed pixels are set to 255 in `mask`.
+ */
+MP_FN_VAR(campy_image, diff, 3, 5)
+{
+    struct _image_t a;
+    struct _image_t b;
+    struct _image_t mask = { 0 };
+
+    _get_gray(aArgs[0], aArgs[2], MP_BUFFER_READ, &a);
+    _get_gray(aArgs[1], aArgs[2], MP_BUFFER_READ, &b);
+
+    mp_int_t threshold = (aArgsCnt > 3) ? mp_obj_get_int(aArgs[3]) : 16;
+
+    if (threshold < 0 || threshold > 255)
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("Threshold out of range"));
+    }
+
+    if ((aArgsCnt > 4) && (mp_const_none != aArgs[4]))
+    {
+        _get_gray(aArgs[4], aArgs[2], MP_BUFFER_WRITE, &mask);
+    }
+
+    if ((a.width != b.width) || (a.height != b.height) ||
+        (mask.buf && ((mask.width != a.width) || (mask.height < a.height))))
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("Images differ in size"));
+    }
+
+    struct campy_image_bbox_t box;
+    size_t                    cnt = campy_image_diff(a.buf, b.buf, a.width, a.height,
+                                                     threshold, mask.buf, &box);
+    mp_obj_t                  ret[2];
+
+    ret[0] = mp_obj_new_int_from_uint(cnt);
+    ret[1] = mp_const_none;
+
+    if (cnt)
+    {
+        mp_obj_t coords[4] =
+        {
+            MP_OBJ_NEW_SMALL_INT(box.x0),
+            MP_OBJ_NEW_SMALL_INT(box.y0),
+            MP_OBJ_NEW_SMALL_INT(box.x1),
+            MP_OBJ_NEW_SMALL_INT(box.y1),
+        };
+
+        ret[1] = mp_obj_new_tuple(4, coords);
+    }
+
+    return mp_obj_new_tuple(2, ret);
+}
+
+
+
+/**
+ * histogram(src[, hist]) -> hist
+ *
+ * Counts pixels of every gray level of grayscale `src` (all bytes of plain
+ * buffers).  Counts are stored into `hist`, a word aligned buffer of 256
+ * 32 bit words such as array('I', ...), or returned as a new list.
+ */
+MP_FN_VAR(campy_image, histogram, 1, 2)
+{
+    struct _image_t src;
+
+    _get_image(aArgs[0], MP_OBJ_NEW_SMALL_INT(1), FORMAT_GRAY, MP_BUFFER_READ, &src);
+
+    if (FORMAT_GRAY != src.format)
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("Grayscale image expected"));
+    }
+
+    if (aArgsCnt > 1)
+    {
+        uint32_t* hist = _get_words(aArgs[1], 256, MP_ERROR_TEXT("Histogram needs 256 words"));
+
+        campy_image_histogram(hist, src.buf, (size_t)src.width * src.height);
+        return aArgs[1];
+    }
+
+    uint32_t hist[256];
+    mp_obj_t items[256];
+
+    campy_image_histogram(hist, src.buf, (size_t)src.width * src.height);
+
+    for (int i = 0; i < 256; ++i)
+    {
+        items[i] = mp_obj_new_int_from_uint(hist[i]);
+    }
+
+    return mp_obj_new_list(256, items);
+}
+
+
+
+/**
+ * integral(dst, src, width) -> dst
+ *
+ * Computes integral image of grayscale `src` into `dst`, a word aligned
+ * buffer of 32 bit words such as array('I', ...).
+ */
+MP_FN_VAR(campy_image, integral, 3, 3)
+{
+    struct _image_t src;
+
+    _get_gray(aArgs[1], aArgs[2], MP_BUFFER_READ, &src);
+
+    uint32_t* dst = _get_words(aArgs[0],
+                               (size_t)src.width * src.height,
+                               MP_ERROR_TEXT("Destination is too small"));
+
+    campy_image_integral(dst, src.buf, src.width, src.height);
+    return aArgs[0];
+}
+
+
+
+/*
+ *******************************************************************************
+ * campy_image module
+ *******************************************************************************
+ */
+MP_MODULE_BEGIN( campy_image            )
+MP_MEMBER_FN(    campy_image, gray      )
+MP_MEMBER_FN(    campy_image, downscale )
+MP_MEMBER_FN(    campy_image, diff      )
+MP_MEMBER_FN(    campy_image, histogram )
+MP_MEMBER_FN(    campy_image, integral  )
+MP_MODULE_END(   campy_image            )
+MP_REGISTER_MODULE(MP_QSTR_campy_image, mp_module_campy_image, 1);
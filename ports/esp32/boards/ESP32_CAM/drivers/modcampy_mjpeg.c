@@ -0,0 +1,522 @@
+/**
+ * @brief   MJPEG streaming of frame buffers to sockets
+ *
+ * `campy_mjpeg.Streamer` writes JPEG frames as parts of a
+ * multipart/x-mixed-replace HTTP response, which browsers show as video.
+ * Frames are written straight from their buffers (camera frame buffers or
+ * any buffer) through the stream protocol of the socket, without copying
+ * them into python objects.
+ *
+ * Writes never block on non-blocking sockets.  `pump` writes chunks until
+ * the socket would block and tells whether anything is left, so a uasyncio
+ * task just waits for the socket to become writable in between:
+ *
+ *      st = campy_mjpeg.Streamer(sock)
+ *      while True:
+ *          frame = cam.latest()
+ *          if frame:
+ *              st.send(frame)
+ *          while not st.pump():
+ *              yield uasyncio.core._io_queue.queue_write(sock)
+ *
+ * Frame being written is always completed, but only the newest of frames
+ * sent meanwhile waits for it; older ones are dropped, so a slow client
+ * gets fewer but current frames.  Streamer owns frames given to `send`,
+ * frames of continuous capture are returned to camera once written or
+ * dropped.
+ *
+ * Data of the frame is looked up again for every write, as a frame buffer
+ * can be invalidated and a buffer resized between pumps.  Such frame is
+ * dropped; if its headers were already written, the rest of it is sent as
+ * zeros, so the client only gets one broken frame.
+ *
+ * @file    modcampy_mjpeg.c
+ */
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "py/stream.h"
+
+#include "mp_namespace.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_camera.h"
+#include "modcampy.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+
+#define MJPEG_BOUNDARY_MAX  40
+#define MJPEG_CHUNK         4096
+
+
+/**
+ * @brief   Sent for rest of dropped frame
+ */
+STATIC const uint8_t _zeros[64];
+
+
+/**
+ * @brief   Part of frame being written
+ */
+enum _part_t
+{
+    PART_IDLE,      /**< @brief No frame is being written */
+    PART_HEAD,      /**< @brief Headers of frame */
+    PART_DATA       /**< @brief JPEG data of frame */
+};
+
+
+/**
+ * @brief   Streamer type
+ */
+struct campy_mjpeg_Streamer
+{
+    mp_obj_base_t  base;                            /**< @brief Type object */
+    mp_obj_t       stream;                          /**< @brief Socket frames are written to */
+    mp_obj_t       frame;                           /**< @brief Frame being written or None */
+    mp_obj_t       pending;                         /**< @brief Newest frame waiting or None */
+    size_t         len;                             /**< @brief Length of JPEG data of `frame` */
+    size_t         off;                             /**< @brief Bytes of current part written */
+    size_t         chunk;                           /**< @brief Maximal length of one write */
+    uint8_t        part;                            /**< @brief Part being written */
+    bool           http;                            /**< @brief HTTP response header is to be written */
+    bool           first;                           /**< @brief No frame was written yet */
+    uint16_t       head_len;                        /**< @brief Length of `head` */
+    char           boundary[MJPEG_BOUNDARY_MAX + 1];/**< @brief Boundary between frames */
+    char           head[256];                       /**< @brief Headers of current frame */
+    mp_uint_t      sent;                            /**< @brief Frames written */
+    mp_uint_t      dropped;                         /**< @brief Frames dropped */
+    mp_uint_t      bytes;                           /**< @brief Bytes written */
+};
+
+
+extern const mp_obj_type_t MP_NAMESPACE2(campy_mjpeg, Streamer);
+
+
+
+/*
+ * Gets JPEG data of frame given to send, false if frame buffer was
+ * invalidated or the object has no buffer any more
+ */
+STATIC bool _frame_data(mp_obj_t        aFrame,
+                        const uint8_t** aData,
+                        size_t*         aLen)
+{
+#ifdef ESP_PLATFORM
+    if (mp_obj_is_type(aFrame, &MP_NAMESPACE2(campy, FrameBuffer)))
+    {
+        struct campy_FrameBuffer* fb = MP_OBJ_TO_PTR(aFrame);
+
+        if (!esp_camera_fb_valid(fb))
+        {
+            return false;
+        }
+
+        *aData = fb->buf;
+        *aLen  = fb->len;
+        return true;
+    }
+#endif
+
+    mp_buffer_info_t info;
+
+    if (!mp_get_buffer(aFrame, &info, MP_BUFFER_READ))
+    {
+        return false;
+    }
+
+    *aData = info.buf;
+    *aLen  = info.len;
+    return true;
+}
+
+
+
+/*
+ * Gives up frame which was written or dropped
+ */
+STATIC void _release(mp_obj_t aFrame)
+{
+#ifdef ESP_PLATFORM
+    if (mp_obj_is_type(aFrame, &MP_NAMESPACE2(campy, FrameBuffer)))
+    {
+        struct campy_FrameBuffer* fb = MP_OBJ_TO_PTR(aFrame);
+
+        if (fb->slot >= 0)
+        {
+            esp_camera_fb_release(fb);
+        }
+    }
+#else
+    (void)aFrame;
+#endif
+}
+
+
+
+/*
+ * Drops frame being written
+ */
+STATIC void _drop(struct campy_mjpeg_Streamer* aSelf)
+{
+    _release(aSelf->frame);
+    aSelf->frame = mp_const_none;
+    ++aSelf->dropped;
+}
+
+
+
+/*
+ * Starts writing of pending frame, headers are prepared in `head`.
+ * Line ending of previous frame goes before the boundary, so it does not
+ * need a write of its own.  Returns false if the frame was dropped.
+ */
+STATIC bool _start(struct campy_mjpeg_Streamer* aSelf)
+{
+    const uint8_t* data;
+
+    aSelf->frame   = aSelf->pending;
+    aSelf->pending = mp_const_none;
+
+    if (!_frame_data(aSelf->frame, &data, &aSelf->len))
+    {
+        _drop(aSelf);
+        return false;
+    }
+
+    int len = 0;
+
+    if (aSelf->http)
+    {
+        len = snprintf(aSelf->head, sizeof(aSelf->head),
+                       "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: multipart/x-mixed-replace; boundary=%s\r\n"
+                       "Cache-Control: no-cache\r\n"
+                       "Connection: close\r\n"
+                       "\r\n",
+                       aSelf->boundary);
+        aSelf->http = false;
+    }
+
+    len += snprintf(aSelf->head + len, sizeof(aSelf->head) - len,
+                    "%s--%s\r\n"
+                    "Content-Type: image/jpeg\r\n"
+                    "Content-Length: %u\r\n"
+                    "\r\n",
+                    aSelf->first ? "" : "\r\n",
+                    aSelf->boundary,
+                    (unsigned)aSelf->len);
+
+    aSelf->first    = false;
+    aSelf->head_len = len;
+    aSelf->part     = PART_HEAD;
+    aSelf->off      = 0;
+    return true;
+}
+
+
+
+STATIC mp_obj_t MP_NAMESPACE3(campy_mjpeg, Streamer, __init__)(const mp_obj_type_t* aType,
+                                                               size_t               aArgsCnt,
+                                                               size_t               aKw,
+                                                               const mp_obj_t*      aArgs)
+{
+    mp_arg_check_num(aArgsCnt, aKw, 1, 4, false);
+    mp_get_stream_raise(aArgs[0], MP_STREAM_OP_WRITE);
+
+    const char* boundary = (aArgsCnt > 1) ? mp_obj_str_get_str(aArgs[1]) : "frame";
+    mp_int_t    chunk    = (aArgsCnt > 3) ? mp_obj_get_int(aArgs[3]) : MJPEG_CHUNK;
+
+    if ((0 == *boundary) || (strlen(boundary) > MJPEG_BOUNDARY_MAX))
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("Invalid boundary"));
+    }
+
+    if (chunk <= 0)
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("Invalid chunk"));
+    }
+
+    struct campy_mjpeg_Streamer* self = m_new_obj(struct campy_mjpeg_Streamer);
+    memset(self, 0, sizeof(*self));
+
+    self->base.type = &MP_NAMESPACE2(campy_mjpeg, Streamer);
+    self->stream    = aArgs[0];
+    self->frame     = mp_const_none;
+    self->pending   = mp_const_none;
+    self->http      = (aArgsCnt > 2) ? mp_obj_is_true(aArgs[2]) : true;
+    self->first     = true;
+    self->chunk     = chunk;
+    self->part      = PART_IDLE;
+    strcpy(self->boundary, boundary);
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+
+
+STATIC void MP_NAMESPACE3(campy_mjpeg, Streamer, __str__)(const mp_print_t* aPrint,
+                                                          mp_obj_t          aSelf,
+                                                          mp_print_kind_t   aKind)
+{
+    struct campy_mjpeg_Streamer* self = MP_OBJ_TO_PTR(aSelf);
+    mp_printf(aPrint,
+              "<Streamer %s sent:%u dropped:%u>",
+              self->boundary,
+              (unsigned)self->sent,
+              (unsigned)self->dropped);
+}
+
+
+
+/**
+ * send(frame) -> bool
+ *
+ * Queues JPEG frame, replacing (dropping) the frame which waits for the
+ * one being written.  Returns False if a frame was dropped.
+ */
+MP_FN_2(campy_mjpeg__Streamer, send, aSelf, aFrame)
+{
+    struct campy_mjpeg_Streamer* self = MP_OBJ_TO_PTR(aSelf);
+
+    /*
+     * Fail now rather than once the frame gets its turn
+     */
+#ifdef ESP_PLATFORM
+    if (mp_obj_is_type(aFrame, &MP_NAMESPACE2(campy, FrameBuffer)))
+    {
+        struct campy_FrameBuffer* fb = MP_OBJ_TO_PTR(aFrame);
+
+        if (!esp_camera_fb_valid(fb))
+        {
+            mp_raise_ValueError(MP_ERROR_TEXT("Frame buffer invalidated (called reducto)"));
+        }
+
+        if (PIXFORMAT_JPEG != fb->format)
+        {
+            mp_raise_ValueError(MP_ERROR_TEXT("JPEG frame expected"));
+        }
+    }
+    else
+#endif
+    {
+        mp_buffer_info_t info;
+        mp_get_buffer_raise(aFrame, &info, MP_BUFFER_READ);
+    }
+
+    bool dropped = (mp_const_none != self->pending);
+
+    if (dropped)
+    {
+        _release(self->pending);
+        ++self->dropped;
+    }
+
+    self->pending = aFrame;
+    return mp_obj_new_bool(!dropped);
+}
+
+
+
+/**
+ * pump() -> bool
+ *
+ * Writes queued frames until the socket would block.  Returns True when
+ * all was written.
+ */
+MP_FN_1(campy_mjpeg__Streamer, pump, aSelf)
+{
+    struct campy_mjpeg_Streamer* self   = MP_OBJ_TO_PTR(aSelf);
+    const mp_stream_p_t*         stream = mp_get_stream(self->stream);
+
+    for (;;)
+    {
+        if (PART_IDLE == self->part)
+        {
+            if (mp_const_none == self->pending)
+            {
+                return mp_const_true;
+            }
+
+            if (!_start(self))
+            {
+                continue;
+            }
+        }
+
+        const uint8_t* buf;
+        size_t         len;
+        size_t         max = self->chunk;
+
+        if (PART_HEAD == self->part)
+        {
+            buf = (const uint8_t*)self->head + self->off;
+            len = self->head_len;
+        }
+        else
+        {
+            const uint8_t* data     = NULL;
+            size_t         data_len = 0;
+
+            if ((mp_const_none != self->frame) &&
+                (!_frame_data(self->frame, &data, &data_len) || (data_len != self->len)))
+            {
+                _drop(self);
+            }
+
+            len = self->len;
+
+            if (mp_const_none != self->frame)
+            {
+                buf = data + self->off;
+            }
+            else
+            {
+                /*
+                 * Headers promised `len` bytes
+                 */
+                buf = _zeros;
+                max = MIN(max, sizeof(_zeros));
+            }
+        }
+
+        size_t cnt = MIN(len - self->off, max);
+
+        if (cnt > 0)
+        {
+            int       err;
+            mp_uint_t out = stream->write(self->stream, buf, cnt, &err);
+
+            if (MP_STREAM_ERROR == out)
+            {
+                if (mp_is_nonblocking_error(err))
+                {
+                    return mp_const_false;
+                }
+
+                mp_raise_OSError(err);
+            }
+
+            if (0 == out)
+            {
+                return mp_const_false;
+            }
+
+            self->off   += out;
+            self->bytes += out;
+        }
+
+        if (self->off < len)
+        {
+            continue;
+        }
+
+        self->off = 0;
+
+        if (PART_HEAD == self->part)
+        {
+            self->part = PART_DATA;
+        }
+        else
+        {
+            if (mp_const_none != self->frame)
+            {
+                _release(self->frame);
+                self->frame = mp_const_none;
+                ++self->sent;
+            }
+
+            self->part = PART_IDLE;
+        }
+    }
+}
+
+
+
+/**
+ * close()
+ *
+ * Drops queued frames, socket stays open.
+ */
+MP_FN_1(campy_mjpeg__Streamer, close, aSelf)
+{
+    struct campy_mjpeg_Streamer* self = MP_OBJ_TO_PTR(aSelf);
+
+    if (mp_const_none != self->pending)
+    {
+        _release(self->pending);
+        self->pending = mp_const_none;
+    }
+
+    if (mp_const_none != self->frame)
+    {
+        _release(self->frame);
+        self->frame = mp_const_none;
+    }
+
+    self->part = PART_IDLE;
+    return mp_const_none;
+}
+
+
+
+/**
+ * stats() -> (sent, dropped, bytes)
+ */
+MP_FN_1(campy_mjpeg__Streamer, stats, aSelf)
+{
+    struct campy_mjpeg_Streamer* self = MP_OBJ_TO_PTR(aSelf);
+    mp_obj_t                     ret[3] =
+    {
+        mp_obj_new_int_from_uint(self->sent),
+        mp_obj_new_int_from_uint(self->dropped),
+        mp_obj_new_int_from_uint(self->bytes),
+    };
+
+    return mp_obj_new_tuple(3, ret);
+}
+
+
+
+/*
+ * True when no frame is being written or waits
+ */
+STATIC mp_obj_t MP_NAMESPACE3(campy_mjpeg__Streamer, idle, __load__)(mp_obj_t aSelf)
+{
+    struct campy_mjpeg_Streamer* self = MP_OBJ_TO_PTR(aSelf);
+    return mp_obj_new_bool((PART_IDLE == self->part) && (mp_const_none == self->pending));
+}
+
+
+
+STATIC void MP_NAMESPACE3(campy_mjpeg, Streamer, __attr__)(mp_obj_t  aSelf,
+                                                           qstr      aAttribute,
+                                                           mp_obj_t* aDestination)
+{
+    MP_LOAD
+    {
+        MP_ATTR_METHOD(   campy_mjpeg, Streamer, send  );
+        MP_ATTR_METHOD(   campy_mjpeg, Streamer, pump  );
+        MP_ATTR_METHOD(   campy_mjpeg, Streamer, close );
+        MP_ATTR_METHOD(   campy_mjpeg, Streamer, stats );
+        MP_ATTR_PROPERTY( campy_mjpeg, Streamer, idle  );
+    }
+}
+
+
+
+MP_CLASS(campy_mjpeg, Streamer)
+
+
+
+/*
+ *******************************************************************************
+ * campy_mjpeg module
+ *******************************************************************************
+ */
+MP_MODULE_BEGIN( campy_mjpeg           )
+MP_MEMBER(       campy_mjpeg, Streamer )
+MP_MODULE_END(   campy_mjpeg           )
+MP_REGISTER_MODULE(MP_QSTR_campy_mjpeg, mp_module_campy_mjpeg, 1);
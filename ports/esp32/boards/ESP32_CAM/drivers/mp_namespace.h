@@ -87,3 +87,13 @@
     STATIC mp_obj_t                                                             mpy__##_parent_##__##_member_##_##_F(const mp_obj_t _a1_, const mp_obj_t _a2_); \
     STATIC MP_DEFINE_CONST_FUN_OBJ_2(mpy__##_parent_##__##_member_##____load__, mpy__##_parent_##__##_member_##_##_F); \
     mp_obj_t                                                                    mpy__##_parent_##__##_member_##_##_F(const mp_obj_t _a1_, const mp_obj_t _a2_)
+
+
+#define MP_FN_VAR(_parent_, _member_, _min_, _max_) \
+    STATIC mp_obj_t                                                                            mpy__##_parent_##__##_member_##_##_F(size_t aArgsCnt, const mp_obj_t* aArgs); \
+    STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mpy__##_parent_##__##_member_##____load__, _min_, _max_, mpy__##_parent_##__##_member_##_##_F); \
+    mp_obj_t                                                                                   mpy__##_parent_##__##_member_##_##_F(size_t aArgsCnt, const mp_obj_t* aArgs)
+
+
+#define MP_MEMBER_FN(_parent_, _member_) \
+    { MP_ROM_QSTR(MP_QSTR_##_member_), MP_ROM_PTR(&mpy__##_parent_##__##_member_##____load__) },
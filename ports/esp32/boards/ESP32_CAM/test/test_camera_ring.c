@@ -0,0 +1,313 @@
+/*
+ * Host test and benchmark for camera_ring.c.
+ *
+ * Ownership rules of the ring are checked step by step, then a synthetic
+ * sensor thread fills frames the way the DMA filter task does while the
+ * main thread takes, checks and "processes" them.  Every frame is filled
+ * with its number, so a frame changing while held by the application shows
+ * up as torn.  The benchmark compares this with capture on demand into a
+ * newly allocated buffer, as Camera.capture() does, and prints frames per
+ * second and bytes allocated per frame.
+ */
+#include "camera_ring.h"
+#include "host_test.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define FB_SIZE     (640 * 480 * 2)     // VGA, YUV422
+#define FRAME_US    10000               // Sensor at 100 fps
+#define FRAMES      60
+
+
+static void test_ownership(void)
+{
+    struct camera_ring_t ring;
+
+    printf("ownership:\n");
+    camera_ring_init(&ring, 3);
+    CHECK(camera_ring_take(&ring) < 0);
+
+    int a = camera_ring_begin(&ring);
+    camera_ring_commit(&ring, a);
+    CHECK(camera_ring_take(&ring) == a);
+
+    // Free slots are filled first
+    int b = camera_ring_begin(&ring);
+    camera_ring_commit(&ring, b);
+    int c = camera_ring_begin(&ring);
+    camera_ring_commit(&ring, c);
+    CHECK(a != b && b != c && a != c);
+    CHECK(ring.dropped == 0);
+
+    // No free slot, the oldest ready frame is overwritten
+    CHECK(camera_ring_begin(&ring) == b);
+    CHECK(ring.dropped == 1);
+    camera_ring_commit(&ring, b);
+
+    // The latest frame is taken, older ones are dropped
+    CHECK(camera_ring_take(&ring) == b);
+    CHECK(ring.state[c] == CAMERA_SLOT_FREE && ring.dropped == 2);
+    CHECK(camera_ring_take(&ring) < 0);
+
+    // Application holds a and b, the latest frame in c is kept for it
+    CHECK(camera_ring_begin(&ring) == c);
+    camera_ring_commit(&ring, c);
+    CHECK(camera_ring_begin(&ring) < 0 && ring.stalls == 1);
+    CHECK(camera_ring_take(&ring) == c);
+    CHECK(camera_ring_begin(&ring) < 0 && ring.stalls == 2);
+
+    CHECK(camera_ring_release(&ring, a));
+    CHECK(!camera_ring_release(&ring, a));
+    CHECK(!camera_ring_release(&ring, -1));
+    CHECK(!camera_ring_release(&ring, 3));
+    CHECK(camera_ring_begin(&ring) == a);
+    camera_ring_abort(&ring, a);
+    CHECK(ring.state[a] == CAMERA_SLOT_FREE);
+    CHECK(ring.captured == 5 && ring.dropped == 2);
+
+    // Sequence numbers wrap
+    camera_ring_init(&ring, 2);
+    ring.next_seq = 0xFFFFFFFF;
+    a = camera_ring_begin(&ring);
+    camera_ring_commit(&ring, a);
+    b = camera_ring_begin(&ring);
+    camera_ring_commit(&ring, b);
+    CHECK(camera_ring_begin(&ring) == a);
+    camera_ring_commit(&ring, a);
+    CHECK(camera_ring_take(&ring) == a);
+}
+
+
+/*
+ * Synthetic camera, the ring is guarded by a mutex like by the critical
+ * section in camera.c
+ */
+static struct
+{
+    pthread_mutex_t      lock;
+    pthread_cond_t       frame_ready;
+    pthread_cond_t       restart;
+    struct camera_ring_t ring;
+    uint8_t*             buf[CAMERA_RING_MAX];
+    int                  slot;      // Being filled, -1 when stalled
+    bool                 stop;
+    unsigned             frame;
+}
+cam;
+
+
+static void sleep_us(long aUs)
+{
+    struct timespec ts = { aUs / 1000000, aUs % 1000000 * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+
+/// Fills a frame in four DMA chunks over the frame time
+static void fill(uint8_t* aBuf, unsigned aFrame)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        sleep_us(FRAME_US / 4);
+        memset(aBuf + i * FB_SIZE / 4, aFrame & 0xFF, FB_SIZE / 4);
+    }
+}
+
+
+static void* sensor(void* aArg)
+{
+    (void)aArg;
+    pthread_mutex_lock(&cam.lock);
+
+    while (!cam.stop)
+    {
+        if (cam.slot < 0)
+        {
+            pthread_cond_wait(&cam.restart, &cam.lock);
+            continue;
+        }
+
+        uint8_t* buf = cam.buf[cam.slot];
+        pthread_mutex_unlock(&cam.lock);
+
+        fill(buf, ++cam.frame);
+
+        pthread_mutex_lock(&cam.lock);
+        camera_ring_commit(&cam.ring, cam.slot);
+        cam.slot = camera_ring_begin(&cam.ring);
+        pthread_cond_signal(&cam.frame_ready);
+    }
+
+    pthread_mutex_unlock(&cam.lock);
+    return NULL;
+}
+
+
+/// Like esp_camera_fb_latest
+static int latest(void)
+{
+    pthread_mutex_lock(&cam.lock);
+
+    int slot;
+
+    while ((slot = camera_ring_take(&cam.ring)) < 0)
+    {
+        if (cam.slot < 0 && (cam.slot = camera_ring_begin(&cam.ring)) >= 0)
+        {
+            pthread_cond_signal(&cam.restart);
+        }
+
+        pthread_cond_wait(&cam.frame_ready, &cam.lock);
+    }
+
+    if (cam.slot < 0 && (cam.slot = camera_ring_begin(&cam.ring)) >= 0)
+    {
+        pthread_cond_signal(&cam.restart);
+    }
+
+    pthread_mutex_unlock(&cam.lock);
+    return slot;
+}
+
+
+static void release(int aSlot)
+{
+    pthread_mutex_lock(&cam.lock);
+    camera_ring_release(&cam.ring, aSlot);
+    pthread_mutex_unlock(&cam.lock);
+}
+
+
+static bool intact(const uint8_t* aBuf)
+{
+    for (size_t i = 1; i < FB_SIZE; ++i)
+    {
+        if (aBuf[i] != aBuf[0])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/// Takes frames from the ring, keeping `aHold` of them held at a time
+static double stream(unsigned aCnt,
+                     unsigned aHold,
+                     long     aProcessUs,
+                     bool*    aIntact)
+{
+    pthread_t thread;
+    int       held[CAMERA_RING_MAX];
+
+    pthread_mutex_init(&cam.lock, NULL);
+    pthread_cond_init(&cam.frame_ready, NULL);
+    pthread_cond_init(&cam.restart, NULL);
+    camera_ring_init(&cam.ring, aCnt);
+    cam.stop  = false;
+    cam.frame = 0;
+
+    for (unsigned i = 0; i < aCnt; ++i)
+    {
+        cam.buf[i] = malloc(FB_SIZE);
+    }
+
+    cam.slot = camera_ring_begin(&cam.ring);
+    pthread_create(&thread, NULL, sensor, NULL);
+
+    double start = host_test_now();
+
+    for (unsigned n = 0; n < FRAMES; ++n)
+    {
+        held[n % aHold] = latest();
+
+        sleep_us(aProcessUs);
+        *aIntact = *aIntact && intact(cam.buf[held[n % aHold]]);
+
+        if (n + 1 >= aHold)
+        {
+            release(held[(n + 1) % aHold]);
+        }
+    }
+
+    double secs = host_test_now() - start;
+
+    pthread_mutex_lock(&cam.lock);
+    cam.stop = true;
+    pthread_cond_signal(&cam.restart);
+    pthread_mutex_unlock(&cam.lock);
+    pthread_join(thread, NULL);
+
+    for (unsigned i = 0; i < aCnt; ++i)
+    {
+        free(cam.buf[i]);
+    }
+
+    return FRAMES / secs;
+}
+
+
+/// Capture on demand: allocate, wait for frame start, fill, process
+static double on_demand(long aProcessUs)
+{
+    double start = host_test_now();
+
+    for (unsigned n = 0; n < FRAMES; ++n)
+    {
+        uint8_t* buf = malloc(FB_SIZE);
+
+        // Capture starts with next VSYNC
+        long phase = (long)((host_test_now() - start) * 1e6) % FRAME_US;
+        sleep_us(FRAME_US - phase);
+        fill(buf, n);
+
+        sleep_us(aProcessUs);
+        free(buf);
+    }
+
+    return FRAMES / (host_test_now() - start);
+}
+
+
+static void benchmark(void)
+{
+    static const long process_us[] = { 2000, 8000, 15000 };
+
+    printf("benchmark (host, sensor at %d fps, %d B frames):\n", 1000000 / FRAME_US, FB_SIZE);
+
+    for (size_t i = 0; i < sizeof(process_us) / sizeof(*process_us); ++i)
+    {
+        bool   ok    = true;
+        double old   = on_demand(process_us[i]);
+        double ring2 = stream(2, 1, process_us[i], &ok);
+        double ring3 = stream(3, 2, process_us[i], &ok);
+
+        CHECK(ok);
+        printf("  processing %2ld ms: %5.1f fps on demand (%d B allocated per frame), "
+               "%5.1f fps with 2 buffers, %5.1f fps with 3 (2 held), 0 B per frame\n",
+               process_us[i] / 1000, old, FB_SIZE, ring2, ring3);
+    }
+}
+
+
+int main(void)
+{
+    test_ownership();
+
+    printf("threads:\n");
+    bool ok = true;
+    stream(3, 1, 1000, &ok);
+    stream(2, 2, 3000, &ok);
+    CHECK(ok);
+
+    benchmark();
+
+    return host_test_done();
+}
@@ -0,0 +1,393 @@
+/*
+ * Host test and benchmark for campy_image.c.
+ *
+ * Every kernel is compared with a straightforward per pixel version of the
+ * same computation, on synthetic frames and on buffers which are not word
+ * aligned, so both the SWAR and the fallback loops are covered.  The
+ * benchmark then runs both versions over VGA frames and prints megapixels
+ * per second.
+ */
+#include "campy_image.h"
+#include "host_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+#define WIDTH   640
+#define HEIGHT  480
+#define PIXELS  (WIDTH * HEIGHT)
+
+
+/*
+ * Buffers are over-allocated so they can be used at an unaligned offset
+ */
+static uint8_t  yuyv[2 * PIXELS + 4];
+static uint8_t  rgb565[2 * PIXELS + 4];
+static uint8_t  gray[PIXELS + 4];
+static uint8_t  gray2[PIXELS + 4];
+static uint8_t  out[PIXELS + 4];
+static uint8_t  ref[PIXELS + 4];
+static uint32_t integral[PIXELS];
+static uint32_t integral_ref[PIXELS];
+static uint32_t scratch[CAMPY_IMAGE_BOX_SCRATCH(WIDTH)];
+
+
+/*
+ * Smooth gradients with some noise, roughly what a sensor delivers
+ */
+static void make_frames(void)
+{
+    for (int y = 0; y < HEIGHT; ++y)
+    {
+        for (int x = 0; x < WIDTH; ++x)
+        {
+            int i = y * WIDTH + x;
+            int v = (x + y) / 5 + rand() % 16;
+
+            gray[i]            = v;
+            gray2[i]           = (x > 300 && x < 340 && y > 200 && y < 260) ? 255 - v : v + rand() % 4;
+            yuyv[2 * i]        = v;
+            yuyv[2 * i + 1]    = rand();
+            rgb565[2 * i]      = rand();
+            rgb565[2 * i + 1]  = rand();
+        }
+    }
+}
+
+
+/*
+ * Reference versions, one pixel at a time
+ */
+static void ref_gray_yuyv(uint8_t* aDst, const uint8_t* aSrc, size_t aPixels)
+{
+    for (size_t i = 0; i < aPixels; ++i)
+    {
+        aDst[i] = aSrc[2 * i];
+    }
+}
+
+
+static void ref_gray_rgb565(uint8_t* aDst, const uint8_t* aSrc, size_t aPixels)
+{
+    for (size_t i = 0; i < aPixels; ++i)
+    {
+        unsigned p = aSrc[2 * i] << 8 | aSrc[2 * i + 1];
+        unsigned r = p >> 11;
+        unsigned g = (p >> 5) & 0x3F;
+        unsigned b = p & 0x1F;
+
+        aDst[i] = (r * 633 + g * 607 + b * 239 + 128) >> 8;
+    }
+}
+
+
+static void ref_box(uint8_t* aDst, unsigned aDw, unsigned aDh,
+                    const uint8_t* aSrc, unsigned aSw, unsigned aSh)
+{
+    for (unsigned y = 0; y < aDh; ++y)
+    {
+        for (unsigned x = 0; x < aDw; ++x)
+        {
+            unsigned y0 = y * aSh / aDh, y1 = (y + 1) * aSh / aDh;
+            unsigned x0 = x * aSw / aDw, x1 = (x + 1) * aSw / aDw;
+            unsigned sum = 0, area = (y1 - y0) * (x1 - x0);
+
+            for (unsigned yy = y0; yy < y1; ++yy)
+            {
+                for (unsigned xx = x0; xx < x1; ++xx)
+                {
+                    sum += aSrc[yy * aSw + xx];
+                }
+            }
+
+            *aDst++ = (sum + area / 2) / area;
+        }
+    }
+}
+
+
+static size_t ref_diff(const uint8_t* aA, const uint8_t* aB, unsigned aW, unsigned aH,
+                       uint8_t aT, uint8_t* aMask, struct campy_image_bbox_t* aBox)
+{
+    size_t cnt = 0;
+
+    aBox->x0 = aW;
+    aBox->y0 = aH;
+    aBox->x1 = 0;
+    aBox->y1 = 0;
+
+    for (unsigned y = 0; y < aH; ++y)
+    {
+        for (unsigned x = 0; x < aW; ++x)
+        {
+            int  d = aA[y * aW + x] - aB[y * aW + x];
+            bool c = abs(d) > aT;
+
+            aMask[y * aW + x] = c ? 255 : 0;
+
+            if (c)
+            {
+                ++cnt;
+                aBox->x0 = x < aBox->x0 ? x : aBox->x0;
+                aBox->x1 = x > aBox->x1 ? x : aBox->x1;
+                aBox->y0 = y < aBox->y0 ? y : aBox->y0;
+                aBox->y1 = y;
+            }
+        }
+    }
+
+    return cnt;
+}
+
+
+static void ref_histogram(uint32_t aHist[256], const uint8_t* aSrc, size_t aPixels)
+{
+    memset(aHist, 0, 256 * sizeof(*aHist));
+
+    for (size_t i = 0; i < aPixels; ++i)
+    {
+        ++aHist[aSrc[i]];
+    }
+}
+
+
+static void ref_integral(uint32_t* aDst, const uint8_t* aSrc, unsigned aW, unsigned aH)
+{
+    for (unsigned y = 0; y < aH; ++y)
+    {
+        for (unsigned x = 0; x < aW; ++x)
+        {
+            uint32_t v = aSrc[y * aW + x];
+
+            v += x     ? aDst[y * aW + x - 1]       : 0;
+            v += y     ? aDst[(y - 1) * aW + x]     : 0;
+            v -= x && y ? aDst[(y - 1) * aW + x - 1] : 0;
+
+            aDst[y * aW + x] = v;
+        }
+    }
+}
+
+
+static void test_gray(void)
+{
+    printf("gray:\n");
+
+    for (int off = 0; off < 2; ++off)
+    {
+        memset(out, 0, sizeof(out));
+        campy_image_gray_yuyv(out + off, yuyv + off, PIXELS - 3);
+        ref_gray_yuyv(ref + off, yuyv + off, PIXELS - 3);
+        CHECK(0 == memcmp(out + off, ref + off, PIXELS - 3));
+
+        campy_image_gray_rgb565(out + off, rgb565 + off, PIXELS - 3);
+        ref_gray_rgb565(ref + off, rgb565 + off, PIXELS - 3);
+        CHECK(0 == memcmp(out + off, ref + off, PIXELS - 3));
+    }
+
+    uint8_t white[4] = { 0xFF, 0xFF, 0x00, 0x00 };
+    uint8_t level[2];
+
+    campy_image_gray_rgb565(level, white, 2);
+    CHECK(255 == level[0] && 0 == level[1]);
+}
+
+
+static void test_downscale(void)
+{
+    static const unsigned sizes[][4] =
+    {
+        { 640, 480, 160, 120 },     // Integral ratio
+        { 640, 480, 100,  75 },     // Non integral ratio
+        { 320, 240, 320, 240 },     // Copy
+        { 643, 101,   7,   3 },     // Odd widths use per pixel path
+    };
+
+    printf("downscale:\n");
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(*sizes); ++i)
+    {
+        unsigned sw = sizes[i][0], sh = sizes[i][1], dw = sizes[i][2], dh = sizes[i][3];
+
+        CHECK(campy_image_downscale_box(out, dw, dh, gray, sw, sh, scratch));
+        ref_box(ref, dw, dh, gray, sw, sh);
+        CHECK(0 == memcmp(out, ref, dw * dh));
+
+        CHECK(campy_image_downscale_box(out, dw, dh, gray + 1, sw, sh, scratch));
+        ref_box(ref, dw, dh, gray + 1, sw, sh);
+        CHECK(0 == memcmp(out, ref, dw * dh));
+    }
+
+    CHECK(!campy_image_downscale_box(out, 0, 10, gray, 640, 480, scratch));
+    CHECK(!campy_image_downscale_box(out, 641, 10, gray, 640, 480, scratch));
+    CHECK(!campy_image_downscale_box(out, 1, 1, gray, 1, 300, scratch));
+
+    /*
+     * Bilinear keeps flat areas flat, copies at equal size and interpolates
+     * between pixel centers when upscaling
+     */
+    uint8_t flat[16 * 16], small[4] = { 0, 100, 200, 100 }, big[16];
+
+    memset(flat, 77, sizeof(flat));
+    CHECK(campy_image_downscale_bilinear(out, 5, 3, flat, 16, 16));
+    CHECK(0 == memcmp(out, flat, 15));
+
+    CHECK(campy_image_downscale_bilinear(out, WIDTH, HEIGHT, gray, WIDTH, HEIGHT));
+    CHECK(0 == memcmp(out, gray, PIXELS));
+
+    CHECK(campy_image_downscale_bilinear(big, 4, 4, small, 2, 2));
+    CHECK(0 == big[0] && 100 == big[3] && 200 == big[12] && 100 == big[15]);
+    CHECK(25 == big[1] && 75 == big[2] && 50 == big[4]);
+
+    CHECK(campy_image_downscale_bilinear(out, 160, 120, gray, 640, 480));
+    CHECK(!campy_image_downscale_bilinear(out, 1, 1, gray, 0, 1));
+}
+
+
+static void test_diff(void)
+{
+    static uint8_t mask[PIXELS + 4];
+    static uint8_t mask_ref[PIXELS + 4];
+
+    printf("diff:\n");
+
+    for (int off = 0; off < 2; ++off)
+    {
+        unsigned w = off ? WIDTH - 1 : WIDTH;
+
+        for (int t = 0; t < 256; t += 51)
+        {
+            struct campy_image_bbox_t box, box_ref;
+            size_t cnt     = campy_image_diff(gray + off, gray2 + off, w, HEIGHT, t, mask + off, &box);
+            size_t cnt_ref = ref_diff(gray + off, gray2 + off, w, HEIGHT, t, mask_ref + off, &box_ref);
+
+            CHECK(cnt == cnt_ref);
+            CHECK(0 == memcmp(mask + off, mask_ref + off, w * HEIGHT));
+            CHECK(0 == memcmp(&box, &box_ref, sizeof(box)) || 0 == cnt);
+            CHECK(cnt == campy_image_diff(gray + off, gray2 + off, w, HEIGHT, t, NULL, &box));
+        }
+    }
+
+    /*
+     * Every possible pair of levels against a few thresholds
+     */
+    static uint8_t a[256 * 256], b[256 * 256];
+
+    for (int i = 0; i < 256 * 256; ++i)
+    {
+        a[i] = i >> 8;
+        b[i] = i;
+    }
+
+    for (int t = 0; t < 256; ++t)
+    {
+        struct campy_image_bbox_t box, box_ref;
+
+        CHECK(campy_image_diff(a, b, 256, 256, t, mask, &box) ==
+              ref_diff(a, b, 256, 256, t, mask_ref, &box_ref));
+    }
+
+    struct campy_image_bbox_t box;
+
+    CHECK(0 == campy_image_diff(gray, gray, WIDTH, HEIGHT, 0, NULL, &box));
+    CHECK(1 == campy_image_diff((const uint8_t*)"\0\0\0\0\0\0\0\x10", (const uint8_t*)"\0\0\0\0\0\0\0\0",
+                                4, 2, 15, NULL, &box));
+    CHECK(3 == box.x0 && 1 == box.y0 && 3 == box.x1 && 1 == box.y1);
+}
+
+
+static void test_histogram(void)
+{
+    uint32_t hist[256], hist_ref[256];
+
+    printf("histogram:\n");
+
+    for (int off = 0; off < 2; ++off)
+    {
+        campy_image_histogram(hist, gray + off, PIXELS - 1);
+        ref_histogram(hist_ref, gray + off, PIXELS - 1);
+        CHECK(0 == memcmp(hist, hist_ref, sizeof(hist)));
+    }
+
+    /*
+     * Flat image of more than 65535 words overflows 16 bit tables
+     */
+    static uint8_t flat[400000];
+
+    memset(flat, 9, sizeof(flat));
+    campy_image_histogram(hist, flat, sizeof(flat));
+    CHECK(sizeof(flat) == hist[9] && 0 == hist[8]);
+}
+
+
+static void test_integral(void)
+{
+    printf("integral:\n");
+
+    campy_image_integral(integral, gray, WIDTH, HEIGHT);
+    ref_integral(integral_ref, gray, WIDTH, HEIGHT);
+    CHECK(0 == memcmp(integral, integral_ref, sizeof(integral)));
+
+    campy_image_integral(integral, gray + 1, 7, 5);
+    ref_integral(integral_ref, gray + 1, 7, 5);
+    CHECK(0 == memcmp(integral, integral_ref, 7 * 5 * sizeof(*integral)));
+}
+
+
+#define BENCH(_name_, _ref_, _kernel_) \
+    do \
+    { \
+        const int rounds = 200; \
+        double    t0     = host_test_now(); \
+        for (int r = 0; r < rounds; ++r) { _ref_; } \
+        double    t1     = host_test_now(); \
+        for (int r = 0; r < rounds; ++r) { _kernel_; } \
+        double    t2     = host_test_now(); \
+        double    a      = rounds * PIXELS / (t1 - t0) / 1e6; \
+        double    b      = rounds * PIXELS / (t2 - t1) / 1e6; \
+        printf("  %-12s %8.1f Mpx/s per pixel, %8.1f Mpx/s kernel (%.1fx)\n", \
+               _name_, a, b, b / a); \
+    } \
+    while (0)
+
+
+static void benchmark(void)
+{
+    static uint8_t mask[PIXELS];
+    uint32_t       hist[256];
+    struct campy_image_bbox_t box;
+
+    printf("benchmark (host, %dx%d frames):\n", WIDTH, HEIGHT);
+
+    BENCH("gray yuyv",   ref_gray_yuyv(out, yuyv, PIXELS),
+                         campy_image_gray_yuyv(out, yuyv, PIXELS));
+    BENCH("gray rgb565", ref_gray_rgb565(out, rgb565, PIXELS),
+                         campy_image_gray_rgb565(out, rgb565, PIXELS));
+    BENCH("box 1/4",     ref_box(out, WIDTH / 4, HEIGHT / 4, gray, WIDTH, HEIGHT),
+                         campy_image_downscale_box(out, WIDTH / 4, HEIGHT / 4, gray, WIDTH, HEIGHT, scratch));
+    BENCH("diff",        ref_diff(gray, gray2, WIDTH, HEIGHT, 20, mask, &box),
+                         campy_image_diff(gray, gray2, WIDTH, HEIGHT, 20, mask, &box));
+    BENCH("histogram",   ref_histogram(hist, gray, PIXELS),
+                         campy_image_histogram(hist, gray, PIXELS));
+    BENCH("integral",    ref_integral(integral_ref, gray, WIDTH, HEIGHT),
+                         campy_image_integral(integral, gray, WIDTH, HEIGHT));
+}
+
+
+int main(void)
+{
+    srand(1);
+    make_frames();
+
+    test_gray();
+    test_downscale();
+    test_diff();
+    test_histogram();
+    test_integral();
+    benchmark();
+
+    return host_test_done();
+}
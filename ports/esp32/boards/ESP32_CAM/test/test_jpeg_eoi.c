@@ -0,0 +1,290 @@
+/*
+ * Host test and benchmark for jpeg_eoi.c.
+ *
+ * Synthetic frames (SOI, random entropy coded data with 0xFF stuffed,
+ * EOI, zero padding) are split into random chunks, including splits inside
+ * the marker, and the scanner has to find the same end as the backward
+ * scan over the whole buffer which the DMA filter task did before.  The
+ * benchmark models a UXGA JPEG frame buffer filled by DMA chunks: before,
+ * every chunk was copied and the end was searched backwards from the end
+ * of the data; now chunks are scanned as they are copied and the padding
+ * after EOI is skipped.
+ */
+#include "jpeg_eoi.h"
+#include "host_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+#define FB_SIZE     (1600 * 1200 * 2 / 5)   // UXGA, JPEG frame buffer size
+#define CHUNK       (1600 * 2)              // One line of DMA data
+#define JPEG_SIZE   (90 * 1024)             // Typical UXGA quality 12 frame
+
+
+/*
+ * Sample layout of the I2S DMA buffers (camera_common.h)
+ */
+typedef union
+{
+    struct
+    {
+        uint8_t sample2;
+        uint8_t unused2;
+        uint8_t sample1;
+        uint8_t unused1;
+    };
+    uint32_t val;
+} dma_elem_t;
+
+
+static uint8_t frame[FB_SIZE + 4];
+
+
+/*
+ * Frame of `aLen` bytes ending with EOI, followed by padding up to
+ * FB_SIZE.  0xFF in data is stuffed with 0x00 or starts a restart marker.
+ */
+static void make_frame(size_t aLen)
+{
+    memset(frame, 0, sizeof(frame));
+    frame[0] = 0xFF;
+    frame[1] = 0xD8;
+    frame[2] = 0xFF;
+
+    for (size_t i = 3; i < aLen - 2; ++i)
+    {
+        frame[i] = rand();
+
+        if ((0xFF == frame[i]) && (i + 1 < aLen - 2))
+        {
+            frame[++i] = (rand() & 7) ? 0x00 : 0xD0 + (rand() & 7);
+        }
+    }
+
+    frame[aLen - 2] = 0xFF;
+    frame[aLen - 1] = 0xD9;
+}
+
+
+/*
+ * Former search in dma_finish_frame
+ */
+static size_t ref_end(const uint8_t* aBuf,
+                      size_t         aLen)
+{
+    const uint8_t* dptr = &aBuf[aLen - 1];
+
+    while (dptr > aBuf)
+    {
+        if (dptr[0] == 0xFF && dptr[1] == 0xD9 && dptr[2] == 0x00 && dptr[3] == 0x00)
+        {
+            return dptr + 2 - aBuf;
+        }
+        dptr--;
+    }
+
+    return 0;
+}
+
+
+/*
+ * Scans frame of `aLen` bytes in chunks of random length up to `aMaxChunk`
+ */
+static size_t scan_split(size_t aLen,
+                         size_t aMaxChunk)
+{
+    struct jpeg_eoi_t scanner;
+    size_t            pos = 0;
+
+    jpeg_eoi_reset(&scanner);
+
+    while (pos < aLen)
+    {
+        size_t n = 1 + rand() % aMaxChunk;
+
+        if (n > aLen - pos)
+        {
+            n = aLen - pos;
+        }
+
+        if (jpeg_eoi_scan(&scanner, frame + pos, n))
+        {
+            return scanner.end;
+        }
+        pos += n;
+    }
+
+    return 0;
+}
+
+
+static void test_scan(void)
+{
+    struct jpeg_eoi_t scanner;
+
+    printf("scan:\n");
+
+    // Marker split after every byte
+    static const uint8_t marker[] = { 0x12, 0xFF, 0xFF, 0xD9, 0x00, 0x00, 0x00 };
+    for (size_t split = 0; split <= sizeof(marker); ++split)
+    {
+        jpeg_eoi_reset(&scanner);
+        bool found = jpeg_eoi_scan(&scanner, marker, split);
+        found = jpeg_eoi_scan(&scanner, marker + split, sizeof(marker) - split) || found;
+        CHECK(found && 4 == scanner.end);
+    }
+
+    // One byte chunks
+    jpeg_eoi_reset(&scanner);
+    for (size_t i = 0; i < sizeof(marker); ++i)
+    {
+        jpeg_eoi_scan(&scanner, marker + i, 1);
+    }
+    CHECK(4 == scanner.end);
+
+    // No padding yet, restart markers and stuffed 0xFF are not the end
+    static const uint8_t partial[] = { 0xFF, 0x00, 0xFF, 0xD0, 0xFF, 0xD9, 0x00 };
+    jpeg_eoi_reset(&scanner);
+    CHECK(!jpeg_eoi_scan(&scanner, partial, sizeof(partial)));
+    CHECK(0 == scanner.end && 3 == scanner.matched);
+    CHECK(jpeg_eoi_scan(&scanner, marker + 5, 1) && 6 == scanner.end);
+
+    // Found marker is kept, later chunks are not scanned
+    CHECK(jpeg_eoi_scan(&scanner, marker, sizeof(marker)) && 6 == scanner.end);
+    jpeg_eoi_reset(&scanner);
+    CHECK(0 == scanner.end && !jpeg_eoi_scan(&scanner, marker, 3));
+
+    // Random frames and splits, also unaligned and at end of buffer
+    for (int round = 0; round < 2000; ++round)
+    {
+        size_t len   = 16 + rand() % 4000;
+        size_t total = len + 2 + rand() % 64;
+
+        make_frame(len);
+        size_t expect = ref_end(frame, total);
+        size_t got    = scan_split(total, 1 + rand() % 300);
+
+        CHECK(len == expect);
+        CHECK(got == expect);
+        if (got != expect)
+        {
+            printf("  len %zu: expected %zu, got %zu\n", len, expect, got);
+            break;
+        }
+    }
+
+    // Without padding after EOI there is no end, as before
+    make_frame(100);
+    frame[101] = 0x55;
+    CHECK(0 == scan_split(101, 7) && 0 == ref_end(frame, 101));
+}
+
+
+/*
+ * dma_filter_jpeg
+ */
+static void filter_jpeg(const dma_elem_t* aSrc,
+                        size_t            aLen,
+                        uint8_t*          aDst)
+{
+    for (size_t i = 0; i < aLen / 4; ++i)
+    {
+        aDst[0] = aSrc[0].sample1;
+        aDst[1] = aSrc[1].sample1;
+        aDst[2] = aSrc[2].sample1;
+        aDst[3] = aSrc[3].sample1;
+        aSrc += 4;
+        aDst += 4;
+    }
+}
+
+
+static void benchmark(void)
+{
+    static dma_elem_t dma[FB_SIZE];
+    static uint8_t    fb[FB_SIZE + 4];
+    const int         rounds = 100;
+    const size_t      chunks = FB_SIZE / CHUNK;
+    size_t            end    = 0;
+
+    make_frame(JPEG_SIZE);
+    for (size_t i = 0; i < FB_SIZE; ++i)
+    {
+        dma[i].val     = rand();
+        dma[i].sample1 = frame[i];
+    }
+
+    printf("benchmark (host, %d byte frame in %d byte buffer, %d byte chunks):\n",
+           JPEG_SIZE, FB_SIZE, CHUNK);
+
+    /*
+     * Scan only, chunks already in frame buffer
+     */
+    double t0 = host_test_now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        end += ref_end(frame, chunks * CHUNK);
+    }
+    double t1 = host_test_now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        struct jpeg_eoi_t scanner;
+
+        jpeg_eoi_reset(&scanner);
+        for (size_t c = 0; c < chunks && !jpeg_eoi_scan(&scanner, frame + c * CHUNK, CHUNK); ++c)
+        {
+        }
+        end += scanner.end;
+    }
+    double t2 = host_test_now();
+
+    CHECK(end == 2 * rounds * JPEG_SIZE);
+    printf("  %-22s %8.1f us backward, %8.1f us chunked (%.1fx)\n", "find end",
+           (t1 - t0) / rounds * 1e6, (t2 - t1) / rounds * 1e6, (t1 - t0) / (t2 - t1));
+
+    /*
+     * Whole frame as done by the DMA filter task
+     */
+    end = 0;
+    t0  = host_test_now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        for (size_t c = 0; c < chunks; ++c)
+        {
+            filter_jpeg(dma + c * CHUNK, CHUNK, fb + c * CHUNK);
+        }
+        end += ref_end(fb, chunks * CHUNK);
+    }
+    t1 = host_test_now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        struct jpeg_eoi_t scanner;
+
+        jpeg_eoi_reset(&scanner);
+        for (size_t c = 0; c < chunks && !scanner.end; ++c)
+        {
+            filter_jpeg(dma + c * CHUNK, CHUNK, fb + c * CHUNK);
+            jpeg_eoi_scan(&scanner, fb + c * CHUNK, CHUNK);
+        }
+        end += scanner.end;
+    }
+    t2 = host_test_now();
+
+    CHECK(end == 2 * rounds * JPEG_SIZE);
+    printf("  %-22s %8.1f us before,   %8.1f us now     (%.1fx)\n", "filter and find end",
+           (t1 - t0) / rounds * 1e6, (t2 - t1) / rounds * 1e6, (t1 - t0) / (t2 - t1));
+}
+
+
+int main(void)
+{
+    srand(1);
+
+    test_scan();
+    benchmark();
+
+    return host_test_done();
+}
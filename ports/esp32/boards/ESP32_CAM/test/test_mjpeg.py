@@ -0,0 +1,306 @@
+# Unix port test and benchmark for campy_mjpeg (modcampy_mjpeg.c).
+#
+# A synthetic camera produces JPEG-like frames (SOI, frame number, filler,
+# EOI) at a fixed rate and a uasyncio server streams them to a loopback
+# client, which parses the multipart stream and checks every frame.  The
+# client is run at full speed and throttled, so frames have to be dropped.
+# The same is done with the usual Python code building each part as bytes
+# and writing it through the uasyncio stream.  Frames per second and bytes
+# allocated per frame (in frame sizes, i.e. copies) are printed for both.
+#
+# Run by "make unix-test".
+
+import gc
+import io
+import sys
+import time
+import uasyncio as asyncio
+from uasyncio import core
+import campy_mjpeg
+
+PORT = 8791
+
+# Socket buffers of a few frames, otherwise the loopback buffers megabytes
+# and a slow client reads old frames instead of missing them.  Options are
+# not exported by usocket, numbers are those of Linux.
+SO_SNDBUF = 7
+SO_RCVBUF = 8
+SOCKET_BUF = 65536
+CAMERA_FPS = 50
+DURATION_MS = 2000
+
+failures = 0
+
+
+def check(cond, what):
+    global failures
+    if not cond:
+        print("  FAIL", what)
+        failures += 1
+
+
+def make_frames():
+    frames = []
+    for n in range(16):
+        size = 20000 + n * 1500
+        f = bytearray(size)
+        f[0:2] = b"\xff\xd8"
+        f[-2:] = b"\xff\xd9"
+        for i in range(2, size - 2, 97):
+            f[i] = i & 0x7F
+        frames.append(f)
+    return frames
+
+
+FRAMES = make_frames()
+
+
+def stamp(frame, seq):
+    frame[2:6] = seq.to_bytes(4, "big")
+    return frame
+
+
+def measure():
+    # Collects outside of measured code, so allocations are not hidden
+    if gc.mem_free() < 1024 * 1024:
+        gc.collect()
+    return gc.mem_alloc()
+
+
+class Camera:
+    # Frames at a fixed rate, newest frame (or the end) wakes the streamer
+    def __init__(self):
+        self.seq = 0
+        self.ev = asyncio.Event()
+
+    async def run(self, sink, until):
+        while time.ticks_diff(until, time.ticks_ms()) > 0:
+            frame = stamp(bytearray(FRAMES[self.seq % len(FRAMES)]), self.seq)
+            self.seq += 1
+            sink(frame)
+            self.ev.set()
+            await asyncio.sleep_ms(1000 // CAMERA_FPS)
+        self.ev.set()
+
+
+async def serve_native(camera, sock, until, alloc):
+    st = campy_mjpeg.Streamer(sock)
+    asyncio.create_task(camera.run(st.send, until))
+    while time.ticks_diff(until, time.ticks_ms()) > 0:
+        if st.idle:
+            camera.ev.clear()
+            await camera.ev.wait()
+        a = measure()
+        done = st.pump()
+        alloc[0] += gc.mem_alloc() - a
+        if not done:
+            yield core._io_queue.queue_write(sock)
+    return st.stats()
+
+
+async def serve_python(camera, writer, until, alloc):
+    # Usual code: keep only the newest frame, format part, write and drain
+    latest = [None]
+    sent = 0
+
+    def sink(frame):
+        latest[0] = frame
+
+    asyncio.create_task(camera.run(sink, until))
+    writer.write(
+        b"HTTP/1.1 200 OK\r\n"
+        b"Content-Type: multipart/x-mixed-replace; boundary=frame\r\n\r\n"
+    )
+    while time.ticks_diff(until, time.ticks_ms()) > 0:
+        if latest[0] is None:
+            camera.ev.clear()
+            await camera.ev.wait()
+            continue
+        data, latest[0] = latest[0], None
+        a = measure()
+        head = "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: {}\r\n\r\n"
+        writer.write(head.format(len(data)).encode() + data + b"\r\n")
+        alloc[0] += gc.mem_alloc() - a
+        await writer.drain()
+        sent += 1
+    return (sent, camera.seq - sent, 0)
+
+
+async def client(delay_ms, result):
+    reader, writer = await asyncio.open_connection("127.0.0.1", PORT)
+    reader.s.setsockopt(1, SO_RCVBUF, SOCKET_BUF)
+    line = await reader.readline()
+    check(line.startswith(b"HTTP/1.1 200"), "status line")
+    while (await reader.readline()) != b"\r\n":
+        pass
+    last = -1
+    t0 = None
+    try:
+        while True:
+            line = await reader.readline()
+            if line == b"\r\n":
+                line = await reader.readline()
+            if not line:
+                break
+            check(line == b"--frame\r\n", "boundary")
+            length = 0
+            while True:
+                line = await reader.readline()
+                if line == b"\r\n":
+                    break
+                if line.startswith(b"Content-Length:"):
+                    length = int(line[15:])
+            data = await reader.readexactly(length)
+            seq = int.from_bytes(data[2:6], "big")
+            check(data[:2] == b"\xff\xd8" and data[-2:] == b"\xff\xd9", "SOI/EOI")
+            check(bytes(data[6:]) == bytes(FRAMES[seq % len(FRAMES)][6:]), "frame data")
+            check(seq > last, "frame order")
+            last = seq
+            if t0 is None:
+                t0 = time.ticks_ms()
+            result[0] += 1
+            result[1] += length
+            if delay_ms:
+                await asyncio.sleep_ms(delay_ms)
+    except (EOFError, OSError):
+        pass
+    result[2] = time.ticks_diff(time.ticks_ms(), t0 or time.ticks_ms())
+    await writer.wait_closed()
+
+
+async def run(native, delay_ms):
+    camera = Camera()
+    alloc = [0]
+    stats = [None]
+    got = [0, 0, 0]
+
+    async def handler(reader, writer):
+        writer.s.setsockopt(1, SO_SNDBUF, SOCKET_BUF)
+        until = time.ticks_add(time.ticks_ms(), DURATION_MS)
+        if native:
+            stats[0] = await serve_native(camera, writer.s, until, alloc)
+        else:
+            stats[0] = await serve_python(camera, writer, until, alloc)
+        await writer.wait_closed()
+
+    gc.collect()
+    gc.disable()
+    server = await asyncio.start_server(handler, "127.0.0.1", PORT)
+    try:
+        await asyncio.wait_for(client(delay_ms, got), DURATION_MS // 1000 + 5)
+    except asyncio.TimeoutError:
+        check(False, "client timed out")
+    server.close()
+    await server.wait_closed()
+    gc.enable()
+
+    sent, dropped, _ = stats[0]
+    avg = got[1] / got[0]
+    fps = got[0] * 1000 / max(got[2], 1)
+    check(got[0] > 0 and got[0] <= sent, "frames received")
+    check(delay_ms == 0 or dropped > 0, "stale frames dropped")
+    print(
+        "  %-6s client delay %2d ms: %5.1f fps, %3d sent, %3d dropped, %.2f copies/frame"
+        % ("native" if native else "python", delay_ms, fps, sent, dropped, alloc[0] / sent / avg)
+    )
+
+
+def test_blocking():
+    # Whole stream over a blocking socket, byte by byte as expected
+    import usocket as socket
+
+    srv = socket.socket()
+    srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    srv.bind(socket.getaddrinfo("127.0.0.1", PORT + 1)[0][-1])
+    srv.listen(1)
+    cli = socket.socket()
+    cli.connect(socket.getaddrinfo("127.0.0.1", PORT + 1)[0][-1])
+    conn = srv.accept()[0]
+
+    st = campy_mjpeg.Streamer(conn, "xyz", True, 7)
+    check(st.idle, "idle")
+    check(st.send(b"AB") is True, "send")
+    check(st.send(b"CDE") is False, "send drops waiting frame")
+    check(not st.idle, "not idle")
+    check(st.pump() is True and st.idle, "pump")
+    st.send(memoryview(b"FG"))
+    st.pump()
+    check(st.stats()[:2] == (2, 1), "stats")
+    expect = (
+        b"HTTP/1.1 200 OK\r\n"
+        b"Content-Type: multipart/x-mixed-replace; boundary=xyz\r\n"
+        b"Cache-Control: no-cache\r\n"
+        b"Connection: close\r\n\r\n"
+        b"--xyz\r\nContent-Type: image/jpeg\r\nContent-Length: 3\r\n\r\nCDE"
+        b"\r\n--xyz\r\nContent-Type: image/jpeg\r\nContent-Length: 2\r\n\r\nFG"
+    )
+    check(st.stats()[2] == len(expect), "bytes")
+    got = b""
+    while len(got) < len(expect):
+        got += cli.recv(len(expect) - len(got))
+    check(got == expect, "stream")
+
+    for args in ((conn, ""), (conn, "x" * 41), (conn, "x", True, 0), (1,)):
+        try:
+            campy_mjpeg.Streamer(*args)
+            check(False, "invalid arguments")
+        except (ValueError, OSError, TypeError):
+            pass
+    for s in (conn, cli, srv):
+        s.close()
+
+
+class SlowWriter(io.IOBase):
+    # Takes `budget` bytes, then would block until more budget is given
+    def __init__(self):
+        self.data = bytearray()
+        self.budget = 0
+
+    def write(self, buf):
+        if not self.budget:
+            return None
+        n = min(len(buf), self.budget)
+        self.data += buf[:n]
+        self.budget -= n
+        return n
+
+    def ioctl(self, req, arg):
+        return 0
+
+
+def test_changed():
+    # Frame resized between pumps is dropped, the rest of its part is zeros
+    w = SlowWriter()
+    st = campy_mjpeg.Streamer(w, "xyz", False, 7)
+    frame = bytearray(b"0123456789")
+    head = b"--xyz\r\nContent-Type: image/jpeg\r\nContent-Length: 10\r\n\r\n"
+    st.send(frame)
+    w.budget = len(head) + 4
+    check(st.pump() is False, "pump would block")
+    frame.extend(b"moved" * 100)
+    w.budget = 1000
+    check(st.pump() is True, "pump after change")
+    check(w.data == head + b"0123" + bytes(6), "rest of dropped frame")
+    check(st.stats()[:2] == (0, 1), "changed frame dropped")
+
+    # Next frame goes on as usual
+    w.data = bytearray()
+    st.send(b"AB")
+    st.pump()
+    check(w.data == b"\r\n" + head.replace(b"10", b"2") + b"AB", "next frame")
+    check(st.stats()[:2] == (1, 1), "next frame sent")
+    check(repr(st) == "<Streamer xyz sent:1 dropped:1>", "repr")
+
+
+print("blocking:")
+test_blocking()
+print("changed frames:")
+test_changed()
+print("benchmark (unix, loopback, camera at %d fps):" % CAMERA_FPS)
+for native in (False, True):
+    for delay in (0, 50):
+        asyncio.run(run(native, delay))
+        gc.collect()
+
+print("%d FAILED" % failures if failures else "OK")
+sys.exit(failures != 0)
@@ -24,12 +24,22 @@
  * THE SOFTWARE.
  */
 #include <string.h>
+#include "py/objarray.h"
 #include "py/objstr.h"
 #include "py/runtime.h"
 #include "extmod/vfs.h"
 #include "modmachine.h"
 #include "mphalport.h"
 #include "esp32/himem.h"
+#include "himem_cache.h"
+#include "himem_heap.h"
+
+
+// Every window of the cache is mapped into a bank of its own, which has to be
+// reserved by the sdkconfig (boards/sdkconfig.spirambs)
+#if CONFIG_SPIRAM_BANKSWITCH_RESERVE < HIMEM_CACHE_WINDOWS
+#error "CONFIG_SPIRAM_BANKSWITCH_RESERVE is lower than HIMEM_CACHE_WINDOWS"
+#endif
 
 
 
@@ -47,13 +57,21 @@
     while (false)
 
 
+/// Alignment of buffers in heap area
+#define HIMEM_HEAP_ALIGN 64
+
+
 
 
 STATIC esp_himem_handle_t      _himem;
 STATIC esp_himem_rangehandle_t _range;
+STATIC himem_cache_t           _cache;
 STATIC bool                    _locked;
 STATIC size_t                  _raw_size;
+STATIC size_t                  _heap_size;
 STATIC size_t                  _fs_size;
+STATIC himem_heap_t            _heap;
+STATIC bool                    _heap_ready;
 STATIC size_t                  _block_size = ESP_HIMEM_BLKSZ;
 STATIC size_t                  _block_cnt;
 
@@ -67,104 +85,44 @@ STATIC uintptr_t _align(uintptr_t aMem)
 
 
 
-enum _Direction
+/*
+ * Himem is split into raw area, heap area and filesystem area, in this order
+ */
+STATIC size_t _fs_base(void)
 {
-    HIMEM_2_RAM,
-    RAM_2_HIMEM,
-    HIMEM_SET
-};
+    return _raw_size + _heap_size;
+}
+
 
 
-STATIC void _dir_copy(void*    aRam,
-                      void*    aHimem,
-                      size_t   aSize,
-                      unsigned aDir)
+STATIC int _map(void*    aCtx,
+                size_t   aHimem,
+                unsigned aWindow,
+                void**   aPtr)
 {
-    enum _Direction dir = (enum _Direction)(aDir & 255);
-    
-    if (HIMEM_2_RAM == dir)
-    {
-        memcpy(aRam, aHimem, aSize);
-    }
-    else if (RAM_2_HIMEM == dir)
-    {
-        memcpy(aHimem, aRam, aSize);
-    }
-    else
-    {
-        memset(aHimem, aDir >> 8, aSize);
-    }
+    return esp_himem_map(_himem, _range, aHimem, aWindow * ESP_HIMEM_BLKSZ, ESP_HIMEM_BLKSZ, 0, aPtr);
 }
 
 
-STATIC void _himem_op(void*           aRam,
-                      uintptr_t       aHimem,
-                      size_t          aSize,
-                      enum _Direction aDir)
+STATIC int _unmap(void*    aCtx,
+                  unsigned aWindow,
+                  void*    aPtr)
+{
+    return esp_himem_unmap(_range, aPtr, ESP_HIMEM_BLKSZ);
+}
+
+
+STATIC void _himem_op(void*            aRam,
+                      uintptr_t        aHimem,
+                      size_t           aSize,
+                      enum himem_dir_t aDir,
+                      uint8_t          aValue)
 {
     /*
-     * Copy unaligned head
-     */
-    uintptr_t       aligned = _align(aHimem);
-    uint8_t*        ram     = aRam;
-    uint8_t const * end     = ram + aSize;
-    
-    if (aligned != aHimem)
-    {
-        size_t ofs = aHimem          - aligned;
-        size_t cnt = ESP_HIMEM_BLKSZ - ofs;
-        
-        if (cnt > aSize)
-        {
-            cnt = aSize;
-        }
-        
-        uint8_t* himem;
-        
-        ESPY__DO_OR_DIE(esp_himem_map(_himem, _range, aligned, 0, ESP_HIMEM_BLKSZ, 0, (void**)&himem), MemoryError);
-        _dir_copy(ram, himem + ofs, cnt, aDir);
-        ESPY__DO_OR_DIE(esp_himem_unmap(_range, himem, ESP_HIMEM_BLKSZ), MemoryError);
-        
-        ram    += cnt;
-        aHimem += cnt;
-    }
-    
-    if (ram == end)
-    {
-        return;
-    }
-    
-    
-    /*
-     * Now copy aligned part
-     */
-    uintptr_t bytes = _align(end - ram);
-    
-    while (bytes != 0)
-    {
-        uint8_t* himem;
-        
-        ESPY__DO_OR_DIE(esp_himem_map(_himem, _range, aHimem, 0, ESP_HIMEM_BLKSZ, 0, (void**)&himem), MemoryError);
-        _dir_copy(ram, himem, ESP_HIMEM_BLKSZ, aDir);
-        ESPY__DO_OR_DIE(esp_himem_unmap(_range, himem, ESP_HIMEM_BLKSZ), MemoryError);
-        
-        ram    += ESP_HIMEM_BLKSZ;
-        aHimem += ESP_HIMEM_BLKSZ;
-        bytes  -= ESP_HIMEM_BLKSZ;
-    }
-    
-    
-    /*
-     * And also copy size unaligned tail
+     * Blocks stay mapped in one of the windows of `_range` between calls,
+     * so sequential and repeated accesses don't map and unmap each block
      */
-    if (ram != end)
-    {
-        uint8_t* himem;
-        
-        ESPY__DO_OR_DIE(esp_himem_map(_himem, _range, aHimem, 0, ESP_HIMEM_BLKSZ, 0, (void**)&himem), MemoryError);
-        _dir_copy(ram, himem, end - ram, aDir);
-        ESPY__DO_OR_DIE(esp_himem_unmap(_range, himem, ESP_HIMEM_BLKSZ), MemoryError);
-    }
+    ESPY__DO_OR_DIE(himem_cache_copy(&_cache, aRam, aHimem, aSize, aDir, aValue), MemoryError);
 }
 
 
@@ -189,7 +147,7 @@ STATIC void _obj2buff(mp_buffer_info_t* aBuff,
 
 STATIC mp_obj_t himem_init(void)
 {
-    size_t size = _raw_size + _fs_size;
+    size_t size = _raw_size + _heap_size + _fs_size;
     
     if (0 == size)
     {
@@ -197,7 +155,9 @@ STATIC mp_obj_t himem_init(void)
         _block_cnt = _fs_size / _block_size;
         
         ESPY__DO_OR_DIE(esp_himem_alloc(_fs_size, &_himem),                  MemoryError);
-        ESPY__DO_OR_DIE(esp_himem_alloc_map_range(ESP_HIMEM_BLKSZ, &_range), MemoryError);
+        ESPY__DO_OR_DIE(esp_himem_alloc_map_range(ESP_HIMEM_BLKSZ * HIMEM_CACHE_WINDOWS, &_range), MemoryError);
+        
+        himem_cache_init(&_cache, ESP_HIMEM_BLKSZ, HIMEM_CACHE_WINDOWS, _map, _unmap, NULL);
     }
     
     return mp_const_none;
@@ -310,6 +270,70 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_VAR(himem_raw_size_obj, 0, himem_raw_size);
 
 
 
+/*
+ * Heap area is taken from filesystem area, raw area is left untouched
+ */
+STATIC mp_obj_t himem_heap_size(size_t          aArgsCnt,
+                                const mp_obj_t* aArgs)
+{
+    if (aArgsCnt > 0)
+    {
+        if (_locked)
+        {
+            mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Size of area locked"));
+        }
+        
+        if (!mp_obj_is_small_int(aArgs[0]))
+        {
+            mp_raise_msg(&mp_type_TypeError, MP_ERROR_TEXT("Size of area shall be an integer"));
+        }
+        
+        size_t size     = _heap_size + _fs_size;
+        size_t new_size = _align(MP_OBJ_SMALL_INT_VALUE(aArgs[0]) + ESP_HIMEM_BLKSZ - 1);
+        
+        if (new_size > size)
+        {
+            mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Requested size of area to large"));
+        }
+        
+        _fs_size   = size - new_size;
+        _block_cnt = _fs_size / _block_size;
+        _heap_size = new_size;
+    }
+    
+    return MP_OBJ_NEW_SMALL_INT(_heap_size);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR(himem_heap_size_obj, 0, himem_heap_size);
+
+
+
+
+STATIC mp_obj_t himem_heap_info(void)
+{
+    size_t   free    = _heap_size;
+    size_t   largest = _heap_size;
+    unsigned cnt     = 0;
+    
+    if (_heap_ready)
+    {
+        himem_heap_stat(&_heap, &free, &largest);
+        cnt = _heap.used_cnt;
+    }
+    
+    mp_obj_t tuple[] =
+    {
+        mp_obj_new_int_from_uint(free),
+        mp_obj_new_int_from_uint(largest),
+        MP_OBJ_NEW_SMALL_INT(cnt),
+    };
+    
+    return mp_obj_new_tuple(3, tuple);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(himem_heap_info_obj, himem_heap_info);
+
+
+
+
 STATIC mp_obj_t himem_page(void)
 {
     return MP_OBJ_NEW_SMALL_INT(ESP_HIMEM_BLKSZ);
@@ -335,7 +359,7 @@ STATIC mp_obj_t himem_read(mp_obj_t aAddress,
     
     vstr_init_len(&bytes, size);
     
-    _himem_op(bytes.buf, addr, size, HIMEM_2_RAM);
+    _himem_op(bytes.buf, addr, size, HIMEM_2_RAM, 0);
     
     return mp_obj_new_str_from_vstr(&mp_type_bytes, &bytes);
 }
@@ -359,7 +383,7 @@ STATIC mp_obj_t himem_write(mp_obj_t aAddress,
         mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Area out of range"));
     }
     
-    _himem_op(buff.buf, addr, buff.len, RAM_2_HIMEM);
+    _himem_op(buff.buf, addr, buff.len, RAM_2_HIMEM, 0);
     
     return mp_const_none;
 }
@@ -368,6 +392,86 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_2(himem_write_obj, himem_write);
 
 
 
+/*
+ * Get part of buffer `aArgs[1]` starting at optional offset `aArgs[2]`
+ * with optional size `aArgs[3]`
+ */
+STATIC void _slice(mp_buffer_info_t* aBuff,
+                   size_t            aArgsCnt,
+                   const mp_obj_t*   aArgs,
+                   unsigned          aRW)
+{
+    mp_get_buffer_raise(aArgs[1], aBuff, aRW);
+    
+    size_t offset = aArgsCnt > 2 ? mp_obj_get_int(aArgs[2]) : 0;
+    
+    if (offset > aBuff->len)
+    {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Offset out of buffer"));
+    }
+    
+    size_t size = aArgsCnt > 3 ? mp_obj_get_int(aArgs[3]) : aBuff->len - offset;
+    
+    if (size > aBuff->len - offset)
+    {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Size out of buffer"));
+    }
+    
+    aBuff->buf  = (uint8_t*)aBuff->buf + offset;
+    aBuff->len = size;
+}
+
+
+
+
+STATIC mp_obj_t himem_readinto(size_t          aArgsCnt,
+                               const mp_obj_t* aArgs)
+{
+    _locked = true;
+    
+    uintptr_t        addr = mp_obj_get_int(aArgs[0]);
+    mp_buffer_info_t buff;
+    
+    _slice(&buff, aArgsCnt, aArgs, MP_BUFFER_WRITE);
+    
+    if (addr + buff.len > _raw_size)
+    {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Area out of range"));
+    }
+    
+    _himem_op(buff.buf, addr, buff.len, HIMEM_2_RAM, 0);
+    
+    return MP_OBJ_NEW_SMALL_INT(buff.len);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(himem_readinto_obj, 2, 4, himem_readinto);
+
+
+
+
+STATIC mp_obj_t himem_write_from(size_t          aArgsCnt,
+                                 const mp_obj_t* aArgs)
+{
+    _locked = true;
+    
+    uintptr_t        addr = mp_obj_get_int(aArgs[0]);
+    mp_buffer_info_t buff;
+    
+    _slice(&buff, aArgsCnt, aArgs, MP_BUFFER_READ);
+    
+    if (addr + buff.len > _raw_size)
+    {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Area out of range"));
+    }
+    
+    _himem_op(buff.buf, addr, buff.len, RAM_2_HIMEM, 0);
+    
+    return MP_OBJ_NEW_SMALL_INT(buff.len);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(himem_write_from_obj, 2, 4, himem_write_from);
+
+
+
+
 STATIC mp_obj_t himem_set(mp_obj_t aAddress,
                           mp_obj_t aValue,
                           mp_obj_t aSize)
@@ -383,7 +487,7 @@ STATIC mp_obj_t himem_set(mp_obj_t aAddress,
         mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Area out of range"));
     }
     
-    _himem_op(NULL, addr, size, HIMEM_SET + (value << 8));
+    _himem_op(NULL, addr, size, HIMEM_SET, value);
     
     return mp_const_none;
 }
@@ -407,7 +511,7 @@ STATIC mp_obj_t himem_readblocks(size_t          aArgsCnt,
         offset += mp_obj_get_int(aArgs[2]);
     }
     
-    _himem_op(bufinfo.buf, _raw_size + offset, bufinfo.len, HIMEM_2_RAM);
+    _himem_op(bufinfo.buf, _fs_base() + offset, bufinfo.len, HIMEM_2_RAM, 0);
     
     return mp_const_none;
 }
@@ -431,7 +535,7 @@ STATIC mp_obj_t himem_writeblocks(size_t          aArgsCnt,
         offset += mp_obj_get_int(aArgs[2]);
     }
     
-    _himem_op(bufinfo.buf, _raw_size + offset, bufinfo.len, RAM_2_HIMEM);
+    _himem_op(bufinfo.buf, _fs_base() + offset, bufinfo.len, RAM_2_HIMEM, 0);
     
     return mp_const_none;
 }
@@ -462,9 +566,10 @@ STATIC mp_obj_t himem_ioctl(mp_obj_t aCmd,
         case MP_BLOCKDEV_IOCTL_BLOCK_ERASE:
         {
             _himem_op(NULL,
-                      _raw_size + (mp_obj_get_int(aArg) * _block_size),
+                      _fs_base() + (mp_obj_get_int(aArg) * _block_size),
                       _block_size,
-                      HIMEM_SET + (0xFF << 8));
+                      HIMEM_SET,
+                      0xFF);
             
             return MP_OBJ_NEW_SMALL_INT(0);
         }
@@ -477,12 +582,258 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_2(himem_ioctl_obj, himem_ioctl);
 
 
 
+/*
+ * Buffer allocated in heap area of himem.
+ *
+ * Himem can't be accessed directly, so a part of the buffer is "mapped" by
+ * copying it into a window in RAM, which is then copied back on unmap.
+ * The window is kept for the next map so mapping parts of the same size
+ * doesn't allocate from GC heap.
+ */
+typedef struct himem_buffer_obj_t
+{
+    mp_obj_base_t base;
+    int           handle;       // -1 once freed
+    size_t        len;
+    uint8_t*      window;
+    size_t        window_size;
+    size_t        map_offset;
+    size_t        map_len;      // 0 if not mapped
+    bool          map_rw;
+}
+himem_buffer_obj_t;
+
+
+STATIC const mp_obj_type_t himem_buffer_type;
+
+
+
+
+STATIC uintptr_t _buffer_addr(himem_buffer_obj_t* aSelf)
+{
+    const himem_chunk_t* chunk = himem_heap_chunk(&_heap, aSelf->handle);
+    
+    if (!chunk)
+    {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Buffer freed"));
+    }
+    
+    return _raw_size + chunk->offset;
+}
+
+
+
+
+STATIC void _buffer_unmap(himem_buffer_obj_t* aSelf)
+{
+    if (aSelf->map_len && aSelf->map_rw)
+    {
+        _himem_op(aSelf->window, _buffer_addr(aSelf) + aSelf->map_offset, aSelf->map_len, RAM_2_HIMEM, 0);
+    }
+    
+    aSelf->map_len = 0;
+}
+
+
+
+
+/// Buffer(size)
+STATIC mp_obj_t himem_buffer_make_new(const mp_obj_type_t* aType,
+                                      size_t               aArgsCnt,
+                                      size_t               aKwCnt,
+                                      const mp_obj_t*      aArgs)
+{
+    mp_arg_check_num(aArgsCnt, aKwCnt, 1, 1, false);
+    
+    mp_int_t size = mp_obj_get_int(aArgs[0]);
+    
+    if (size < 0)
+    {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Negative size"));
+    }
+    
+    if (!_heap_ready)
+    {
+        himem_heap_init(&_heap, _heap_size, HIMEM_HEAP_ALIGN);
+        _heap_ready = true;
+    }
+    
+    _locked = true;
+    
+    int handle = himem_heap_alloc(&_heap, size);
+    
+    if (handle < 0)
+    {
+        mp_raise_msg(&mp_type_MemoryError, MP_ERROR_TEXT("Not enough memory in heap area"));
+    }
+    
+    himem_buffer_obj_t* self = m_new_obj_with_finaliser(himem_buffer_obj_t);
+    
+    self->base.type   = aType;
+    self->handle      = handle;
+    self->len         = size;
+    self->window      = NULL;
+    self->window_size = 0;
+    self->map_len     = 0;
+    
+    return MP_OBJ_FROM_PTR(self);
+}
+
+
+
+
+/// map(offset=0, size=-1, readonly=False)
+///
+/// Returns memoryview of `size` bytes from `offset`, valid until unmap(),
+/// the next map() or free()
+STATIC mp_obj_t himem_buffer_map(size_t          aArgsCnt,
+                                 const mp_obj_t* aArgs,
+                                 mp_map_t*       aKwArgs)
+{
+    enum { ARG_offset, ARG_size, ARG_readonly };
+    
+    STATIC const mp_arg_t allowed_args[] =
+    {
+        { MP_QSTR_offset,   MP_ARG_INT,  {.u_int  = 0}     },
+        { MP_QSTR_size,     MP_ARG_INT,  {.u_int  = -1}    },
+        { MP_QSTR_readonly, MP_ARG_BOOL, {.u_bool = false} },
+    };
+    
+    himem_buffer_obj_t* self = MP_OBJ_TO_PTR(aArgs[0]);
+    mp_arg_val_t        args[MP_ARRAY_SIZE(allowed_args)];
+    
+    mp_arg_parse_all(aArgsCnt - 1, aArgs + 1, aKwArgs, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    
+    mp_int_t offset = args[ARG_offset].u_int;
+    mp_int_t size   = args[ARG_size].u_int;
+    
+    if (offset < 0 || (size_t)offset > self->len)
+    {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Offset out of buffer"));
+    }
+    
+    if (size < 0)
+    {
+        size = self->len - offset;
+    }
+    
+    if ((size_t)size > self->len - offset)
+    {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Size out of buffer"));
+    }
+    
+    uintptr_t addr = _buffer_addr(self);
+    
+    _buffer_unmap(self);
+    
+    if (self->window_size < (size_t)size)
+    {
+        self->window      = m_new(uint8_t, size);
+        self->window_size = size;
+    }
+    
+    _himem_op(self->window, addr + offset, size, HIMEM_2_RAM, 0);
+    
+    self->map_offset = offset;
+    self->map_len    = size;
+    self->map_rw     = !args[ARG_readonly].u_bool;
+    
+    return mp_obj_new_memoryview(self->map_rw ? 'B' | MP_OBJ_ARRAY_TYPECODE_FLAG_RW : 'B',
+                                 size,
+                                 self->window);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(himem_buffer_map_obj, 1, himem_buffer_map);
+
+
+
+
+/// unmap()
+///
+/// Copies mapped part back to himem, unless it was mapped read only
+STATIC mp_obj_t himem_buffer_unmap(mp_obj_t aSelf)
+{
+    himem_buffer_obj_t* self = MP_OBJ_TO_PTR(aSelf);
+    
+    _buffer_unmap(self);
+    
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(himem_buffer_unmap_obj, himem_buffer_unmap);
+
+
+
+
+/// free()
+///
+/// Returns buffer to heap area, mapped part is dropped
+STATIC mp_obj_t himem_buffer_free(mp_obj_t aSelf)
+{
+    himem_buffer_obj_t* self = MP_OBJ_TO_PTR(aSelf);
+    
+    if (self->handle >= 0)
+    {
+        himem_heap_free(&_heap, self->handle);
+    }
+    
+    self->handle      = -1;
+    self->map_len     = 0;
+    self->window      = NULL;
+    self->window_size = 0;
+    
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(himem_buffer_free_obj, himem_buffer_free);
+
+
+
+
+STATIC mp_obj_t himem_buffer_unary_op(mp_unary_op_t aOp,
+                                      mp_obj_t      aSelf)
+{
+    himem_buffer_obj_t* self = MP_OBJ_TO_PTR(aSelf);
+    
+    switch (aOp)
+    {
+        case MP_UNARY_OP_LEN:
+            return MP_OBJ_NEW_SMALL_INT(self->handle >= 0 ? self->len : 0);
+        default:
+            return MP_OBJ_NULL;
+    }
+}
+
+
+
+
+STATIC const mp_rom_map_elem_t himem_buffer_locals_dict_table[] =
+{
+    { MP_ROM_QSTR(MP_QSTR_map),     MP_ROM_PTR(&himem_buffer_map_obj)   },
+    { MP_ROM_QSTR(MP_QSTR_unmap),   MP_ROM_PTR(&himem_buffer_unmap_obj) },
+    { MP_ROM_QSTR(MP_QSTR_free),    MP_ROM_PTR(&himem_buffer_free_obj)  },
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&himem_buffer_free_obj)  },
+};
+STATIC MP_DEFINE_CONST_DICT(himem_buffer_locals_dict, himem_buffer_locals_dict_table);
+
+
+STATIC const mp_obj_type_t himem_buffer_type =
+{
+    { &mp_type_type },
+    .name        = MP_QSTR_Buffer,
+    .make_new    = himem_buffer_make_new,
+    .unary_op    = himem_buffer_unary_op,
+    .locals_dict = (mp_obj_dict_t*)&himem_buffer_locals_dict,
+};
+
+
+
+
 STATIC const mp_map_elem_t globals_dict_table[] =
 {
     { MP_ROM_QSTR(MP_QSTR___name__),    MP_ROM_QSTR(MP_QSTR_himem)         },
     { MP_ROM_QSTR(MP_QSTR___init__),    MP_ROM_PTR(&himem_init_obj)        },
     { MP_ROM_QSTR(MP_QSTR_read),        MP_ROM_PTR(&himem_read_obj)        },
     { MP_ROM_QSTR(MP_QSTR_write),       MP_ROM_PTR(&himem_write_obj)       },
+    { MP_ROM_QSTR(MP_QSTR_readinto),    MP_ROM_PTR(&himem_readinto_obj)    },
+    { MP_ROM_QSTR(MP_QSTR_write_from),  MP_ROM_PTR(&himem_write_from_obj)  },
     { MP_ROM_QSTR(MP_QSTR_set),         MP_ROM_PTR(&himem_set_obj)         },
     { MP_ROM_QSTR(MP_QSTR_readblocks),  MP_ROM_PTR(&himem_readblocks_obj)  },
     { MP_ROM_QSTR(MP_QSTR_writeblocks), MP_ROM_PTR(&himem_writeblocks_obj) },
@@ -490,7 +841,10 @@ STATIC const mp_map_elem_t globals_dict_table[] =
     { MP_ROM_QSTR(MP_QSTR_fs_size),     MP_ROM_PTR(&himem_fs_size_obj)     },
     { MP_ROM_QSTR(MP_QSTR_raw_size),    MP_ROM_PTR(&himem_raw_size_obj)    },
     { MP_ROM_QSTR(MP_QSTR_block_size),  MP_ROM_PTR(&himem_block_size_obj)  },
-    { MP_ROM_QSTR(MP_QSTR_page),        MP_ROM_PTR(&himem_page_obj)        }
+    { MP_ROM_QSTR(MP_QSTR_heap_size),   MP_ROM_PTR(&himem_heap_size_obj)   },
+    { MP_ROM_QSTR(MP_QSTR_heap_info),   MP_ROM_PTR(&himem_heap_info_obj)   },
+    { MP_ROM_QSTR(MP_QSTR_page),        MP_ROM_PTR(&himem_page_obj)        },
+    { MP_ROM_QSTR(MP_QSTR_Buffer),      MP_ROM_PTR(&himem_buffer_type)     }
 };
 STATIC MP_DEFINE_CONST_DICT(globals_dict, globals_dict_table);
 
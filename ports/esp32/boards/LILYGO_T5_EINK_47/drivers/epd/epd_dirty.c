@@ -0,0 +1,134 @@
+#include "epd_dirty.h"
+
+#include <string.h>
+
+
+/// Grow area `a` to also cover area `b`, which is below it.
+static void extend(EpdDirtyRect_t *a, const EpdDirtyRect_t *b)
+{
+    int x0 = a->x < b->x ? a->x : b->x;
+    int x1 = a->x + a->width > b->x + b->width ? a->x + a->width
+             : b->x + b->width;
+    a->x = x0;
+    a->width = x1 - x0;
+    a->height = b->y + b->height - a->y;
+}
+
+/// Number of clean rows between area `a` and area `b` below it.
+static int gap(const EpdDirtyRect_t *a, const EpdDirtyRect_t *b)
+{
+    return b->y - (a->y + a->height);
+}
+
+size_t epd_dirty_find(const uint8_t *fb, const uint8_t *shadow, int width,
+                      int height, EpdDirtyRect_t *rects, size_t max_rects,
+                      int merge_gap)
+{
+    const size_t row_bytes = width / 2;
+    size_t n = 0;
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t *a = fb + y * row_bytes;
+        const uint8_t *b = shadow + y * row_bytes;
+        if (memcmp(a, b, row_bytes) == 0) {
+            continue;
+        }
+
+        // Find the first and last differing bytes of the row
+        size_t x0 = 0;
+        while (a[x0] == b[x0]) {
+            x0++;
+        }
+        size_t x1 = row_bytes - 1;
+        while (a[x1] == b[x1]) {
+            x1--;
+        }
+        EpdDirtyRect_t row = { 2 * x0, y, 2 * (x1 - x0 + 1), 1 };
+
+        if (n == 0) {
+            rects[n++] = row;
+            continue;
+        }
+        int row_gap = gap(&rects[n - 1], &row);
+        if (row_gap <= merge_gap) {
+            extend(&rects[n - 1], &row);
+            continue;
+        }
+        if (n < max_rects) {
+            rects[n++] = row;
+            continue;
+        }
+
+        // Out of space, so merge whichever neighbouring pair is closest,
+        // counting the new row as the last area
+        size_t best = n - 1;
+        int best_gap = row_gap;
+        for (size_t i = 0; i + 1 < n; i++) {
+            if (gap(&rects[i], &rects[i + 1]) < best_gap) {
+                best = i;
+                best_gap = gap(&rects[i], &rects[i + 1]);
+            }
+        }
+        if (best == n - 1) {
+            extend(&rects[n - 1], &row);
+        } else {
+            extend(&rects[best], &rects[best + 1]);
+            memmove(&rects[best + 1], &rects[best + 2],
+                    (n - best - 2) * sizeof(*rects));
+            rects[n - 1] = row;
+        }
+    }
+
+    return n;
+}
+
+void epd_dirty_extract(const uint8_t *fb, int fb_width, EpdDirtyRect_t area,
+                       uint8_t *out)
+{
+    const size_t row_bytes = fb_width / 2;
+    const size_t out_bytes = area.width / 2;
+    const uint8_t *src = fb + area.y * row_bytes + area.x / 2;
+    for (int y = 0; y < area.height; y++) {
+        memcpy(out, src, out_bytes);
+        out += out_bytes;
+        src += row_bytes;
+    }
+}
+
+void epd_dirty_commit(uint8_t *shadow, const uint8_t *fb, int fb_width,
+                      EpdDirtyRect_t area)
+{
+    const size_t row_bytes = fb_width / 2;
+    // The rows of a dirty area match outside of its x range, so whole rows
+    // can be copied
+    memcpy(shadow + area.y * row_bytes, fb + area.y * row_bytes,
+           area.height * row_bytes);
+}
+
+void epd_dirty_fill(uint8_t *shadow, int fb_width, int fb_height,
+                    EpdDirtyRect_t area, uint8_t color)
+{
+    int x0 = area.x < 0 ? 0 : area.x;
+    int y0 = area.y < 0 ? 0 : area.y;
+    int x1 = area.x + area.width > fb_width ? fb_width : area.x + area.width;
+    int y1 = area.y + area.height > fb_height ? fb_height : area.y + area.height;
+    const size_t row_bytes = fb_width / 2;
+    color &= 0x0F;
+
+    for (int y = y0; y < y1; y++) {
+        uint8_t *row = shadow + y * row_bytes;
+        int x = x0;
+        if (x < x1 && x % 2) {
+            row[x / 2] = (row[x / 2] & 0x0F) | (color << 4);
+            x++;
+        }
+        int whole = (x1 - x) / 2;
+        if (whole > 0) {
+            memset(row + x / 2, color | (color << 4), whole);
+            x += 2 * whole;
+        }
+        if (x < x1) {
+            row[x / 2] = (row[x / 2] & 0xF0) | color;
+        }
+    }
+}
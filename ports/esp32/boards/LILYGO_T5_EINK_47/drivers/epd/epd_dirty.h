@@ -0,0 +1,80 @@
+/**
+ * Dirty-region tracking for a 4 bit per pixel framebuffer.
+ *
+ * The framebuffer is compared with a shadow copy of what was last sent to
+ * the display, and the rows that differ are coalesced into a few rectangles
+ * so only those need to be redrawn.
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Maximum number of rectangles returned by `epd_dirty_find`.
+#define EPD_DIRTY_MAX_RECTS 8
+
+/// Dirty rows separated by at most this many clean rows are drawn together,
+/// since each separate draw has a fixed cost of a pass over the whole panel.
+#define EPD_DIRTY_MERGE_GAP 16
+
+/// An area of the framebuffer, with the same layout as `Rect_t`.
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} EpdDirtyRect_t;
+
+/**
+ * Find the areas where a framebuffer differs from its shadow copy.
+ *
+ * @param fb: The framebuffer, `width / 2` bytes per row.
+ * @param shadow: The shadow copy, with the same layout as `fb`.
+ * @param width: Width of the framebuffer in pixels, must be even.
+ * @param height: Height of the framebuffer in pixels.
+ * @param rects: Receives the dirty areas, in order of `y`.  The areas are
+ *   aligned to whole bytes (`x` and `width` are even) and don't overlap.
+ * @param max_rects: Capacity of `rects`, at least 1.  If more areas are
+ *   found then the closest ones are merged.
+ * @param merge_gap: Merge areas separated by at most this many clean rows.
+ * @returns The number of areas stored in `rects`.
+ */
+size_t epd_dirty_find(const uint8_t *fb, const uint8_t *shadow, int width,
+                      int height, EpdDirtyRect_t *rects, size_t max_rects,
+                      int merge_gap);
+
+/**
+ * Copy an area of a framebuffer into a packed image, in the form expected by
+ * `epd_draw_image`.
+ *
+ * @param fb: The framebuffer, `fb_width / 2` bytes per row.
+ * @param fb_width: Width of the framebuffer in pixels, must be even.
+ * @param area: The area to copy, `x` and `width` must be even.
+ * @param out: Receives `area.width / 2 * area.height` bytes.
+ */
+void epd_dirty_extract(const uint8_t *fb, int fb_width, EpdDirtyRect_t area,
+                       uint8_t *out);
+
+/**
+ * Copy the rows of an area from the framebuffer to the shadow copy, after
+ * the area has been drawn.
+ */
+void epd_dirty_commit(uint8_t *shadow, const uint8_t *fb, int fb_width,
+                      EpdDirtyRect_t area);
+
+/**
+ * Set an area of the shadow copy to a color, after the same area of the
+ * display has been cleared to that color.
+ *
+ * @param color: 4 bit color, 15 is white.
+ */
+void epd_dirty_fill(uint8_t *shadow, int fb_width, int fb_height,
+                    EpdDirtyRect_t area, uint8_t color);
+
+#ifdef __cplusplus
+}
+#endif
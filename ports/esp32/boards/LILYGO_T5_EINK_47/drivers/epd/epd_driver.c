@@ -45,7 +45,36 @@ const int contrast_cycles_4_white[15] = {10, 10, 8, 8, 8,  8,  8, 10, 10, 15, 15
 // Heap space to use for the EPD output lookup table, which
 // is calculated for each cycle.
 static uint8_t *conversion_lut;
-static QueueHandle_t output_queue;
+
+// Number of line buffers handed from `provide_out` to `feed_display`.
+// While one line is being output, the next one is prepared.
+#define LINE_BUFFER_COUNT 2
+
+// Line hand-off between the render tasks.  `provide_out` takes a buffer
+// from `free_lines`, fills it and passes it through `ready_lines` to
+// `feed_display`, which gives it back once the line is converted.
+static uint8_t line_buffers[LINE_BUFFER_COUNT][EPD_WIDTH / 2];
+static QueueHandle_t free_lines;
+static QueueHandle_t ready_lines;
+
+typedef struct {
+    uint8_t *data_ptr;
+    Rect_t area;
+    int frame;
+    enum DrawMode mode;
+} OutputParams;
+
+// Images to draw, for `provide_out`, and frames to output, for
+// `feed_display`.
+static QueueHandle_t image_queue;
+static QueueHandle_t frame_queue;
+// Given by `feed_display` after each frame.
+static SemaphoreHandle_t frame_done;
+// Taken while an image is being drawn.
+static SemaphoreHandle_t draw_idle;
+
+static void provide_out(void *arg);
+static void feed_display(void *arg);
 
 // output a row to the display.
 static void write_row(uint32_t output_time_dus)
@@ -65,9 +94,31 @@ void epd_init()
     skipping = 0;
     epd_base_init(EPD_WIDTH);
 
-    conversion_lut = (uint8_t *)heap_caps_malloc(1 << 16, MALLOC_CAP_8BIT);
+    if (conversion_lut != NULL) {
+        return;
+    }
+
+    conversion_lut = (uint8_t *)heap_caps_malloc(EPD_LUT_SIZE, MALLOC_CAP_8BIT);
     assert(conversion_lut != NULL);
-    output_queue = xQueueCreate(64, EPD_WIDTH / 2);
+
+    free_lines = xQueueCreate(LINE_BUFFER_COUNT, sizeof(uint8_t *));
+    ready_lines = xQueueCreate(LINE_BUFFER_COUNT, sizeof(uint8_t *));
+    image_queue = xQueueCreate(1, sizeof(OutputParams));
+    frame_queue = xQueueCreate(1, sizeof(OutputParams));
+    frame_done = xSemaphoreCreateBinary();
+    draw_idle = xSemaphoreCreateBinary();
+    assert(free_lines && ready_lines && image_queue && frame_queue &&
+           frame_done && draw_idle);
+    xSemaphoreGive(draw_idle);
+    for (int i = 0; i < LINE_BUFFER_COUNT; i++) {
+        uint8_t *line = line_buffers[i];
+        xQueueSendToBack(free_lines, &line, 0);
+    }
+
+    // The render tasks live as long as the display, so that drawing an
+    // image doesn't create and delete tasks for each frame.
+    xTaskCreatePinnedToCore(provide_out, "provide_out", 8000, NULL, 10, NULL, 0);
+    xTaskCreatePinnedToCore(feed_display, "render", 8000, NULL, 10, NULL, 1);
 }
 
 // skip a display row
@@ -99,6 +150,7 @@ void skip_row(uint8_t pipeline_finish_time)
 
 void epd_push_pixels(Rect_t area, short time, int color)
 {
+    epd_draw_wait();
 
     uint8_t row[EPD_LINE_BYTES] = {0};
 
@@ -180,27 +232,6 @@ void reorder_line_buffer(uint32_t *line_data)
     }
 }
 
-void IRAM_ATTR calc_epd_input_4bpp(uint32_t *line_data, uint8_t *epd_input,
-                                   uint8_t k, uint8_t *conversion_lut)
-{
-
-    uint32_t *wide_epd_input = (uint32_t *)epd_input;
-    uint16_t *line_data_16 = (uint16_t *)line_data;
-
-    // this is reversed for little-endian, but this is later compensated
-    // through the output peripheral.
-    for (uint32_t j = 0; j < EPD_WIDTH / 16; j++) {
-
-        uint16_t v1 = *(line_data_16++);
-        uint16_t v2 = *(line_data_16++);
-        uint16_t v3 = *(line_data_16++);
-        uint16_t v4 = *(line_data_16++);
-        uint32_t pixel = conversion_lut[v1] << 16 | conversion_lut[v2] << 24 |
-                         conversion_lut[v3] | conversion_lut[v4] << 8;
-        wide_epd_input[j] = pixel;
-    }
-}
-
 const DRAM_ATTR uint32_t lut_1bpp[256] = {
     0x0000, 0x0001, 0x0004, 0x0005, 0x0010, 0x0011, 0x0014, 0x0015, 0x0040,
     0x0041, 0x0044, 0x0045, 0x0050, 0x0051, 0x0054, 0x0055, 0x0100, 0x0101,
@@ -248,50 +279,6 @@ void IRAM_ATTR calc_epd_input_1bpp(uint8_t *line_data, uint8_t *epd_input,
     }
 }
 
-static void IRAM_ATTR reset_lut(uint8_t *lut_mem, enum DrawMode mode)
-{
-    switch (mode) {
-    case BLACK_ON_WHITE:
-        memset(lut_mem, 0x55, (1 << 16));
-        break;
-    case WHITE_ON_BLACK:
-    case WHITE_ON_WHITE:
-        memset(lut_mem, 0xAA, (1 << 16));
-        break;
-    default:
-        ESP_LOGW("epd_driver", "unknown draw mode %d!", mode);
-        break;
-    }
-}
-
-static void IRAM_ATTR update_LUT(uint8_t *lut_mem, uint8_t k,
-                                 enum DrawMode mode)
-{
-    if (mode == BLACK_ON_WHITE || mode == WHITE_ON_WHITE) {
-        k = 15 - k;
-    }
-
-    // reset the pixels which are not to be lightened / darkened
-    // any longer in the current frame
-    for (uint32_t l = k; l < (1 << 16); l += 16) {
-        lut_mem[l] &= 0xFC;
-    }
-
-    for (uint32_t l = (k << 4); l < (1 << 16); l += (1 << 8)) {
-        for (uint32_t p = 0; p < 16; p++) {
-            lut_mem[l + p] &= 0xF3;
-        }
-    }
-    for (uint32_t l = (k << 8); l < (1 << 16); l += (1 << 12)) {
-        for (uint32_t p = 0; p < (1 << 8); p++) {
-            lut_mem[l + p] &= 0xCF;
-        }
-    }
-    for (uint32_t p = (k << 12); p < ((k + 1) << 12); p++) {
-        lut_mem[p] &= 0x3F;
-    }
-}
-
 void IRAM_ATTR nibble_shift_buffer_right(uint8_t *buf, uint32_t len)
 {
     uint8_t carry = 0xF;
@@ -648,27 +635,12 @@ void IRAM_ATTR epd_draw_grayscale_image(Rect_t area, uint8_t *data)
     epd_draw_image(area, data, BLACK_ON_WHITE);
 }
 
-typedef struct {
-    uint8_t *data_ptr;
-    SemaphoreHandle_t done_smphr;
-    Rect_t area;
-    int frame;
-    enum DrawMode mode;
-} OutputParams;
-
-void IRAM_ATTR provide_out(OutputParams *params)
+// Pass the lines of the image area to `feed_display`, for one frame.
+static void IRAM_ATTR provide_lines(const OutputParams *params)
 {
-    uint8_t line[EPD_WIDTH / 2];
-    memset(line, 255, EPD_WIDTH / 2);
     Rect_t area = params->area;
     uint8_t *ptr = params->data_ptr;
 
-    if (params->frame == 0) {
-        reset_lut(conversion_lut, params->mode);
-    }
-
-    update_LUT(conversion_lut, params->frame, params->mode);
-
     if (area.x < 0) {
         ptr += -area.x / 2;
     }
@@ -681,13 +653,15 @@ void IRAM_ATTR provide_out(OutputParams *params)
             continue;
         }
 
-        uint32_t *lp;
-        bool shifted = false;
+        uint8_t *line;
+        xQueueReceive(free_lines, &line, portMAX_DELAY);
+
         if (area.width == EPD_WIDTH && area.x == 0) {
-            lp = (uint32_t *)ptr;
+            memcpy(line, ptr, EPD_WIDTH / 2);
             ptr += EPD_WIDTH / 2;
         } else {
-            uint8_t *buf_start = (uint8_t *)line;
+            memset(line, 255, EPD_WIDTH / 2);
+            uint8_t *buf_start = line;
             uint32_t line_bytes = area.width / 2 + area.width % 2;
             if (area.x >= 0) {
                 buf_start += area.x / 2;
@@ -705,63 +679,92 @@ void IRAM_ATTR provide_out(OutputParams *params)
                 *(buf_start + line_bytes - 1) |= 0xF0;
             }
             if (area.x % 2 == 1 && area.x < EPD_WIDTH) {
-                shifted = true;
                 // shift one nibble to right
                 nibble_shift_buffer_right(
                     buf_start, min(line_bytes + 1, (uint32_t)line + EPD_WIDTH / 2 -
                                    (uint32_t)buf_start));
             }
-            lp = (uint32_t *)line;
-        }
-        xQueueSendToBack(output_queue, lp, portMAX_DELAY);
-        if (shifted) {
-            memset(line, 255, EPD_WIDTH / 2);
         }
+        xQueueSendToBack(ready_lines, &line, portMAX_DELAY);
     }
-
-    xSemaphoreGive(params->done_smphr);
-    vTaskDelay(portMAX_DELAY);
 }
 
-void IRAM_ATTR feed_display(OutputParams *params)
+// Render task on core 0, which runs the frames of each image and prepares
+// the lines for `feed_display`.
+static void IRAM_ATTR provide_out(void *arg)
 {
-    Rect_t area = params->area;
-    const int *contrast_lut = contrast_cycles_4;
-    switch (params->mode) {
-    case WHITE_ON_WHITE:
-    case BLACK_ON_WHITE:
-        contrast_lut = contrast_cycles_4;
-        break;
-    case WHITE_ON_BLACK:
-        contrast_lut = contrast_cycles_4_white;
-        break;
-    }
+    OutputParams params;
 
-    epd_start_frame();
-    for (int i = 0; i < EPD_HEIGHT; i++) {
-        if (i < area.y || i >= area.y + area.height) {
-            skip_row(contrast_lut[params->frame]);
-            continue;
+    for (;;) {
+        xQueueReceive(image_queue, &params, portMAX_DELAY);
+        vTaskDelay(10);
+
+        for (int k = 0; k < EPD_LUT_FRAMES; k++) {
+            params.frame = k;
+            xQueueSendToBack(frame_queue, &params, portMAX_DELAY);
+
+            // The table only has to change where pixels are done with
+            // this frame
+            if (k == 0) {
+                epd_lut_reset(conversion_lut, params.mode);
+            }
+            epd_lut_update(conversion_lut, k, params.mode);
+
+            provide_lines(&params);
+            xSemaphoreTake(frame_done, portMAX_DELAY);
         }
-        uint8_t output[EPD_WIDTH / 2];
-        xQueueReceive(output_queue, output, portMAX_DELAY);
-        calc_epd_input_4bpp((uint32_t *)output, epd_get_current_buffer(),
-                            params->frame, conversion_lut);
-        write_row(contrast_lut[params->frame]);
-    }
-    if (!skipping) {
-        // Since we "pipeline" row output, we still have to latch out the last row.
-        write_row(contrast_lut[params->frame]);
+
+        xSemaphoreGive(draw_idle);
     }
-    epd_end_frame();
+}
+
+// Render task on core 1, which converts the lines and outputs each frame.
+static void IRAM_ATTR feed_display(void *arg)
+{
+    OutputParams params;
+
+    for (;;) {
+        xQueueReceive(frame_queue, &params, portMAX_DELAY);
+
+        Rect_t area = params.area;
+        const int *contrast_lut = contrast_cycles_4;
+        switch (params.mode) {
+        case WHITE_ON_WHITE:
+        case BLACK_ON_WHITE:
+            contrast_lut = contrast_cycles_4;
+            break;
+        case WHITE_ON_BLACK:
+            contrast_lut = contrast_cycles_4_white;
+            break;
+        }
+
+        epd_start_frame();
+        for (int i = 0; i < EPD_HEIGHT; i++) {
+            if (i < area.y || i >= area.y + area.height) {
+                skip_row(contrast_lut[params.frame]);
+                continue;
+            }
+            uint8_t *line;
+            xQueueReceive(ready_lines, &line, portMAX_DELAY);
+            epd_lut_convert_4bpp((uint32_t *)line, epd_get_current_buffer(),
+                                 conversion_lut, EPD_WIDTH);
+            xQueueSendToBack(free_lines, &line, portMAX_DELAY);
+            write_row(contrast_lut[params.frame]);
+        }
+        if (!skipping) {
+            // Since we "pipeline" row output, we still have to latch out the last row.
+            write_row(contrast_lut[params.frame]);
+        }
+        epd_end_frame();
 
-    xSemaphoreGive(params->done_smphr);
-    vTaskDelay(portMAX_DELAY);
+        xSemaphoreGive(frame_done);
+    }
 }
 
 void IRAM_ATTR epd_draw_frame_1bit(Rect_t area, uint8_t *ptr,
                                    enum DrawMode mode, int time)
 {
+    epd_draw_wait();
 
     epd_start_frame();
     uint8_t line[EPD_WIDTH / 8];
@@ -833,44 +836,35 @@ void IRAM_ATTR epd_draw_frame_1bit(Rect_t area, uint8_t *ptr,
     epd_end_frame();
 }
 
-void IRAM_ATTR epd_draw_image(Rect_t area, uint8_t *data, enum DrawMode mode)
+void epd_draw_image_async(Rect_t area, uint8_t *data, enum DrawMode mode)
 {
-    uint8_t line[EPD_WIDTH / 2];
-    memset(line, 255, EPD_WIDTH / 2);
-    uint8_t frame_count = 15;
-
-    SemaphoreHandle_t fetch_sem = xSemaphoreCreateBinary();
-    SemaphoreHandle_t feed_sem = xSemaphoreCreateBinary();
-    vTaskDelay(10);
-    for (uint8_t k = 0; k < frame_count; k++) {
-        OutputParams p1 = {
-            .area = area,
-            .data_ptr = data,
-            .frame = k,
-            .mode = mode,
-            .done_smphr = fetch_sem,
-        };
-        OutputParams p2 = {
-            .area = area,
-            .data_ptr = data,
-            .frame = k,
-            .mode = mode,
-            .done_smphr = feed_sem,
-        };
+    OutputParams params = {
+        .area = area,
+        .data_ptr = data,
+        .frame = 0,
+        .mode = mode,
+    };
 
-        TaskHandle_t t1, t2;
-        xTaskCreatePinnedToCore((void (*)(void *))provide_out, "privide_out", 8000,
-                                &p1, 10, &t1, 0);
-        xTaskCreatePinnedToCore((void (*)(void *))feed_display, "render", 8000, &p2,
-                                10, &t2, 1);
+    xSemaphoreTake(draw_idle, portMAX_DELAY);
+    xQueueSendToBack(image_queue, &params, portMAX_DELAY);
+}
 
-        xSemaphoreTake(fetch_sem, portMAX_DELAY);
-        xSemaphoreTake(feed_sem, portMAX_DELAY);
+bool epd_draw_busy()
+{
+    return draw_idle != NULL && uxSemaphoreGetCount(draw_idle) == 0;
+}
 
-        vTaskDelete(t1);
-        vTaskDelete(t2);
-        vTaskDelay(5);
+void epd_draw_wait()
+{
+    if (draw_idle == NULL) {
+        return;
     }
-    vSemaphoreDelete(fetch_sem);
-    vSemaphoreDelete(feed_sem);
+    xSemaphoreTake(draw_idle, portMAX_DELAY);
+    xSemaphoreGive(draw_idle);
+}
+
+void IRAM_ATTR epd_draw_image(Rect_t area, uint8_t *data, enum DrawMode mode)
+{
+    epd_draw_image_async(area, data, mode);
+    epd_draw_wait();
 }
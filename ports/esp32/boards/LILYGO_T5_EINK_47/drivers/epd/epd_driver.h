@@ -8,10 +8,13 @@ extern "C" {
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include <esp_attr.h>
 
+#include "epd_lut.h"
+
 
 /// Width of the display area in pixels.
 #define EPD_WIDTH 960
@@ -31,16 +34,6 @@ typedef struct {
     int height;
 } Rect_t;
 
-/// The image drawing mode.
-enum DrawMode {
-    /// Draw black / grayscale image on a white display.
-    BLACK_ON_WHITE = 1 << 0,
-    /// "Draw with white ink" on a white display.
-    WHITE_ON_WHITE = 1 << 1,
-    /// Draw with white ink on a black display.
-    WHITE_ON_BLACK = 1 << 2,
-};
-
 /// Font drawing flags
 enum DrawFlags {
     /// Draw a background.
@@ -125,6 +118,21 @@ void IRAM_ATTR epd_draw_grayscale_image(Rect_t area, uint8_t *data);
  */
 void IRAM_ATTR epd_draw_image(Rect_t area, uint8_t *data, enum DrawMode mode);
 
+/**
+ * Start drawing a picture like `epd_draw_image` and return without waiting
+ * for it to finish.  The picture is drawn by render tasks on both cores.
+ * If a previous picture is still being drawn, wait for it first.
+ *
+ * `data` must stay valid and unchanged until `epd_draw_wait` returns.
+ */
+void epd_draw_image_async(Rect_t area, uint8_t *data, enum DrawMode mode);
+
+/** @returns true while a picture is being drawn. */
+bool epd_draw_busy();
+
+/** Wait until the picture being drawn, if any, is finished. */
+void epd_draw_wait();
+
 
 
 void IRAM_ATTR epd_draw_frame_1bit(Rect_t area, uint8_t *ptr, enum DrawMode mode, int time);
@@ -364,6 +372,43 @@ void get_glyph(const GFXfont *font, uint32_t code_point, GFXglyph **glyph);
 void write_string(const GFXfont *font, const char *string, int *cursor_x,
                   int *cursor_y, uint8_t *framebuffer);
 
+/// Alignment of the lines written by `write_text`.
+enum TextAlign {
+    ALIGN_LEFT,
+    ALIGN_CENTER,
+    ALIGN_RIGHT,
+};
+
+/**
+ * Write a string to a framebuffer.  Lines are broken at '\n' and, if
+ * `width` is positive, at spaces (or within a word, if it doesn't fit on
+ * its own) so that no line is wider than `width`.
+ *
+ * @param x: Left edge of the text.  If `width` is 0, centered and right
+ *   aligned lines end up centered on / ending at `x` instead.
+ * @param y: Base line of the first line, each following one is
+ *   `font->advance_y` lower.
+ * @param width: Width to wrap and align the lines to, or 0.
+ * @param framebuffer: The framebuffer to draw to, or NULL to only measure
+ *   the text.
+ * @param bounds: If not NULL, receives the area covered by the lines.
+ */
+void write_text(const GFXfont *font, const char *string, size_t len,
+                int x, int y, int width, enum TextAlign align,
+                uint8_t *framebuffer, const FontProperties *properties,
+                Rect_t *bounds);
+
+/**
+ * Drop the decompressed glyphs cached for the `count` glyphs at `glyph`.
+ * Must be called when a font's glyph table is allocated, since it may reuse
+ * the memory of a font collected before.
+ */
+void glyph_cache_clear(const GFXglyph *glyph, size_t count);
+
+/** Get the number of hits and misses, and the size of the glyph cache. */
+void glyph_cache_info(unsigned long *hits, unsigned long *misses,
+                      size_t *bytes);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,202 @@
+#include "epd_glyph_cache.h"
+
+#include <string.h>
+
+#include "lib/uzlib/tinf.h"
+
+
+#define NONE 0xFFFF
+
+
+static uint16_t *bucket_of(EpdGlyphCache_t *cache, const void *key)
+{
+    uint32_t hash = (uint32_t)((uintptr_t)key >> 2) * 2654435761u;
+    return &cache->buckets[(hash >> 16) & cache->bucket_mask];
+}
+
+/// Unlink entry `i` from the LRU list.
+static void lru_remove(EpdGlyphCache_t *cache, uint16_t i)
+{
+    EpdGlyphEntry_t *e = &cache->entries[i];
+    if (e->prev != NONE) {
+        cache->entries[e->prev].next = e->next;
+    } else {
+        cache->head = e->next;
+    }
+    if (e->next != NONE) {
+        cache->entries[e->next].prev = e->prev;
+    } else {
+        cache->tail = e->prev;
+    }
+}
+
+/// Link entry `i` as the most recently used one.
+static void lru_push(EpdGlyphCache_t *cache, uint16_t i)
+{
+    EpdGlyphEntry_t *e = &cache->entries[i];
+    e->prev = NONE;
+    e->next = cache->head;
+    if (cache->head != NONE) {
+        cache->entries[cache->head].prev = i;
+    } else {
+        cache->tail = i;
+    }
+    cache->head = i;
+}
+
+/// Drop entry `i`.
+static void remove_entry(EpdGlyphCache_t *cache, uint16_t i)
+{
+    EpdGlyphEntry_t *e = &cache->entries[i];
+
+    uint16_t *link = bucket_of(cache, e->key);
+    while (*link != i) {
+        link = &cache->entries[*link].chain;
+    }
+    *link = e->chain;
+
+    lru_remove(cache, i);
+    cache->free(e->bitmap);
+    cache->bytes -= e->size;
+    cache->count--;
+    e->chain = cache->unused;
+    cache->unused = i;
+}
+
+/// Drop the least recently used entry.
+static void evict(EpdGlyphCache_t *cache)
+{
+    remove_entry(cache, cache->tail);
+}
+
+bool epd_glyph_cache_init(EpdGlyphCache_t *cache, uint16_t capacity,
+                          size_t max_bytes, void *(*alloc)(size_t size),
+                          void (*free)(void *ptr))
+{
+    uint16_t buckets = 1;
+    while (buckets < capacity) {
+        buckets <<= 1;
+    }
+
+    memset(cache, 0, sizeof(*cache));
+    cache->alloc = alloc;
+    cache->free = free;
+    cache->entries = alloc(capacity * sizeof(*cache->entries));
+    cache->buckets = alloc(buckets * sizeof(*cache->buckets));
+    if (cache->entries == NULL || cache->buckets == NULL) {
+        epd_glyph_cache_deinit(cache);
+        return false;
+    }
+    memset(cache->buckets, 0xFF, buckets * sizeof(*cache->buckets));
+    cache->capacity = capacity;
+    cache->bucket_mask = buckets - 1;
+    cache->head = NONE;
+    cache->tail = NONE;
+    cache->max_bytes = max_bytes;
+    for (uint16_t i = 0; i < capacity; i++) {
+        cache->entries[i].chain = i + 1 < capacity ? i + 1 : NONE;
+    }
+    cache->unused = 0;
+    return true;
+}
+
+void epd_glyph_cache_clear(EpdGlyphCache_t *cache)
+{
+    while (cache->count > 0) {
+        evict(cache);
+    }
+}
+
+void epd_glyph_cache_drop(EpdGlyphCache_t *cache, const void *begin,
+                          const void *end)
+{
+    uint16_t i = cache->head;
+    while (i != NONE) {
+        uint16_t next = cache->entries[i].next;
+        uintptr_t key = (uintptr_t)cache->entries[i].key;
+        if (key >= (uintptr_t)begin && key < (uintptr_t)end) {
+            remove_entry(cache, i);
+        }
+        i = next;
+    }
+}
+
+void epd_glyph_cache_deinit(EpdGlyphCache_t *cache)
+{
+    epd_glyph_cache_clear(cache);
+    if (cache->free) {
+        cache->free(cache->entries);
+        cache->free(cache->buckets);
+    }
+    cache->entries = NULL;
+    cache->buckets = NULL;
+    cache->capacity = 0;
+}
+
+const uint8_t *epd_glyph_cache_get(EpdGlyphCache_t *cache, const void *key,
+                                   size_t size, const uint8_t *data,
+                                   size_t data_size)
+{
+    uint16_t *bucket = bucket_of(cache, key);
+    for (uint16_t i = *bucket; i != NONE; i = cache->entries[i].chain) {
+        if (cache->entries[i].key == key) {
+            if (cache->head != i) {
+                lru_remove(cache, i);
+                lru_push(cache, i);
+            }
+            cache->hits++;
+            return cache->entries[i].bitmap;
+        }
+    }
+    cache->misses++;
+
+    if (size > cache->max_bytes) {
+        return NULL;
+    }
+
+    while (cache->count > 0 &&
+           (cache->count == cache->capacity ||
+            cache->bytes + size > cache->max_bytes)) {
+        evict(cache);
+    }
+    uint8_t *bitmap = cache->alloc(size);
+    if (bitmap == NULL) {
+        return NULL;
+    }
+    if (!epd_glyph_inflate(bitmap, size, data, data_size)) {
+        cache->free(bitmap);
+        return NULL;
+    }
+
+    uint16_t i = cache->unused;
+    EpdGlyphEntry_t *e = &cache->entries[i];
+    cache->unused = e->chain;
+    e->key = key;
+    e->bitmap = bitmap;
+    e->size = size;
+    e->chain = *bucket;
+    *bucket = i;
+    lru_push(cache, i);
+    cache->bytes += size;
+    cache->count++;
+    return bitmap;
+}
+
+bool epd_glyph_inflate(uint8_t *out, size_t size, const uint8_t *data,
+                       size_t data_size)
+{
+    // Kept off the stack, it holds two Huffman trees
+    static TINF_DATA d;
+
+    uzlib_uncompress_init(&d, NULL, 0);
+    d.source = data;
+    d.source_limit = data + data_size;
+    d.dest = out;
+    d.dest_limit = out + size;
+
+    if (uzlib_zlib_parse_header(&d) < 0) {
+        return false;
+    }
+    int st = uzlib_uncompress(&d);
+    return st >= 0 && d.dest == out + size;
+}
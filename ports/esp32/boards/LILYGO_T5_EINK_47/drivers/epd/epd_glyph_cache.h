@@ -0,0 +1,105 @@
+/**
+ * Cache of decompressed glyph bitmaps.
+ *
+ * Font glyphs are stored zlib-compressed.  Drawing text decompresses each
+ * glyph it draws, so glyphs used over and over (digits of a clock, common
+ * letters) are kept decompressed here, with the least recently used ones
+ * evicted once the cache is full.
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// A cached bitmap, linked into the LRU list and a hash bucket by index.
+typedef struct {
+    const void *key;
+    uint8_t *bitmap;
+    uint32_t size;
+    uint16_t prev;
+    uint16_t next;
+    uint16_t chain;
+} EpdGlyphEntry_t;
+
+typedef struct {
+    void *(*alloc)(size_t size);
+    void (*free)(void *ptr);
+
+    EpdGlyphEntry_t *entries;
+    uint16_t *buckets;
+    uint16_t capacity;
+    uint16_t bucket_mask;
+    uint16_t count;
+    /// Most and least recently used entries.
+    uint16_t head;
+    uint16_t tail;
+    /// First unused entry, the others are chained through `chain`.
+    uint16_t unused;
+
+    size_t bytes;
+    size_t max_bytes;
+
+    unsigned long hits;
+    unsigned long misses;
+} EpdGlyphCache_t;
+
+/**
+ * Set up an empty cache.
+ *
+ * @param capacity: Maximum number of glyphs, below 65535.
+ * @param max_bytes: Maximum total size of the cached bitmaps.
+ * @param alloc: Allocates the bitmaps and the cache's own tables, for
+ *   example from PSRAM.
+ * @param free: Frees memory from `alloc`.
+ * @returns false if the tables could not be allocated.
+ */
+bool epd_glyph_cache_init(EpdGlyphCache_t *cache, uint16_t capacity,
+                          size_t max_bytes, void *(*alloc)(size_t size),
+                          void (*free)(void *ptr));
+
+/**
+ * Drop all cached bitmaps, for example when the memory of a font may be
+ * reused by another one.
+ */
+void epd_glyph_cache_clear(EpdGlyphCache_t *cache);
+
+/**
+ * Drop the cached bitmaps whose key lies in [begin, end), for example the
+ * glyphs of one font whose memory may have been reused.
+ */
+void epd_glyph_cache_drop(EpdGlyphCache_t *cache, const void *begin,
+                          const void *end);
+
+/// Free all bitmaps and the tables of the cache.
+void epd_glyph_cache_deinit(EpdGlyphCache_t *cache);
+
+/**
+ * Get the decompressed bitmap of a glyph.
+ *
+ * @param key: Identifies the glyph, usually a pointer to its `GFXglyph`.
+ * @param size: Size of the decompressed bitmap.
+ * @param data: The compressed bitmap, used on a cache miss.
+ * @param data_size: Size of the compressed bitmap.
+ * @returns The bitmap, valid until the next call, or NULL if it could not
+ *   be decompressed or allocated.
+ */
+const uint8_t *epd_glyph_cache_get(EpdGlyphCache_t *cache, const void *key,
+                                   size_t size, const uint8_t *data,
+                                   size_t data_size);
+
+/**
+ * Decompress a zlib stream of known decompressed size.
+ *
+ * @returns true if exactly `size` bytes were produced.
+ */
+bool epd_glyph_inflate(uint8_t *out, size_t size, const uint8_t *data,
+                       size_t data_size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,70 @@
+#include "epd_lut.h"
+
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+#else
+#define IRAM_ATTR
+#endif
+
+
+void IRAM_ATTR epd_lut_reset(uint8_t *lut, enum DrawMode mode)
+{
+    switch (mode) {
+    case BLACK_ON_WHITE:
+        memset(lut, 0x55, EPD_LUT_SIZE);
+        break;
+    case WHITE_ON_BLACK:
+    case WHITE_ON_WHITE:
+        memset(lut, 0xAA, EPD_LUT_SIZE);
+        break;
+    }
+}
+
+void IRAM_ATTR epd_lut_update(uint8_t *lut, uint8_t k, enum DrawMode mode)
+{
+    if (mode == BLACK_ON_WHITE || mode == WHITE_ON_WHITE) {
+        k = 15 - k;
+    }
+
+    // reset the pixels which are not to be lightened / darkened
+    // any longer in the current frame
+    for (uint32_t l = k; l < EPD_LUT_SIZE; l += 16) {
+        lut[l] &= 0xFC;
+    }
+
+    for (uint32_t l = (k << 4); l < EPD_LUT_SIZE; l += (1 << 8)) {
+        for (uint32_t p = 0; p < 16; p++) {
+            lut[l + p] &= 0xF3;
+        }
+    }
+    for (uint32_t l = (k << 8); l < EPD_LUT_SIZE; l += (1 << 12)) {
+        for (uint32_t p = 0; p < (1 << 8); p++) {
+            lut[l + p] &= 0xCF;
+        }
+    }
+    for (uint32_t p = (uint32_t)k << 12; p < (uint32_t)(k + 1) << 12; p++) {
+        lut[p] &= 0x3F;
+    }
+}
+
+void IRAM_ATTR epd_lut_convert_4bpp(const uint32_t *line_data,
+                                    uint8_t *epd_input, const uint8_t *lut,
+                                    int width)
+{
+    uint32_t *wide_epd_input = (uint32_t *)epd_input;
+    const uint16_t *line_data_16 = (const uint16_t *)line_data;
+
+    // this is reversed for little-endian, but this is later compensated
+    // through the output peripheral.
+    for (int j = 0; j < width / 16; j++) {
+        uint16_t v1 = *(line_data_16++);
+        uint16_t v2 = *(line_data_16++);
+        uint16_t v3 = *(line_data_16++);
+        uint16_t v4 = *(line_data_16++);
+        uint32_t pixel = (uint32_t)lut[v1] << 16 | (uint32_t)lut[v2] << 24 |
+                         lut[v3] | lut[v4] << 8;
+        wide_epd_input[j] = pixel;
+    }
+}
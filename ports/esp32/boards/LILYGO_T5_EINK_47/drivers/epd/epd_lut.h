@@ -0,0 +1,65 @@
+/**
+ * Conversion of 4 bit per pixel image lines to EPD output.
+ *
+ * A grayscale image is drawn in 15 frames.  In each frame, every pixel is
+ * either darkened / lightened or left alone, depending on its brightness
+ * and the frame index.  The decision is looked up for four pixels at once
+ * in a 64 KiB table, which is updated in place from frame to frame.
+ */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma once
+
+#include <stdint.h>
+
+/// Size of the conversion table in bytes, one entry per 16 bit input.
+#define EPD_LUT_SIZE (1 << 16)
+
+/// Number of frames needed to draw a 4 bit per pixel image.
+#define EPD_LUT_FRAMES 15
+
+/// The image drawing mode.
+enum DrawMode {
+    /// Draw black / grayscale image on a white display.
+    BLACK_ON_WHITE = 1 << 0,
+    /// "Draw with white ink" on a white display.
+    WHITE_ON_WHITE = 1 << 1,
+    /// Draw with white ink on a black display.
+    WHITE_ON_BLACK = 1 << 2,
+};
+
+/**
+ * Prepare the conversion table for the first frame of an image, so that
+ * every pixel is darkened (or lightened, when drawing with white ink).
+ * An unknown mode leaves the table untouched.
+ */
+void epd_lut_reset(uint8_t *lut, enum DrawMode mode);
+
+/**
+ * Update the conversion table for frame `k`.  Only the entries containing
+ * a pixel which is done after this frame are changed, which are 4096 of
+ * every 65536 entries per pixel position.
+ *
+ * Must be called for each frame in order, starting with 0 right after
+ * `epd_lut_reset`.
+ */
+void epd_lut_update(uint8_t *lut, uint8_t k, enum DrawMode mode);
+
+/**
+ * Convert a line of 4 bit pixels to the 2 bit per pixel EPD input of the
+ * current frame.
+ *
+ * @param line_data: `width / 2` bytes of pixel data, 32 bit aligned.
+ * @param epd_input: Receives `width / 4` bytes, 32 bit aligned.  The 16
+ *   bit halves are swapped, which is undone by the output peripheral.
+ * @param lut: The conversion table of the current frame.
+ * @param width: Line width in pixels, a multiple of 16.
+ */
+void epd_lut_convert_4bpp(const uint32_t *line_data, uint8_t *epd_input,
+                          const uint8_t *lut, int width);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,12 +7,16 @@
 #include <esp_log.h>
 
 #include "epd_driver.h"
+#include "epd_glyph_cache.h"
 
 #include "py/mpconfig.h"
 #include "py/misc.h"
 
 
-extern int uncompress(uint8_t* dest, unsigned long* destLen, const uint8_t* source, unsigned long sourceLen);
+/// Maximum number of decompressed glyphs kept for drawing text.
+#define GLYPH_CACHE_ENTRIES 512
+/// Maximum total size of the decompressed glyphs, in PSRAM if available.
+#define GLYPH_CACHE_BYTES (128 * 1024)
 
 
 typedef struct {
@@ -46,6 +50,11 @@ static inline int max(int x, int y)
     return x > y ? x : y;
 }
 
+/// Decoded in place of malformed or truncated UTF-8 sequences.
+#define REPLACEMENT_CP 0xFFFD
+
+/// Length of the sequence starting with `ch`, 0 for a continuation byte and
+/// 5 for a malformed one.
 static int utf8_len(const uint8_t ch)
 {
     int len = 0;
@@ -55,28 +64,35 @@ static int utf8_len(const uint8_t ch)
         }
         ++len;
     }
-    if (len > 4) { /* Malformed leading byte */
-        assert("invalid unicode.");
-    }
     return len;
 }
 
-static uint32_t next_cp(uint8_t **string)
+/*
+ * Decode the code point at *string, which must be before `end`, and move
+ * past it.  Bytes which don't start a complete sequence before `end` decode
+ * as REPLACEMENT_CP one at a time.
+ */
+static uint32_t next_cp(const uint8_t **string, const uint8_t *end)
 {
-    if (**string == 0) {
-        return 0;
+    const uint8_t *chr = *string;
+    int bytes = utf8_len(*chr);
+    if (bytes < 1 || bytes > 4 || end - chr < bytes) {
+        *string = chr + 1;
+        return REPLACEMENT_CP;
     }
-    int bytes = utf8_len(**string);
-    uint8_t *chr = *string;
-    *string += bytes;
     int shift = utf[0]->bits_stored * (bytes - 1);
-    uint32_t codep = (*chr++ & utf[bytes]->mask) << shift;
+    uint32_t codep = (*chr & utf[bytes]->mask) << shift;
 
-    for (int i = 1; i < bytes; ++i, ++chr) {
+    for (int i = 1; i < bytes; ++i) {
+        if ((chr[i] & ~utf[0]->mask) != utf[0]->lead) {
+            *string = chr + i;
+            return REPLACEMENT_CP;
+        }
         shift -= utf[0]->bits_stored;
-        codep |= ((uint8_t) * chr & utf[0]->mask) << shift;
+        codep |= (chr[i] & utf[0]->mask) << shift;
     }
 
+    *string = chr + bytes;
     return codep;
 }
 
@@ -92,6 +108,45 @@ static FontProperties font_properties_default()
     return props;
 }
 
+static void *glyph_cache_alloc(size_t size)
+{
+    void *ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (ptr == NULL) {
+        ptr = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    return ptr;
+}
+
+static EpdGlyphCache_t *glyph_cache()
+{
+    static EpdGlyphCache_t cache;
+    static int state; // 0: not initialized, 1: ready, -1: failed
+
+    if (state == 0) {
+        state = epd_glyph_cache_init(&cache, GLYPH_CACHE_ENTRIES,
+                                     GLYPH_CACHE_BYTES, glyph_cache_alloc,
+                                     heap_caps_free) ? 1 : -1;
+    }
+    return state > 0 ? &cache : NULL;
+}
+
+void glyph_cache_clear(const GFXglyph *glyph, size_t count)
+{
+    EpdGlyphCache_t *cache = glyph_cache();
+    if (cache) {
+        epd_glyph_cache_drop(cache, glyph, glyph + count);
+    }
+}
+
+void glyph_cache_info(unsigned long *hits, unsigned long *misses,
+                      size_t *bytes)
+{
+    EpdGlyphCache_t *cache = glyph_cache();
+    *hits = cache ? cache->hits : 0;
+    *misses = cache ? cache->misses : 0;
+    *bytes = cache ? cache->bytes : 0;
+}
+
 void get_glyph(const GFXfont *font, uint32_t code_point, GFXglyph **glyph)
 {
     UnicodeInterval *intervals = font->intervals;
@@ -191,11 +246,27 @@ static void draw_char(const GFXfont *font, uint8_t *buffer,
 
     int byte_width = (width / 2 + width % 2);
     unsigned long bitmap_size = byte_width * height;
-    uint8_t *bitmap = NULL;
+    const uint8_t *bitmap = NULL;
+    uint8_t *decompressed = NULL;
+    if (bitmap_size == 0) {
+        *cursor_x += glyph->advance_x;
+        return;
+    }
     if (font->compressed) {
-        bitmap = (uint8_t *)m_malloc(bitmap_size);
-        uncompress(bitmap, &bitmap_size, &font->bitmap[offset],
-                   glyph->compressed_size);
+        // Repeated characters are taken from the cache, the rest is
+        // decompressed into a temporary buffer
+        EpdGlyphCache_t *cache = glyph_cache();
+        if (cache) {
+            bitmap = epd_glyph_cache_get(cache, glyph, bitmap_size,
+                                         &font->bitmap[offset],
+                                         glyph->compressed_size);
+        }
+        if (bitmap == NULL) {
+            decompressed = (uint8_t *)m_malloc(bitmap_size);
+            epd_glyph_inflate(decompressed, bitmap_size, &font->bitmap[offset],
+                              glyph->compressed_size);
+            bitmap = decompressed;
+        }
     } else {
         bitmap = &font->bitmap[offset];
     }
@@ -215,7 +286,7 @@ static void draw_char(const GFXfont *font, uint8_t *buffer,
         bool byte_complete = start_pos % 2;
         int x = max(0, -start_pos);
         int max_x = min(start_pos + width, buf_width * 2);
-        for (int xx = start_pos; xx < max_x; xx++) {
+        for (int xx = start_pos + x; xx < max_x; xx++) {
             uint32_t buf_pos = yy * buf_width + xx / 2;
             uint8_t old = buffer[buf_pos];
             uint8_t bm = bitmap[y * byte_width + x / 2];
@@ -234,8 +305,8 @@ static void draw_char(const GFXfont *font, uint8_t *buffer,
             x++;
         }
     }
-    if (font->compressed) {
-        m_free(bitmap);
+    if (decompressed) {
+        m_free(decompressed);
     }
     *cursor_x += glyph->advance_x;
 }
@@ -302,8 +373,10 @@ void get_text_bounds(const GFXfont *font, const char *string, int *x, int *y,
     }
     int minx = 100000, miny = 100000, maxx = -1, maxy = -1;
     int original_x = *x;
-    uint32_t c;
-    while ((c = next_cp((uint8_t **)&string))) {
+    const uint8_t *p = (const uint8_t *)string;
+    const uint8_t *end = p + strlen(string);
+    while (p < end) {
+        uint32_t c = next_cp(&p, end);
         get_char_bounds(font, c, x, y, &minx, &miny, &maxx, &maxy, &props);
     }
     *x1 = min(original_x, minx);
@@ -359,8 +432,6 @@ void write_mode(const GFXfont *font, const char *string, int *cursor_x,
         local_cursor_y = *cursor_y;
     }
 
-    uint32_t c;
-
     int cursor_x_init = local_cursor_x;
     int cursor_y_init = local_cursor_y;
 
@@ -370,7 +441,10 @@ void write_mode(const GFXfont *font, const char *string, int *cursor_x,
             epd_draw_hline(local_cursor_x, local_cursor_y - (font->advance_y - baseline_height) + l, w, bg << 4, buffer);
         }
     }
-    while ((c = next_cp((uint8_t **)&string))) {
+    const uint8_t *p = (const uint8_t *)string;
+    const uint8_t *end = p + strlen(string);
+    while (p < end) {
+        uint32_t c = next_cp(&p, end);
         draw_char(font, buffer, &local_cursor_x, local_cursor_y, buf_width, buf_height, c, &props);
     }
 
@@ -419,3 +493,120 @@ void write_string(const GFXfont *font, const char *string, int *cursor_x,
 
     m_free(tofree);
 }
+
+static int advance_of(const GFXfont *font, uint32_t cp,
+                      const FontProperties *props)
+{
+    GFXglyph *glyph;
+    get_glyph(font, cp, &glyph);
+
+    if (!glyph) {
+        get_glyph(font, props->fallback_glyph, &glyph);
+    }
+
+    return glyph ? glyph->advance_x : 0;
+}
+
+/*
+ * Find the end of the line starting at `start`, no wider than `width` if it
+ * is positive.  Sets the start of the next line and the width of this one.
+ */
+static const char *line_end(const GFXfont *font, const char *start,
+                            const char *end, int width,
+                            const FontProperties *props, const char **next,
+                            int *line_width)
+{
+    const char *p = start;
+    const char *space = NULL;
+    int space_width = 0;
+    int w = 0;
+
+    while (p < end) {
+        if (*p == '\n') {
+            *next = p + 1;
+            *line_width = w;
+            return p;
+        }
+        const char *cp_start = p;
+        uint32_t cp = next_cp((const uint8_t **)&p, (const uint8_t *)end);
+        int advance = advance_of(font, cp, props);
+
+        if (cp == ' ') {
+            space = cp_start;
+            space_width = w;
+        } else if (width > 0 && w + advance > width) {
+            if (space) {
+                *next = space + 1;
+                *line_width = space_width;
+                return space;
+            }
+            // a word which doesn't fit on its own, break it
+            if (cp_start > start) {
+                *next = cp_start;
+                *line_width = w;
+                return cp_start;
+            }
+        }
+        w += advance;
+    }
+
+    *next = end;
+    *line_width = w;
+    return end;
+}
+
+void write_text(const GFXfont *font, const char *string, size_t len,
+                int x, int y, int width, enum TextAlign align,
+                uint8_t *framebuffer, const FontProperties *properties,
+                Rect_t *bounds)
+{
+    FontProperties props;
+    if (properties == NULL) {
+        props = font_properties_default();
+    } else {
+        props = *properties;
+    }
+
+    const char *p = string;
+    const char *end = string + len;
+    int baseline = y;
+    int lines = 0;
+    int minx = 100000, maxx = -100000;
+
+    do {
+        const char *next;
+        int w;
+        const char *stop = line_end(font, p, end, width, &props, &next, &w);
+
+        int line_x = x;
+        if (align == ALIGN_CENTER) {
+            line_x = width > 0 ? x + (width - w) / 2 : x - w / 2;
+        } else if (align == ALIGN_RIGHT) {
+            line_x = width > 0 ? x + width - w : x - w;
+        }
+
+        if (framebuffer != NULL) {
+            int cursor_x = line_x;
+            while (p < stop) {
+                uint32_t cp = next_cp((const uint8_t **)&p,
+                                      (const uint8_t *)stop);
+                draw_char(font, framebuffer, &cursor_x, baseline,
+                          EPD_WIDTH / 2, EPD_HEIGHT, cp, &props);
+            }
+        }
+
+        minx = min(minx, line_x);
+        maxx = max(maxx, line_x + w);
+        lines++;
+        baseline += font->advance_y;
+        p = next;
+    } while (p < end);
+
+    if (bounds != NULL) {
+        bounds->x = minx;
+        bounds->y = y - font->ascender;
+        bounds->width = maxx - minx;
+        bounds->height = (lines - 1) * font->advance_y + font->ascender -
+                         font->descender;
+    }
+}
@@ -28,14 +28,17 @@
 #include "py/runtime.h"
 
 
+#include "epd_dirty.h"
 #include "epd_driver.h"
 #include <stdint.h>
+#include <string.h>
 
 
 typedef struct my_epd_obj
 {
     mp_obj_base_t   base;
     mp_obj_array_t* fb;
+    uint8_t*        shadow;     // What the display shows, NULL until update()
 }
 my_epd_obj;
 
@@ -75,6 +78,7 @@ mp_obj_t my_epd_make_new(const mp_obj_type_t* aType,
     
     epd_init();
     self->fb = new_ba(EPD_WIDTH / 2 * EPD_HEIGHT);
+    self->shadow = NULL;
     
     return MP_OBJ_FROM_PTR(self);
 }
@@ -91,6 +95,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(py_epd_fb_obj, py_epd_fb);
 STATIC mp_obj_t py_epd_on(mp_obj_t aSelf)
 {
     MP_THREAD_GIL_EXIT();
+    epd_draw_wait();
     epd_poweron();
     MP_THREAD_GIL_ENTER();
     
@@ -102,6 +107,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(py_epd_on_obj, py_epd_on);
 STATIC mp_obj_t py_epd_off(mp_obj_t aSelf)
 {
     MP_THREAD_GIL_EXIT();
+    epd_draw_wait();
     epd_poweroff();
     MP_THREAD_GIL_ENTER();
     
@@ -113,6 +119,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(py_epd_off_obj, py_epd_off);
 STATIC mp_obj_t py_epd_power_off(mp_obj_t aSelf)
 {
     MP_THREAD_GIL_EXIT();
+    epd_draw_wait();
     epd_poweroff_all();
     MP_THREAD_GIL_ENTER();
     
@@ -123,10 +130,17 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(py_epd_power_off_obj, py_epd_power_off);
 
 STATIC mp_obj_t py_epd_clear(mp_obj_t aSelf)
 {
+    my_epd_obj* self = MP_OBJ_TO_PTR(aSelf);
+    
     MP_THREAD_GIL_EXIT();
     epd_clear();
     MP_THREAD_GIL_ENTER();
     
+    if (self->shadow)
+    {
+        memset(self->shadow, 0xFF, EPD_WIDTH / 2 * EPD_HEIGHT);
+    }
+    
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(py_epd_clear_obj, py_epd_clear);
@@ -141,14 +155,161 @@ STATIC mp_obj_t py_epd_flush(mp_obj_t aSelf)
     epd_draw_image(area, self->fb->items, BLACK_ON_WHITE);
     MP_THREAD_GIL_ENTER();
     
+    if (self->shadow)
+    {
+        memcpy(self->shadow, self->fb->items, EPD_WIDTH / 2 * EPD_HEIGHT);
+    }
+    
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(py_epd_flush_obj, py_epd_flush);
 
 
+/// How often the awaitable returned by flush_async() checks for completion.
+#define EPD_ASYNC_POLL_MS 20
+
+
+/// Awaitable which completes once the display is done drawing.  While the
+/// display is busy, each step sleeps the awaiting uasyncio task for
+/// `EPD_ASYNC_POLL_MS`.
+STATIC mp_obj_t py_epd_done_iternext(mp_obj_t aSelf)
+{
+    if (!epd_draw_busy())
+    {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    
+    mp_obj_t uasyncio = mp_import_name(MP_QSTR_uasyncio, mp_const_none, MP_OBJ_NEW_SMALL_INT(0));
+    mp_obj_t sleep    = mp_call_function_1(mp_load_attr(uasyncio, MP_QSTR_sleep_ms),
+                                           MP_OBJ_NEW_SMALL_INT(EPD_ASYNC_POLL_MS));
+    return mp_iternext(sleep);
+}
+
+
+STATIC const mp_obj_type_t py_epd_done_type =
+{
+    { &mp_type_type },
+    .name     = MP_QSTR_EpdDone,
+    .getiter  = mp_identity_getiter,
+    .iternext = py_epd_done_iternext,
+};
+
+
+STATIC const mp_obj_base_t py_epd_done_obj = { &py_epd_done_type };
+
+
+/// Start drawing the framebuffer and return an awaitable which completes
+/// once it is drawn.  The framebuffer must not change until then.
+STATIC mp_obj_t py_epd_flush_async(mp_obj_t aSelf)
+{
+    my_epd_obj* self = MP_OBJ_TO_PTR(aSelf);
+    Rect_t      area = { 0, 0, EPD_WIDTH, EPD_HEIGHT };
+    
+    MP_THREAD_GIL_EXIT();
+    epd_draw_image_async(area, self->fb->items, BLACK_ON_WHITE);
+    MP_THREAD_GIL_ENTER();
+    
+    if (self->shadow)
+    {
+        memcpy(self->shadow, self->fb->items, EPD_WIDTH / 2 * EPD_HEIGHT);
+    }
+    
+    return MP_OBJ_FROM_PTR(&py_epd_done_obj);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(py_epd_flush_async_obj, py_epd_flush_async);
+
+
+STATIC mp_obj_t py_epd_busy(mp_obj_t aSelf)
+{
+    return mp_obj_new_bool(epd_draw_busy());
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(py_epd_busy_obj, py_epd_busy);
+
+
+STATIC mp_obj_t py_epd_wait(mp_obj_t aSelf)
+{
+    MP_THREAD_GIL_EXIT();
+    epd_draw_wait();
+    MP_THREAD_GIL_ENTER();
+    
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(py_epd_wait_obj, py_epd_wait);
+
+
+/// Redraw only the areas of the framebuffer that changed since the last
+/// update(), and return them as a list of (x, y, w, h) tuples.  The first
+/// call redraws the whole display.
+STATIC mp_obj_t py_epd_update(mp_obj_t aSelf)
+{
+    my_epd_obj*    self = MP_OBJ_TO_PTR(aSelf);
+    uint8_t*       fb   = self->fb->items;
+    EpdDirtyRect_t rects[EPD_DIRTY_MAX_RECTS];
+    size_t         count;
+    
+    if (self->shadow)
+    {
+        count = epd_dirty_find(fb, self->shadow, EPD_WIDTH, EPD_HEIGHT,
+                               rects, EPD_DIRTY_MAX_RECTS, EPD_DIRTY_MERGE_GAP);
+    }
+    else
+    {
+        self->shadow = m_new(uint8_t, EPD_WIDTH / 2 * EPD_HEIGHT);
+        rects[0]     = (EpdDirtyRect_t) { 0, 0, EPD_WIDTH, EPD_HEIGHT };
+        count        = 1;
+    }
+    
+    mp_obj_t result = mp_obj_new_list(0, NULL);
+    
+    for (size_t i = 0; i < count; i++)
+    {
+        Rect_t   area = { rects[i].x, rects[i].y, rects[i].width, rects[i].height };
+        bool     packed = area.width != EPD_WIDTH;
+        uint8_t* data;
+        
+        // Rows of a full width area are contiguous in the framebuffer,
+        // anything narrower is packed into a temporary image
+        if (!packed)
+        {
+            data = fb + area.y * EPD_WIDTH / 2;
+        }
+        else
+        {
+            data = m_new(uint8_t, area.width / 2 * area.height);
+            epd_dirty_extract(fb, EPD_WIDTH, rects[i], data);
+        }
+        
+        MP_THREAD_GIL_EXIT();
+        epd_clear_area(area);
+        epd_draw_image(area, data, BLACK_ON_WHITE);
+        MP_THREAD_GIL_ENTER();
+        
+        if (packed)
+        {
+            m_del(uint8_t, data, area.width / 2 * area.height);
+        }
+        
+        epd_dirty_commit(self->shadow, fb, EPD_WIDTH, rects[i]);
+        
+        mp_obj_t items[4] =
+        {
+            MP_OBJ_NEW_SMALL_INT(area.x),
+            MP_OBJ_NEW_SMALL_INT(area.y),
+            MP_OBJ_NEW_SMALL_INT(area.width),
+            MP_OBJ_NEW_SMALL_INT(area.height)
+        };
+        mp_obj_list_append(result, mp_obj_new_tuple(4, items));
+    }
+    
+    return result;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(py_epd_update_obj, py_epd_update);
+
+
 STATIC mp_obj_t py_epd_clear_area(size_t          aArgsCnt,
                                   const mp_obj_t* aArgs)
 {
+    my_epd_obj* self = MP_OBJ_TO_PTR(aArgs[0]);
     Rect_t area =
     {
         MP_OBJ_SMALL_INT_VALUE(aArgs[1]),
@@ -161,11 +322,246 @@ STATIC mp_obj_t py_epd_clear_area(size_t          aArgsCnt,
     epd_clear_area(area);
     MP_THREAD_GIL_ENTER();
     
+    if (self->shadow)
+    {
+        EpdDirtyRect_t dirty = { area.x, area.y, area.width, area.height };
+        epd_dirty_fill(self->shadow, EPD_WIDTH, EPD_HEIGHT, dirty, 15);
+    }
+    
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(py_epd_clear_area_obj, 5, 5, py_epd_clear_area);
 
 
+/// Size of a glyph record in the `glyphs` buffer of `Font`,
+/// packed as "<BBBhhHI" (width, height, advance_x, left, top,
+/// compressed_size, data_offset).
+#define FONT_GLYPH_SIZE    14
+/// Size of an interval record in the `intervals` buffer of `Font`,
+/// packed as "<III" (first, last, offset).
+#define FONT_INTERVAL_SIZE 12
+
+
+typedef struct my_font_obj
+{
+    mp_obj_base_t base;
+    mp_obj_t      bitmap;     // Keeps the glyph bitmaps alive
+    GFXfont       font;
+}
+my_font_obj;
+
+
+static uint32_t get_le(const uint8_t* aPtr, size_t aSize)
+{
+    uint32_t value = 0;
+    
+    while (aSize--)
+    {
+        value = (value << 8) | aPtr[aSize];
+    }
+    
+    return value;
+}
+
+
+/// Font(bitmap, glyphs, intervals, advance_y, ascender, descender, compressed=True)
+///
+/// Wrap font data as produced by the epdiy font converter.  The bitmap is
+/// used in place, so it can be a bytes object frozen into flash.
+STATIC mp_obj_t my_font_make_new(const mp_obj_type_t* aType,
+                                 size_t               aArgsCnt,
+                                 size_t               aKwCnt,
+                                 const mp_obj_t*      aArgs)
+{
+    mp_arg_check_num(aArgsCnt, aKwCnt, 6, 7, false);
+    
+    mp_buffer_info_t bitmap, glyphs, intervals;
+    mp_get_buffer_raise(aArgs[0], &bitmap,    MP_BUFFER_READ);
+    mp_get_buffer_raise(aArgs[1], &glyphs,    MP_BUFFER_READ);
+    mp_get_buffer_raise(aArgs[2], &intervals, MP_BUFFER_READ);
+    
+    if (glyphs.len % FONT_GLYPH_SIZE || intervals.len % FONT_INTERVAL_SIZE)
+    {
+        mp_raise_ValueError(MP_ERROR_TEXT("invalid font tables"));
+    }
+    
+    size_t glyph_cnt    = glyphs.len    / FONT_GLYPH_SIZE;
+    size_t interval_cnt = intervals.len / FONT_INTERVAL_SIZE;
+    bool   compressed   = aArgsCnt > 6 ? mp_obj_is_true(aArgs[6]) : true;
+    
+    my_font_obj* self = m_new_obj(my_font_obj);
+    self->base.type   = aType;
+    self->bitmap      = aArgs[0];
+    
+    GFXglyph*        glyph    = m_new(GFXglyph,        glyph_cnt);
+    UnicodeInterval* interval = m_new(UnicodeInterval, interval_cnt);
+    
+    for (size_t i = 0; i < glyph_cnt; i++)
+    {
+        const uint8_t* g = (const uint8_t*)glyphs.buf + i * FONT_GLYPH_SIZE;
+        
+        glyph[i].width           = g[0];
+        glyph[i].height          = g[1];
+        glyph[i].advance_x       = g[2];
+        glyph[i].left            = (int16_t)get_le(g + 3, 2);
+        glyph[i].top             = (int16_t)get_le(g + 5, 2);
+        glyph[i].compressed_size = get_le(g + 7, 2);
+        glyph[i].data_offset     = get_le(g + 9, 4);
+        
+        size_t size = compressed ? glyph[i].compressed_size
+                                 : (glyph[i].width + 1) / 2 * glyph[i].height;
+        
+        if (glyph[i].data_offset + size > bitmap.len)
+        {
+            mp_raise_ValueError(MP_ERROR_TEXT("invalid font tables"));
+        }
+    }
+    
+    for (size_t i = 0; i < interval_cnt; i++)
+    {
+        const uint8_t* r = (const uint8_t*)intervals.buf + i * FONT_INTERVAL_SIZE;
+        
+        interval[i].first  = get_le(r,     4);
+        interval[i].last   = get_le(r + 4, 4);
+        interval[i].offset = get_le(r + 8, 4);
+        
+        if (interval[i].last < interval[i].first ||
+            interval[i].offset + interval[i].last - interval[i].first >= glyph_cnt)
+        {
+            mp_raise_ValueError(MP_ERROR_TEXT("invalid font tables"));
+        }
+    }
+    
+    self->font.bitmap         = bitmap.buf;
+    self->font.glyph          = glyph;
+    self->font.intervals      = interval;
+    self->font.interval_count = interval_cnt;
+    self->font.advance_y      = mp_obj_get_int(aArgs[3]);
+    self->font.ascender       = mp_obj_get_int(aArgs[4]);
+    self->font.descender      = mp_obj_get_int(aArgs[5]);
+    self->font.compressed     = compressed;
+    
+    // Cached glyphs are looked up by the address of their GFXglyph, which
+    // may be the address of a glyph of a font collected before
+    glyph_cache_clear(glyph, glyph_cnt);
+    
+    return MP_OBJ_FROM_PTR(self);
+}
+
+
+static const mp_obj_type_t py_font_type =
+{
+    { &mp_type_type },
+    .name     = MP_QSTR_Font,
+    .make_new = my_font_make_new,
+};
+
+
+static mp_obj_t write_text_obj(size_t          aArgsCnt,
+                               const mp_obj_t* aArgs,
+                               mp_map_t*       aKwArgs,
+                               bool            aDraw)
+{
+    enum { ARG_font, ARG_text, ARG_x, ARG_y, ARG_width, ARG_align, ARG_fg, ARG_bg };
+    static const mp_arg_t allowed_args[] =
+    {
+        { MP_QSTR_font,  MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = MP_OBJ_NULL } },
+        { MP_QSTR_text,  MP_ARG_REQUIRED | MP_ARG_OBJ, { .u_obj = MP_OBJ_NULL } },
+        { MP_QSTR_x,     MP_ARG_INT,                   { .u_int = 0 }           },
+        { MP_QSTR_y,     MP_ARG_INT,                   { .u_int = 0 }           },
+        { MP_QSTR_width, MP_ARG_KW_ONLY | MP_ARG_INT,  { .u_int = 0 }           },
+        { MP_QSTR_align, MP_ARG_KW_ONLY | MP_ARG_INT,  { .u_int = ALIGN_LEFT }  },
+        { MP_QSTR_fg,    MP_ARG_KW_ONLY | MP_ARG_INT,  { .u_int = 0 }           },
+        { MP_QSTR_bg,    MP_ARG_KW_ONLY | MP_ARG_INT,  { .u_int = 15 }          },
+    };
+    
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(aArgsCnt - 1, aArgs + 1, aKwArgs, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    
+    if (!mp_obj_is_type(args[ARG_font].u_obj, &py_font_type))
+    {
+        mp_raise_TypeError(MP_ERROR_TEXT("expecting a Font"));
+    }
+    
+    // Text is decoded as UTF-8, which only str guarantees
+    if (!mp_obj_is_str(args[ARG_text].u_obj))
+    {
+        mp_raise_TypeError(MP_ERROR_TEXT("expecting a str"));
+    }
+    
+    my_epd_obj*    self = MP_OBJ_TO_PTR(aArgs[0]);
+    my_font_obj*   font = MP_OBJ_TO_PTR(args[ARG_font].u_obj);
+    size_t         len;
+    const char*    text = mp_obj_str_get_data(args[ARG_text].u_obj, &len);
+    FontProperties props =
+    {
+        .fg_color       = args[ARG_fg].u_int,
+        .bg_color       = args[ARG_bg].u_int,
+        .fallback_glyph = 0,
+        .flags          = 0
+    };
+    Rect_t         bounds;
+    
+    write_text(&font->font, text, len, args[ARG_x].u_int, args[ARG_y].u_int,
+               args[ARG_width].u_int, args[ARG_align].u_int,
+               aDraw ? self->fb->items : NULL, &props, &bounds);
+    
+    mp_obj_t items[4] =
+    {
+        MP_OBJ_NEW_SMALL_INT(bounds.x),
+        MP_OBJ_NEW_SMALL_INT(bounds.y),
+        MP_OBJ_NEW_SMALL_INT(bounds.width),
+        MP_OBJ_NEW_SMALL_INT(bounds.height)
+    };
+    return mp_obj_new_tuple(4, items);
+}
+
+
+/// text(font, text, x=0, y=0, *, width=0, align=LEFT, fg=0, bg=15)
+///
+/// Draw text into the framebuffer with its first base line at `y`, and
+/// return the covered area as (x, y, w, h).  With `width`, lines are
+/// wrapped and aligned to it.
+STATIC mp_obj_t py_epd_text(size_t          aArgsCnt,
+                            const mp_obj_t* aArgs,
+                            mp_map_t*       aKwArgs)
+{
+    return write_text_obj(aArgsCnt, aArgs, aKwArgs, true);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(py_epd_text_obj, 3, py_epd_text);
+
+
+/// text_bounds(font, text, x=0, y=0, *, width=0, align=LEFT)
+///
+/// Return the area text() would cover, without drawing.
+STATIC mp_obj_t py_epd_text_bounds(size_t          aArgsCnt,
+                                   const mp_obj_t* aArgs,
+                                   mp_map_t*       aKwArgs)
+{
+    return write_text_obj(aArgsCnt, aArgs, aKwArgs, false);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_KW(py_epd_text_bounds_obj, 3, py_epd_text_bounds);
+
+
+/// Return (hits, misses, bytes) of the cache of decompressed glyphs.
+STATIC mp_obj_t py_epd_glyph_cache(mp_obj_t aSelf)
+{
+    unsigned long hits, misses;
+    size_t        bytes;
+    
+    glyph_cache_info(&hits, &misses, &bytes);
+    
+    mp_obj_t items[3] =
+    {
+        mp_obj_new_int_from_uint(hits),
+        mp_obj_new_int_from_uint(misses),
+        mp_obj_new_int_from_uint(bytes)
+    };
+    return mp_obj_new_tuple(3, items);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(py_epd_glyph_cache_obj, py_epd_glyph_cache);
+
+
 
 STATIC const mp_rom_map_elem_t py_epd_locals_dict_table[] =
 {
@@ -176,6 +572,16 @@ STATIC const mp_rom_map_elem_t py_epd_locals_dict_table[] =
     { MP_ROM_QSTR(MP_QSTR_clear),       MP_ROM_PTR(&py_epd_clear_obj)      },
     { MP_ROM_QSTR(MP_QSTR_clear_area),  MP_ROM_PTR(&py_epd_clear_area_obj) },
     { MP_ROM_QSTR(MP_QSTR_flush),       MP_ROM_PTR(&py_epd_flush_obj)      },
+    { MP_ROM_QSTR(MP_QSTR_flush_async), MP_ROM_PTR(&py_epd_flush_async_obj)},
+    { MP_ROM_QSTR(MP_QSTR_busy),        MP_ROM_PTR(&py_epd_busy_obj)       },
+    { MP_ROM_QSTR(MP_QSTR_wait),        MP_ROM_PTR(&py_epd_wait_obj)       },
+    { MP_ROM_QSTR(MP_QSTR_update),      MP_ROM_PTR(&py_epd_update_obj)     },
+    { MP_ROM_QSTR(MP_QSTR_text),        MP_ROM_PTR(&py_epd_text_obj)       },
+    { MP_ROM_QSTR(MP_QSTR_text_bounds), MP_ROM_PTR(&py_epd_text_bounds_obj)},
+    { MP_ROM_QSTR(MP_QSTR_glyph_cache), MP_ROM_PTR(&py_epd_glyph_cache_obj)},
+    { MP_ROM_QSTR(MP_QSTR_LEFT),        MP_ROM_INT(ALIGN_LEFT)             },
+    { MP_ROM_QSTR(MP_QSTR_CENTER),      MP_ROM_INT(ALIGN_CENTER)           },
+    { MP_ROM_QSTR(MP_QSTR_RIGHT),       MP_ROM_INT(ALIGN_RIGHT)            },
     { MP_ROM_QSTR(MP_QSTR_WIDTH),       MP_ROM_INT(EPD_WIDTH)              },
     { MP_ROM_QSTR(MP_QSTR_HEIGHT),      MP_ROM_INT(EPD_HEIGHT)             },
 };
@@ -195,6 +601,7 @@ STATIC const mp_map_elem_t globals_dict_table[] =
 {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_epd) },
     { MP_ROM_QSTR(MP_QSTR_Epd),      MP_ROM_PTR(&py_epd_type) },
+    { MP_ROM_QSTR(MP_QSTR_Font),     MP_ROM_PTR(&py_font_type) },
 };
 STATIC MP_DEFINE_CONST_DICT(globals_dict, globals_dict_table);
 
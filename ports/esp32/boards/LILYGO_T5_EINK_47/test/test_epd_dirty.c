@@ -0,0 +1,178 @@
+/**
+ * Host test for epd_dirty.c.
+ *
+ * Each scenario changes a copy of a framebuffer, finds the dirty areas and
+ * checks that redrawing only those areas onto a simulated panel reproduces
+ * the new framebuffer.  The number of rows and image bytes that would be
+ * pushed to the display is printed next to the cost of a full redraw.  Rows
+ * outside of the drawn area are skipped quickly by the driver, so the number
+ * of rows driven is a fair estimate of the refresh time.
+ */
+#include "epd_dirty.h"
+#include "host_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIDTH 960
+#define HEIGHT 540
+#define FB_SIZE (WIDTH / 2 * HEIGHT)
+
+static uint8_t fb[FB_SIZE];
+static uint8_t shadow[FB_SIZE];
+static uint8_t panel[FB_SIZE];
+static uint8_t image[FB_SIZE];
+
+static void set_pixel(uint8_t *buf, int x, int y, uint8_t color)
+{
+    uint8_t *p = buf + y * WIDTH / 2 + x / 2;
+    if (x % 2) {
+        *p = (*p & 0x0F) | (color << 4);
+    } else {
+        *p = (*p & 0xF0) | color;
+    }
+}
+
+static uint8_t get_pixel(const uint8_t *buf, int x, int y)
+{
+    uint8_t p = buf[y * WIDTH / 2 + x / 2];
+    return x % 2 ? p >> 4 : p & 0x0F;
+}
+
+static void fill_rect(uint8_t *buf, int x, int y, int w, int h, uint8_t color)
+{
+    for (int j = y; j < y + h; j++) {
+        for (int i = x; i < x + w; i++) {
+            set_pixel(buf, i, j, color);
+        }
+    }
+}
+
+/// Draw a packed image onto the simulated panel, like `epd_draw_image`.
+static void draw_image(EpdDirtyRect_t area, const uint8_t *data)
+{
+    for (int y = 0; y < area.height; y++) {
+        memcpy(panel + (area.y + y) * WIDTH / 2 + area.x / 2,
+               data + y * area.width / 2, area.width / 2);
+    }
+}
+
+/// Find the dirty areas of `fb`, redraw them and check the result.
+static size_t update(const char *name, size_t max_rects, size_t expect_max)
+{
+    EpdDirtyRect_t rects[EPD_DIRTY_MAX_RECTS];
+    size_t n = epd_dirty_find(fb, shadow, WIDTH, HEIGHT, rects, max_rects,
+                              EPD_DIRTY_MERGE_GAP);
+    long rows = 0;
+    long bytes = 0;
+
+    printf("%s:\n", name);
+    CHECK(n <= expect_max);
+    memcpy(panel, shadow, FB_SIZE);
+    for (size_t i = 0; i < n; i++) {
+        EpdDirtyRect_t r = rects[i];
+        printf("  rect %d,%d %dx%d\n", r.x, r.y, r.width, r.height);
+        CHECK(r.x % 2 == 0 && r.width % 2 == 0);
+        CHECK(r.width > 0 && r.height > 0);
+        CHECK(r.x + r.width <= WIDTH && r.y + r.height <= HEIGHT);
+        if (i > 0) {
+            CHECK(rects[i - 1].y + rects[i - 1].height <= r.y);
+        }
+        epd_dirty_extract(fb, WIDTH, r, image);
+        draw_image(r, image);
+        epd_dirty_commit(shadow, fb, WIDTH, r);
+        rows += r.height;
+        bytes += r.width / 2 * r.height;
+    }
+    CHECK(memcmp(panel, fb, FB_SIZE) == 0);
+    CHECK(memcmp(shadow, fb, FB_SIZE) == 0);
+    printf("  %zu rects, %ld/%d rows driven, %ld/%d image bytes (%.1f%%)\n",
+           n, rows, HEIGHT, bytes, FB_SIZE, 100.0 * bytes / FB_SIZE);
+    return n;
+}
+
+static void reset(void)
+{
+    memset(fb, 0xFF, FB_SIZE);
+    memset(shadow, 0xFF, FB_SIZE);
+}
+
+int main(void)
+{
+    // Nothing changed
+    reset();
+    CHECK(update("unchanged", EPD_DIRTY_MAX_RECTS, 0) == 0);
+
+    // The minute digits of a clock and a battery indicator
+    reset();
+    fill_rect(shadow, 400, 200, 200, 120, 0);
+    memcpy(fb, shadow, FB_SIZE);
+    fill_rect(fb, 510, 210, 80, 100, 15);
+    fill_rect(fb, 530, 230, 30, 60, 0);
+    fill_rect(fb, 900, 10, 41, 11, 5);
+    update("clock", EPD_DIRTY_MAX_RECTS, 2);
+
+    // A single pixel at an odd x position
+    reset();
+    set_pixel(fb, 301, 77, 0);
+    update("pixel", EPD_DIRTY_MAX_RECTS, 1);
+
+    // Lines of text close together are merged into one area
+    reset();
+    for (int i = 0; i < 5; i++) {
+        fill_rect(fb, 20, 40 + 30 * i, 500, 20, 0);
+    }
+    update("text lines", EPD_DIRTY_MAX_RECTS, 1);
+
+    // More scattered changes than there are rects
+    reset();
+    srand(1);
+    for (int i = 0; i < 30; i++) {
+        fill_rect(fb, rand() % (WIDTH - 20), 18 * i, 1 + rand() % 20, 3,
+                  rand() % 15);
+    }
+    update("scattered", EPD_DIRTY_MAX_RECTS, EPD_DIRTY_MAX_RECTS);
+
+    // The same with room for only one rect
+    reset();
+    fill_rect(fb, 10, 10, 4, 4, 0);
+    fill_rect(fb, 600, 300, 4, 4, 0);
+    fill_rect(fb, 100, 500, 4, 4, 0);
+    update("one rect", 1, 1);
+
+    // When full, the closest pair is merged even if it includes the new row
+    reset();
+    fill_rect(fb, 0, 0, 2, 1, 0);
+    fill_rect(fb, 0, 100, 2, 1, 0);
+    fill_rect(fb, 0, 400, 2, 1, 0);
+    fill_rect(fb, 0, 430, 2, 1, 0);
+    CHECK(update("closest pair", 3, 3) == 3);
+
+    // Everything changed
+    reset();
+    memset(fb, 0x00, FB_SIZE);
+    update("full", EPD_DIRTY_MAX_RECTS, 1);
+
+    // Filling the shadow after clearing an area at odd coordinates
+    reset();
+    memset(shadow, 0x00, FB_SIZE);
+    EpdDirtyRect_t area = { 3, 5, 7, 2 };
+    epd_dirty_fill(shadow, WIDTH, HEIGHT, area, 15);
+    area = (EpdDirtyRect_t) { WIDTH - 3, HEIGHT - 1, 10, 10 };
+    epd_dirty_fill(shadow, WIDTH, HEIGHT, area, 15);
+    printf("fill:\n");
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            int inside = (x >= 3 && x < 10 && y >= 5 && y < 7)
+                         || (x >= WIDTH - 3 && y == HEIGHT - 1);
+            if (get_pixel(shadow, x, y) != (inside ? 15 : 0)) {
+                CHECK(get_pixel(shadow, x, y) == (inside ? 15 : 0));
+                y = HEIGHT;
+                break;
+            }
+        }
+    }
+
+    return host_test_done();
+}
@@ -0,0 +1,241 @@
+/**
+ * Host test and benchmark for epd_glyph_cache.c.
+ *
+ * A font of zlib-compressed glyphs is generated the way the epdiy font
+ * converter does it.  The test checks that cached bitmaps match the
+ * originals, and that entries are evicted in least recently used order
+ * once either limit of the cache is reached.  The benchmark then draws
+ * text into a framebuffer, decompressing every glyph as font.c used to and
+ * through the cache, and prints the glyphs drawn per second.
+ */
+#include "epd_glyph_cache.h"
+#include "host_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <zlib.h>
+
+#define WIDTH 960
+#define HEIGHT 540
+#define GLYPHS 95
+#define GLYPH_WIDTH 22
+#define GLYPH_HEIGHT 34
+#define GLYPH_BYTES ((GLYPH_WIDTH + 1) / 2 * GLYPH_HEIGHT)
+
+typedef struct {
+    uint8_t raw[GLYPH_BYTES];
+    uint8_t data[GLYPH_BYTES + 64];
+    size_t data_size;
+} Glyph;
+
+static Glyph glyphs[GLYPHS];
+static uint8_t fb[WIDTH / 2 * HEIGHT];
+
+/// Build glyphs looking roughly like anti-aliased letters: a few strokes
+/// with soft edges on a white background.
+static void make_font(void)
+{
+    for (int g = 0; g < GLYPHS; g++) {
+        uint8_t pixels[GLYPH_HEIGHT][GLYPH_WIDTH];
+        memset(pixels, 15, sizeof(pixels));
+        for (int s = 0; s < 3; s++) {
+            int x0 = rand() % GLYPH_WIDTH, y0 = rand() % GLYPH_HEIGHT;
+            int x1 = rand() % GLYPH_WIDTH, y1 = rand() % GLYPH_HEIGHT;
+            for (int t = 0; t <= 64; t++) {
+                int x = x0 + (x1 - x0) * t / 64;
+                int y = y0 + (y1 - y0) * t / 64;
+                for (int dy = -2; dy <= 2; dy++) {
+                    for (int dx = -2; dx <= 2; dx++) {
+                        int xx = x + dx, yy = y + dy;
+                        if (xx < 0 || xx >= GLYPH_WIDTH || yy < 0 || yy >= GLYPH_HEIGHT) {
+                            continue;
+                        }
+                        int v = (abs(dx) + abs(dy)) * 4;
+                        if (v < pixels[yy][xx]) {
+                            pixels[yy][xx] = v;
+                        }
+                    }
+                }
+            }
+        }
+
+        Glyph *glyph = &glyphs[g];
+        memset(glyph->raw, 0, GLYPH_BYTES);
+        for (int y = 0; y < GLYPH_HEIGHT; y++) {
+            for (int x = 0; x < GLYPH_WIDTH; x++) {
+                glyph->raw[y * ((GLYPH_WIDTH + 1) / 2) + x / 2] |=
+                    pixels[y][x] << (4 * (x % 2));
+            }
+        }
+        uLongf size = sizeof(glyph->data);
+        compress2(glyph->data, &size, glyph->raw, GLYPH_BYTES, 9);
+        glyph->data_size = size;
+    }
+}
+
+static const uint8_t *get(EpdGlyphCache_t *cache, int g)
+{
+    return epd_glyph_cache_get(cache, &glyphs[g], GLYPH_BYTES, glyphs[g].data,
+                               glyphs[g].data_size);
+}
+
+static void test_cache(void)
+{
+    EpdGlyphCache_t cache;
+
+    printf("inflate:\n");
+    uint8_t out[GLYPH_BYTES];
+    for (int g = 0; g < GLYPHS; g++) {
+        CHECK(epd_glyph_inflate(out, GLYPH_BYTES, glyphs[g].data,
+                                glyphs[g].data_size));
+        CHECK(memcmp(out, glyphs[g].raw, GLYPH_BYTES) == 0);
+    }
+    CHECK(!epd_glyph_inflate(out, GLYPH_BYTES - 1, glyphs[0].data,
+                             glyphs[0].data_size) ||
+          memcmp(out, glyphs[0].raw, GLYPH_BYTES - 1) == 0);
+
+    printf("hits and misses:\n");
+    CHECK(epd_glyph_cache_init(&cache, 128, 1 << 20, malloc, free));
+    for (int n = 0; n < 3; n++) {
+        for (int g = 0; g < GLYPHS; g++) {
+            const uint8_t *bitmap = get(&cache, g);
+            CHECK(bitmap != NULL && memcmp(bitmap, glyphs[g].raw, GLYPH_BYTES) == 0);
+        }
+    }
+    CHECK(cache.misses == GLYPHS);
+    CHECK(cache.hits == 2 * GLYPHS);
+    CHECK(cache.count == GLYPHS);
+    CHECK(cache.bytes == GLYPHS * GLYPH_BYTES);
+    epd_glyph_cache_deinit(&cache);
+
+    printf("entry limit:\n");
+    CHECK(epd_glyph_cache_init(&cache, 4, 1 << 20, malloc, free));
+    get(&cache, 0);
+    get(&cache, 1);
+    get(&cache, 2);
+    get(&cache, 3);
+    get(&cache, 0);     // 1 is now the least recently used
+    get(&cache, 4);     // evicts 1
+    CHECK(cache.count == 4);
+    unsigned long misses = cache.misses;
+    get(&cache, 0);
+    get(&cache, 2);
+    get(&cache, 3);
+    get(&cache, 4);
+    CHECK(cache.misses == misses);
+    get(&cache, 1);
+    CHECK(cache.misses == misses + 1);
+    epd_glyph_cache_deinit(&cache);
+
+    printf("byte limit:\n");
+    CHECK(epd_glyph_cache_init(&cache, 64, 3 * GLYPH_BYTES, malloc, free));
+    for (int g = 0; g < 10; g++) {
+        CHECK(get(&cache, g) != NULL);
+        CHECK(cache.bytes <= 3 * GLYPH_BYTES);
+    }
+    CHECK(cache.count == 3);
+    misses = cache.misses;
+    get(&cache, 9);
+    get(&cache, 8);
+    get(&cache, 7);
+    CHECK(cache.misses == misses);
+
+    printf("clear:\n");
+    epd_glyph_cache_clear(&cache);
+    CHECK(cache.count == 0 && cache.bytes == 0);
+    CHECK(get(&cache, 9) != NULL);
+    CHECK(cache.misses == misses + 1);
+    epd_glyph_cache_deinit(&cache);
+
+    printf("drop:\n");
+    CHECK(epd_glyph_cache_init(&cache, 64, 1 << 20, malloc, free));
+    for (int g = 0; g < 10; g++) {
+        get(&cache, g);
+    }
+    epd_glyph_cache_drop(&cache, &glyphs[3], &glyphs[6]);
+    CHECK(cache.count == 7 && cache.bytes == 7 * GLYPH_BYTES);
+    misses = cache.misses;
+    for (int g = 0; g < 10; g++) {
+        get(&cache, g);
+    }
+    CHECK(cache.misses == misses + 3);
+    epd_glyph_cache_deinit(&cache);
+}
+
+/// Draw a glyph bitmap into the framebuffer like `draw_char` in font.c.
+static void blit(const uint8_t *bitmap, int x0, int y0)
+{
+    const int byte_width = (GLYPH_WIDTH + 1) / 2;
+    for (int y = 0; y < GLYPH_HEIGHT; y++) {
+        uint8_t *row = fb + (y0 + y) * WIDTH / 2;
+        for (int x = 0; x < GLYPH_WIDTH; x++) {
+            uint8_t bm = bitmap[y * byte_width + x / 2];
+            bm = x & 1 ? bm >> 4 : bm & 0x0F;
+            int xx = x0 + x;
+            if (xx & 1) {
+                row[xx / 2] = (row[xx / 2] & 0x0F) | (bm << 4);
+            } else {
+                row[xx / 2] = (row[xx / 2] & 0xF0) | bm;
+            }
+        }
+    }
+}
+
+/// Draw `count` glyphs of a text made of `distinct` different characters,
+/// and return the glyphs drawn per second.
+static double draw_text(EpdGlyphCache_t *cache, int count, int distinct)
+{
+    clock_t start = clock();
+    int x = 0, y = 0;
+
+    for (int i = 0; i < count; i++) {
+        int g = (i * 7) % distinct;
+        if (cache) {
+            blit(get(cache, g), x, y);
+        } else {
+            uint8_t *bitmap = malloc(GLYPH_BYTES);
+            epd_glyph_inflate(bitmap, GLYPH_BYTES, glyphs[g].data,
+                              glyphs[g].data_size);
+            blit(bitmap, x, y);
+            free(bitmap);
+        }
+        x += GLYPH_WIDTH;
+        if (x + GLYPH_WIDTH > WIDTH) {
+            x = 0;
+            y = (y + GLYPH_HEIGHT) % (HEIGHT - GLYPH_HEIGHT);
+        }
+    }
+
+    return count / ((double)(clock() - start) / CLOCKS_PER_SEC);
+}
+
+static void benchmark(void)
+{
+    const int count = 200000;
+    static const int distinct[] = { 10, 60, GLYPHS };
+
+    printf("benchmark (host, %d glyphs of %dx%d, %zu bytes compressed):\n",
+           count, GLYPH_WIDTH, GLYPH_HEIGHT, glyphs[0].data_size);
+    for (size_t i = 0; i < sizeof(distinct) / sizeof(*distinct); i++) {
+        EpdGlyphCache_t cache;
+        epd_glyph_cache_init(&cache, 512, 128 * 1024, malloc, free);
+        double without = draw_text(NULL, count, distinct[i]);
+        double with = draw_text(&cache, count, distinct[i]);
+        printf("  %2d distinct: %9.0f glyphs/s without cache, %9.0f with"
+               " (%.1fx)\n", distinct[i], without, with, with / without);
+        epd_glyph_cache_deinit(&cache);
+    }
+}
+
+int main(void)
+{
+    srand(1);
+    make_font();
+    test_cache();
+    benchmark();
+
+    return host_test_done();
+}
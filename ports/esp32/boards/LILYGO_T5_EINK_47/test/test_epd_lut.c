@@ -0,0 +1,137 @@
+/**
+ * Host test and benchmark for epd_lut.c.
+ *
+ * For each draw mode, the conversion table is updated frame by frame and
+ * compared with the expected output of every possible input, and a random
+ * line is converted and compared with a pixel by pixel conversion.  The
+ * time spent on the table and on converting all lines of a full screen
+ * image is printed at the end.
+ */
+#include "epd_lut.h"
+#include "host_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WIDTH 960
+#define HEIGHT 540
+
+static uint8_t lut[EPD_LUT_SIZE];
+static uint32_t line[WIDTH / 8];
+static uint32_t output[WIDTH / 16];
+
+/// The 2 bit EPD input of a pixel with brightness `v` in frame `k`.
+static uint8_t expected_pixel(uint8_t v, int k, enum DrawMode mode)
+{
+    if (mode == BLACK_ON_WHITE) {
+        // darken until the pixel is dark enough
+        return v < 15 - k ? 1 : 0;
+    } else if (mode == WHITE_ON_WHITE) {
+        return v < 15 - k ? 2 : 0;
+    } else {
+        // lighten until the pixel is light enough
+        return v > k ? 2 : 0;
+    }
+}
+
+/// The table entry of 4 pixels (16 bits of input) in frame `k`.
+static uint8_t expected_entry(uint32_t input, int k, enum DrawMode mode)
+{
+    uint8_t entry = 0;
+    for (int p = 0; p < 4; p++) {
+        entry |= expected_pixel((input >> (4 * p)) & 0x0F, k, mode) << (2 * p);
+    }
+    return entry;
+}
+
+static void check_mode(const char *name, enum DrawMode mode)
+{
+    printf("%s:\n", name);
+    epd_lut_reset(lut, mode);
+    for (int k = 0; k < EPD_LUT_FRAMES; k++) {
+        epd_lut_update(lut, k, mode);
+
+        int wrong = 0;
+        for (uint32_t i = 0; i < EPD_LUT_SIZE; i++) {
+            wrong += lut[i] != expected_entry(i, k, mode);
+        }
+        if (wrong) {
+            printf("  frame %d: %d wrong entries\n", k, wrong);
+        }
+        CHECK(wrong == 0);
+
+        // Output bytes are in the order of the input words 3, 4, 1, 2
+        uint16_t *in = (uint16_t *)line;
+        uint8_t *out = (uint8_t *)output;
+        for (int i = 0; i < WIDTH / 4; i++) {
+            in[i] = rand();
+        }
+        epd_lut_convert_4bpp(line, (uint8_t *)output, lut, WIDTH);
+        static const int order[4] = { 2, 3, 0, 1 };
+        for (int i = 0; i < WIDTH / 4; i++) {
+            int word = i / 4 * 4 + order[i % 4];
+            CHECK(out[i] == expected_entry(in[word], k, mode));
+        }
+    }
+}
+
+static double seconds(clock_t start)
+{
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+static void benchmark(void)
+{
+    const int images = 20;
+    volatile uint32_t sink = 0;
+
+    for (int i = 0; i < WIDTH / 8; i++) {
+        line[i] = rand();
+    }
+
+    clock_t start = clock();
+    for (int n = 0; n < images; n++) {
+        epd_lut_reset(lut, BLACK_ON_WHITE);
+    }
+    double reset = seconds(start) / images;
+
+    start = clock();
+    for (int n = 0; n < images; n++) {
+        epd_lut_reset(lut, BLACK_ON_WHITE);
+        for (int k = 0; k < EPD_LUT_FRAMES; k++) {
+            epd_lut_update(lut, k, BLACK_ON_WHITE);
+        }
+    }
+    double update = (seconds(start) / images - reset) / EPD_LUT_FRAMES;
+
+    start = clock();
+    for (int n = 0; n < images; n++) {
+        for (int k = 0; k < EPD_LUT_FRAMES; k++) {
+            for (int y = 0; y < HEIGHT; y++) {
+                epd_lut_convert_4bpp(line, (uint8_t *)output, lut, WIDTH);
+                sink += output[y % (WIDTH / 16)];
+            }
+        }
+    }
+    double convert = seconds(start) / images / EPD_LUT_FRAMES;
+
+    printf("benchmark (host):\n");
+    printf("  reset %.1f us per image\n", reset * 1e6);
+    printf("  update %.1f us per frame\n", update * 1e6);
+    printf("  convert %.1f us per frame, %.2f us per line\n",
+           convert * 1e6, convert * 1e6 / HEIGHT);
+    (void)sink;
+}
+
+int main(void)
+{
+    srand(1);
+    check_mode("black on white", BLACK_ON_WHITE);
+    check_mode("white on white", WHITE_ON_WHITE);
+    check_mode("white on black", WHITE_ON_BLACK);
+    benchmark();
+
+    return host_test_done();
+}
@@ -30,6 +30,8 @@
 /*********************
  *      DEFINES
  *********************/
+/* Queued transactions in flight, a flush of the ST7789 takes up to 6 */
+#define DISP_SPI_QUEUE_SIZE 8
 
 /**********************
  *      TYPEDEFS
@@ -38,6 +40,7 @@
 /**********************
  *  STATIC PROTOTYPES
  **********************/
+static void IRAM_ATTR spi_pre (spi_transaction_t *trans);
 static void IRAM_ATTR spi_ready (spi_transaction_t *trans);
 
 /**********************
@@ -45,6 +48,10 @@ static void IRAM_ATTR spi_ready (spi_transaction_t *trans);
  **********************/
 static spi_device_handle_t spi;
 static volatile uint8_t spi_pending_trans = 0;
+static spi_transaction_ext_t spi_queued_trans[DISP_SPI_QUEUE_SIZE];
+static uint8_t spi_queued_next = 0;
+static int dc_pin = -1;
+static transaction_cb_t chained_pre_cb;
 static transaction_cb_t chained_post_cb;
 
 /**********************
@@ -56,6 +63,8 @@ static transaction_cb_t chained_post_cb;
  **********************/
 void disp_spi_add_device_config(spi_host_device_t host, spi_device_interface_config_t *devcfg)
 {
+    chained_pre_cb=devcfg->pre_cb;
+    devcfg->pre_cb=spi_pre;
     chained_post_cb=devcfg->post_cb;
     devcfg->post_cb=spi_ready;
     esp_err_t ret=spi_bus_add_device(host, devcfg, &spi);
@@ -72,7 +81,7 @@ void disp_spi_add_device(spi_host_device_t host)
         .clock_speed_hz = SPI_TFT_CLOCK_SPEED_HZ,
         .mode = SPI_TFT_SPI_MODE,
         .spics_io_num=DISP_SPI_CS,              // CS pin
-        .queue_size=1,
+        .queue_size=DISP_SPI_QUEUE_SIZE,
         .pre_cb=NULL,
         .post_cb=NULL,
 #if !defined (CONFIG_LVGL_TFT_DISPLAY_CONTROLLER_FT81X)
@@ -91,8 +100,10 @@ void disp_spi_transaction(const uint8_t *data, uint16_t length,
         return;
     }
 
-    /* Wait for previous pending transaction results */
-    disp_wait_for_pending_transactions();
+    /* Polled and synchronous transactions can't overlap queued ones */
+    if (flags & (DISP_SPI_SEND_POLLING | DISP_SPI_SEND_SYNCHRONOUS)) {
+        disp_wait_for_pending_transactions();
+    }
 
     spi_transaction_ext_t t = {0};
 
@@ -127,24 +138,43 @@ void disp_spi_transaction(const uint8_t *data, uint16_t length,
     } else if (flags & DISP_SPI_SEND_SYNCHRONOUS) {
         spi_device_transmit(spi, (spi_transaction_t *) &t);
     } else {
-        static spi_transaction_ext_t queuedt;
-        memcpy(&queuedt, &t, sizeof t);
+        /* Slots are used in order, the oldest is free once its result is taken */
+        if (spi_pending_trans == DISP_SPI_QUEUE_SIZE) {
+            disp_reap_transaction(portMAX_DELAY);
+        }
+        spi_transaction_ext_t *queuedt = &spi_queued_trans[spi_queued_next];
+        memcpy(queuedt, &t, sizeof t);
         spi_pending_trans++;
-        if (spi_device_queue_trans(spi, (spi_transaction_t *) &queuedt, portMAX_DELAY) != ESP_OK) {
+        if (spi_device_queue_trans(spi, (spi_transaction_t *) queuedt, portMAX_DELAY) != ESP_OK) {
             spi_pending_trans--; /* Clear wait state */
+        } else {
+            spi_queued_next = (spi_queued_next + 1) % DISP_SPI_QUEUE_SIZE;
         }
     }
 }
 
+void disp_spi_set_dc_pin(int pin)
+{
+    dc_pin = pin;
+}
 
-void disp_wait_for_pending_transactions(void)
+
+bool disp_reap_transaction(TickType_t ticks_to_wait)
 {
     spi_transaction_t *presult;
 
+    if (spi_pending_trans &&
+        spi_device_get_trans_result(spi, &presult, ticks_to_wait) == ESP_OK) {
+        spi_pending_trans--;
+        return true;
+    }
+    return false;
+}
+
+void disp_wait_for_pending_transactions(void)
+{
     while (spi_pending_trans) {
-        if (spi_device_get_trans_result(spi, &presult, portMAX_DELAY) == ESP_OK) {
-            spi_pending_trans--;
-        }
+        disp_reap_transaction(portMAX_DELAY);
     }
 }
 
@@ -163,6 +193,20 @@ void disp_spi_release(void)
  *   STATIC FUNCTIONS
  **********************/
 
+/* Sets D/C line of queued transactions, others set it before sending */
+static void IRAM_ATTR spi_pre(spi_transaction_t *trans)
+{
+    disp_spi_send_flag_t flags = (disp_spi_send_flag_t) trans->user;
+
+    if (dc_pin >= 0 && (flags & (DISP_SPI_DC_LOW | DISP_SPI_DC_HIGH))) {
+        gpio_set_level(dc_pin, (flags & DISP_SPI_DC_HIGH) ? 1 : 0);
+    }
+
+    if (chained_pre_cb) {
+        chained_pre_cb(trans);
+    }
+}
+
 static void IRAM_ATTR spi_ready(spi_transaction_t *trans)
 {
     disp_spi_send_flag_t flags = (disp_spi_send_flag_t) trans->user;
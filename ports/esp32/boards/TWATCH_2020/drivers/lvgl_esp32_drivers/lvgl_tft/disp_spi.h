@@ -16,6 +16,7 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include <driver/spi_master.h>
+#include <freertos/FreeRTOS.h>
 
 /*********************
  *      DEFINES
@@ -39,6 +40,8 @@ typedef enum _disp_spi_send_flag_t {
     DISP_SPI_MODE_DIO           = 0x00000400, /* Reserved */
     DISP_SPI_MODE_QIO           = 0x00000800, /* Reserved */
     DISP_SPI_MODE_DIOQIO_ADDR   = 0x00001000, /* Reserved */
+    DISP_SPI_DC_LOW             = 0x00002000, /* D/C line set when sent, see disp_spi_set_dc_pin */
+    DISP_SPI_DC_HIGH            = 0x00004000,
 } disp_spi_send_flag_t;
 
 typedef struct _disp_spi_read_data {
@@ -57,6 +60,8 @@ void disp_spi_add_device(spi_host_device_t host);
 void disp_spi_add_device_config(spi_host_device_t host, spi_device_interface_config_t *devcfg);
 void disp_spi_transaction(const uint8_t *data, uint16_t length,
     disp_spi_send_flag_t flags, disp_spi_read_data *out, uint64_t addr);
+void disp_spi_set_dc_pin(int pin);
+bool disp_reap_transaction(TickType_t ticks_to_wait);
 void disp_wait_for_pending_transactions(void);
 void disp_spi_acquire(void);
 void disp_spi_release(void);
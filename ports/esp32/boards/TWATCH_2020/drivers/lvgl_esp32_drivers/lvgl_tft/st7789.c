@@ -11,6 +11,7 @@
 #include "esp_log.h"
 
 #include "st7789.h"
+#include "st7789_batch.h"
 
 #include "disp_spi.h"
 #include "driver/gpio.h"
@@ -35,11 +36,12 @@ typedef struct {
  **********************/
 
 static void st7789_send_data(void *data, uint16_t length);
-static void st7789_send_color(void *data, uint16_t length);
+static void st7789_queue(void *ctx, bool dc, const uint8_t *data, uint32_t length, bool flush);
 
 /**********************
  *  STATIC VARIABLES
  **********************/
+static st7789_batch_t batch;
 
 /**********************
  *      MACROS
@@ -81,6 +83,8 @@ void st7789_init(void)
 
     //Initialize non-SPI GPIOs
     gpio_set_direction(ST7789_DC, GPIO_MODE_OUTPUT);
+    disp_spi_set_dc_pin(ST7789_DC);
+    st7789_batch_init(&batch, st7789_queue, NULL);
     gpio_set_direction(ST7789_RST, GPIO_MODE_OUTPUT);
     
 #if ST7789_ENABLE_BACKLIGHT_CONTROL
@@ -126,15 +130,18 @@ void st7789_enable_backlight(bool backlight)
 
 /* The ST7789 display controller can drive 320*240 displays, when using a 240*240
  * display there's a gap of 80px, we need to edit the coordinates to take into
- * account that gap, this is not necessary in all orientations. */
+ * account that gap, this is not necessary in all orientations.
+ *
+ * Transactions are only queued, lv_disp_flush_ready is called from the
+ * spi_ready ISR when the pixels are sent, so LVGL renders into its other
+ * draw buffer meanwhile. */
 void st7789_flush(struct _disp_drv_t * drv, const lv_area_t * area, lv_color_t * color_map)
 {
-    uint8_t data[4] = {0};
-
     uint16_t offsetx1 = area->x1;
     uint16_t offsetx2 = area->x2;
     uint16_t offsety1 = area->y1;
     uint16_t offsety2 = area->y2;
+    uint16_t offsetyend = drv->ver_res - 1;
 
 #if (LV_HOR_RES_MAX == 240) && (LV_VER_RES_MAX == 240)
 #if (CONFIG_LVGL_DISPLAY_ORIENTATION_PORTRAIT)
@@ -143,32 +150,12 @@ void st7789_flush(struct _disp_drv_t * drv, const lv_area_t * area, lv_color_t *
 #elif (CONFIG_LVGL_DISPLAY_ORIENTATION_LANDSCAPE_INVERTED)
     offsety1 += 80;
     offsety2 += 80;
+    offsetyend += 80;
 #endif
 #endif
 
-    /*Column addresses*/
-    st7789_send_cmd(ST7789_CASET);
-    data[0] = (offsetx1 >> 8) & 0xFF;
-    data[1] = offsetx1 & 0xFF;
-    data[2] = (offsetx2 >> 8) & 0xFF;
-    data[3] = offsetx2 & 0xFF;
-    st7789_send_data(data, 4);
-
-    /*Page addresses*/
-    st7789_send_cmd(ST7789_RASET);
-    data[0] = (offsety1 >> 8) & 0xFF;
-    data[1] = offsety1 & 0xFF;
-    data[2] = (offsety2 >> 8) & 0xFF;
-    data[3] = offsety2 & 0xFF;
-    st7789_send_data(data, 4);
-
-    /*Memory write*/
-    st7789_send_cmd(ST7789_RAMWR);
-
-    uint32_t size = lv_area_get_width(area) * lv_area_get_height(area);
-
-    st7789_send_color((void*)color_map, size * 2);
-
+    st7789_batch_area(&batch, offsetx1, offsety1, offsetx2, offsety2, offsetyend,
+        (const uint8_t *) color_map);
 }
 
 /**********************
@@ -176,6 +163,9 @@ void st7789_flush(struct _disp_drv_t * drv, const lv_area_t * area, lv_color_t *
  **********************/
 void st7789_send_cmd(uint8_t cmd)
 {
+    /* Command may change the window or memory write */
+    st7789_batch_reset(&batch);
+
     disp_wait_for_pending_transactions();
     gpio_set_level(ST7789_DC, 0);
     disp_spi_send_data(&cmd, 1);
@@ -188,11 +178,16 @@ static void st7789_send_data(void * data, uint16_t length)
     disp_spi_send_data(data, length);
 }
 
-static void st7789_send_color(void * data, uint16_t length)
+static void st7789_queue(void *ctx, bool dc, const uint8_t *data, uint32_t length, bool flush)
 {
-    disp_wait_for_pending_transactions();
-    gpio_set_level(ST7789_DC, 1);
-    disp_spi_send_colors(data, length);
+    disp_spi_send_flag_t flags = DISP_SPI_SEND_QUEUED;
+
+    flags |= dc ? DISP_SPI_DC_HIGH : DISP_SPI_DC_LOW;
+    if (flush) {
+        flags |= DISP_SPI_SIGNAL_FLUSH;
+    }
+
+    disp_spi_transaction(data, length, flags, NULL, 0);
 }
 
 void st7789_set_orientation(uint8_t orientation)
@@ -0,0 +1,96 @@
+/**
+ * @file st7789_batch.c
+ *
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include "st7789_batch.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+/* Commands used here, see st7789.h */
+#define BATCH_CASET     0x2A
+#define BATCH_RASET     0x2B
+#define BATCH_RAMWR     0x2C
+#define BATCH_RAMWRC    0x3C
+
+/**********************
+ *  STATIC PROTOTYPES
+ **********************/
+static void send_cmd(st7789_batch_t *batch, uint8_t cmd);
+static void send_range(st7789_batch_t *batch, uint8_t cmd, uint16_t start, uint16_t end);
+
+/**********************
+ *   GLOBAL FUNCTIONS
+ **********************/
+void st7789_batch_init(st7789_batch_t *batch, st7789_batch_send_t send, void *ctx)
+{
+    batch->send = send;
+    batch->ctx = ctx;
+    batch->areas = 0;
+    batch->merged = 0;
+    st7789_batch_reset(batch);
+}
+
+void st7789_batch_reset(st7789_batch_t *batch)
+{
+    batch->valid = false;
+}
+
+void st7789_batch_area(st7789_batch_t *batch,
+    uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t y_end,
+    const uint8_t *pixels)
+{
+    bool columns = batch->valid && x1 == batch->x1 && x2 == batch->x2;
+
+    if (y_end < y2) {
+        y_end = y2;
+    }
+
+    batch->areas++;
+
+    if (columns && y1 == batch->y_next && y2 <= batch->y_end) {
+        /* Right below the previous area, memory write goes on there */
+        batch->merged++;
+        send_cmd(batch, BATCH_RAMWRC);
+    } else {
+        if (!columns) {
+            send_range(batch, BATCH_CASET, x1, x2);
+            batch->x1 = x1;
+            batch->x2 = x2;
+        }
+        send_range(batch, BATCH_RASET, y1, y_end);
+        send_cmd(batch, BATCH_RAMWR);
+        batch->y_end = y_end;
+        batch->valid = true;
+    }
+
+    batch->y_next = y2 + 1;
+
+    uint32_t size = (uint32_t) (x2 - x1 + 1) * (y2 - y1 + 1);
+    batch->send(batch->ctx, true, pixels, size * 2, true);
+}
+
+/**********************
+ *   STATIC FUNCTIONS
+ **********************/
+static void send_cmd(st7789_batch_t *batch, uint8_t cmd)
+{
+    batch->send(batch->ctx, false, &cmd, 1, false);
+}
+
+static void send_range(st7789_batch_t *batch, uint8_t cmd, uint16_t start, uint16_t end)
+{
+    uint8_t data[4];
+
+    data[0] = (start >> 8) & 0xFF;
+    data[1] = start & 0xFF;
+    data[2] = (end >> 8) & 0xFF;
+    data[3] = end & 0xFF;
+
+    send_cmd(batch, cmd);
+    batch->send(batch->ctx, true, data, 4, false);
+}
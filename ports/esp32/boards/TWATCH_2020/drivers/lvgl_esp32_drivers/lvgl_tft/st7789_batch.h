@@ -0,0 +1,69 @@
+/**
+ * @file st7789_batch.h
+ *
+ * Turns flushed areas into ST7789 command and pixel transactions.
+ *
+ * The address window is tracked between flushes: columns are only sent when
+ * they change, and the window always reaches down to the bottom of the
+ * display, so an area right below the previous one with the same columns
+ * (LVGL flushes large areas in strips of the draw buffer height) continues
+ * the previous memory write with a single RAMWRC command.
+ *
+ * Transactions are handed to a send function which is expected to queue
+ * them.
+ */
+
+#ifndef ST7789_BATCH_H
+#define ST7789_BATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdbool.h>
+#include <stdint.h>
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/* Queues one transaction. dc is the level of the D/C line (false for
+ * commands). Data of up to 4 bytes may live on the stack of the caller,
+ * pixels stay valid until the transaction with flush set is done. */
+typedef void (*st7789_batch_send_t)(void *ctx, bool dc, const uint8_t *data,
+    uint32_t length, bool flush);
+
+typedef struct {
+    st7789_batch_send_t send;
+    void *ctx;
+    bool valid;         /* Window below is set on the display */
+    uint16_t x1;        /* Columns of window */
+    uint16_t x2;
+    uint16_t y_end;     /* Last row of window */
+    uint16_t y_next;    /* Row the memory write continues at */
+    uint32_t areas;     /* Areas sent */
+    uint32_t merged;    /* Areas continuing the previous one */
+} st7789_batch_t;
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+void st7789_batch_init(st7789_batch_t *batch, st7789_batch_send_t send, void *ctx);
+
+/* Forgets the window, after commands sent outside of the batch */
+void st7789_batch_reset(st7789_batch_t *batch);
+
+/* Queues commands and RGB565 pixels of area x1..x2, y1..y2 (inclusive,
+ * display coordinates). y_end is the last row of the display. */
+void st7789_batch_area(st7789_batch_t *batch,
+    uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint16_t y_end,
+    const uint8_t *pixels);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* ST7789_BATCH_H */
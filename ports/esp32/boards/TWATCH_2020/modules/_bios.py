@@ -168,9 +168,11 @@ class Display:
         # Initializes display
         st7789.lvgl_driver_init()
         
+        # Two draw buffers, LVGL renders into one while the other is sent
         disp_buf1         = st7789.lv_disp_buf_t()
         buf1_1            = bytes(_DISP_BUFF_SIZE)
-        disp_buf1.init(buf1_1, None, len(buf1_1) // 4)
+        buf1_2            = bytes(_DISP_BUFF_SIZE)
+        disp_buf1.init(buf1_1, buf1_2, len(buf1_1) // 4)
         
         disp_drv          = st7789.lv_disp_drv_t()
         disp_drv.init()
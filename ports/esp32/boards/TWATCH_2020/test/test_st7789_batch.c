@@ -0,0 +1,420 @@
+/*
+ * Host test and benchmark for st7789_batch.c.
+ *
+ * A mock SPI bus takes the transactions and feeds them to a model of the
+ * ST7789 (address window, memory pointer, RAMWR/RAMWRC), so random flushed
+ * areas have to end up in display memory exactly as drawn, with the
+ * expected number of transactions.
+ *
+ * The mock also keeps simulated time of CPU and bus.  Polled transactions
+ * hold the CPU until they are on the wire, queued ones only cost the CPU
+ * to queue them and the bus a gap for the ISR.  The benchmark refreshes the
+ * whole 240x240 screen in strips of the draw buffer height as LVGL does:
+ * the former flush (commands polled after waiting for pending pixels) with
+ * one draw buffer, and the batched flush with one and two draw buffers.
+ * Numbers are model numbers for a 40 MHz bus, not measurements.
+ */
+#include "st7789_batch.h"
+#include "host_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#define WIDTH       240
+#define HEIGHT      240
+#define RAM_ROWS    320             // Controller memory is 240x320
+#define ROW_OFFSET  80              // Landscape inverted 240x240 panel
+
+#define SPI_HZ      40000000.0      // 80 MHz / CONFIG_LVGL_TFT_CUSTOM_SPI_CLK_DIVIDER
+#define POLL_US     8.0             // CPU per polled transaction
+#define QUEUE_US    5.0             // CPU per queued transaction
+#define GAP_US      4.0             // Bus idle between queued transactions (ISR)
+
+#define CASET       0x2A
+#define RASET       0x2B
+#define RAMWR       0x2C
+#define RAMWRC      0x3C
+
+
+/*
+ * Mock SPI bus with ST7789 behind it
+ */
+struct mock_bus
+{
+    uint16_t ram[RAM_ROWS][WIDTH];
+    uint8_t  cmd;
+    uint8_t  params[4];
+    int      nparams;
+    uint16_t xs, xe, ys, ye;    // Address window
+    uint16_t x, y;              // Memory pointer
+    bool     writing;
+
+    unsigned trans;             // Transactions
+    unsigned cmds;              // Command transactions
+    double   cpu;               // Simulated time of CPU
+    double   bus;               // Bus is busy until then
+    double   ready;             // Last flushed pixels are sent then
+};
+
+
+static struct mock_bus bus;
+
+
+static void mock_reset(void)
+{
+    memset(&bus, 0, sizeof(bus));
+}
+
+
+static void mock_bytes(bool aDc, const uint8_t* aData, uint32_t aLen)
+{
+    bus.trans++;
+
+    if (!aDc)
+    {
+        for (uint32_t i = 0; i < aLen; ++i)
+        {
+            bus.cmd     = aData[i];
+            bus.nparams = 0;
+            bus.writing = (RAMWR == bus.cmd) || (RAMWRC == bus.cmd);
+            if (RAMWR == bus.cmd)
+            {
+                bus.x = bus.xs;
+                bus.y = bus.ys;
+            }
+            bus.cmds++;
+        }
+        return;
+    }
+
+    if (bus.writing)
+    {
+        for (uint32_t i = 0; i + 1 < aLen; i += 2)
+        {
+            if (bus.y < RAM_ROWS && bus.x < WIDTH)
+            {
+                bus.ram[bus.y][bus.x] = aData[i] << 8 | aData[i + 1];
+            }
+            if (bus.x++ == bus.xe)
+            {
+                bus.x = bus.xs;
+                bus.y = (bus.y == bus.ye) ? bus.ys : bus.y + 1;
+            }
+        }
+        return;
+    }
+
+    for (uint32_t i = 0; i < aLen && bus.nparams < 4; ++i)
+    {
+        bus.params[bus.nparams++] = aData[i];
+    }
+
+    if (4 == bus.nparams)
+    {
+        uint16_t start = bus.params[0] << 8 | bus.params[1];
+        uint16_t end   = bus.params[2] << 8 | bus.params[3];
+
+        if (CASET == bus.cmd)
+        {
+            bus.xs = start;
+            bus.xe = end;
+        }
+        else if (RASET == bus.cmd)
+        {
+            bus.ys = start;
+            bus.ye = end;
+        }
+    }
+}
+
+
+static double _max(double a, double b)
+{
+    return a > b ? a : b;
+}
+
+
+/*
+ * disp_spi_transaction(..., DISP_SPI_SEND_POLLING, ...)
+ */
+static void mock_poll(bool aDc, const uint8_t* aData, uint32_t aLen)
+{
+    mock_bytes(aDc, aData, aLen);
+    bus.cpu = _max(bus.cpu, bus.bus) + POLL_US + aLen * 8 / SPI_HZ * 1e6;
+    bus.bus = bus.cpu;
+}
+
+
+/*
+ * disp_spi_transaction(..., DISP_SPI_SEND_QUEUED, ...), as send function
+ * of the batch
+ */
+static void mock_queue(void*          aCtx,
+                       bool           aDc,
+                       const uint8_t* aData,
+                       uint32_t       aLen,
+                       bool           aFlush)
+{
+    (void)aCtx;
+
+    mock_bytes(aDc, aData, aLen);
+    bus.cpu += QUEUE_US;
+    bus.bus  = _max(bus.cpu, bus.bus) + GAP_US + aLen * 8 / SPI_HZ * 1e6;
+    if (aFlush)
+    {
+        bus.ready = bus.bus;
+    }
+}
+
+
+/*
+ * Former st7789_flush, every command waited for pending transactions
+ */
+static void legacy_flush(uint16_t       aX1,
+                         uint16_t       aY1,
+                         uint16_t       aX2,
+                         uint16_t       aY2,
+                         const uint8_t* aPixels)
+{
+    uint8_t cmd;
+    uint8_t data[4];
+
+    cmd = CASET;
+    mock_poll(false, &cmd, 1);
+    data[0] = aX1 >> 8; data[1] = aX1; data[2] = aX2 >> 8; data[3] = aX2;
+    mock_poll(true, data, 4);
+
+    cmd = RASET;
+    mock_poll(false, &cmd, 1);
+    data[0] = aY1 >> 8; data[1] = aY1; data[2] = aY2 >> 8; data[3] = aY2;
+    mock_poll(true, data, 4);
+
+    cmd = RAMWR;
+    mock_poll(false, &cmd, 1);
+
+    bus.cpu = _max(bus.cpu, bus.bus);
+    mock_queue(NULL, true, aPixels, (aX2 - aX1 + 1) * (aY2 - aY1 + 1) * 2, true);
+}
+
+
+/*
+ * Screen as drawn, big endian RGB565 as sent
+ */
+static uint16_t screen[HEIGHT][WIDTH];
+static uint8_t  pixels[WIDTH * HEIGHT * 2];
+
+
+/*
+ * Draws random area into screen and its pixels into `pixels`
+ */
+static void draw(uint16_t aX1,
+                 uint16_t aY1,
+                 uint16_t aX2,
+                 uint16_t aY2)
+{
+    uint8_t* p = pixels;
+
+    for (int y = aY1; y <= aY2; ++y)
+    {
+        for (int x = aX1; x <= aX2; ++x)
+        {
+            uint16_t c = rand();
+
+            screen[y][x] = c;
+            *p++ = c >> 8;
+            *p++ = c;
+        }
+    }
+}
+
+
+static bool screen_matches(void)
+{
+    for (int y = 0; y < HEIGHT; ++y)
+    {
+        if (memcmp(screen[y], bus.ram[y + ROW_OFFSET], sizeof(screen[y])))
+        {
+            printf("  row %d differs\n", y);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+static void flush(st7789_batch_t* aBatch,
+                  uint16_t        aX1,
+                  uint16_t        aY1,
+                  uint16_t        aX2,
+                  uint16_t        aY2)
+{
+    draw(aX1, aY1, aX2, aY2);
+    st7789_batch_area(aBatch, aX1, aY1 + ROW_OFFSET, aX2, aY2 + ROW_OFFSET,
+                      HEIGHT - 1 + ROW_OFFSET, pixels);
+}
+
+
+static void test_batch(void)
+{
+    st7789_batch_t batch;
+
+    printf("batch:\n");
+    mock_reset();
+    st7789_batch_init(&batch, mock_queue, NULL);
+
+    // Full screen in strips: window once, then RAMWRC and pixels per strip
+    for (int y = 0; y < HEIGHT; y += 10)
+    {
+        flush(&batch, 0, y, WIDTH - 1, y + 9);
+    }
+    CHECK(screen_matches());
+    CHECK(bus.trans == 6 + 23 * 2 && bus.cmds == 3 + 23);
+    CHECK(batch.areas == 24 && batch.merged == 23);
+
+    // Same columns elsewhere, only rows are sent
+    unsigned trans = bus.trans;
+    flush(&batch, 0, 5, WIDTH - 1, 6);
+    CHECK(bus.trans - trans == 4);
+
+    // Other columns
+    trans = bus.trans;
+    flush(&batch, 10, 7, 20, 8);
+    CHECK(bus.trans - trans == 6);
+
+    // Strip below with other columns can't continue
+    trans = bus.trans;
+    flush(&batch, 10, 9, 21, 9);
+    CHECK(bus.trans - trans == 6);
+
+    // Window is sent again after reset
+    trans = bus.trans;
+    st7789_batch_reset(&batch);
+    flush(&batch, 10, 10, 21, 10);
+    CHECK(bus.trans - trans == 6);
+    CHECK(screen_matches());
+
+    // Random areas and runs of strips
+    for (int round = 0; round < 3000; ++round)
+    {
+        uint16_t x1 = rand() % WIDTH;
+        uint16_t x2 = x1 + rand() % (WIDTH - x1);
+        uint16_t y1 = rand() % HEIGHT;
+        uint16_t y2 = y1 + rand() % (HEIGHT - y1);
+
+        if (rand() & 1)
+        {
+            for (uint16_t h = 1 + rand() % 16; y1 <= y2; y1 += h)
+            {
+                flush(&batch, x1, y1, x2, (y1 + h - 1 < y2) ? y1 + h - 1 : y2);
+            }
+        }
+        else
+        {
+            flush(&batch, x1, y1, x2, y2);
+        }
+
+        if (0 == rand() % 50)
+        {
+            st7789_batch_reset(&batch);
+        }
+    }
+    CHECK(screen_matches());
+    printf("  %u areas, %u continued previous one\n", batch.areas, batch.merged);
+}
+
+
+enum mode
+{
+    LEGACY,         // Former flush, one draw buffer
+    BATCH_SINGLE,   // Batched and queued, one draw buffer
+    BATCH_DOUBLE    // Batched and queued, two draw buffers
+};
+
+
+/*
+ * Refreshes the screen in strips of `aRows`, rendering takes `aRenderUs`
+ * per pixel.  Returns simulated time of refresh.
+ */
+static double refresh(enum mode aMode,
+                      int       aRows,
+                      double    aRenderUs,
+                      unsigned* aTrans)
+{
+    st7789_batch_t batch;
+
+    mock_reset();
+    st7789_batch_init(&batch, mock_queue, NULL);
+
+    for (int y = 0; y < HEIGHT; y += aRows)
+    {
+        int y2 = (y + aRows - 1 < HEIGHT) ? y + aRows - 1 : HEIGHT - 1;
+
+        bus.cpu += aRenderUs * WIDTH * (y2 - y + 1);
+        draw(0, y, WIDTH - 1, y2);
+
+        // LVGL waits for the previous flush before the next one
+        bus.cpu = _max(bus.cpu, bus.ready);
+
+        if (LEGACY == aMode)
+        {
+            legacy_flush(0, y + ROW_OFFSET, WIDTH - 1, y2 + ROW_OFFSET, pixels);
+        }
+        else
+        {
+            st7789_batch_area(&batch, 0, y + ROW_OFFSET, WIDTH - 1, y2 + ROW_OFFSET,
+                              HEIGHT - 1 + ROW_OFFSET, pixels);
+        }
+
+        // One draw buffer is only rendered into again when it is sent
+        if (BATCH_DOUBLE != aMode)
+        {
+            bus.cpu = _max(bus.cpu, bus.ready);
+        }
+    }
+
+    CHECK(screen_matches());
+    *aTrans = bus.trans;
+    return _max(bus.cpu, bus.ready);
+}
+
+
+static void benchmark(void)
+{
+    static const char* names[] = { "former, 1 buffer", "batched, 1 buffer", "batched, 2 buffers" };
+    const int          rows[]  = { 4, 16 };
+    const double       render[] = { 0.1, 0.4 };
+
+    printf("benchmark (model, %dx%d refresh, %.0f MHz SPI):\n", WIDTH, HEIGHT, SPI_HZ / 1e6);
+
+    for (unsigned r = 0; r < sizeof(rows) / sizeof(rows[0]); ++r)
+    {
+        for (unsigned p = 0; p < sizeof(render) / sizeof(render[0]); ++p)
+        {
+            double   base = 0;
+            unsigned trans;
+
+            printf("  %2d rows per buffer, rendering %.1f us/px:\n", rows[r], render[p]);
+            for (int m = LEGACY; m <= BATCH_DOUBLE; ++m)
+            {
+                double t = refresh(m, rows[r], render[p], &trans);
+
+                base = base ? base : t;
+                printf("    %-20s %6.1f ms, %5.1f fps, %4u transactions (%.2fx)\n",
+                       names[m], t / 1000, 1e6 / t, trans, base / t);
+            }
+        }
+    }
+}
+
+
+int main(void)
+{
+    srand(1);
+
+    test_batch();
+    benchmark();
+
+    return host_test_done();
+}
@@ -0,0 +1,186 @@
+/*
+ * This file is part of the MicroPython ESP32 project
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021 Ondrej Sienczak (OSi)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "himem_cache.h"
+#include <string.h>
+
+
+
+
+void himem_cache_init(himem_cache_t* aCache,
+                      size_t         aBlockSize,
+                      unsigned       aWindowCnt,
+                      himem_map_fn   aMap,
+                      himem_unmap_fn aUnmap,
+                      void*          aCtx)
+{
+    memset(aCache, 0, sizeof(*aCache));
+
+    aCache->map        = aMap;
+    aCache->unmap      = aUnmap;
+    aCache->ctx        = aCtx;
+    aCache->block_size = aBlockSize;
+    aCache->window_cnt = aWindowCnt < HIMEM_CACHE_WINDOWS ? aWindowCnt : HIMEM_CACHE_WINDOWS;
+}
+
+
+
+
+uint8_t* himem_cache_ptr(himem_cache_t* aCache,
+                         size_t         aHimem,
+                         int*           aErr)
+{
+    size_t          block  = aHimem - aHimem % aCache->block_size;
+    himem_window_t* victim = &aCache->windows[0];
+
+    ++aCache->clock;
+
+    /*
+     * Look for the block between mapped windows and, at the same time,
+     * for a free or least recently used window to map it into
+     */
+    for (unsigned i = 0; i < aCache->window_cnt; ++i)
+    {
+        himem_window_t* w = &aCache->windows[i];
+
+        if (w->ptr && w->himem == block)
+        {
+            w->used = aCache->clock;
+            ++aCache->hits;
+            return w->ptr + (aHimem - block);
+        }
+
+        if (victim->ptr && (!w->ptr || w->used < victim->used))
+        {
+            victim = w;
+        }
+    }
+
+    unsigned idx = victim - aCache->windows;
+
+    if (victim->ptr)
+    {
+        *aErr = aCache->unmap(aCache->ctx, idx, victim->ptr);
+        victim->ptr = NULL;
+
+        if (*aErr)
+        {
+            return NULL;
+        }
+    }
+
+    void* ptr = NULL;
+    *aErr     = aCache->map(aCache->ctx, block, idx, &ptr);
+
+    if (*aErr)
+    {
+        return NULL;
+    }
+
+    ++aCache->maps;
+    victim->ptr   = ptr;
+    victim->himem = block;
+    victim->used  = aCache->clock;
+
+    return victim->ptr + (aHimem - block);
+}
+
+
+
+
+int himem_cache_copy(himem_cache_t*   aCache,
+                     void*            aRam,
+                     size_t           aHimem,
+                     size_t           aSize,
+                     enum himem_dir_t aDir,
+                     uint8_t          aValue)
+{
+    uint8_t* ram = aRam;
+
+    while (aSize > 0)
+    {
+        int      err;
+        uint8_t* himem = himem_cache_ptr(aCache, aHimem, &err);
+
+        if (!himem)
+        {
+            return err;
+        }
+
+        size_t cnt = aCache->block_size - aHimem % aCache->block_size;
+
+        if (cnt > aSize)
+        {
+            cnt = aSize;
+        }
+
+        if (HIMEM_2_RAM == aDir)
+        {
+            memcpy(ram, himem, cnt);
+            ram += cnt;
+        }
+        else if (RAM_2_HIMEM == aDir)
+        {
+            memcpy(himem, ram, cnt);
+            ram += cnt;
+        }
+        else
+        {
+            memset(himem, aValue, cnt);
+        }
+
+        aHimem += cnt;
+        aSize  -= cnt;
+    }
+
+    return 0;
+}
+
+
+
+
+int himem_cache_flush(himem_cache_t* aCache)
+{
+    int rc = 0;
+
+    for (unsigned i = 0; i < aCache->window_cnt; ++i)
+    {
+        himem_window_t* w = &aCache->windows[i];
+
+        if (w->ptr)
+        {
+            int err = aCache->unmap(aCache->ctx, i, w->ptr);
+
+            if (err && !rc)
+            {
+                rc = err;
+            }
+
+            w->ptr = NULL;
+        }
+    }
+
+    return rc;
+}
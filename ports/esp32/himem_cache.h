@@ -0,0 +1,147 @@
+/*
+ * This file is part of the MicroPython ESP32 project
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021 Ondrej Sienczak (OSi)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+/*
+ * Cache of himem blocks mapped into the address space.
+ *
+ * Himem is only accessible through a few windows of one block, each of
+ * which can map any block of himem.  Mapping and unmapping a block is
+ * expensive, so blocks stay mapped between accesses and the least recently
+ * used window is remapped when a block is not mapped yet.
+ *
+ * The cache only knows about blocks and windows, mapping itself is done by
+ * the backend functions.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+#ifndef HIMEM_CACHE_WINDOWS
+#define HIMEM_CACHE_WINDOWS 4
+#endif
+
+
+/// Maps himem block at offset `aHimem` into window `aWindow`, returns 0 on success.
+typedef int (*himem_map_fn)(void*     aCtx,
+                            size_t    aHimem,
+                            unsigned  aWindow,
+                            void**    aPtr);
+
+/// Unmaps window `aWindow` mapped at `aPtr`, returns 0 on success.
+typedef int (*himem_unmap_fn)(void*    aCtx,
+                              unsigned aWindow,
+                              void*    aPtr);
+
+
+typedef struct himem_window_t
+{
+    uint8_t* ptr;       // NULL if the window is not mapped
+    size_t   himem;     // Offset of the mapped block
+    uint32_t used;      // Time of last use, for LRU
+}
+himem_window_t;
+
+
+typedef struct himem_cache_t
+{
+    himem_map_fn   map;
+    himem_unmap_fn unmap;
+    void*          ctx;
+    size_t         block_size;
+    unsigned       window_cnt;
+    uint32_t       clock;
+    himem_window_t windows[HIMEM_CACHE_WINDOWS];
+
+    // Statistics
+    unsigned long  hits;
+    unsigned long  maps;
+}
+himem_cache_t;
+
+
+enum himem_dir_t
+{
+    HIMEM_2_RAM,
+    RAM_2_HIMEM,
+    HIMEM_SET
+};
+
+
+/**
+ * @brief Sets up a cache with no windows mapped
+ *
+ * @param aCache        Cache
+ * @param aBlockSize    Size of block (and window)
+ * @param aWindowCnt    Number of windows, at most `HIMEM_CACHE_WINDOWS`
+ * @param aMap          Backend mapping function
+ * @param aUnmap        Backend unmapping function
+ * @param aCtx          Passed to backend functions
+ */
+void himem_cache_init(himem_cache_t* aCache,
+                      size_t         aBlockSize,
+                      unsigned       aWindowCnt,
+                      himem_map_fn   aMap,
+                      himem_unmap_fn aUnmap,
+                      void*          aCtx);
+
+/**
+ * @brief Returns pointer to himem offset `aHimem`, mapping its block if needed
+ *
+ * The pointer is valid up to the end of the block and until the next
+ * call of any himem_cache function.
+ *
+ * @param aErr  Receives backend error code, if mapping failed
+ * @return Pointer or NULL on error
+ */
+uint8_t* himem_cache_ptr(himem_cache_t* aCache,
+                         size_t         aHimem,
+                         int*           aErr);
+
+/**
+ * @brief Copies between RAM and himem, or fills himem
+ *
+ * @param aRam      RAM buffer, unused for `HIMEM_SET`
+ * @param aHimem    Himem offset
+ * @param aSize     Number of bytes
+ * @param aDir      Direction of copy
+ * @param aValue    Fill value for `HIMEM_SET`
+ * @return 0 or backend error code
+ */
+int himem_cache_copy(himem_cache_t*   aCache,
+                     void*            aRam,
+                     size_t           aHimem,
+                     size_t           aSize,
+                     enum himem_dir_t aDir,
+                     uint8_t          aValue);
+
+/**
+ * @brief Unmaps all windows
+ *
+ * @return 0 or first backend error code
+ */
+int himem_cache_flush(himem_cache_t* aCache);
@@ -0,0 +1,243 @@
+/*
+ * This file is part of the MicroPython ESP32 project
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021 Ondrej Sienczak (OSi)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "himem_heap.h"
+#include <string.h>
+
+
+
+
+static uint16_t _new_chunk(himem_heap_t* aHeap)
+{
+    uint16_t idx = aHeap->unused;
+
+    if (HIMEM_HEAP_NONE != idx)
+    {
+        aHeap->unused = aHeap->chunks[idx].next;
+    }
+
+    return idx;
+}
+
+
+
+
+static void _drop_chunk(himem_heap_t* aHeap,
+                        uint16_t      aIdx)
+{
+    himem_chunk_t* chunk = &aHeap->chunks[aIdx];
+
+    if (HIMEM_HEAP_NONE != chunk->prev)
+    {
+        aHeap->chunks[chunk->prev].next = chunk->next;
+    }
+    else
+    {
+        aHeap->head = chunk->next;
+    }
+
+    if (HIMEM_HEAP_NONE != chunk->next)
+    {
+        aHeap->chunks[chunk->next].prev = chunk->prev;
+    }
+
+    chunk->used   = false;
+    chunk->size   = 0;
+    chunk->next   = aHeap->unused;
+    aHeap->unused = aIdx;
+}
+
+
+
+
+void himem_heap_init(himem_heap_t* aHeap,
+                     size_t        aSize,
+                     size_t        aAlign)
+{
+    memset(aHeap, 0, sizeof(*aHeap));
+
+    aHeap->size  = aSize & ~(aAlign - 1);
+    aHeap->align = aAlign;
+
+    for (unsigned i = 0; i < HIMEM_HEAP_CHUNKS; ++i)
+    {
+        aHeap->chunks[i].next = i + 1 < HIMEM_HEAP_CHUNKS ? i + 1 : HIMEM_HEAP_NONE;
+    }
+
+    aHeap->unused = 0;
+    aHeap->head   = _new_chunk(aHeap);
+
+    himem_chunk_t* chunk = &aHeap->chunks[aHeap->head];
+
+    chunk->offset = 0;
+    chunk->size   = aHeap->size;
+    chunk->prev   = HIMEM_HEAP_NONE;
+    chunk->next   = HIMEM_HEAP_NONE;
+}
+
+
+
+
+int himem_heap_alloc(himem_heap_t* aHeap,
+                     size_t        aSize)
+{
+    if (0 == aSize)
+    {
+        aSize = 1;
+    }
+
+    if (aSize > aHeap->size)
+    {
+        return -1;
+    }
+
+    size_t   size = (aSize + aHeap->align - 1) & ~(aHeap->align - 1);
+    uint16_t best = HIMEM_HEAP_NONE;
+
+    for (uint16_t i = aHeap->head; HIMEM_HEAP_NONE != i; i = aHeap->chunks[i].next)
+    {
+        const himem_chunk_t* chunk = &aHeap->chunks[i];
+
+        if (!chunk->used && chunk->size >= size &&
+            (HIMEM_HEAP_NONE == best || chunk->size < aHeap->chunks[best].size))
+        {
+            best = i;
+
+            if (chunk->size == size)
+            {
+                break;
+            }
+        }
+    }
+
+    if (HIMEM_HEAP_NONE == best)
+    {
+        return -1;
+    }
+
+    himem_chunk_t* chunk = &aHeap->chunks[best];
+
+    /*
+     * Rest of the chunk stays free, unless we ran out of entries, in which
+     * case the whole chunk is used
+     */
+    if (chunk->size > size)
+    {
+        uint16_t idx = _new_chunk(aHeap);
+
+        if (HIMEM_HEAP_NONE != idx)
+        {
+            himem_chunk_t* rest = &aHeap->chunks[idx];
+
+            rest->offset = chunk->offset + size;
+            rest->size   = chunk->size - size;
+            rest->used   = false;
+            rest->prev   = best;
+            rest->next   = chunk->next;
+
+            if (HIMEM_HEAP_NONE != chunk->next)
+            {
+                aHeap->chunks[chunk->next].prev = idx;
+            }
+
+            chunk->next = idx;
+            chunk->size = size;
+        }
+    }
+
+    chunk->used        = true;
+    aHeap->used_bytes += chunk->size;
+    ++aHeap->used_cnt;
+
+    return best;
+}
+
+
+
+
+const himem_chunk_t* himem_heap_chunk(const himem_heap_t* aHeap,
+                                      int                 aHandle)
+{
+    if (aHandle < 0 || aHandle >= HIMEM_HEAP_CHUNKS || !aHeap->chunks[aHandle].used)
+    {
+        return NULL;
+    }
+
+    return &aHeap->chunks[aHandle];
+}
+
+
+
+
+bool himem_heap_free(himem_heap_t* aHeap,
+                     int           aHandle)
+{
+    if (!himem_heap_chunk(aHeap, aHandle))
+    {
+        return false;
+    }
+
+    uint16_t       idx   = aHandle;
+    himem_chunk_t* chunk = &aHeap->chunks[idx];
+
+    chunk->used        = false;
+    aHeap->used_bytes -= chunk->size;
+    --aHeap->used_cnt;
+
+    if (HIMEM_HEAP_NONE != chunk->next && !aHeap->chunks[chunk->next].used)
+    {
+        chunk->size += aHeap->chunks[chunk->next].size;
+        _drop_chunk(aHeap, chunk->next);
+    }
+
+    if (HIMEM_HEAP_NONE != chunk->prev && !aHeap->chunks[chunk->prev].used)
+    {
+        aHeap->chunks[chunk->prev].size += chunk->size;
+        _drop_chunk(aHeap, idx);
+    }
+
+    return true;
+}
+
+
+
+
+void himem_heap_stat(const himem_heap_t* aHeap,
+                     size_t*             aFree,
+                     size_t*             aLargest)
+{
+    *aFree    = aHeap->size - aHeap->used_bytes;
+    *aLargest = 0;
+
+    for (uint16_t i = aHeap->head; HIMEM_HEAP_NONE != i; i = aHeap->chunks[i].next)
+    {
+        const himem_chunk_t* chunk = &aHeap->chunks[i];
+
+        if (!chunk->used && chunk->size > *aLargest)
+        {
+            *aLargest = chunk->size;
+        }
+    }
+}
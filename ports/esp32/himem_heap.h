@@ -0,0 +1,113 @@
+/*
+ * This file is part of the MicroPython ESP32 project
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2021 Ondrej Sienczak (OSi)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+/*
+ * Best-fit allocator of an area of himem.
+ *
+ * Himem is not addressable, so the allocator keeps its bookkeeping in RAM,
+ * in a fixed table of chunks ordered by offset.  Chunks are handed out by
+ * their index in the table, which stays valid until the chunk is freed.
+ *
+ * The allocator only deals with offsets, copying data is up to the user.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+#ifndef HIMEM_HEAP_CHUNKS
+#define HIMEM_HEAP_CHUNKS 128
+#endif
+
+#define HIMEM_HEAP_NONE 0xFFFF
+
+
+typedef struct himem_chunk_t
+{
+    size_t   offset;
+    size_t   size;
+    uint16_t prev;      // Neighbours by offset, or next unused chunk
+    uint16_t next;
+    bool     used;
+}
+himem_chunk_t;
+
+
+typedef struct himem_heap_t
+{
+    himem_chunk_t chunks[HIMEM_HEAP_CHUNKS];
+    uint16_t      head;         // Chunk at offset 0
+    uint16_t      unused;       // First unused entry of `chunks`
+    size_t        size;
+    size_t        align;
+
+    // Statistics
+    size_t        used_bytes;
+    unsigned      used_cnt;
+}
+himem_heap_t;
+
+
+/**
+ * @brief Sets up a heap of one free chunk
+ *
+ * @param aHeap     Heap
+ * @param aSize     Size of managed area
+ * @param aAlign    Alignment and granularity of chunks, power of 2
+ */
+void himem_heap_init(himem_heap_t* aHeap,
+                     size_t        aSize,
+                     size_t        aAlign);
+
+/**
+ * @brief Allocates the smallest free chunk of at least `aSize` bytes
+ *
+ * @return Handle of chunk or -1 if there is no chunk large enough
+ */
+int himem_heap_alloc(himem_heap_t* aHeap,
+                     size_t        aSize);
+
+/**
+ * @brief Frees chunk and merges it with free neighbours
+ *
+ * @return false if `aHandle` is not an allocated chunk
+ */
+bool himem_heap_free(himem_heap_t* aHeap,
+                     int           aHandle);
+
+/**
+ * @brief Returns allocated chunk or NULL if `aHandle` is not allocated
+ */
+const himem_chunk_t* himem_heap_chunk(const himem_heap_t* aHeap,
+                                      int                 aHandle);
+
+/**
+ * @brief Gets free bytes in total and the largest free chunk
+ */
+void himem_heap_stat(const himem_heap_t* aHeap,
+                     size_t*             aFree,
+                     size_t*             aLargest);
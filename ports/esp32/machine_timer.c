@@ -32,6 +32,7 @@
 
 #include "py/obj.h"
 #include "py/runtime.h"
+#include "py/profile.h"
 #include "modmachine.h"
 #include "mphalport.h"
 
@@ -128,61 +129,115 @@ STATIC void machine_timer_disable(machine_timer_obj_t *self) {
     // referenced elsewhere
 }
 
-STATIC void machine_timer_isr(void *self_in) {
-    machine_timer_obj_t *self = self_in;
-    timg_dev_t *device = self->group ? &(TIMERG1) : &(TIMERG0);
+// Acknowledge the alarm interrupt of a timer, and re-arm it if repeat is set.
+STATIC void machine_timer_isr_clear(mp_uint_t group, mp_uint_t index, mp_uint_t repeat) {
+    timg_dev_t *device = group ? &(TIMERG1) : &(TIMERG0);
 
     #if HAVE_TIMER_LL
 
     #if CONFIG_IDF_TARGET_ESP32
-    device->hw_timer[self->index].update = 1;
+    device->hw_timer[index].update = 1;
     #else
     #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 4, 0)
     #if CONFIG_IDF_TARGET_ESP32S3
-    device->hw_timer[self->index].update.tn_update = 1;
+    device->hw_timer[index].update.tn_update = 1;
     #else
-    device->hw_timer[self->index].update.tx_update = 1;
+    device->hw_timer[index].update.tx_update = 1;
     #endif
     #else
-    device->hw_timer[self->index].update.update = 1;
+    device->hw_timer[index].update.update = 1;
     #endif
     #endif
-    timer_ll_clear_intr_status(device, self->index);
-    timer_ll_set_alarm_enable(device, self->index, self->repeat);
+    timer_ll_clear_intr_status(device, index);
+    timer_ll_set_alarm_enable(device, index, repeat);
 
     #else
 
-    device->hw_timer[self->index].update = 1;
-    if (self->index) {
+    device->hw_timer[index].update = 1;
+    if (index) {
         device->int_clr_timers.t1 = 1;
     } else {
         device->int_clr_timers.t0 = 1;
     }
-    device->hw_timer[self->index].config.alarm_en = self->repeat;
+    device->hw_timer[index].config.alarm_en = repeat;
 
     #endif
+}
 
+STATIC void machine_timer_isr(void *self_in) {
+    machine_timer_obj_t *self = self_in;
+    machine_timer_isr_clear(self->group, self->index, self->repeat);
     mp_sched_schedule(self->callback, self);
     mp_hal_wake_main_task_from_isr();
 }
 
-STATIC void machine_timer_enable(machine_timer_obj_t *self) {
+STATIC void machine_timer_start(mp_uint_t group, mp_uint_t index, mp_uint_t repeat, uint64_t period,
+    intr_handler_t isr, void *arg, intr_handle_t *handle) {
     timer_config_t config;
     config.alarm_en = TIMER_ALARM_EN;
-    config.auto_reload = self->repeat;
+    config.auto_reload = repeat;
     config.counter_dir = TIMER_COUNT_UP;
     config.divider = TIMER_DIVIDER;
     config.intr_type = TIMER_INTR_LEVEL;
     config.counter_en = TIMER_PAUSE;
 
-    check_esp_err(timer_init(self->group, self->index, &config));
-    check_esp_err(timer_set_counter_value(self->group, self->index, 0x00000000));
-    check_esp_err(timer_set_alarm_value(self->group, self->index, self->period));
-    check_esp_err(timer_enable_intr(self->group, self->index));
-    check_esp_err(timer_isr_register(self->group, self->index, machine_timer_isr, (void *)self, TIMER_FLAGS, &self->handle));
-    check_esp_err(timer_start(self->group, self->index));
+    check_esp_err(timer_init(group, index, &config));
+    check_esp_err(timer_set_counter_value(group, index, 0x00000000));
+    check_esp_err(timer_set_alarm_value(group, index, period));
+    check_esp_err(timer_enable_intr(group, index));
+    check_esp_err(timer_isr_register(group, index, isr, arg, TIMER_FLAGS, handle));
+    check_esp_err(timer_start(group, index));
 }
 
+STATIC void machine_timer_enable(machine_timer_obj_t *self) {
+    machine_timer_start(self->group, self->index, self->repeat, self->period,
+        machine_timer_isr, (void *)self, &self->handle);
+}
+
+#if MICROPY_PY_MICROPYTHON_PROFILE
+
+// The sampling profiler uses the hardware timer of
+// machine.Timer(MICROPY_HW_PROFILE_TIMER), Timer(2) by default.  That timer is
+// reserved while the profiler runs: it can't be initialised then, and the
+// profiler can't be started while it is running.  Its interrupt is allocated
+// on the core running MicroPython so the ISR samples whichever MicroPython
+// thread it interrupted.
+#define PROF_TIMER_GROUP ((MICROPY_HW_PROFILE_TIMER >> 1) & 1)
+#define PROF_TIMER_INDEX (MICROPY_HW_PROFILE_TIMER & 1)
+
+STATIC intr_handle_t prof_timer_handle;
+
+STATIC bool prof_timer_is_reserved(machine_timer_obj_t *self) {
+    return prof_timer_handle != NULL && self->group == PROF_TIMER_GROUP && self->index == PROF_TIMER_INDEX;
+}
+
+STATIC void prof_timer_isr(void *arg) {
+    (void)arg;
+    machine_timer_isr_clear(PROF_TIMER_GROUP, PROF_TIMER_INDEX, 1);
+    mp_prof_sample();
+}
+
+void mp_prof_sample_timer_start(mp_uint_t period_us) {
+    mp_prof_sample_timer_stop();
+    for (machine_timer_obj_t *t = MP_STATE_PORT(machine_timer_obj_head); t; t = t->next) {
+        if (t->handle != NULL && t->group == PROF_TIMER_GROUP && t->index == PROF_TIMER_INDEX) {
+            mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("profiler timer in use"));
+        }
+    }
+    uint64_t period = (uint64_t)period_us * (TIMER_SCALE / 1000000);
+    machine_timer_start(PROF_TIMER_GROUP, PROF_TIMER_INDEX, 1, period, prof_timer_isr, NULL, &prof_timer_handle);
+}
+
+void mp_prof_sample_timer_stop(void) {
+    if (prof_timer_handle) {
+        timer_pause(PROF_TIMER_GROUP, PROF_TIMER_INDEX);
+        esp_intr_free(prof_timer_handle);
+        prof_timer_handle = NULL;
+    }
+}
+
+#endif
+
 STATIC mp_obj_t machine_timer_init_helper(machine_timer_obj_t *self, mp_uint_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     enum {
         ARG_mode,
@@ -203,6 +258,12 @@ STATIC mp_obj_t machine_timer_init_helper(machine_timer_obj_t *self, mp_uint_t n
         #endif
     };
 
+    #if MICROPY_PY_MICROPYTHON_PROFILE
+    if (prof_timer_is_reserved(self)) {
+        mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("timer used by profiler"));
+    }
+    #endif
+
     machine_timer_disable(self);
 
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
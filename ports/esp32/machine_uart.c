@@ -445,7 +445,10 @@ STATIC mp_uint_t machine_uart_read(mp_obj_t self_in, void *buf_in, mp_uint_t siz
         time_to_wait = pdMS_TO_TICKS(self->timeout);
     }
 
+    // Don't hold the GIL while blocking on the UART so other threads can run.
+    MP_THREAD_GIL_EXIT();
     int bytes_read = uart_read_bytes(self->uart_num, buf_in, size, time_to_wait);
+    MP_THREAD_GIL_ENTER();
 
     if (bytes_read <= 0) {
         *errcode = MP_EAGAIN;
@@ -458,7 +461,10 @@ STATIC mp_uint_t machine_uart_read(mp_obj_t self_in, void *buf_in, mp_uint_t siz
 STATIC mp_uint_t machine_uart_write(mp_obj_t self_in, const void *buf_in, mp_uint_t size, int *errcode) {
     machine_uart_obj_t *self = MP_OBJ_TO_PTR(self_in);
 
+    // This can block until there is room in the TX buffer, so release the GIL.
+    MP_THREAD_GIL_EXIT();
     int bytes_written = uart_write_bytes(self->uart_num, buf_in, size);
+    MP_THREAD_GIL_ENTER();
 
     if (bytes_written < 0) {
         *errcode = MP_EAGAIN;
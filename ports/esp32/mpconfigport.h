@@ -63,6 +63,7 @@
 #define MICROPY_ENABLE_SCHEDULER            (1)
 #define MICROPY_SCHEDULER_DEPTH             (8)
 #define MICROPY_VFS                         (1)
+#define MICROPY_MODULE_IMPORT_CACHE         (1)
 
 // control over Python builtins
 #define MICROPY_PY_FUNCTION_ATTRS           (1)
@@ -101,6 +102,12 @@
 #define MICROPY_PY_BUILTINS_HELP_MODULES    (1)
 #define MICROPY_PY___FILE__                 (1)
 #define MICROPY_PY_MICROPYTHON_MEM_INFO     (1)
+#define MICROPY_PY_MICROPYTHON_PROFILE      (1)
+#define MICROPY_PY_MICROPYTHON_PROFILE_SAMPLES (128)
+// machine.Timer id whose hardware timer is used by the profiler
+#ifndef MICROPY_HW_PROFILE_TIMER
+#define MICROPY_HW_PROFILE_TIMER            (2)
+#endif
 #define MICROPY_PY_ARRAY                    (1)
 #define MICROPY_PY_ARRAY_SLICE_ASSIGN       (1)
 #define MICROPY_PY_ATTRTUPLE                (1)
@@ -118,6 +125,7 @@
 #define MICROPY_PY_IO_BYTESIO               (1)
 #define MICROPY_PY_IO_BUFFEREDWRITER        (1)
 #define MICROPY_PY_STRUCT                   (1)
+#define MICROPY_PY_STRUCT_OBJECT            (1)
 #define MICROPY_PY_SYS                      (1)
 #define MICROPY_PY_SYS_MAXSIZE              (1)
 #define MICROPY_PY_SYS_MODULES              (1)
@@ -130,6 +138,7 @@
 #define MICROPY_PY_THREAD                   (1)
 #define MICROPY_PY_THREAD_GIL               (1)
 #define MICROPY_PY_THREAD_GIL_VM_DIVISOR    (32)
+#define MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL (1000)
 
 // extended modules
 #ifndef MICROPY_PY_BLUETOOTH
@@ -140,6 +149,7 @@
 #endif
 #define MICROPY_PY_UASYNCIO                 (1)
 #define MICROPY_PY_UCTYPES                  (1)
+#define MICROPY_PY_UCTYPES_COMPILE          (1)
 #define MICROPY_PY_UZLIB                    (1)
 #define MICROPY_PY_UJSON                    (1)
 #define MICROPY_PY_URE                      (1)
@@ -190,6 +200,7 @@
 #define MICROPY_PY_UWEBSOCKET               (1)
 #define MICROPY_PY_WEBREPL                  (1)
 #define MICROPY_PY_FRAMEBUF                 (1)
+#define MICROPY_PY_ARRAYOPS                 (1)
 #define MICROPY_PY_BTREE                    (1)
 #define MICROPY_PY_ONEWIRE                  (1)
 #define MICROPY_PY_USOCKET_EVENTS           (MICROPY_PY_WEBREPL)
@@ -206,6 +217,8 @@
 
 // use vfs's functions for import stat and builtin open
 #define mp_import_stat mp_vfs_import_stat
+#define mp_import_listdir mp_vfs_import_listdir
+#define mp_import_dir_stamp mp_vfs_import_dir_stamp
 #define mp_builtin_open mp_vfs_open
 #define mp_builtin_open_obj mp_vfs_open_obj
 
@@ -341,6 +354,7 @@ void *esp_native_code_commit(void *, size_t, void *);
 #include "freertos/FreeRTOS.h"
 #define MICROPY_BEGIN_ATOMIC_SECTION() portENTER_CRITICAL_NESTED()
 #define MICROPY_END_ATOMIC_SECTION(state) portEXIT_CRITICAL_NESTED(state)
+#define MICROPY_THREAD_YIELD() taskYIELD()
 
 #if MICROPY_PY_USOCKET_EVENTS
 #define MICROPY_PY_USOCKET_EVENTS_HANDLER extern void usocket_events_handler(void); usocket_events_handler();
@@ -0,0 +1,118 @@
+/*
+ * Fake himem for host tests.
+ *
+ * The himem is a temporary file.  Windows are mapped into a reserved range
+ * of the address space with mmap, so like on the ESP32 a block written
+ * through a window is seen through any later mapping of the same block.
+ * Like esp_himem_map, mapping a block or a window which is already mapped
+ * fails.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+#define FAKE_HIMEM_WINDOWS_MAX 16
+
+
+typedef struct fake_himem_t
+{
+    FILE*         file;
+    uint8_t*      windows;
+    size_t        size;
+    size_t        block_size;
+    size_t        mapped[FAKE_HIMEM_WINDOWS_MAX];   // Block + 1, or 0
+    unsigned long maps;
+    unsigned long unmaps;
+}
+fake_himem_t;
+
+
+static bool fake_himem_open(fake_himem_t* aFake,
+                            size_t        aSize,
+                            size_t        aBlockSize)
+{
+    memset(aFake, 0, sizeof(*aFake));
+    aFake->size       = aSize;
+    aFake->block_size = aBlockSize;
+    aFake->file       = tmpfile();
+
+    if (!aFake->file || ftruncate(fileno(aFake->file), aSize))
+    {
+        return false;
+    }
+
+    aFake->windows = mmap(NULL, aBlockSize * FAKE_HIMEM_WINDOWS_MAX, PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    return aFake->windows != MAP_FAILED;
+}
+
+
+static void fake_himem_close(fake_himem_t* aFake)
+{
+    munmap(aFake->windows, aFake->block_size * FAKE_HIMEM_WINDOWS_MAX);
+    fclose(aFake->file);
+}
+
+
+static int fake_himem_map(void*    aCtx,
+                          size_t   aHimem,
+                          unsigned aWindow,
+                          void**   aPtr)
+{
+    fake_himem_t* fake = aCtx;
+
+    if (aWindow >= FAKE_HIMEM_WINDOWS_MAX || fake->mapped[aWindow] ||
+        aHimem % fake->block_size || aHimem >= fake->size)
+    {
+        return 0x102;   // ESP_ERR_INVALID_ARG
+    }
+
+    for (unsigned i = 0; i < FAKE_HIMEM_WINDOWS_MAX; ++i)
+    {
+        if (fake->mapped[i] == aHimem + 1)
+        {
+            return 0x103;   // ESP_ERR_INVALID_STATE
+        }
+    }
+
+    uint8_t* ptr = mmap(fake->windows + aWindow * fake->block_size, fake->block_size,
+                        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                        fileno(fake->file), aHimem);
+
+    if (ptr == MAP_FAILED)
+    {
+        return 0x101;   // ESP_ERR_NO_MEM
+    }
+
+    fake->mapped[aWindow] = aHimem + 1;
+    ++fake->maps;
+    *aPtr = ptr;
+    return 0;
+}
+
+
+static int fake_himem_unmap(void*    aCtx,
+                            unsigned aWindow,
+                            void*    aPtr)
+{
+    fake_himem_t* fake = aCtx;
+
+    if (aWindow >= FAKE_HIMEM_WINDOWS_MAX || !fake->mapped[aWindow] ||
+        aPtr != fake->windows + aWindow * fake->block_size)
+    {
+        return 0x102;
+    }
+
+    mmap(aPtr, fake->block_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    fake->mapped[aWindow] = 0;
+    ++fake->unmaps;
+    return 0;
+}
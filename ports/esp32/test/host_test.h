@@ -0,0 +1,41 @@
+/*
+ * Helpers shared by the host tests of the port and of the board drivers.
+ *
+ * CHECK counts and reports a failed condition without stopping the test,
+ * host_test_done prints the result and gives the exit status of main.
+ * host_test_now is a monotonic wall clock in seconds for the benchmarks.
+ */
+#pragma once
+
+#include <stdio.h>
+#include <time.h>
+
+
+static int failures;
+
+
+#define CHECK(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } \
+    while (0)
+
+
+static inline double host_test_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+static inline int host_test_done(void)
+{
+    printf(failures ? "%d FAILED\n" : "OK\n", failures);
+    return failures != 0;
+}
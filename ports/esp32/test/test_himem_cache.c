@@ -0,0 +1,221 @@
+/*
+ * Host test and benchmark for himem_cache.c, on top of an mmap backed fake
+ * himem.
+ *
+ * Random reads, writes and fills are checked against a copy of the himem
+ * in RAM.  Then access patterns of the himem module are replayed, with the
+ * cache and with one window mapped and unmapped around every block as
+ * himem.c used to do, and the number of map calls and time are printed.
+ */
+#include "himem_cache.h"
+#include "fake_himem.h"
+#include "host_test.h"
+
+#include <time.h>
+
+
+#define BLOCK  (32 * 1024)
+#define SIZE   (64 * BLOCK)
+
+
+static uint8_t ref[SIZE];
+static uint8_t buf[4 * BLOCK];
+
+
+static size_t rnd(size_t aMax)
+{
+    return ((size_t)rand() << 16 ^ rand()) % aMax;
+}
+
+
+static void test_random(void)
+{
+    fake_himem_t  fake;
+    himem_cache_t cache;
+
+    printf("random access:\n");
+    CHECK(fake_himem_open(&fake, SIZE, BLOCK));
+    himem_cache_init(&cache, BLOCK, HIMEM_CACHE_WINDOWS, fake_himem_map, fake_himem_unmap, &fake);
+    memset(ref, 0, SIZE);
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        size_t size = rnd(i % 10 ? 600 : sizeof(buf)) + 1;
+        size_t addr = rnd(SIZE - size);
+
+        switch (rand() % 3)
+        {
+            case 0:
+                for (size_t j = 0; j < size; ++j)
+                {
+                    buf[j] = rand();
+                }
+                memcpy(ref + addr, buf, size);
+                CHECK(0 == himem_cache_copy(&cache, buf, addr, size, RAM_2_HIMEM, 0));
+                break;
+            case 1:
+                memset(ref + addr, i & 0xFF, size);
+                CHECK(0 == himem_cache_copy(&cache, NULL, addr, size, HIMEM_SET, i & 0xFF));
+                break;
+            default:
+                CHECK(0 == himem_cache_copy(&cache, buf, addr, size, HIMEM_2_RAM, 0));
+                CHECK(0 == memcmp(buf, ref + addr, size));
+                break;
+        }
+    }
+
+    CHECK(0 == himem_cache_flush(&cache));
+    CHECK(fake.maps == fake.unmaps);
+
+    // Everything written through the windows has reached the himem
+    uint8_t* himem = mmap(NULL, SIZE, PROT_READ, MAP_SHARED, fileno(fake.file), 0);
+    CHECK(0 == memcmp(himem, ref, SIZE));
+    munmap(himem, SIZE);
+
+    fake_himem_close(&fake);
+}
+
+
+static void test_lru(void)
+{
+    fake_himem_t  fake;
+    himem_cache_t cache;
+    int           err;
+
+    printf("lru:\n");
+    CHECK(fake_himem_open(&fake, SIZE, BLOCK));
+    himem_cache_init(&cache, BLOCK, 4, fake_himem_map, fake_himem_unmap, &fake);
+
+    for (size_t b = 0; b < 4; ++b)
+    {
+        CHECK(NULL != himem_cache_ptr(&cache, b * BLOCK + 10, &err));
+    }
+    CHECK(4 == fake.maps);
+
+    himem_cache_ptr(&cache, 0, &err);           // Block 1 is now the oldest
+    himem_cache_ptr(&cache, 4 * BLOCK, &err);   // Replaces block 1
+    CHECK(5 == fake.maps && 1 == fake.unmaps);
+    himem_cache_ptr(&cache, 0, &err);
+    himem_cache_ptr(&cache, 2 * BLOCK, &err);
+    himem_cache_ptr(&cache, 3 * BLOCK, &err);
+    himem_cache_ptr(&cache, 4 * BLOCK, &err);
+    CHECK(5 == fake.maps);
+    himem_cache_ptr(&cache, 1 * BLOCK, &err);
+    CHECK(6 == fake.maps);
+
+    // Backend errors are passed through
+    CHECK(NULL == himem_cache_ptr(&cache, SIZE, &err) && 0x102 == err);
+
+    himem_cache_flush(&cache);
+    fake_himem_close(&fake);
+}
+
+
+typedef void (*pattern_fn)(himem_cache_t* aCache, bool aOld);
+
+
+static void copy(himem_cache_t*   aCache,
+                 bool             aOld,
+                 void*            aRam,
+                 size_t           aHimem,
+                 size_t           aSize,
+                 enum himem_dir_t aDir)
+{
+    himem_cache_copy(aCache, aRam, aHimem, aSize, aDir, 0xFF);
+
+    if (aOld)
+    {
+        himem_cache_flush(aCache);
+    }
+}
+
+
+/// Reading the whole himem in chunks of 4 KB
+static void stream(himem_cache_t* aCache, bool aOld)
+{
+    for (size_t addr = 0; addr < SIZE; addr += 4096)
+    {
+        copy(aCache, aOld, buf, addr, 4096, HIMEM_2_RAM);
+    }
+}
+
+
+/// Block device use by a filesystem: 512 B blocks, mostly in a few
+/// regions (metadata, current file) with some random access
+static void filesystem(himem_cache_t* aCache, bool aOld)
+{
+    for (int i = 0; i < 4096; ++i)
+    {
+        size_t region = rand() % 8 ? (size_t)(rand() % 3) * 16 * BLOCK : rnd(SIZE);
+        size_t addr   = (region + rnd(BLOCK)) / 512 * 512 % SIZE;
+
+        copy(aCache, aOld, buf, addr, 512, rand() % 4 ? HIMEM_2_RAM : RAM_2_HIMEM);
+    }
+}
+
+
+/// Small records of an array spread across two blocks
+static void records(himem_cache_t* aCache, bool aOld)
+{
+    for (int i = 0; i < 4096; ++i)
+    {
+        copy(aCache, aOld, buf, BLOCK - 1024 + (i % 64) * 32, 32, HIMEM_2_RAM);
+    }
+}
+
+
+static void benchmark(void)
+{
+    static const struct
+    {
+        const char* name;
+        pattern_fn  fn;
+    }
+    patterns[] =
+    {
+        { "stream 4K",  stream     },
+        { "filesystem", filesystem },
+        { "records",    records    },
+    };
+
+    printf("benchmark (host, map calls and time per pattern):\n");
+
+    for (size_t i = 0; i < sizeof(patterns) / sizeof(*patterns); ++i)
+    {
+        unsigned long maps[2];
+        double        secs[2];
+
+        for (int old = 1; old >= 0; --old)
+        {
+            fake_himem_t  fake;
+            himem_cache_t cache;
+
+            fake_himem_open(&fake, SIZE, BLOCK);
+            himem_cache_init(&cache, BLOCK, old ? 1 : HIMEM_CACHE_WINDOWS,
+                             fake_himem_map, fake_himem_unmap, &fake);
+            srand(2);
+
+            clock_t start = clock();
+            patterns[i].fn(&cache, old);
+            himem_cache_flush(&cache);
+            secs[old] = (double)(clock() - start) / CLOCKS_PER_SEC;
+            maps[old] = fake.maps;
+
+            fake_himem_close(&fake);
+        }
+
+        printf("  %-10s %6lu maps %7.1f ms without cache, %6lu maps %7.1f ms with\n",
+               patterns[i].name, maps[1], secs[1] * 1e3, maps[0], secs[0] * 1e3);
+    }
+}
+
+
+int main(void)
+{
+    srand(1);
+    test_random();
+    test_lru();
+    benchmark();
+
+    return host_test_done();
+}
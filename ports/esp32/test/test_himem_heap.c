@@ -0,0 +1,291 @@
+/*
+ * Host test and benchmark for himem_heap.c.
+ *
+ * The heap is checked against its invariants while buffers are allocated
+ * and freed at random, with the content of each buffer written and
+ * verified through himem_cache on the fake himem, like himem.Buffer does.
+ * The benchmark replays the life of Python buffers (allocate, map a
+ * window, modify it, unmap, free) and prints their throughput.
+ */
+#include "himem_cache.h"
+#include "himem_heap.h"
+#include "fake_himem.h"
+#include "host_test.h"
+
+#include <time.h>
+
+
+#define BLOCK  (32 * 1024)
+#define SIZE   (128 * BLOCK)
+#define ALIGN  64
+
+
+static size_t rnd(size_t aMax)
+{
+    return ((size_t)rand() << 16 ^ rand()) % aMax;
+}
+
+
+/// Chunks cover the heap without gaps and no two free chunks are adjacent
+static bool consistent(const himem_heap_t* aHeap)
+{
+    size_t   offset = 0;
+    size_t   used   = 0;
+    unsigned cnt    = 0;
+    uint16_t prev   = HIMEM_HEAP_NONE;
+    bool     free   = false;
+
+    for (uint16_t i = aHeap->head; HIMEM_HEAP_NONE != i; i = aHeap->chunks[i].next)
+    {
+        const himem_chunk_t* chunk = &aHeap->chunks[i];
+
+        if (chunk->offset != offset || chunk->prev != prev || chunk->offset % ALIGN ||
+            (free && !chunk->used))
+        {
+            return false;
+        }
+
+        if (chunk->used)
+        {
+            used += chunk->size;
+            ++cnt;
+        }
+
+        offset += chunk->size;
+        free    = !chunk->used;
+        prev    = i;
+    }
+
+    return offset == aHeap->size && used == aHeap->used_bytes && cnt == aHeap->used_cnt;
+}
+
+
+static void test_best_fit(void)
+{
+    himem_heap_t heap;
+
+    printf("best fit:\n");
+    himem_heap_init(&heap, SIZE, ALIGN);
+
+    int a = himem_heap_alloc(&heap, 100000);
+    int b = himem_heap_alloc(&heap, 50000);
+    int c = himem_heap_alloc(&heap, 200000);
+    int d = himem_heap_alloc(&heap, 60000);
+    int e = himem_heap_alloc(&heap, 1000);
+
+    CHECK(a >= 0 && b >= 0 && c >= 0 && d >= 0 && e >= 0);
+    CHECK(himem_heap_chunk(&heap, a)->offset == 0);
+    CHECK(himem_heap_chunk(&heap, b)->offset == (100000 + ALIGN - 1) / ALIGN * ALIGN);
+
+    size_t b_offset = himem_heap_chunk(&heap, b)->offset;
+    size_t d_offset = himem_heap_chunk(&heap, d)->offset;
+
+    // Holes of 200000, 60000 and 50000 bytes, and the rest of the heap
+    CHECK(himem_heap_free(&heap, c));
+    CHECK(himem_heap_free(&heap, d));
+    CHECK(!himem_heap_free(&heap, d));
+    CHECK(himem_heap_free(&heap, b));
+    CHECK(consistent(&heap));
+
+    // b, c and d were merged into one hole
+    int f = himem_heap_alloc(&heap, 40000);
+    CHECK(himem_heap_chunk(&heap, f)->offset == b_offset);
+
+    // Holes of 50000 and 60000 bytes, 55000 fits only into the second one
+    himem_heap_free(&heap, f);
+    b = himem_heap_alloc(&heap, 50000);
+    c = himem_heap_alloc(&heap, 200000);
+    d = himem_heap_alloc(&heap, 60000);
+    himem_heap_free(&heap, b);
+    himem_heap_free(&heap, d);
+    CHECK(himem_heap_chunk(&heap, himem_heap_alloc(&heap, 55000))->offset == d_offset);
+    CHECK(himem_heap_chunk(&heap, himem_heap_alloc(&heap, 45000))->offset == b_offset);
+    CHECK(consistent(&heap));
+
+    CHECK(himem_heap_alloc(&heap, SIZE) < 0);
+    CHECK(himem_heap_alloc(&heap, (size_t)-1) < 0);
+    CHECK(NULL == himem_heap_chunk(&heap, -1));
+    CHECK(NULL == himem_heap_chunk(&heap, HIMEM_HEAP_CHUNKS));
+}
+
+
+static void test_out_of_chunks(void)
+{
+    himem_heap_t heap;
+    int          handles[HIMEM_HEAP_CHUNKS];
+
+    printf("out of chunks:\n");
+    himem_heap_init(&heap, SIZE, ALIGN);
+
+    for (unsigned i = 0; i < HIMEM_HEAP_CHUNKS; ++i)
+    {
+        handles[i] = himem_heap_alloc(&heap, 100);
+        CHECK(handles[i] >= 0);
+    }
+
+    // Last chunk got the rest of the heap, as there was no entry to split it
+    size_t free, largest;
+    himem_heap_stat(&heap, &free, &largest);
+    CHECK(0 == free && 0 == largest);
+    CHECK(himem_heap_alloc(&heap, 1) < 0);
+
+    for (unsigned i = 0; i < HIMEM_HEAP_CHUNKS; i += 2)
+    {
+        himem_heap_free(&heap, handles[i]);
+    }
+
+    for (unsigned i = 1; i < HIMEM_HEAP_CHUNKS; i += 2)
+    {
+        himem_heap_free(&heap, handles[i]);
+    }
+
+    himem_heap_stat(&heap, &free, &largest);
+    CHECK(SIZE == free && SIZE == largest);
+    CHECK(consistent(&heap));
+}
+
+
+static void test_random(void)
+{
+    fake_himem_t  fake;
+    himem_cache_t cache;
+    himem_heap_t  heap;
+    int           handles[64];
+    size_t        sizes[64];
+    static uint8_t buf[256 * 1024];
+
+    printf("random:\n");
+    CHECK(fake_himem_open(&fake, SIZE, BLOCK));
+    himem_cache_init(&cache, BLOCK, HIMEM_CACHE_WINDOWS, fake_himem_map, fake_himem_unmap, &fake);
+    himem_heap_init(&heap, SIZE, ALIGN);
+    memset(handles, 0xFF, sizeof(handles));
+
+    for (int n = 0; n < 20000; ++n)
+    {
+        unsigned i = rand() % 64;
+
+        if (handles[i] >= 0)
+        {
+            const himem_chunk_t* chunk = himem_heap_chunk(&heap, handles[i]);
+
+            himem_cache_copy(&cache, buf, chunk->offset, sizes[i], HIMEM_2_RAM, 0);
+
+            for (size_t j = 0; j < sizes[i]; ++j)
+            {
+                if (buf[j] != (uint8_t)(i + j))
+                {
+                    CHECK(!"content of buffer");
+                    break;
+                }
+            }
+
+            CHECK(himem_heap_free(&heap, handles[i]));
+            handles[i] = -1;
+        }
+        else
+        {
+            sizes[i]   = rnd(n % 16 ? 8192 : sizeof(buf));
+            handles[i] = himem_heap_alloc(&heap, sizes[i]);
+
+            if (handles[i] >= 0)
+            {
+                for (size_t j = 0; j < sizes[i]; ++j)
+                {
+                    buf[j] = i + j;
+                }
+
+                himem_cache_copy(&cache, buf, himem_heap_chunk(&heap, handles[i])->offset,
+                                 sizes[i], RAM_2_HIMEM, 0);
+            }
+        }
+
+        if (n % 64 == 0 && !consistent(&heap))
+        {
+            CHECK(consistent(&heap));
+            break;
+        }
+    }
+
+    for (unsigned i = 0; i < 64; ++i)
+    {
+        himem_heap_free(&heap, handles[i]);
+    }
+
+    CHECK(consistent(&heap) && 0 == heap.used_cnt);
+    CHECK(heap.chunks[heap.head].size == SIZE);
+
+    himem_cache_flush(&cache);
+    fake_himem_close(&fake);
+}
+
+
+static void benchmark(void)
+{
+    static const size_t sizes[] = { 4096, 64 * 1024, 512 * 1024 };
+    static uint8_t      window[512 * 1024];
+
+    fake_himem_t  fake;
+    himem_cache_t cache;
+    himem_heap_t  heap;
+    int           live[32];
+
+    printf("benchmark (host, buffers filling half of heap):\n");
+    fake_himem_open(&fake, SIZE, BLOCK);
+    himem_cache_init(&cache, BLOCK, HIMEM_CACHE_WINDOWS, fake_himem_map, fake_himem_unmap, &fake);
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); ++s)
+    {
+        const int      ops = sizes[s] > 65536 ? 2000 : 50000;
+        const unsigned cnt = SIZE / 2 / sizes[s] < 32 ? SIZE / 2 / sizes[s] : 32;
+        double         secs[2];
+
+        // Allocate and free only, then with a map and unmap of whole buffer
+        for (int mapped = 0; mapped < 2; ++mapped)
+        {
+            himem_heap_init(&heap, SIZE, ALIGN);
+            memset(live, 0xFF, sizeof(live));
+            srand(3);
+
+            clock_t start = clock();
+
+            for (int n = 0; n < ops; ++n)
+            {
+                unsigned i    = rand() % cnt;
+                size_t   size = sizes[s] / 2 + rnd(sizes[s] / 2);
+
+                himem_heap_free(&heap, live[i]);
+                live[i] = himem_heap_alloc(&heap, size);
+
+                if (mapped && live[i] >= 0)
+                {
+                    size_t addr = himem_heap_chunk(&heap, live[i])->offset;
+
+                    himem_cache_copy(&cache, window, addr, size, HIMEM_2_RAM, 0);
+                    window[n % size]++;
+                    himem_cache_copy(&cache, window, addr, size, RAM_2_HIMEM, 0);
+                }
+            }
+
+            secs[mapped] = (double)(clock() - start) / CLOCKS_PER_SEC;
+        }
+
+        printf("  %6zu B x %2u: %9.0f alloc+free/s, %9.0f alloc+map+unmap+free/s (%.0f MB/s)\n",
+               sizes[s], cnt, ops / secs[0], ops / secs[1],
+               ops * 0.75 * sizes[s] * 2 / secs[1] / 1e6);
+    }
+
+    himem_cache_flush(&cache);
+    fake_himem_close(&fake);
+}
+
+
+int main(void)
+{
+    srand(1);
+    test_best_fit();
+    test_out_of_chunks();
+    test_random();
+    benchmark();
+
+    return host_test_done();
+}
@@ -35,6 +35,7 @@
 #include <ctype.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <dirent.h>
 #include <errno.h>
 #include <signal.h>
 
@@ -315,6 +316,7 @@ STATIC void print_help(char **argv) {
         "  compile-only                 -- parse and compile only\n"
         #if MICROPY_EMIT_NATIVE
         "  emit={bytecode,native,viper} -- set the default code emitter\n"
+        "  emit=auto                    -- native code for functions that loop, else bytecode\n"
         #else
         "  emit=bytecode                -- set the default code emitter\n"
         #endif
@@ -362,6 +364,8 @@ STATIC void pre_process_options(int argc, char **argv) {
                     emit_opt = MP_EMIT_OPT_NATIVE_PYTHON;
                 } else if (strcmp(argv[a + 1], "emit=viper") == 0) {
                     emit_opt = MP_EMIT_OPT_VIPER;
+                } else if (strcmp(argv[a + 1], "emit=auto") == 0) {
+                    emit_opt = MP_EMIT_OPT_NATIVE_AUTO;
                 #endif
                 #if MICROPY_ENABLE_GC
                 } else if (strncmp(argv[a + 1], "heapsize=", sizeof("heapsize=") - 1) == 0) {
@@ -738,6 +742,70 @@ uint mp_import_stat(const char *path) {
     return MP_IMPORT_STAT_NO_EXIST;
 }
 
+#if MICROPY_MODULE_IMPORT_CACHE
+mp_obj_t mp_import_dir_stamp(const char *path, bool *casefold) {
+    if (path[0] == '\0') {
+        path = ".";
+    }
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return MP_OBJ_NULL;
+    }
+    #ifdef _PC_CASE_SENSITIVE
+    *casefold = pathconf(path, _PC_CASE_SENSITIVE) == 0;
+    #endif
+    // modification time with the full resolution of the filesystem
+    #if defined(__APPLE__)
+    struct timespec ts = st.st_mtimespec;
+    #else
+    struct timespec ts = st.st_mtim;
+    #endif
+    return mp_obj_new_int_from_ll((long long)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+bool mp_import_listdir(const char *path, mp_import_listdir_cb_t cb, void *arg) {
+    DIR *dir = opendir(path[0] == '\0' ? "." : path);
+    if (dir == NULL) {
+        // a missing directory has no entries, other errors fall back to stat
+        return errno == ENOENT || errno == ENOTDIR;
+    }
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        struct dirent *de;
+        while ((de = readdir(dir)) != NULL) {
+            mp_import_stat_t stat = MP_IMPORT_STAT_NO_EXIST;
+            #ifdef _DIRENT_HAVE_D_TYPE
+            if (de->d_type == DT_DIR) {
+                stat = MP_IMPORT_STAT_DIR;
+            } else if (de->d_type == DT_REG) {
+                stat = MP_IMPORT_STAT_FILE;
+            } else
+            #endif
+            {
+                // type unknown or a symlink, so stat the target
+                struct stat st;
+                if (fstatat(dirfd(dir), de->d_name, &st, 0) == 0) {
+                    if (S_ISDIR(st.st_mode)) {
+                        stat = MP_IMPORT_STAT_DIR;
+                    } else if (S_ISREG(st.st_mode)) {
+                        stat = MP_IMPORT_STAT_FILE;
+                    }
+                }
+            }
+            if (stat != MP_IMPORT_STAT_NO_EXIST) {
+                cb(arg, de->d_name, strlen(de->d_name), stat);
+            }
+        }
+        nlr_pop();
+    } else {
+        closedir(dir);
+        nlr_jump(nlr.ret_val);
+    }
+    closedir(dir);
+    return true;
+}
+#endif
+
 #if MICROPY_PY_IO
 // Factory function for I/O stream classes, only needed if generic VFS subsystem isn't used.
 // Note: buffering and encoding are currently ignored.
@@ -751,6 +819,12 @@ mp_obj_t mp_builtin_open(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kwar
     };
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     mp_arg_parse_all(n_args, pos_args, kwargs, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    #if MICROPY_MODULE_IMPORT_CACHE
+    // opening a file for writing may create a module
+    if (strpbrk(mp_obj_str_get_str(args[ARG_mode].u_obj), "wax+") != NULL) {
+        mp_import_cache_invalidate();
+    }
+    #endif
     return mp_vfs_posix_file_open(&mp_type_textio, args[ARG_file].u_obj, args[ARG_mode].u_obj);
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(mp_builtin_open_obj, 1, mp_builtin_open);
@@ -114,6 +114,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_os_statvfs_obj, mod_os_statvfs);
 
 STATIC mp_obj_t mod_os_remove(mp_obj_t path_in) {
     const char *path = mp_obj_str_get_str(path_in);
+    mp_import_cache_invalidate();
 
     // Note that POSIX requires remove() to be able to delete a directory
     // too (act as rmdir()). This is POSIX extenstion to ANSI C semantics
@@ -133,6 +134,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_os_remove_obj, mod_os_remove);
 STATIC mp_obj_t mod_os_rename(mp_obj_t old_path_in, mp_obj_t new_path_in) {
     const char *old_path = mp_obj_str_get_str(old_path_in);
     const char *new_path = mp_obj_str_get_str(new_path_in);
+    mp_import_cache_invalidate();
 
     MP_THREAD_GIL_EXIT();
     int r = rename(old_path, new_path);
@@ -146,6 +148,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_os_rename_obj, mod_os_rename);
 
 STATIC mp_obj_t mod_os_rmdir(mp_obj_t path_in) {
     const char *path = mp_obj_str_get_str(path_in);
+    mp_import_cache_invalidate();
 
     MP_THREAD_GIL_EXIT();
     int r = rmdir(path);
@@ -217,6 +220,7 @@ MP_DEFINE_CONST_FUN_OBJ_1(mod_os_unsetenv_obj, mod_os_unsetenv);
 STATIC mp_obj_t mod_os_mkdir(mp_obj_t path_in) {
     // TODO: Accept mode param
     const char *path = mp_obj_str_get_str(path_in);
+    mp_import_cache_invalidate();
     MP_THREAD_GIL_EXIT();
     #ifdef _WIN32
     int r = mkdir(path);
@@ -36,6 +36,12 @@
 
 #define MICROPY_ALLOC_PATH_MAX      (PATH_MAX)
 #define MICROPY_PERSISTENT_CODE_LOAD (1)
+#ifndef MICROPY_PERSISTENT_CODE_XIP
+#define MICROPY_PERSISTENT_CODE_XIP (1)
+#endif
+#ifndef MICROPY_MODULE_IMPORT_CACHE
+#define MICROPY_MODULE_IMPORT_CACHE (1)
+#endif
 #if !defined(MICROPY_EMIT_X64) && defined(__x86_64__)
     #define MICROPY_EMIT_X64        (1)
 #endif
@@ -85,6 +91,12 @@
 #ifndef MICROPY_OPT_MAP_LOOKUP_CACHE
 #define MICROPY_OPT_MAP_LOOKUP_CACHE (1)
 #endif
+#ifndef MICROPY_OPT_INSTANCE_SHAPES
+#define MICROPY_OPT_INSTANCE_SHAPES (1)
+#endif
+#ifndef MICROPY_OPT_STR_FAST_SCAN
+#define MICROPY_OPT_STR_FAST_SCAN   (1)
+#endif
 #define MICROPY_MODULE_WEAK_LINKS   (1)
 #define MICROPY_CAN_OVERRIDE_BUILTINS (1)
 #define MICROPY_VFS_POSIX_FILE      (1)
@@ -146,10 +158,13 @@
 #define MICROPY_PY_UTIME_MP_HAL     (1)
 #define MICROPY_PY_UERRNO           (1)
 #define MICROPY_PY_UCTYPES          (1)
+#define MICROPY_PY_UCTYPES_COMPILE  (1)
 #define MICROPY_PY_UZLIB            (1)
 #define MICROPY_PY_UJSON            (1)
 #define MICROPY_PY_URE              (1)
 #define MICROPY_PY_UHEAPQ           (1)
+#define MICROPY_PY_ARRAYOPS         (1)
+#define MICROPY_PY_STRUCT_OBJECT    (1)
 #define MICROPY_PY_UTIMEQ           (1)
 #define MICROPY_PY_UHASHLIB         (1)
 #if MICROPY_PY_USSL
@@ -194,7 +209,8 @@ extern const struct _mp_print_t mp_stderr_print;
 #define MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF   (1)
 #define MICROPY_EMERGENCY_EXCEPTION_BUF_SIZE  (256)
 #define MICROPY_KBD_EXCEPTION       (1)
-#define MICROPY_ASYNC_KBD_INTR      (1)
+// Raising from the signal handler is not safe when threads are serialised by a GIL.
+#define MICROPY_ASYNC_KBD_INTR      (!MICROPY_PY_THREAD_GIL)
 
 #define mp_type_fileio mp_type_vfs_posix_fileio
 #define mp_type_textio mp_type_vfs_posix_textio
@@ -365,6 +381,9 @@ struct _mp_bluetooth_nimble_malloc_t;
 #if MICROPY_PY_THREAD
 #define MICROPY_BEGIN_ATOMIC_SECTION() (mp_thread_unix_begin_atomic_section(), 0xffffffff)
 #define MICROPY_END_ATOMIC_SECTION(x) (void)x; mp_thread_unix_end_atomic_section()
+// Only used when built with the GIL (make MICROPY_PY_THREAD_GIL=1).
+#define MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL (1000)
+#define MICROPY_THREAD_YIELD() sched_yield()
 #endif
 
 #define MICROPY_EVENT_POLL_HOOK \
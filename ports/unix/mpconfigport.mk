@@ -13,6 +13,9 @@ MICROPY_PY_BTREE = 1
 
 # _thread module using pthreads
 MICROPY_PY_THREAD = 1
+# Serialise the VM with a global interpreter lock (the default is fine-grained
+# locking of the GC and qstr pool instead)
+MICROPY_PY_THREAD_GIL = 0
 
 # Subset of CPython termios module
 MICROPY_PY_TERMIOS = 1
@@ -64,6 +64,45 @@ STATIC void sighandler(int signum) {
 }
 #endif
 
+#if MICROPY_PY_MICROPYTHON_PROFILE && !defined(_WIN32)
+
+#include "py/profile.h"
+
+STATIC void prof_sighandler(int signum) {
+    (void)signum;
+    mp_prof_sample();
+}
+
+STATIC void prof_set_timer(mp_uint_t period_us) {
+    struct itimerval it;
+    it.it_interval.tv_sec = period_us / 1000000;
+    it.it_interval.tv_usec = period_us % 1000000;
+    it.it_value = it.it_interval;
+    setitimer(ITIMER_PROF, &it, NULL);
+}
+
+// The sampling profiler uses SIGPROF, which is raised at the given interval
+// of CPU time consumed by the process.
+void mp_prof_sample_timer_start(mp_uint_t period_us) {
+    struct sigaction sa;
+    sa.sa_flags = SA_RESTART;
+    sa.sa_handler = prof_sighandler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, NULL);
+    prof_set_timer(period_us);
+}
+
+void mp_prof_sample_timer_stop(void) {
+    prof_set_timer(0);
+    struct sigaction sa;
+    sa.sa_flags = 0;
+    sa.sa_handler = SIG_IGN;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, NULL);
+}
+
+#endif
+
 void mp_hal_set_interrupt_char(char c) {
     // configure terminal settings to (not) let ctrl-C through
     if (c == CHAR_CTRL_C) {
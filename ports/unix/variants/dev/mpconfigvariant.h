@@ -33,6 +33,8 @@
 
 #define MICROPY_PY_BUILTINS_HELP                (1)
 #define MICROPY_PY_BUILTINS_HELP_MODULES        (1)
+#define MICROPY_PY_MICROPYTHON_ALLOC_STATS      (1)
+#define MICROPY_PY_MICROPYTHON_PROFILE          (1)
 #define MICROPY_PY_SYS_SETTRACE                 (1)
 #define MICROPY_PY_UOS_VFS                      (1)
 #define MICROPY_PY_URANDOM_EXTRA_FUNCS          (1)
@@ -43,5 +45,7 @@
 
 // Use vfs's functions for import stat and builtin open.
 #define mp_import_stat mp_vfs_import_stat
+#define mp_import_listdir mp_vfs_import_listdir
+#define mp_import_dir_stamp mp_vfs_import_dir_stamp
 #define mp_builtin_open mp_vfs_open
 #define mp_builtin_open_obj mp_vfs_open_obj
@@ -57,6 +57,7 @@
 #define MICROPY_OPT_COMPUTED_GOTO   (0)
 #define MICROPY_OPT_LOAD_ATTR_FAST_PATH (0)
 #define MICROPY_OPT_MAP_LOOKUP_CACHE (0)
+#define MICROPY_OPT_STR_FAST_SCAN (0)
 #define MICROPY_CAN_OVERRIDE_BUILTINS (0)
 #define MICROPY_BUILTIN_METHOD_CHECK_SELF_ARG (0)
 #define MICROPY_CPYTHON_COMPAT      (0)
@@ -31,10 +31,12 @@
 
 #include "py/compile.h"
 #include "py/objmodule.h"
+#include "py/objstr.h"
 #include "py/persistentcode.h"
 #include "py/runtime.h"
 #include "py/builtin.h"
 #include "py/frozenmod.h"
+#include "py/smallint.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
 #define DEBUG_PRINT (1)
@@ -54,6 +56,156 @@ bool mp_obj_is_package(mp_obj_t module) {
     return dest[0] != MP_OBJ_NULL;
 }
 
+#if MICROPY_MODULE_IMPORT_CACHE
+
+// The import cache maps a directory path to a snapshot of its listing, so that
+// resolving modules against a sys.path entry lists the directory once instead of
+// stat'ing every candidate file name.  A snapshot is a list holding a dict that
+// maps entry name to mp_import_stat_t (or None if the directory could not be
+// listed, in which case mp_import_stat is used), the stamp of the directory when
+// it was listed, the import generation it was last checked in and whether names
+// are matched case-insensitively.  Like CPython's FileFinder, the first use of a
+// snapshot in each import compares the stamp with the directory's current one and
+// lists the directory again if it changed, so files added by other processes are
+// found.  The cache is exposed as sys.path_importer_cache and is also invalidated
+// whenever the filesystem is modified through MicroPython.
+
+enum {
+    IMPORT_SNAP_LISTING,
+    IMPORT_SNAP_STAMP,
+    IMPORT_SNAP_GEN,
+    IMPORT_SNAP_CASEFOLD,
+    IMPORT_SNAP_SIZE,
+};
+
+void mp_import_cache_invalidate(void) {
+    mp_map_clear(&MP_STATE_VM(import_cache).map);
+}
+
+STATIC size_t import_cache_fold(char *dest, const char *src, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        dest[i] = unichar_tolower(src[i]);
+    }
+    return len;
+}
+
+STATIC void import_cache_add_entry(void *arg, const char *name, size_t len, mp_import_stat_t stat) {
+    mp_obj_t *snap = arg;
+    vstr_t vstr;
+    vstr_init_len(&vstr, len);
+    if (mp_obj_is_true(snap[IMPORT_SNAP_CASEFOLD])) {
+        import_cache_fold(vstr.buf, name, len);
+    } else {
+        memcpy(vstr.buf, name, len);
+    }
+    name = vstr.buf;
+    if (stat == MP_IMPORT_STAT_FILE) {
+        // only source and compiled modules can be found as files
+        if (!((len > 3 && memcmp(name + len - 3, ".py", 3) == 0)
+              || (len > 4 && memcmp(name + len - 4, ".mpy", 4) == 0))) {
+            vstr_clear(&vstr);
+            return;
+        }
+    } else if (name[0] == '.' && (len == 1 || (len == 2 && name[1] == '.'))) {
+        vstr_clear(&vstr);
+        return;
+    }
+    mp_obj_dict_store(snap[IMPORT_SNAP_LISTING], mp_obj_new_str_from_vstr(&mp_type_str, &vstr), MP_OBJ_NEW_SMALL_INT(stat));
+}
+
+STATIC mp_map_elem_t *import_cache_lookup(mp_map_t *map, const char *str, size_t len) {
+    // use a temporary str object as the key so lookups don't allocate
+    mp_obj_str_t key = {{&mp_type_str}, qstr_compute_hash((const byte *)str, len), len, (const byte *)str};
+    return mp_map_lookup(map, MP_OBJ_FROM_PTR(&key), MP_MAP_LOOKUP);
+}
+
+STATIC mp_obj_t *import_cache_snapshot(const char *path, size_t dir_len) {
+    mp_map_elem_t *elem = import_cache_lookup(&MP_STATE_VM(import_cache).map, path, dir_len);
+    mp_obj_t gen = MP_OBJ_NEW_SMALL_INT(MP_STATE_VM(import_cache_gen));
+    mp_obj_t stamp = MP_OBJ_NULL;
+    bool casefold = false;
+    bool stamped = false;
+    if (elem != NULL && mp_obj_is_type(elem->value, &mp_type_list)) {
+        size_t len;
+        mp_obj_t *snap;
+        mp_obj_list_get(elem->value, &len, &snap);
+        if (len == IMPORT_SNAP_SIZE) {
+            if (snap[IMPORT_SNAP_GEN] == gen) {
+                return snap;
+            }
+            // first use in this import, recheck the directory (one stat)
+            stamp = mp_import_dir_stamp(mp_obj_str_get_str(elem->key), &casefold);
+            stamped = true;
+            if (stamp != MP_OBJ_NULL && snap[IMPORT_SNAP_STAMP] != mp_const_none
+                && mp_obj_equal(stamp, snap[IMPORT_SNAP_STAMP])) {
+                snap[IMPORT_SNAP_GEN] = gen;
+                return snap;
+            }
+        }
+    }
+
+    // take a snapshot of the directory and remember it; the stamp is taken first
+    // so that changes made while listing are seen next time
+    mp_obj_t dir = mp_obj_new_str(path, dir_len);
+    const char *dir_str = mp_obj_str_get_str(dir);
+    if (!stamped) {
+        stamp = mp_import_dir_stamp(dir_str, &casefold);
+    }
+    mp_obj_t items[IMPORT_SNAP_SIZE] = {
+        [IMPORT_SNAP_LISTING] = mp_obj_new_dict(0),
+        // an unknown stamp means the snapshot is only used during this import
+        [IMPORT_SNAP_STAMP] = stamp == MP_OBJ_NULL ? mp_const_none : stamp,
+        [IMPORT_SNAP_GEN] = gen,
+        [IMPORT_SNAP_CASEFOLD] = mp_obj_new_bool(casefold),
+    };
+    mp_obj_t snap_obj = mp_obj_new_list(IMPORT_SNAP_SIZE, items);
+    mp_obj_t *snap;
+    size_t len;
+    mp_obj_list_get(snap_obj, &len, &snap);
+    if (!mp_import_listdir(dir_str, import_cache_add_entry, snap)) {
+        snap[IMPORT_SNAP_LISTING] = mp_const_none;
+    }
+    mp_obj_dict_store(MP_OBJ_FROM_PTR(&MP_STATE_VM(import_cache)), dir, snap_obj);
+    return snap;
+}
+
+STATIC mp_import_stat_t mp_import_stat_cached(const char *path) {
+    const char *name = strrchr(path, PATH_SEP_CHAR);
+    size_t dir_len = 0;
+    if (name == NULL) {
+        name = path;
+    } else {
+        // a path like "/foo" lives in the root directory "/"
+        dir_len = name == path ? 1 : name - path;
+        name += 1;
+    }
+
+    mp_obj_t *snap = import_cache_snapshot(path, dir_len);
+    if (snap[IMPORT_SNAP_LISTING] == mp_const_none) {
+        return mp_import_stat(path);
+    }
+    mp_map_t *map = mp_obj_dict_get_map(snap[IMPORT_SNAP_LISTING]);
+    size_t name_len = strlen(name);
+    mp_map_elem_t *elem;
+    if (mp_obj_is_true(snap[IMPORT_SNAP_CASEFOLD])) {
+        char *folded = mp_local_alloc(name_len);
+        elem = import_cache_lookup(map, folded, import_cache_fold(folded, name, name_len));
+        mp_local_free(folded);
+    } else {
+        elem = import_cache_lookup(map, name, name_len);
+    }
+    if (elem == NULL) {
+        return MP_IMPORT_STAT_NO_EXIST;
+    }
+    return MP_OBJ_SMALL_INT_VALUE(elem->value);
+}
+
+#else
+
+#define mp_import_stat_cached mp_import_stat
+
+#endif
+
 // Stat either frozen or normal module by a given path
 // (whatever is available, if at all).
 STATIC mp_import_stat_t mp_import_stat_any(const char *path) {
@@ -63,7 +215,7 @@ STATIC mp_import_stat_t mp_import_stat_any(const char *path) {
         return st;
     }
     #endif
-    return mp_import_stat(path);
+    return mp_import_stat_cached(path);
 }
 
 STATIC mp_import_stat_t stat_file_py_or_mpy(vstr_t *path) {
@@ -253,6 +405,11 @@ mp_obj_t mp_builtin___import__(size_t n_args, const mp_obj_t *args) {
     }
     #endif
 
+    #if MICROPY_MODULE_IMPORT_CACHE
+    // cached directories are rechecked once in each import
+    MP_STATE_VM(import_cache_gen) = (MP_STATE_VM(import_cache_gen) + 1) & MP_SMALL_INT_POSITIVE_MASK;
+    #endif
+
     mp_obj_t module_name = args[0];
     mp_obj_t fromtuple = mp_const_none;
     mp_int_t level = 0;
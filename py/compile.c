@@ -230,6 +230,24 @@ STATIC void reserve_labels_for_native(compiler_t *comp, int n) {
 #define reserve_labels_for_native(comp, n)
 #endif
 
+#if MICROPY_EMIT_NATIVE
+// Record a property of the current scope, for resolving MP_EMIT_OPT_NATIVE_AUTO.
+#define compile_scope_hint(comp, hint) ((comp)->scope_cur->emit_hints |= (hint))
+#else
+#define compile_scope_hint(comp, hint)
+#endif
+
+STATIC void compile_emit_binary_op(compiler_t *comp, mp_binary_op_t op) {
+    EMIT_ARG(binary_op, op);
+    #if MICROPY_EMIT_NATIVE
+    // The native emitter inlines a fast path for small-int operands, using 2 labels
+    if (comp->scope_cur->emit_options == MP_EMIT_OPT_NATIVE_PYTHON
+        || comp->scope_cur->emit_options == MP_EMIT_OPT_NATIVE_AUTO) {
+        comp->next_label += 2;
+    }
+    #endif
+}
+
 STATIC void compile_increase_except_level(compiler_t *comp, uint label, int kind) {
     EMIT_ARG(setup_block, label, kind);
     comp->cur_except_level += 1;
@@ -910,6 +928,8 @@ STATIC void compile_funcdef(compiler_t *comp, mp_parse_node_struct_t *pns) {
 
 STATIC void c_del_stmt(compiler_t *comp, mp_parse_node_t pn) {
     if (MP_PARSE_NODE_IS_ID(pn)) {
+        // native code doesn't detect use of a deleted local
+        compile_scope_hint(comp, SCOPE_HINT_BYTECODE);
         compile_delete_id(comp, MP_PARSE_NODE_LEAF_ARG(pn));
     } else if (MP_PARSE_NODE_IS_STRUCT_KIND(pn, PN_atom_expr_normal)) {
         mp_parse_node_struct_t *pns = (mp_parse_node_struct_t *)pn;
@@ -1018,9 +1038,11 @@ STATIC void compile_yield_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
 STATIC void compile_raise_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
     if (MP_PARSE_NODE_IS_NULL(pns->nodes[0])) {
         // raise
+        compile_scope_hint(comp, SCOPE_HINT_BYTECODE);
         EMIT_ARG(raise_varargs, 0);
     } else if (MP_PARSE_NODE_IS_STRUCT_KIND(pns->nodes[0], PN_raise_stmt_arg)) {
         // raise x from y
+        compile_scope_hint(comp, SCOPE_HINT_BYTECODE);
         pns = (mp_parse_node_struct_t *)pns->nodes[0];
         compile_node(comp, pns->nodes[0]);
         compile_node(comp, pns->nodes[1]);
@@ -1336,6 +1358,7 @@ done:
     comp->break_continue_except_level = old_break_continue_except_level;
 
 STATIC void compile_while_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
+    compile_scope_hint(comp, SCOPE_HINT_LOOP);
     START_BREAK_CONTINUE_BLOCK
 
     if (!mp_parse_node_is_const_false(pns->nodes[0])) { // optimisation: don't emit anything for "while False"
@@ -1402,7 +1425,7 @@ STATIC void compile_for_stmt_optimised_range(compiler_t *comp, mp_parse_node_t p
 
     // compile: var + step
     compile_node(comp, pn_step);
-    EMIT_ARG(binary_op, MP_BINARY_OP_INPLACE_ADD);
+    compile_emit_binary_op(comp, MP_BINARY_OP_INPLACE_ADD);
 
     EMIT_ARG(label_assign, entry_label);
 
@@ -1416,9 +1439,9 @@ STATIC void compile_for_stmt_optimised_range(compiler_t *comp, mp_parse_node_t p
     }
     assert(MP_PARSE_NODE_IS_SMALL_INT(pn_step));
     if (MP_PARSE_NODE_LEAF_SMALL_INT(pn_step) >= 0) {
-        EMIT_ARG(binary_op, MP_BINARY_OP_LESS);
+        compile_emit_binary_op(comp, MP_BINARY_OP_LESS);
     } else {
-        EMIT_ARG(binary_op, MP_BINARY_OP_MORE);
+        compile_emit_binary_op(comp, MP_BINARY_OP_MORE);
     }
     EMIT_ARG(pop_jump_if, true, top_label);
 
@@ -1456,6 +1479,7 @@ STATIC void compile_for_stmt_optimised_range(compiler_t *comp, mp_parse_node_t p
 }
 
 STATIC void compile_for_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
+    compile_scope_hint(comp, SCOPE_HINT_LOOP);
     // this bit optimises: for <x> in range(...), turning it into an explicitly incremented variable
     // this is actually slower, but uses no heap memory
     // for viper it will be much, much faster
@@ -1731,6 +1755,7 @@ STATIC void compile_await_object_method(compiler_t *comp, qstr method) {
 }
 
 STATIC void compile_async_for_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
+    compile_scope_hint(comp, SCOPE_HINT_BYTECODE);
     // comp->break_label |= MP_EMIT_BREAK_FROM_FOR;
 
     qstr context = MP_PARSE_NODE_LEAF_ARG(pns->nodes[1]);
@@ -1895,6 +1920,7 @@ STATIC void compile_async_with_stmt_helper(compiler_t *comp, size_t n, mp_parse_
 }
 
 STATIC void compile_async_with_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
+    compile_scope_hint(comp, SCOPE_HINT_BYTECODE);
     // get the nodes for the pre-bit of the with (the a as b, c as d, ... bit)
     mp_parse_node_t *nodes;
     size_t n = mp_parse_node_extract_list(&pns->nodes[0], PN_with_stmt_list, &nodes);
@@ -1978,7 +2004,7 @@ STATIC void compile_expr_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
             assert(MP_PARSE_NODE_IS_TOKEN(pns1->nodes[0]));
             mp_token_kind_t tok = MP_PARSE_NODE_LEAF_ARG(pns1->nodes[0]);
             mp_binary_op_t op = MP_BINARY_OP_INPLACE_OR + (tok - MP_TOKEN_DEL_PIPE_EQUAL);
-            EMIT_ARG(binary_op, op);
+            compile_emit_binary_op(comp, op);
             c_assign(comp, pns->nodes[0], ASSIGN_AUG_STORE); // lhs store for aug assign
         } else if (kind == PN_expr_stmt_assign_list) {
             int rhs = MP_PARSE_NODE_STRUCT_NUM_NODES(pns1) - 1;
@@ -2139,19 +2165,19 @@ STATIC void compile_comparison(compiler_t *comp, mp_parse_node_struct_t *pns) {
             } else {
                 op = MP_BINARY_OP_LESS + (tok - MP_TOKEN_OP_LESS);
             }
-            EMIT_ARG(binary_op, op);
+            compile_emit_binary_op(comp, op);
         } else {
             assert(MP_PARSE_NODE_IS_STRUCT(pns->nodes[i])); // should be
             mp_parse_node_struct_t *pns2 = (mp_parse_node_struct_t *)pns->nodes[i];
             int kind = MP_PARSE_NODE_STRUCT_KIND(pns2);
             if (kind == PN_comp_op_not_in) {
-                EMIT_ARG(binary_op, MP_BINARY_OP_NOT_IN);
+                compile_emit_binary_op(comp, MP_BINARY_OP_NOT_IN);
             } else {
                 assert(kind == PN_comp_op_is); // should be
                 if (MP_PARSE_NODE_IS_NULL(pns2->nodes[0])) {
-                    EMIT_ARG(binary_op, MP_BINARY_OP_IS);
+                    compile_emit_binary_op(comp, MP_BINARY_OP_IS);
                 } else {
-                    EMIT_ARG(binary_op, MP_BINARY_OP_IS_NOT);
+                    compile_emit_binary_op(comp, MP_BINARY_OP_IS_NOT);
                 }
             }
         }
@@ -2182,7 +2208,7 @@ STATIC void compile_binary_op(compiler_t *comp, mp_parse_node_struct_t *pns) {
     compile_node(comp, pns->nodes[0]);
     for (int i = 1; i < num_nodes; ++i) {
         compile_node(comp, pns->nodes[i]);
-        EMIT_ARG(binary_op, binary_op);
+        compile_emit_binary_op(comp, binary_op);
     }
 }
 
@@ -2193,7 +2219,7 @@ STATIC void compile_term(compiler_t *comp, mp_parse_node_struct_t *pns) {
         compile_node(comp, pns->nodes[i + 1]);
         mp_token_kind_t tok = MP_PARSE_NODE_LEAF_ARG(pns->nodes[i]);
         mp_binary_op_t op = MP_BINARY_OP_LSHIFT + (tok - MP_TOKEN_OP_DBL_LESS);
-        EMIT_ARG(binary_op, op);
+        compile_emit_binary_op(comp, op);
     }
 }
 
@@ -2308,7 +2334,7 @@ STATIC void compile_atom_expr_normal(compiler_t *comp, mp_parse_node_struct_t *p
 
 STATIC void compile_power(compiler_t *comp, mp_parse_node_struct_t *pns) {
     compile_generic_all_nodes(comp, pns); // 2 nodes, arguments of power
-    EMIT_ARG(binary_op, MP_BINARY_OP_POWER);
+    compile_emit_binary_op(comp, MP_BINARY_OP_POWER);
 }
 
 STATIC void compile_trailer_paren_helper(compiler_t *comp, mp_parse_node_t pn_arglist, bool is_method_call, int n_positional_extra) {
@@ -2889,6 +2915,7 @@ STATIC void compile_scope_lambda_param(compiler_t *comp, mp_parse_node_t pn) {
 }
 
 STATIC void compile_scope_comp_iter(compiler_t *comp, mp_parse_node_struct_t *pns_comp_for, mp_parse_node_t pn_inner_expr, int for_depth) {
+    compile_scope_hint(comp, SCOPE_HINT_LOOP);
     uint l_top = comp_next_label(comp);
     uint l_end = comp_next_label(comp);
     EMIT_ARG(label_assign, l_top);
@@ -2977,7 +3004,7 @@ STATIC void compile_scope(compiler_t *comp, scope_t *scope, pass_kind_t pass) {
     comp->scope_cur = scope;
     comp->next_label = 0;
     EMIT_ARG(start_pass, pass, scope);
-    reserve_labels_for_native(comp, 6); // used by native's start_pass
+    reserve_labels_for_native(comp, 7); // used by native's start_pass
 
     if (comp->pass == MP_PASS_SCOPE) {
         // reset maximum stack sizes in scope
@@ -3403,6 +3430,26 @@ STATIC void scope_compute_things(scope_t *scope) {
     }
 }
 
+#if MICROPY_EMIT_NATIVE
+// Choose the emitter for a scope that was compiled with MP_EMIT_OPT_NATIVE_AUTO.
+// Functions that loop are where the time goes, so they get native code.  Module
+// and class bodies run once, and other functions are short, so they stay as the
+// more compact bytecode.  So do functions using features that the native emitter
+// doesn't support.
+STATIC uint compile_resolve_auto_emit(scope_t *scope) {
+    #if MICROPY_DYNAMIC_COMPILER
+    if (mp_dynamic_compiler.native_arch == MP_NATIVE_ARCH_NONE) {
+        return MP_EMIT_OPT_BYTECODE;
+    }
+    #endif
+    if (SCOPE_IS_FUNC_LIKE(scope->kind)
+        && (scope->emit_hints & (SCOPE_HINT_LOOP | SCOPE_HINT_BYTECODE)) == SCOPE_HINT_LOOP) {
+        return MP_EMIT_OPT_NATIVE_PYTHON;
+    }
+    return MP_EMIT_OPT_BYTECODE;
+}
+#endif
+
 #if !MICROPY_PERSISTENT_CODE_SAVE
 STATIC
 #endif
@@ -3457,6 +3504,16 @@ mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_f
         }
     }
 
+    #if MICROPY_EMIT_NATIVE
+    // now that all scopes have been seen, pick the emitter for automatic ones
+    for (scope_t *s = comp->scope_head; s != NULL; s = s->next) {
+        if (s->emit_options == MP_EMIT_OPT_NATIVE_AUTO) {
+            s->emit_options = compile_resolve_auto_emit(s);
+            s->emit_hints |= SCOPE_HINT_AUTO;
+        }
+    }
+    #endif
+
     // compute some things related to scope and identifiers
     for (scope_t *s = comp->scope_head; s != NULL && comp->compile_error == MP_OBJ_NULL; s = s->next) {
         scope_compute_things(s);
@@ -82,6 +82,12 @@ void mp_emit_glue_assign_bytecode(mp_raw_code_t *rc, const byte *code,
     #if MICROPY_PY_SYS_SETTRACE
     mp_bytecode_prelude_t *prelude = &rc->prelude;
     mp_prof_extract_prelude(code, prelude);
+    #if MICROPY_PERSISTENT_CODE_XIP
+    if (rc->qstr_table != NULL) {
+        prelude->qstr_block_name = rc->qstr_table[prelude->qstr_block_name];
+        prelude->qstr_source_file = rc->qstr_table[prelude->qstr_source_file];
+    }
+    #endif
     #endif
 
     #ifdef DEBUG_PRINT
@@ -202,6 +208,9 @@ mp_obj_t mp_make_function_from_raw_code(const mp_raw_code_t *rc, mp_obj_t def_ar
             // rc->kind should always be set and BYTECODE is the only remaining case
             assert(rc->kind == MP_CODE_BYTECODE);
             fun = mp_obj_new_fun_bc(def_args, def_kw_args, rc->fun_data, rc->const_table);
+            #if MICROPY_PERSISTENT_CODE_XIP
+            ((mp_obj_fun_bc_t *)MP_OBJ_TO_PTR(fun))->qstr_table = rc->qstr_table;
+            #endif
             // check for generator functions and if so change the type of the object
             if ((rc->scope_flags & MP_SCOPE_FLAG_GENERATOR) != 0) {
                 ((mp_obj_base_t *)MP_OBJ_TO_PTR(fun))->type = &mp_type_gen_wrap;
@@ -38,6 +38,7 @@ enum {
     MP_EMIT_OPT_NATIVE_PYTHON,
     MP_EMIT_OPT_VIPER,
     MP_EMIT_OPT_ASM,
+    MP_EMIT_OPT_NATIVE_AUTO, // resolved to NATIVE_PYTHON or BYTECODE per scope
 };
 
 typedef enum {
@@ -60,6 +61,9 @@ typedef struct _mp_raw_code_t {
     mp_uint_t n_pos_args : 11;
     const void *fun_data;
     const mp_uint_t *const_table;
+    #if MICROPY_PERSISTENT_CODE_XIP
+    const uint16_t *qstr_table; // if non-NULL, qstrs in fun_data are indices into this
+    #endif
     #if MICROPY_PERSISTENT_CODE_SAVE
     size_t fun_data_len;
     uint16_t n_obj;
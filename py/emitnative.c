@@ -49,6 +49,7 @@
 #include "py/emit.h"
 #include "py/nativeglue.h"
 #include "py/objstr.h"
+#include "py/smallint.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
 #define DEBUG_PRINT (1)
@@ -204,18 +205,46 @@ typedef struct _exc_stack_entry_t {
     uint16_t is_active : 1;
 } exc_stack_entry_t;
 
+// Value of local_reg[] for a local that lives in the state
+#define LOCAL_REG_NONE (0xff)
+
+// A load or store of a local, and a backwards jump, recorded during
+// MP_PASS_STACK_SIZE to decide which locals to keep in registers
+typedef struct _local_use_t {
+    size_t code_offset;
+    mp_uint_t local_num;
+} local_use_t;
+
+typedef struct _loop_range_t {
+    size_t start;
+    size_t end;
+} loop_range_t;
+
 struct _emit_t {
     mp_obj_t *error_slot;
     uint *label_slot;
     uint exit_label;
+    uint unbound_label;
     int pass;
 
     bool do_viper_types;
+    bool check_unbound_locals;
     bool prelude_offset_uses_u16_encoding;
 
     mp_uint_t local_vtype_alloc;
     vtype_kind_t *local_vtype;
 
+    mp_uint_t local_reg_alloc;
+    uint8_t *local_reg;
+
+    size_t local_use_alloc;
+    size_t local_use_len;
+    local_use_t *local_use;
+
+    size_t loop_range_alloc;
+    size_t loop_range_len;
+    loop_range_t *loop_range;
+
     mp_uint_t stack_info_alloc;
     stack_info_t *stack_info;
     vtype_kind_t saved_stack_vtype;
@@ -249,7 +278,12 @@ struct _emit_t {
     ASM_T *as;
 };
 
-STATIC const uint8_t reg_local_table[REG_LOCAL_NUM] = {REG_LOCAL_1, REG_LOCAL_2, REG_LOCAL_3};
+STATIC const uint8_t reg_local_table[REG_LOCAL_NUM] = {
+    REG_LOCAL_1, REG_LOCAL_2, REG_LOCAL_3,
+    #if REG_LOCAL_NUM > 3
+    REG_LOCAL_4, REG_LOCAL_5,
+    #endif
+};
 
 STATIC void emit_native_global_exc_entry(emit_t *emit);
 STATIC void emit_native_global_exc_exit(emit_t *emit);
@@ -263,6 +297,10 @@ emit_t *EXPORT_FUN(new)(mp_obj_t * error_slot, uint *label_slot, mp_uint_t max_n
     emit->stack_info = m_new(stack_info_t, emit->stack_info_alloc);
     emit->exc_stack_alloc = 8;
     emit->exc_stack = m_new(exc_stack_entry_t, emit->exc_stack_alloc);
+    emit->local_use_alloc = 16;
+    emit->local_use = m_new(local_use_t, emit->local_use_alloc);
+    emit->loop_range_alloc = 4;
+    emit->loop_range = m_new(loop_range_t, emit->loop_range_alloc);
     emit->as = m_new0(ASM_T, 1);
     mp_asm_base_init(&emit->as->base, max_num_labels);
     return emit;
@@ -272,6 +310,9 @@ void EXPORT_FUN(free)(emit_t * emit) {
     mp_asm_base_deinit(&emit->as->base, false);
     m_del_obj(ASM_T, emit->as);
     m_del(exc_stack_entry_t, emit->exc_stack, emit->exc_stack_alloc);
+    m_del(loop_range_t, emit->loop_range, emit->loop_range_alloc);
+    m_del(local_use_t, emit->local_use, emit->local_use_alloc);
+    m_del(uint8_t, emit->local_reg, emit->local_reg_alloc);
     m_del(vtype_kind_t, emit->local_vtype, emit->local_vtype_alloc);
     m_del(stack_info_t, emit->stack_info, emit->stack_info_alloc);
     m_del_obj(emit_t, emit);
@@ -352,11 +393,96 @@ STATIC void emit_native_mov_reg_qstr_obj(emit_t *emit, int reg_dest, qstr qst) {
         emit_native_mov_state_reg((emit), (local_num), (reg_temp)); \
     } while (false)
 
+// Record a load or store of a local, to weigh it for a register
+STATIC void emit_native_note_local_use(emit_t *emit, mp_uint_t local_num) {
+    if (emit->pass != MP_PASS_STACK_SIZE) {
+        return;
+    }
+    if (emit->local_use_len >= emit->local_use_alloc) {
+        emit->local_use = m_renew(local_use_t, emit->local_use, emit->local_use_alloc, emit->local_use_alloc * 2);
+        emit->local_use_alloc *= 2;
+    }
+    local_use_t *use = &emit->local_use[emit->local_use_len++];
+    use->code_offset = mp_asm_base_get_code_pos(&emit->as->base);
+    use->local_num = local_num;
+}
+
+// Record a jump; if it goes backwards then the code it skips over is a loop
+STATIC void emit_native_note_jump(emit_t *emit, mp_uint_t label) {
+    if (emit->pass != MP_PASS_STACK_SIZE) {
+        return;
+    }
+    size_t start = emit->as->base.label_offsets[label];
+    if (start == (size_t)-1) {
+        // forwards jump
+        return;
+    }
+    size_t end = mp_asm_base_get_code_pos(&emit->as->base);
+    for (size_t i = 0; i < emit->loop_range_len; ++i) {
+        if (emit->loop_range[i].start == start) {
+            // another jump to the top of the same loop, eg continue
+            emit->loop_range[i].end = MAX(emit->loop_range[i].end, end);
+            return;
+        }
+    }
+    if (emit->loop_range_len >= emit->loop_range_alloc) {
+        emit->loop_range = m_renew(loop_range_t, emit->loop_range, emit->loop_range_alloc, emit->loop_range_alloc * 2);
+        emit->loop_range_alloc *= 2;
+    }
+    loop_range_t *loop = &emit->loop_range[emit->loop_range_len++];
+    loop->start = start;
+    loop->end = end;
+}
+
+// Choose which locals to keep in registers, using the uses recorded during
+// MP_PASS_STACK_SIZE.  Each use counts for more the deeper it is nested in
+// loops, and the locals with the most weight get the registers.
+STATIC void emit_native_alloc_local_regs(emit_t *emit) {
+    scope_t *scope = emit->scope;
+    memset(emit->local_reg, LOCAL_REG_NONE, scope->num_locals);
+    if (!CAN_USE_REGS_FOR_LOCALS(emit) || scope->num_locals == 0) {
+        return;
+    }
+
+    mp_uint_t *weight = m_new0(mp_uint_t, scope->num_locals);
+    for (size_t i = 0; i < emit->local_use_len; ++i) {
+        local_use_t *use = &emit->local_use[i];
+        size_t depth = 0;
+        for (size_t j = 0; j < emit->loop_range_len; ++j) {
+            if (emit->loop_range[j].start <= use->code_offset && use->code_offset <= emit->loop_range[j].end) {
+                ++depth;
+            }
+        }
+        weight[use->local_num] += (mp_uint_t)1 << (3 * MIN(depth, 5));
+    }
+
+    for (size_t r = 0; r < REG_LOCAL_NUM; ++r) {
+        mp_uint_t best = 0;
+        mp_uint_t best_weight = 0;
+        for (mp_uint_t i = 0; i < scope->num_locals; ++i) {
+            if (weight[i] > best_weight) {
+                best = i;
+                best_weight = weight[i];
+            }
+        }
+        if (best_weight == 0) {
+            break;
+        }
+        emit->local_reg[best] = reg_local_table[r];
+        weight[best] = 0;
+    }
+
+    m_del(mp_uint_t, weight, scope->num_locals);
+}
+
 STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     DEBUG_printf("start_pass(pass=%u, scope=%p)\n", pass, scope);
 
     emit->pass = pass;
     emit->do_viper_types = scope->emit_options == MP_EMIT_OPT_VIPER;
+    // code compiled without being asked for keeps the NameError for unbound locals
+    emit->check_unbound_locals = !emit->do_viper_types && (scope->emit_hints & SCOPE_HINT_AUTO);
+    emit->unbound_label = *emit->label_slot + 6;
     emit->stack_size = 0;
     #if N_PRELUDE_AS_BYTES_OBJ
     emit->const_table_cur_obj = emit->do_viper_types ? 0 : 1; // reserve first obj for prelude bytes obj
@@ -376,6 +502,19 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         emit->local_vtype_alloc = scope->num_locals;
     }
 
+    // decide which locals are kept in registers, once the uses are known
+    if (emit->local_reg_alloc < scope->num_locals) {
+        emit->local_reg = m_renew(uint8_t, emit->local_reg, emit->local_reg_alloc, scope->num_locals);
+        emit->local_reg_alloc = scope->num_locals;
+    }
+    if (pass == MP_PASS_STACK_SIZE) {
+        emit->local_use_len = 0;
+        emit->loop_range_len = 0;
+        memset(emit->local_reg, LOCAL_REG_NONE, scope->num_locals);
+    } else if (pass == MP_PASS_CODE_SIZE) {
+        emit_native_alloc_local_regs(emit);
+    }
+
     // set default type for arguments
     mp_uint_t num_args = emit->scope->num_pos_args + emit->scope->num_kwonly_args;
     if (scope->scope_flags & MP_SCOPE_FLAG_VARARGS) {
@@ -424,16 +563,17 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         // Work out size of state (locals plus stack)
         // n_state counts all stack and locals, even those in registers
         emit->n_state = scope->num_locals + scope->stack_size;
+        // Locals in registers don't need a slot, but only those at the end of
+        // the state can be left out (see LOCAL_IDX_LOCAL_VAR).  An argument
+        // in REG_LOCAL_3 still needs a slot if it isn't the last one (see below).
         int num_locals_in_regs = 0;
-        if (CAN_USE_REGS_FOR_LOCALS(emit)) {
-            num_locals_in_regs = scope->num_locals;
-            if (num_locals_in_regs > REG_LOCAL_NUM) {
-                num_locals_in_regs = REG_LOCAL_NUM;
-            }
-            // Need a spot for REG_LOCAL_3 if 4 or more args (see below)
-            if (scope->num_pos_args >= 4) {
-                --num_locals_in_regs;
+        while (num_locals_in_regs < scope->num_locals) {
+            int reg = emit->local_reg[num_locals_in_regs];
+            if (reg == LOCAL_REG_NONE
+                || (reg == REG_LOCAL_3 && num_locals_in_regs + 1 < scope->num_pos_args)) {
+                break;
             }
+            ++num_locals_in_regs;
         }
 
         // Work out where the locals and Python stack start within the C stack
@@ -492,15 +632,18 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
                 r = REG_RET;
             }
             // REG_LOCAL_3 points to the args array so be sure not to overwrite it if it's still needed
-            if (i < REG_LOCAL_NUM && CAN_USE_REGS_FOR_LOCALS(emit) && (i != 2 || emit->scope->num_pos_args == 3)) {
-                ASM_MOV_REG_REG(emit->as, reg_local_table[i], r);
+            int reg = emit->local_reg[i];
+            if (reg != LOCAL_REG_NONE && (reg != REG_LOCAL_3 || i + 1 == emit->scope->num_pos_args)) {
+                ASM_MOV_REG_REG(emit->as, reg, r);
             } else {
                 emit_native_mov_state_reg(emit, LOCAL_IDX_LOCAL_VAR(emit, i), r);
             }
         }
-        // Get 3rd local from the stack back into REG_LOCAL_3 if this reg couldn't be written to above
-        if (emit->scope->num_pos_args >= 4 && CAN_USE_REGS_FOR_LOCALS(emit)) {
-            ASM_MOV_REG_LOCAL(emit->as, REG_LOCAL_3, LOCAL_IDX_LOCAL_VAR(emit, 2));
+        // Get the argument for REG_LOCAL_3 from the stack if this reg couldn't be written to above
+        for (int i = 0; i + 1 < emit->scope->num_pos_args; i++) {
+            if (emit->local_reg[i] == REG_LOCAL_3) {
+                ASM_MOV_REG_LOCAL(emit->as, REG_LOCAL_3, LOCAL_IDX_LOCAL_VAR(emit, i));
+            }
         }
 
         emit_native_global_exc_entry(emit);
@@ -615,9 +758,9 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         emit_native_global_exc_entry(emit);
 
         // cache some locals in registers, but only if no exception handlers
-        if (CAN_USE_REGS_FOR_LOCALS(emit)) {
-            for (int i = 0; i < REG_LOCAL_NUM && i < scope->num_locals; ++i) {
-                ASM_MOV_REG_LOCAL(emit->as, reg_local_table[i], LOCAL_IDX_LOCAL_VAR(emit, i));
+        for (int i = 0; i < scope->num_locals; ++i) {
+            if (emit->local_reg[i] != LOCAL_REG_NONE) {
+                ASM_MOV_REG_LOCAL(emit->as, emit->local_reg[i], LOCAL_IDX_LOCAL_VAR(emit, i));
             }
         }
 
@@ -1332,6 +1475,15 @@ STATIC void emit_native_global_exc_exit(emit_t *emit) {
     }
 
     ASM_EXIT(emit->as);
+
+    if (emit->check_unbound_locals) {
+        // A local was used before being assigned to: raise NameError
+        mp_asm_base_label_assign(&emit->as->base, emit->unbound_label);
+        emit_native_mov_reg_qstr(emit, REG_ARG_1, MP_QSTR_NameError);
+        emit_call(emit, MP_F_LOAD_GLOBAL);
+        ASM_MOV_REG_REG(emit->as, REG_ARG_1, REG_RET);
+        emit_call(emit, MP_F_NATIVE_RAISE);
+    }
 }
 
 STATIC void emit_native_import_name(emit_t *emit, qstr qst) {
@@ -1443,13 +1595,18 @@ STATIC void emit_native_load_fast(emit_t *emit, qstr qst, mp_uint_t local_num) {
         EMIT_NATIVE_VIPER_TYPE_ERROR(emit, MP_ERROR_TEXT("local '%q' used before type known"), qst);
     }
     emit_native_pre(emit);
-    if (local_num < REG_LOCAL_NUM && CAN_USE_REGS_FOR_LOCALS(emit)) {
-        emit_post_push_reg(emit, vtype, reg_local_table[local_num]);
-    } else {
+    emit_native_note_local_use(emit, local_num);
+    int reg = emit->local_reg[local_num];
+    if (reg == LOCAL_REG_NONE) {
+        reg = REG_TEMP0;
         need_reg_single(emit, REG_TEMP0, 0);
         emit_native_mov_reg_state(emit, REG_TEMP0, LOCAL_IDX_LOCAL_VAR(emit, local_num));
-        emit_post_push_reg(emit, vtype, REG_TEMP0);
     }
+    if (emit->check_unbound_locals && local_num >= emit->scope->num_pos_args + emit->scope->num_kwonly_args) {
+        // locals start as MP_OBJ_NULL, see mp_setup_code_state
+        ASM_JUMP_IF_REG_ZERO(emit->as, reg, emit->unbound_label, false);
+    }
+    emit_post_push_reg(emit, vtype, reg);
 }
 
 STATIC void emit_native_load_deref(emit_t *emit, qstr qst, mp_uint_t local_num) {
@@ -1664,8 +1821,9 @@ STATIC void emit_native_load_subscr(emit_t *emit) {
 
 STATIC void emit_native_store_fast(emit_t *emit, qstr qst, mp_uint_t local_num) {
     vtype_kind_t vtype;
-    if (local_num < REG_LOCAL_NUM && CAN_USE_REGS_FOR_LOCALS(emit)) {
-        emit_pre_pop_reg(emit, &vtype, reg_local_table[local_num]);
+    emit_native_note_local_use(emit, local_num);
+    if (emit->local_reg[local_num] != LOCAL_REG_NONE) {
+        emit_pre_pop_reg(emit, &vtype, emit->local_reg[local_num]);
     } else {
         emit_pre_pop_reg(emit, &vtype, REG_TEMP0);
         emit_native_mov_state_reg(emit, LOCAL_IDX_LOCAL_VAR(emit, local_num), REG_TEMP0);
@@ -2010,6 +2168,7 @@ STATIC void emit_native_jump(emit_t *emit, mp_uint_t label) {
     emit_native_pre(emit);
     // need to commit stack because we are jumping elsewhere
     need_stack_settled(emit);
+    emit_native_note_jump(emit, label);
     ASM_JUMP(emit->as, label);
     emit_post(emit);
 }
@@ -2039,6 +2198,7 @@ STATIC void emit_native_jump_helper(emit_t *emit, bool cond, mp_uint_t label, bo
     }
     // need to commit stack because we may jump elsewhere
     need_stack_settled(emit);
+    emit_native_note_jump(emit, label);
     // Emit the jump
     if (cond) {
         ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label, vtype == VTYPE_PYOBJ);
@@ -2312,6 +2472,97 @@ STATIC void emit_native_unary_op(emit_t *emit, mp_unary_op_t op) {
     }
 }
 
+#if N_X64
+STATIC bool stack_is_small_int_imm(const stack_info_t *si) {
+    return si->kind == STACK_IMM && si->vtype == VTYPE_INT && MP_SMALL_INT_FITS(si->data.u_imm);
+}
+
+// Inline code for a binary op on Python objects that is fast when both operands
+// are small ints and otherwise calls mp_binary_op.  Operands that are known to
+// be small-int constants don't need their tag checked.  Uses the 2 labels that
+// the compiler reserves after each binary op.  Returns false if op has no fast
+// path, in which case nothing is emitted.
+STATIC bool emit_native_binary_op_small_int(emit_t *emit, mp_binary_op_t op) {
+    mp_binary_op_t op_base = op;
+    if (MP_BINARY_OP_INPLACE_OR <= op && op <= MP_BINARY_OP_INPLACE_POWER) {
+        op_base += MP_BINARY_OP_OR - MP_BINARY_OP_INPLACE_OR;
+    }
+    if (!(op_base == MP_BINARY_OP_OR || op_base == MP_BINARY_OP_XOR || op_base == MP_BINARY_OP_AND
+          || op_base == MP_BINARY_OP_ADD || op_base == MP_BINARY_OP_SUBTRACT
+          || op_base <= MP_BINARY_OP_NOT_EQUAL)) {
+        return false;
+    }
+
+    bool lhs_is_int = stack_is_small_int_imm(peek_stack(emit, 1));
+    bool rhs_is_int = stack_is_small_int_imm(peek_stack(emit, 0));
+    vtype_kind_t vtype_lhs, vtype_rhs;
+    emit_pre_pop_reg_reg(emit, &vtype_rhs, REG_ARG_3, &vtype_lhs, REG_ARG_2);
+    // the slow path calls a function, so settle the stack before branching to it
+    need_reg_all(emit);
+    mp_uint_t slow_label = *emit->label_slot;
+    mp_uint_t done_label = *emit->label_slot + 1;
+
+    // REG_ARG_1 holds the small-int tag bit; check both operands have it set
+    asm_x64_mov_i64_to_r64_optimised(emit->as, 1, REG_ARG_1);
+    if (!lhs_is_int || !rhs_is_int) {
+        asm_x64_mov_r64_r64(emit->as, REG_RET, lhs_is_int ? REG_ARG_3 : REG_ARG_2);
+        if (!lhs_is_int && !rhs_is_int) {
+            asm_x64_and_r64_r64(emit->as, REG_RET, REG_ARG_3);
+        }
+        asm_x64_test_r64_with_r64(emit->as, REG_RET, REG_ARG_1);
+        asm_x64_jcc_label(emit->as, ASM_X64_CC_JZ, slow_label);
+    }
+
+    // operate directly on the tagged values, (x << 1) | 1
+    if (op_base <= MP_BINARY_OP_NOT_EQUAL) {
+        // tagging preserves order, so compare the objects then load the
+        // resulting bool from mp_fun_table using the 0/1 result as an index
+        static const byte ccs[6] = {
+            ASM_X64_CC_JL,
+            ASM_X64_CC_JG,
+            ASM_X64_CC_JE,
+            ASM_X64_CC_JLE,
+            ASM_X64_CC_JGE,
+            ASM_X64_CC_JNE,
+        };
+        asm_x64_xor_r64_r64(emit->as, REG_RET, REG_RET);
+        asm_x64_cmp_r64_with_r64(emit->as, REG_ARG_3, REG_ARG_2);
+        asm_x64_setcc_r8(emit->as, ccs[op_base - MP_BINARY_OP_LESS], REG_RET);
+        for (int i = 0; i < 3; ++i) {
+            asm_x64_add_r64_r64(emit->as, REG_RET, REG_RET);
+        }
+        asm_x64_add_r64_r64(emit->as, REG_RET, REG_FUN_TABLE);
+        asm_x64_mov_mem64_to_r64(emit->as, REG_RET, MP_F_CONST_FALSE_OBJ * 8, REG_RET);
+    } else {
+        asm_x64_mov_r64_r64(emit->as, REG_RET, REG_ARG_2);
+        if (op_base == MP_BINARY_OP_OR) {
+            asm_x64_or_r64_r64(emit->as, REG_RET, REG_ARG_3);
+        } else if (op_base == MP_BINARY_OP_XOR) {
+            asm_x64_xor_r64_r64(emit->as, REG_RET, REG_ARG_3);
+            asm_x64_or_r64_r64(emit->as, REG_RET, REG_ARG_1);
+        } else if (op_base == MP_BINARY_OP_AND) {
+            asm_x64_and_r64_r64(emit->as, REG_RET, REG_ARG_3);
+        } else if (op_base == MP_BINARY_OP_ADD) {
+            asm_x64_xor_r64_r64(emit->as, REG_RET, REG_ARG_1);
+            asm_x64_add_r64_r64(emit->as, REG_RET, REG_ARG_3);
+            asm_x64_jcc_label(emit->as, ASM_X64_CC_JO, slow_label);
+        } else {
+            asm_x64_sub_r64_r64(emit->as, REG_RET, REG_ARG_3);
+            asm_x64_jcc_label(emit->as, ASM_X64_CC_JO, slow_label);
+            asm_x64_or_r64_r64(emit->as, REG_RET, REG_ARG_1);
+        }
+    }
+    asm_x64_jmp_label(emit->as, done_label);
+
+    // slow path: operands aren't both small ints, or the result overflowed
+    mp_asm_base_label_assign(&emit->as->base, slow_label);
+    emit_call_with_imm_arg(emit, MP_F_BINARY_OP, op, REG_ARG_1);
+    mp_asm_base_label_assign(&emit->as->base, done_label);
+    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
+    return true;
+}
+#endif
+
 STATIC void emit_native_binary_op(emit_t *emit, mp_binary_op_t op) {
     DEBUG_printf("binary_op(" UINT_FMT ")\n", op);
     vtype_kind_t vtype_lhs = peek_vtype(emit, 1);
@@ -2552,6 +2803,11 @@ STATIC void emit_native_binary_op(emit_t *emit, mp_binary_op_t op) {
                 MP_ERROR_TEXT("binary op %q not implemented"), mp_binary_op_method_name[op]);
         }
     } else if (vtype_lhs == VTYPE_PYOBJ && vtype_rhs == VTYPE_PYOBJ) {
+        #if N_X64
+        if (!emit->do_viper_types && emit_native_binary_op_small_int(emit, op)) {
+            return;
+        }
+        #endif
         emit_pre_pop_reg_reg(emit, &vtype_rhs, REG_ARG_3, &vtype_lhs, REG_ARG_2);
         bool invert = false;
         if (op == MP_BINARY_OP_NOT_IN) {
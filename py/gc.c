@@ -31,6 +31,7 @@
 
 #include "py/gc.h"
 #include "py/runtime.h"
+#include "py/profile.h"
 
 #if MICROPY_ENABLE_GC
 
@@ -541,6 +542,10 @@ found:
     MP_STATE_MEM(gc_alloc_amount) += n_blocks;
     #endif
 
+    #if MICROPY_PY_MICROPYTHON_ALLOC_STATS
+    mp_prof_alloc_record(n_blocks * BYTES_PER_BLOCK);
+    #endif
+
     GC_EXIT();
 
     #if MICROPY_GC_CONSERVATIVE_CLEAR
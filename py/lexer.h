@@ -203,6 +203,21 @@ typedef enum {
 } mp_import_stat_t;
 
 mp_import_stat_t mp_import_stat(const char *path);
+
+#if MICROPY_MODULE_IMPORT_CACHE
+// Lists the directory at path (the empty string being the current directory),
+// calling cb for each entry that is a directory or a file.  A directory that
+// doesn't exist has no entries; returns false if the directory can't be listed.
+typedef void (*mp_import_listdir_cb_t)(void *arg, const char *name, size_t len, mp_import_stat_t stat);
+bool mp_import_listdir(const char *path, mp_import_listdir_cb_t cb, void *arg);
+// Returns an object that changes whenever entries are added to or removed from
+// the directory at path (usually its modification time), or MP_OBJ_NULL if it
+// can't be determined.  Sets casefold if the filesystem ignores case in names.
+mp_obj_t mp_import_dir_stamp(const char *path, bool *casefold);
+void mp_import_cache_invalidate(void);
+#else
+#define mp_import_cache_invalidate()
+#endif
 mp_lexer_t *mp_lexer_new_from_file(const char *filename);
 
 #if MICROPY_HELPER_LEXER_UNIX
@@ -31,6 +31,7 @@
 #include "py/runtime.h"
 #include "py/gc.h"
 #include "py/mphal.h"
+#include "py/profile.h"
 
 // Various builtins specific to MicroPython runtime,
 // living in micropython module
@@ -154,6 +155,47 @@ STATIC mp_obj_t mp_micropython_kbd_intr(mp_obj_t int_chr_in) {
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mp_micropython_kbd_intr_obj, mp_micropython_kbd_intr);
 #endif
 
+#if MICROPY_PY_MICROPYTHON_PROFILE
+STATIC mp_obj_t mp_micropython_profile_start(size_t n_args, const mp_obj_t *args) {
+    mp_int_t period_us = 1000;
+    if (n_args > 0) {
+        period_us = mp_obj_get_int(args[0]);
+        if (period_us <= 0) {
+            mp_raise_ValueError(NULL);
+        }
+    }
+    mp_prof_sample_start(period_us);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_profile_start_obj, 0, 1, mp_micropython_profile_start);
+
+STATIC mp_obj_t mp_micropython_profile_stop(void) {
+    mp_prof_sample_stop();
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_profile_stop_obj, mp_micropython_profile_stop);
+
+STATIC mp_obj_t mp_micropython_profile_dump(void) {
+    return mp_prof_sample_dump();
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_profile_dump_obj, mp_micropython_profile_dump);
+#endif
+
+#if MICROPY_PY_MICROPYTHON_ALLOC_STATS
+STATIC mp_obj_t mp_micropython_alloc_stats(size_t n_args, const mp_obj_t *args) {
+    mp_int_t n = 10;
+    if (n_args > 0) {
+        n = mp_obj_get_int(args[0]);
+    }
+    mp_obj_t stats = mp_prof_alloc_stats(n < 0 ? 0 : n);
+    if (n_args > 1 && mp_obj_is_true(args[1])) {
+        mp_prof_alloc_clear();
+    }
+    return stats;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_alloc_stats_obj, 0, 2, mp_micropython_alloc_stats);
+#endif
+
 #if MICROPY_ENABLE_SCHEDULER
 STATIC mp_obj_t mp_micropython_schedule(mp_obj_t function, mp_obj_t arg) {
     if (!mp_sched_schedule(function, arg)) {
@@ -201,6 +243,14 @@ STATIC const mp_rom_map_elem_t mp_module_micropython_globals_table[] = {
     #if MICROPY_ENABLE_SCHEDULER
     { MP_ROM_QSTR(MP_QSTR_schedule), MP_ROM_PTR(&mp_micropython_schedule_obj) },
     #endif
+    #if MICROPY_PY_MICROPYTHON_ALLOC_STATS
+    { MP_ROM_QSTR(MP_QSTR_alloc_stats), MP_ROM_PTR(&mp_micropython_alloc_stats_obj) },
+    #endif
+    #if MICROPY_PY_MICROPYTHON_PROFILE
+    { MP_ROM_QSTR(MP_QSTR_profile_start), MP_ROM_PTR(&mp_micropython_profile_start_obj) },
+    { MP_ROM_QSTR(MP_QSTR_profile_stop), MP_ROM_PTR(&mp_micropython_profile_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_profile_dump), MP_ROM_PTR(&mp_micropython_profile_dump_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_micropython_globals, mp_module_micropython_globals_table);
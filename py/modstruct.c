@@ -250,6 +250,290 @@ STATIC mp_obj_t struct_pack_into(size_t n_args, const mp_obj_t *args) {
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_pack_into_obj, 3, MP_OBJ_FUN_ARGS_MAX, struct_pack_into);
 
+#if MICROPY_PY_STRUCT_OBJECT
+
+/******************************************************************************/
+// Struct objects
+//
+// A Struct parses its format string once, into a list of fields each giving
+// the typecode, byte offset and repeat count of a run of values, so packing
+// and unpacking don't need to reparse the format or recompute alignment.
+
+typedef struct _struct_field_t {
+    char type;
+    size_t offset;
+    size_t count; // number of values, or number of bytes for 's'
+} struct_field_t;
+
+typedef struct _mp_obj_struct_t {
+    mp_obj_base_t base;
+    mp_obj_t format;
+    char fmt_type;
+    size_t size;
+    size_t num_items;
+    size_t num_fields;
+    struct_field_t fields[];
+} mp_obj_struct_t;
+
+STATIC const mp_obj_type_t struct_type;
+
+STATIC mp_obj_t struct_compile(mp_obj_t fmt_in) {
+    const char *fmt = mp_obj_str_get_str(fmt_in);
+    size_t num_fields = 0;
+    for (const char *f = fmt; *f; ++f) {
+        num_fields += !unichar_isdigit(*f);
+    }
+    mp_obj_struct_t *self = m_new_obj_var(mp_obj_struct_t, struct_field_t, num_fields);
+    self->base.type = &struct_type;
+    self->format = fmt_in;
+    self->fmt_type = get_fmt_type(&fmt);
+    size_t size = 0;
+    size_t num_items = 0;
+    struct_field_t *field = self->fields;
+    for (; *fmt; fmt++) {
+        mp_uint_t cnt = 1;
+        if (unichar_isdigit(*fmt)) {
+            cnt = get_fmt_num(&fmt);
+        }
+        if (*fmt == 's') {
+            num_items += 1;
+            field->offset = size;
+            size += cnt;
+        } else {
+            if (cnt == 0) {
+                continue;
+            }
+            num_items += cnt;
+            size_t align;
+            size_t sz = mp_binary_get_size(self->fmt_type, *fmt, &align);
+            // Values of one type are a multiple of their alignment in size,
+            // so only the first of a run needs aligning
+            size = (size + align - 1) & ~(align - 1);
+            field->offset = size;
+            size += sz * cnt;
+        }
+        field->type = *fmt;
+        field->count = cnt;
+        ++field;
+    }
+    self->num_fields = field - self->fields;
+    self->size = size;
+    self->num_items = num_items;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+STATIC mp_obj_t struct_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    (void)type;
+    mp_arg_check_num(n_args, n_kw, 1, 1, false);
+    return struct_compile(args[0]);
+}
+
+// Return a pointer to the struct at the given offset, checking it fits in the buffer
+STATIC byte *struct_get_ptr(mp_obj_struct_t *self, mp_buffer_info_t *bufinfo, mp_int_t offset) {
+    if (offset < 0) {
+        // negative offsets are relative to the end of the buffer
+        offset += bufinfo->len;
+    }
+    if (offset < 0 || (size_t)offset > bufinfo->len || bufinfo->len - offset < self->size) {
+        mp_raise_ValueError(MP_ERROR_TEXT("buffer too small"));
+    }
+    return (byte *)bufinfo->buf + offset;
+}
+
+// Unpack the values at p into items, which has room for num_items values
+STATIC void struct_unpack_items(mp_obj_struct_t *self, byte *p_base, mp_obj_t *items) {
+    for (size_t i = 0; i < self->num_fields; ++i) {
+        const struct_field_t *field = &self->fields[i];
+        byte *p = p_base + field->offset;
+        if (field->type == 's') {
+            *items++ = mp_obj_new_bytes(p, field->count);
+        } else {
+            for (size_t j = field->count; j; --j) {
+                *items++ = mp_binary_get_val(self->fmt_type, field->type, p_base, &p);
+            }
+        }
+    }
+}
+
+// Unpack the values at p into out, which is a list of the right length or
+// else any object supporting item assignment (such as an array)
+STATIC void struct_unpack_into_obj(mp_obj_struct_t *self, byte *p_base, mp_obj_t out) {
+    if (mp_obj_is_type(out, &mp_type_list)) {
+        size_t len;
+        mp_obj_t *items;
+        mp_obj_list_get(out, &len, &items);
+        if (len != self->num_items) {
+            mp_raise_ValueError(MP_ERROR_TEXT("wrong length"));
+        }
+        struct_unpack_items(self, p_base, items);
+        return;
+    }
+    size_t idx = 0;
+    for (size_t i = 0; i < self->num_fields; ++i) {
+        const struct_field_t *field = &self->fields[i];
+        byte *p = p_base + field->offset;
+        for (size_t j = field->type == 's' ? 1 : field->count; j; --j) {
+            mp_obj_t item;
+            if (field->type == 's') {
+                item = mp_obj_new_bytes(p, field->count);
+            } else {
+                item = mp_binary_get_val(self->fmt_type, field->type, p_base, &p);
+            }
+            mp_obj_subscr(out, MP_OBJ_NEW_SMALL_INT(idx++), item);
+        }
+    }
+}
+
+STATIC mp_obj_t struct_obj_unpack_from(size_t n_args, const mp_obj_t *args) {
+    mp_obj_struct_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_READ);
+    byte *p = struct_get_ptr(self, &bufinfo, n_args > 2 ? mp_obj_get_int(args[2]) : 0);
+    if (n_args > 3 && args[3] != mp_const_none) {
+        struct_unpack_into_obj(self, p, args[3]);
+        return args[3];
+    }
+    mp_obj_tuple_t *res = MP_OBJ_TO_PTR(mp_obj_new_tuple(self->num_items, NULL));
+    struct_unpack_items(self, p, res->items);
+    return MP_OBJ_FROM_PTR(res);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_obj_unpack_from_obj, 2, 4, struct_obj_unpack_from);
+
+STATIC mp_obj_t struct_obj_unpack(mp_obj_t self_in, mp_obj_t buf_in) {
+    mp_obj_t args[2] = { self_in, buf_in };
+    return struct_obj_unpack_from(2, args);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(struct_obj_unpack_obj, struct_obj_unpack);
+
+// This function assumes there is enough room at p_base to store all the values
+STATIC void struct_pack_items(mp_obj_struct_t *self, byte *p_base, size_t n_args, const mp_obj_t *args) {
+    memset(p_base, 0, self->size);
+    const mp_obj_t *args_end = args + n_args;
+    for (size_t i = 0; i < self->num_fields && args < args_end; ++i) {
+        const struct_field_t *field = &self->fields[i];
+        byte *p = p_base + field->offset;
+        if (field->type == 's') {
+            mp_buffer_info_t bufinfo;
+            mp_get_buffer_raise(*args++, &bufinfo, MP_BUFFER_READ);
+            memcpy(p, bufinfo.buf, MIN(bufinfo.len, field->count));
+        } else {
+            // If we run out of args then we just finish, like ustruct.pack
+            for (size_t j = field->count; j && args < args_end; --j) {
+                mp_binary_set_val(self->fmt_type, field->type, *args++, p_base, &p);
+            }
+        }
+    }
+}
+
+STATIC mp_obj_t struct_obj_pack(size_t n_args, const mp_obj_t *args) {
+    mp_obj_struct_t *self = MP_OBJ_TO_PTR(args[0]);
+    vstr_t vstr;
+    vstr_init_len(&vstr, self->size);
+    struct_pack_items(self, (byte *)vstr.buf, n_args - 1, args + 1);
+    return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_obj_pack_obj, 1, MP_OBJ_FUN_ARGS_MAX, struct_obj_pack);
+
+STATIC mp_obj_t struct_obj_pack_into(size_t n_args, const mp_obj_t *args) {
+    mp_obj_struct_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_WRITE);
+    byte *p = struct_get_ptr(self, &bufinfo, mp_obj_get_int(args[2]));
+    struct_pack_items(self, p, n_args - 3, args + 3);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_obj_pack_into_obj, 3, MP_OBJ_FUN_ARGS_MAX, struct_obj_pack_into);
+
+typedef struct _struct_iter_unpack_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    mp_obj_struct_t *st;
+    mp_obj_t buf_obj;
+    mp_obj_t out;
+    size_t offset;
+} struct_iter_unpack_t;
+
+STATIC mp_obj_t struct_iter_unpack_iternext(mp_obj_t self_in) {
+    struct_iter_unpack_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(self->buf_obj, &bufinfo, MP_BUFFER_READ);
+    if (bufinfo.len - MIN(bufinfo.len, self->offset) < self->st->size) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    byte *p = (byte *)bufinfo.buf + self->offset;
+    self->offset += self->st->size;
+    if (self->out != mp_const_none) {
+        struct_unpack_into_obj(self->st, p, self->out);
+        return self->out;
+    }
+    mp_obj_tuple_t *res = MP_OBJ_TO_PTR(mp_obj_new_tuple(self->st->num_items, NULL));
+    struct_unpack_items(self->st, p, res->items);
+    return MP_OBJ_FROM_PTR(res);
+}
+
+// iter_unpack(buf, out=None): iterate over consecutive structs in buf.  If out
+// is given then each struct is unpacked into it and it is yielded each time.
+STATIC mp_obj_t struct_obj_iter_unpack(size_t n_args, const mp_obj_t *args) {
+    mp_obj_struct_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_READ);
+    if (self->size == 0 || bufinfo.len % self->size != 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("buffer size must be a multiple of struct size"));
+    }
+    struct_iter_unpack_t *it = m_new_obj(struct_iter_unpack_t);
+    it->base.type = &mp_type_polymorph_iter;
+    it->iternext = struct_iter_unpack_iternext;
+    it->st = self;
+    it->buf_obj = args[1];
+    it->out = n_args > 2 ? args[2] : mp_const_none;
+    it->offset = 0;
+    return MP_OBJ_FROM_PTR(it);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(struct_obj_iter_unpack_obj, 2, 3, struct_obj_iter_unpack);
+
+STATIC const mp_rom_map_elem_t struct_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_pack), MP_ROM_PTR(&struct_obj_pack_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&struct_obj_pack_into_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unpack), MP_ROM_PTR(&struct_obj_unpack_obj) },
+    { MP_ROM_QSTR(MP_QSTR_unpack_from), MP_ROM_PTR(&struct_obj_unpack_from_obj) },
+    { MP_ROM_QSTR(MP_QSTR_iter_unpack), MP_ROM_PTR(&struct_obj_iter_unpack_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(struct_locals_dict, struct_locals_dict_table);
+
+STATIC void struct_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
+    if (dest[0] != MP_OBJ_NULL) {
+        // not load attribute
+        return;
+    }
+    mp_obj_struct_t *self = MP_OBJ_TO_PTR(self_in);
+    if (attr == MP_QSTR_size) {
+        dest[0] = MP_OBJ_NEW_SMALL_INT(self->size);
+    } else if (attr == MP_QSTR_format) {
+        dest[0] = self->format;
+    } else {
+        mp_map_elem_t *elem = mp_map_lookup((mp_map_t *)&struct_locals_dict.map, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP);
+        if (elem != NULL) {
+            mp_convert_member_lookup(self_in, &struct_type, elem->value, dest);
+        }
+    }
+}
+
+STATIC const mp_obj_type_t struct_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Struct,
+    .make_new = struct_make_new,
+    .attr = struct_attr,
+};
+
+STATIC mp_obj_t struct_iter_unpack(mp_obj_t fmt_in, mp_obj_t buf_in) {
+    mp_obj_t args[2] = { struct_compile(fmt_in), buf_in };
+    return struct_obj_iter_unpack(2, args);
+}
+MP_DEFINE_CONST_FUN_OBJ_2(struct_iter_unpack_obj, struct_iter_unpack);
+
+#endif // MICROPY_PY_STRUCT_OBJECT
+
 STATIC const mp_rom_map_elem_t mp_module_struct_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ustruct) },
     { MP_ROM_QSTR(MP_QSTR_calcsize), MP_ROM_PTR(&struct_calcsize_obj) },
@@ -257,6 +541,10 @@ STATIC const mp_rom_map_elem_t mp_module_struct_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_pack_into), MP_ROM_PTR(&struct_pack_into_obj) },
     { MP_ROM_QSTR(MP_QSTR_unpack), MP_ROM_PTR(&struct_unpack_from_obj) },
     { MP_ROM_QSTR(MP_QSTR_unpack_from), MP_ROM_PTR(&struct_unpack_from_obj) },
+    #if MICROPY_PY_STRUCT_OBJECT
+    { MP_ROM_QSTR(MP_QSTR_Struct), MP_ROM_PTR(&struct_type) },
+    { MP_ROM_QSTR(MP_QSTR_iter_unpack), MP_ROM_PTR(&struct_iter_unpack_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_struct_globals, mp_module_struct_globals_table);
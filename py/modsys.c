@@ -187,6 +187,9 @@ STATIC const mp_rom_map_elem_t mp_module_sys_globals_table[] = {
 
     { MP_ROM_QSTR(MP_QSTR_path), MP_ROM_PTR(&MP_STATE_VM(mp_sys_path_obj)) },
     { MP_ROM_QSTR(MP_QSTR_argv), MP_ROM_PTR(&MP_STATE_VM(mp_sys_argv_obj)) },
+    #if MICROPY_MODULE_IMPORT_CACHE
+    { MP_ROM_QSTR(MP_QSTR_path_importer_cache), MP_ROM_PTR(&MP_STATE_VM(import_cache)) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_version), MP_ROM_PTR(&mp_sys_version_obj) },
     { MP_ROM_QSTR(MP_QSTR_version_info), MP_ROM_PTR(&mp_sys_version_info_obj) },
     { MP_ROM_QSTR(MP_QSTR_implementation), MP_ROM_PTR(&mp_sys_implementation_obj) },
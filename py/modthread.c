@@ -29,6 +29,7 @@
 
 #include "py/runtime.h"
 #include "py/stackctrl.h"
+#include "py/mphal.h"
 
 #if MICROPY_PY_THREAD
 
@@ -42,6 +43,62 @@
 #define DEBUG_printf(...) (void)0
 #endif
 
+#if MICROPY_PY_THREAD_GIL && MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL
+/****************************************************************/
+// GIL hand-off
+
+// The number of threads blocked waiting on the GIL is only a hint, it is never
+// used to decide whether the GIL is held.  gil_handoff is incremented (with
+// the GIL held) each time a thread acquires the GIL, so a thread that gives
+// up the GIL can tell when another thread has taken it.
+
+void mp_thread_gil_init(void) {
+    MP_STATE_VM(gil_switch_interval) = MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL;
+    MP_STATE_VM(gil_acquired_ticks) = 0;
+    MP_STATE_VM(gil_handoff) = 0;
+    MP_STATE_VM(gil_waiters) = 0;
+}
+
+void mp_thread_gil_enter(void) {
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    ++MP_STATE_VM(gil_waiters);
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+
+    mp_thread_mutex_lock(&MP_STATE_VM(gil_mutex), 1);
+
+    atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    --MP_STATE_VM(gil_waiters);
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+
+    ++MP_STATE_VM(gil_handoff);
+    MP_STATE_VM(gil_acquired_ticks) = mp_hal_ticks_us();
+}
+
+// Called periodically by the VM with the GIL held.  If another thread is waiting
+// and this thread has held the GIL for at least the switch interval then give up
+// the GIL and don't try to take it back until a waiting thread got it (or the
+// switch interval elapses again, in case the waiter cannot be scheduled).
+void mp_thread_gil_switch(void) {
+    if (MP_STATE_VM(gil_waiters) == 0) {
+        return;
+    }
+    mp_uint_t t0 = mp_hal_ticks_us();
+    mp_uint_t interval = MP_STATE_VM(gil_switch_interval);
+    if (t0 - MP_STATE_VM(gil_acquired_ticks) < interval) {
+        return;
+    }
+    unsigned int handoff = MP_STATE_VM(gil_handoff);
+    MP_THREAD_GIL_EXIT();
+    while (MP_STATE_VM(gil_handoff) == handoff
+           && MP_STATE_VM(gil_waiters) != 0
+           && mp_hal_ticks_us() - t0 <= interval) {
+        MICROPY_THREAD_YIELD();
+    }
+    MP_THREAD_GIL_ENTER();
+}
+
+#endif
+
 /****************************************************************/
 // Lock object
 
@@ -144,6 +201,21 @@ STATIC mp_obj_t mod_thread_stack_size(size_t n_args, const mp_obj_t *args) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_thread_stack_size_obj, 0, 1, mod_thread_stack_size);
 
+#if MICROPY_PY_THREAD_GIL && MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL
+STATIC mp_obj_t mod_thread_switch_interval(size_t n_args, const mp_obj_t *args) {
+    mp_obj_t ret = mp_obj_new_int_from_uint(MP_STATE_VM(gil_switch_interval));
+    if (n_args == 1) {
+        mp_int_t interval = mp_obj_get_int(args[0]);
+        if (interval < 0) {
+            mp_raise_ValueError(NULL);
+        }
+        MP_STATE_VM(gil_switch_interval) = interval;
+    }
+    return ret;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_thread_switch_interval_obj, 0, 1, mod_thread_switch_interval);
+#endif
+
 typedef struct _thread_entry_args_t {
     mp_obj_dict_t *dict_locals;
     mp_obj_dict_t *dict_globals;
@@ -174,6 +246,16 @@ STATIC void *thread_entry(void *args_in) {
     // The GC starts off unlocked on this thread.
     ts.gc_lock_depth = 0;
 
+    #if MICROPY_PROF_FRAME_CHAIN
+    ts.prof_frame_top = NULL;
+    #endif
+
+    #if MICROPY_PY_SYS_SETTRACE
+    ts.prof_trace_callback = MP_OBJ_NULL;
+    ts.prof_callback_is_executing = false;
+    ts.current_code_state = NULL;
+    #endif
+
     ts.mp_pending_exception = MP_OBJ_NULL;
 
     // set locals and globals from the calling context
@@ -289,6 +371,9 @@ STATIC const mp_rom_map_elem_t mp_module_thread_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_LockType), MP_ROM_PTR(&mp_type_thread_lock) },
     { MP_ROM_QSTR(MP_QSTR_get_ident), MP_ROM_PTR(&mod_thread_get_ident_obj) },
     { MP_ROM_QSTR(MP_QSTR_stack_size), MP_ROM_PTR(&mod_thread_stack_size_obj) },
+    #if MICROPY_PY_THREAD_GIL && MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL
+    { MP_ROM_QSTR(MP_QSTR_switch_interval), MP_ROM_PTR(&mod_thread_switch_interval_obj) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_start_new_thread), MP_ROM_PTR(&mod_thread_start_new_thread_obj) },
     { MP_ROM_QSTR(MP_QSTR_exit), MP_ROM_PTR(&mod_thread_exit_obj) },
     { MP_ROM_QSTR(MP_QSTR_allocate_lock), MP_ROM_PTR(&mod_thread_allocate_lock_obj) },
@@ -322,6 +322,14 @@
 #define MICROPY_PERSISTENT_CODE_SAVE_FILE (0)
 #endif
 
+// Whether to support loading .mpy files saved with the execute-in-place layout
+// (mpy-cross -mxip).  Their bytecode refers to qstrs through a per-module table
+// so it can run directly from memory that stays mapped, such as flash or an
+// mmap'd file, instead of being copied into the heap.
+#ifndef MICROPY_PERSISTENT_CODE_XIP
+#define MICROPY_PERSISTENT_CODE_XIP (0)
+#endif
+
 // Whether generated code can persist independently of the VM/runtime instance
 // This is enabled automatically when needed by other features
 #ifndef MICROPY_PERSISTENT_CODE
@@ -538,6 +546,14 @@
 #define MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE (128)
 #endif
 
+// Whether instances of user classes store their attributes as a flat array of
+// values laid out by a per-class list of attribute names (a "shape"), instead
+// of each instance owning a hash map.  Instances that set their attributes in
+// an unusual order, or delete one, fall back to a map.
+#ifndef MICROPY_OPT_INSTANCE_SHAPES
+#define MICROPY_OPT_INSTANCE_SHAPES (0)
+#endif
+
 // Whether to use fast versions of bitwise operations (and, or, xor) when the
 // arguments are both positive.  Increases Thumb2 code size by about 250 bytes.
 #ifndef MICROPY_OPT_MPZ_BITWISE
@@ -545,6 +561,15 @@
 #endif
 
 
+// Whether str/bytes find, count, replace, split, strip and case conversion
+// look for candidate matches with memchr (which the C library usually
+// vectorises) and scan for whitespace and ASCII letters a machine word at a
+// time.  Makes searching large strings several times faster, at the cost of
+// a few hundred bytes of code.
+#ifndef MICROPY_OPT_STR_FAST_SCAN
+#define MICROPY_OPT_STR_FAST_SCAN (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
 // Whether math.factorial is large, fast and recursive (1) or small and slow (0).
 #ifndef MICROPY_OPT_MATH_FACTORIAL
 #define MICROPY_OPT_MATH_FACTORIAL (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
@@ -844,6 +869,15 @@ typedef double mp_float_t;
 #define MICROPY_MODULE_FROZEN (MICROPY_MODULE_FROZEN_STR || MICROPY_MODULE_FROZEN_MPY)
 #endif
 
+// Whether to cache directory listings when resolving imports, so that each
+// directory on sys.path is listed once rather than stat'ed for every candidate
+// module.  When enabled, a port must implement mp_import_listdir and
+// mp_import_dir_stamp, and call mp_import_cache_invalidate whenever the
+// filesystem is modified.
+#ifndef MICROPY_MODULE_IMPORT_CACHE
+#define MICROPY_MODULE_IMPORT_CACHE (0)
+#endif
+
 // Whether you can override builtins in the builtins module
 #ifndef MICROPY_CAN_OVERRIDE_BUILTINS
 #define MICROPY_CAN_OVERRIDE_BUILTINS (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
@@ -1171,6 +1205,40 @@ typedef double mp_float_t;
 #define MICROPY_PY_MICROPYTHON_HEAP_LOCKED (0)
 #endif
 
+// Whether to provide the "micropython.profile_start/profile_stop/profile_dump"
+// sampling profiler.  The port must provide mp_prof_sample_timer_start/stop,
+// which arrange for mp_prof_sample() to be called periodically from a timer
+// interrupt (or signal handler) on the thread running the VM.
+#ifndef MICROPY_PY_MICROPYTHON_PROFILE
+#define MICROPY_PY_MICROPYTHON_PROFILE (0)
+#endif
+
+// Number of samples kept in the sampling profiler's ring buffer
+#ifndef MICROPY_PY_MICROPYTHON_PROFILE_SAMPLES
+#define MICROPY_PY_MICROPYTHON_PROFILE_SAMPLES (256)
+#endif
+
+// Maximum number of (innermost) frames recorded per sample
+#ifndef MICROPY_PY_MICROPYTHON_PROFILE_DEPTH
+#define MICROPY_PY_MICROPYTHON_PROFILE_DEPTH (8)
+#endif
+
+// Whether to count heap allocations per call site (bytecode function and line)
+// and provide "micropython.alloc_stats" to report them.  This adds a hash table
+// update to every gc_alloc so is intended for development builds.
+#ifndef MICROPY_PY_MICROPYTHON_ALLOC_STATS
+#define MICROPY_PY_MICROPYTHON_ALLOC_STATS (0)
+#endif
+
+// Number of distinct allocation sites tracked (at most 65536)
+#ifndef MICROPY_PY_MICROPYTHON_ALLOC_STATS_SITES
+#define MICROPY_PY_MICROPYTHON_ALLOC_STATS_SITES (128)
+#endif
+
+// Whether mp_execute_bytecode keeps a per-thread chain of the active bytecode
+// frames for the profilers (sys.settrace has its own chain of code states)
+#define MICROPY_PROF_FRAME_CHAIN ((MICROPY_PY_MICROPYTHON_PROFILE || MICROPY_PY_MICROPYTHON_ALLOC_STATS) && !MICROPY_PY_SYS_SETTRACE)
+
 // Whether to provide "array" module. Note that large chunk of the
 // underlying code is shared with "bytearray" builtin type, so to
 // get real savings, it should be disabled too.
@@ -1306,6 +1374,12 @@ typedef double mp_float_t;
 #define MICROPY_PY_STRUCT (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_CORE_FEATURES)
 #endif
 
+// Whether to provide "struct.Struct" objects, which parse their format once,
+// and "struct.iter_unpack"
+#ifndef MICROPY_PY_STRUCT_OBJECT
+#define MICROPY_PY_STRUCT_OBJECT (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
 // Whether to provide "sys" module
 #ifndef MICROPY_PY_SYS
 #define MICROPY_PY_SYS (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_CORE_FEATURES)
@@ -1413,6 +1487,20 @@ typedef double mp_float_t;
 #define MICROPY_PY_THREAD_GIL_VM_DIVISOR (32)
 #endif
 
+// Minimum time in microseconds that a thread holds the GIL before the VM hands
+// it over to a waiting thread (checked every MICROPY_PY_THREAD_GIL_VM_DIVISOR
+// jump-loops).  The value can be changed at runtime with _thread.switch_interval().
+// Set this to 0 to disable the time-based fair hand-off and simply release and
+// re-acquire the GIL at every divisor tick.
+#ifndef MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL
+#define MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL (0)
+#endif
+
+// Hook used by a thread handing over the GIL to let a waiting thread run.
+#ifndef MICROPY_THREAD_YIELD
+#define MICROPY_THREAD_YIELD()
+#endif
+
 // Extended modules
 
 #ifndef MICROPY_PY_UASYNCIO
@@ -1429,6 +1517,12 @@ typedef double mp_float_t;
 #define MICROPY_PY_UCTYPES_NATIVE_C_TYPES (1)
 #endif
 
+// Whether to provide uctypes.compile(), to convert a descriptor into a table
+// of decoded fields for faster attribute access
+#ifndef MICROPY_PY_UCTYPES_COMPILE
+#define MICROPY_PY_UCTYPES_COMPILE (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
+#endif
+
 #ifndef MICROPY_PY_UZLIB
 #define MICROPY_PY_UZLIB (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
 #endif
@@ -1564,6 +1658,11 @@ typedef double mp_float_t;
 #define MICROPY_PY_FRAMEBUF (MICROPY_CONFIG_ROM_LEVEL_AT_LEAST_EXTRA_FEATURES)
 #endif
 
+// Whether to provide the "arrayops" module, bulk arithmetic on arrays
+#ifndef MICROPY_PY_ARRAYOPS
+#define MICROPY_PY_ARRAYOPS (0)
+#endif
+
 #ifndef MICROPY_PY_BTREE
 #define MICROPY_PY_BTREE (0)
 #endif
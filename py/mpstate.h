@@ -47,6 +47,7 @@ typedef struct mp_dynamic_compiler_t {
     bool py_builtins_str_unicode;
     uint8_t native_arch;
     uint8_t nlr_buf_num_regs;
+    bool xip; // save .mpy files with the execute-in-place layout
 } mp_dynamic_compiler_t;
 extern mp_dynamic_compiler_t mp_dynamic_compiler;
 #endif
@@ -61,6 +62,19 @@ typedef struct _mp_sched_item_t {
     mp_obj_t arg;
 } mp_sched_item_t;
 
+#if MICROPY_PY_MICROPYTHON_ALLOC_STATS
+// Number and total size of heap allocations made by one line of bytecode.
+typedef struct _mp_alloc_site_t {
+    qstr block_name; // MP_QSTRnull for an unused entry
+    qstr source_file;
+    size_t source_line;
+    size_t count;
+    size_t bytes;
+} mp_alloc_site_t;
+
+#define MP_ALLOC_SITE_CACHE_SIZE (32)
+#endif
+
 // This structure hold information about the memory allocation system.
 typedef struct _mp_state_mem_t {
     #if MICROPY_MEM_STATS
@@ -157,6 +171,12 @@ typedef struct _mp_state_vm_t {
     mp_obj_list_t mp_sys_path_obj;
     mp_obj_list_t mp_sys_argv_obj;
 
+    #if MICROPY_MODULE_IMPORT_CACHE
+    // directory listings used to resolve imports (may be exposed as sys.path_importer_cache)
+    mp_obj_dict_t import_cache;
+    mp_uint_t import_cache_gen;
+    #endif
+
     // dictionary for overridden builtins
     #if MICROPY_CAN_OVERRIDE_BUILTINS
     mp_obj_dict_t *mp_module_builtins_override_dict;
@@ -193,6 +213,10 @@ typedef struct _mp_state_vm_t {
     mp_obj_t bluetooth;
     #endif
 
+    #if MICROPY_PY_MICROPYTHON_PROFILE
+    struct _mp_prof_sample_t *prof_samples;
+    #endif
+
     //
     // END ROOT POINTER SECTION
     ////////////////////////////////////////////////////////////
@@ -206,6 +230,24 @@ typedef struct _mp_state_vm_t {
     #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
     // This is a global mutex used to make qstr interning thread-safe.
     mp_thread_mutex_t qstr_mutex;
+    #if MICROPY_OPT_INSTANCE_SHAPES
+    // This is a global mutex used to extend the attribute layouts of classes.
+    mp_thread_mutex_t instance_layout_mutex;
+    #endif
+    #endif
+
+    #if MICROPY_PY_MICROPYTHON_PROFILE
+    // State of the sampling profiler, samples are stored in prof_samples.
+    volatile size_t prof_sample_count;
+    volatile bool prof_sample_running;
+    #endif
+
+    #if MICROPY_PY_MICROPYTHON_ALLOC_STATS
+    // Open-addressed hash table of allocation sites, see mp_prof_alloc_record.
+    mp_alloc_site_t alloc_sites[MICROPY_PY_MICROPYTHON_ALLOC_STATS_SITES];
+    // Direct-mapped cache from bytecode ip to index in alloc_sites.
+    const byte *alloc_site_cache_ip[MP_ALLOC_SITE_CACHE_SIZE];
+    uint16_t alloc_site_cache_pos[MP_ALLOC_SITE_CACHE_SIZE];
     #endif
 
     #if MICROPY_ENABLE_COMPILER
@@ -229,6 +271,14 @@ typedef struct _mp_state_vm_t {
     #if MICROPY_PY_THREAD_GIL
     // This is a global mutex used to make the VM/runtime thread-safe.
     mp_thread_mutex_t gil_mutex;
+
+    #if MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL
+    // State used to hand the GIL over fairly to waiting threads, see mp_thread_gil_switch.
+    mp_uint_t gil_switch_interval;
+    mp_uint_t gil_acquired_ticks;
+    volatile unsigned int gil_handoff;
+    volatile uint16_t gil_waiters;
+    #endif
     #endif
 
     #if MICROPY_OPT_MAP_LOOKUP_CACHE
@@ -256,6 +306,11 @@ typedef struct _mp_state_thread_t {
     // Locking of the GC is done per thread.
     uint16_t gc_lock_depth;
 
+    #if MICROPY_PROF_FRAME_CHAIN
+    // Innermost bytecode frame being executed, for the profilers.
+    struct _mp_prof_frame_link_t *prof_frame_top;
+    #endif
+
     ////////////////////////////////////////////////////////////
     // START ROOT POINTER SECTION
     // Everything that needs GC scanning must start here, and
@@ -51,7 +51,14 @@ void mp_thread_mutex_unlock(mp_thread_mutex_t *mutex);
 
 #if MICROPY_PY_THREAD && MICROPY_PY_THREAD_GIL
 #include "py/mpstate.h"
+#if MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL
+void mp_thread_gil_init(void);
+void mp_thread_gil_enter(void);
+void mp_thread_gil_switch(void);
+#define MP_THREAD_GIL_ENTER() mp_thread_gil_enter()
+#else
 #define MP_THREAD_GIL_ENTER() mp_thread_mutex_lock(&MP_STATE_VM(gil_mutex), 1)
+#endif
 #define MP_THREAD_GIL_EXIT() mp_thread_mutex_unlock(&MP_STATE_VM(gil_mutex))
 #else
 #define MP_THREAD_GIL_ENTER()
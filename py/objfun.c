@@ -167,7 +167,7 @@ qstr mp_obj_fun_get_name(mp_const_obj_t fun_in) {
 
     const byte *bc = fun->bytecode;
     MP_BC_PRELUDE_SIG_DECODE(bc);
-    return mp_obj_code_get_name(bc);
+    return mp_obj_fun_bc_get_qstr(fun, mp_obj_code_get_name(bc));
 }
 
 #if MICROPY_CPYTHON_COMPAT
@@ -33,6 +33,9 @@ typedef struct _mp_obj_fun_bc_t {
     mp_obj_dict_t *globals;         // the context within which this function was defined
     const byte *bytecode;           // bytecode for the function
     const mp_uint_t *const_table;   // constant table
+    #if MICROPY_PERSISTENT_CODE_XIP
+    const uint16_t *qstr_table;     // if non-NULL, qstrs in bytecode are indices into this
+    #endif
     #if MICROPY_PY_SYS_SETTRACE
     const struct _mp_raw_code_t *rc;
     #endif
@@ -46,4 +49,16 @@ typedef struct _mp_obj_fun_bc_t {
 
 void mp_obj_fun_bc_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest);
 
+// Convert a qstr stored in the bytecode of the given function to a real qstr.
+static inline qstr mp_obj_fun_bc_get_qstr(const mp_obj_fun_bc_t *fun, qstr qst) {
+    #if MICROPY_PERSISTENT_CODE_XIP
+    if (fun->qstr_table != NULL) {
+        return fun->qstr_table[qst];
+    }
+    #else
+    (void)fun;
+    #endif
+    return qst;
+}
+
 #endif // MICROPY_INCLUDED_PY_OBJFUN_H
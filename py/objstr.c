@@ -274,9 +274,33 @@ wrong_args:
     mp_raise_TypeError(MP_ERROR_TEXT("wrong number of arguments"));
 }
 
+#if MICROPY_OPT_STR_FAST_SCAN
+// A word with every byte set to b, and a test for whether any byte of w is
+// less than n (for n <= 0x80)
+#define WORD_BYTES(b) ((mp_uint_t)-1 / 0xff * (b))
+#define WORD_HAS_LESS(w, n) (((w) - WORD_BYTES(n)) & ~(w) & WORD_BYTES(0x80))
+#define WORD_IS_ALIGNED(p) (((uintptr_t)(p) & (sizeof(mp_uint_t) - 1)) == 0)
+#endif
+
 // like strstr but with specified length and allows \0 bytes
-// TODO replace with something more efficient/standard
 const byte *find_subbytes(const byte *haystack, size_t hlen, const byte *needle, size_t nlen, int direction) {
+    #if MICROPY_OPT_STR_FAST_SCAN
+    if (direction > 0 && hlen >= nlen && nlen > 0) {
+        // let memchr find each candidate first byte, then compare the rest
+        const byte *top = haystack + hlen - nlen + 1;
+        while (haystack < top) {
+            const byte *p = memchr(haystack, needle[0], top - haystack);
+            if (p == NULL) {
+                break;
+            }
+            if (memcmp(p + 1, needle + 1, nlen - 1) == 0) {
+                return p;
+            }
+            haystack = p + 1;
+        }
+        return NULL;
+    }
+    #endif
     if (hlen >= nlen) {
         size_t str_index, str_index_end;
         if (direction > 0) {
@@ -500,6 +524,26 @@ STATIC mp_obj_t str_join(mp_obj_t self_in, mp_obj_t arg) {
 }
 MP_DEFINE_CONST_FUN_OBJ_2(str_join_obj, str_join);
 
+// Return a pointer to the first whitespace character at or after s
+STATIC const byte *str_skip_nonspace(const byte *s, const byte *top) {
+    #if MICROPY_OPT_STR_FAST_SCAN
+    while (s < top && !WORD_IS_ALIGNED(s)) {
+        if (unichar_isspace(*s)) {
+            return s;
+        }
+        s++;
+    }
+    // all whitespace characters are below 0x21, so skip words with none of those
+    while (s + sizeof(mp_uint_t) <= top && !WORD_HAS_LESS(*(const mp_uint_t *)s, 0x21)) {
+        s += sizeof(mp_uint_t);
+    }
+    #endif
+    while (s < top && !unichar_isspace(*s)) {
+        s++;
+    }
+    return s;
+}
+
 mp_obj_t mp_obj_str_split(size_t n_args, const mp_obj_t *args) {
     const mp_obj_type_t *self_type = mp_obj_get_type(args[0]);
     mp_int_t splits = -1;
@@ -524,9 +568,7 @@ mp_obj_t mp_obj_str_split(size_t n_args, const mp_obj_t *args) {
         }
         while (s < top && splits != 0) {
             const byte *start = s;
-            while (s < top && !unichar_isspace(*s)) {
-                s++;
-            }
+            s = str_skip_nonspace(s, top);
             mp_obj_list_append(res, mp_obj_new_str_of_type(self_type, start, s - start));
             if (s >= top) {
                 break;
@@ -825,7 +867,7 @@ STATIC mp_obj_t str_uni_strip(int type, size_t n_args, const mp_obj_t *args) {
         delta = -1;
     }
     for (size_t len = orig_str_len; len > 0; len--) {
-        if (find_subbytes(chars_to_del, chars_to_del_len, &orig_str[i], 1, 1) == NULL) {
+        if (memchr(chars_to_del, orig_str[i], chars_to_del_len) == NULL) {
             if (!first_good_char_pos_set) {
                 first_good_char_pos_set = true;
                 first_good_char_pos = i;
@@ -1747,15 +1789,16 @@ STATIC mp_obj_t str_count(size_t n_args, const mp_obj_t *args) {
         return MP_OBJ_NEW_SMALL_INT(utf8_charlen(start, end - start) + 1);
     }
 
-    // count the occurrences
+    // count the occurrences; a needle that is valid UTF-8 can only match at
+    // the start of a character so there's no need to step by characters
     mp_int_t num_occurrences = 0;
     for (const byte *haystack_ptr = start; haystack_ptr + needle_len <= end;) {
-        if (memcmp(haystack_ptr, needle, needle_len) == 0) {
-            num_occurrences++;
-            haystack_ptr += needle_len;
-        } else {
-            haystack_ptr = utf8_next_char(haystack_ptr);
+        haystack_ptr = find_subbytes(haystack_ptr, end - haystack_ptr, needle, needle_len, 1);
+        if (haystack_ptr == NULL) {
+            break;
         }
+        num_occurrences++;
+        haystack_ptr += needle_len;
     }
 
     return MP_OBJ_NEW_SMALL_INT(num_occurrences);
@@ -1823,8 +1866,24 @@ STATIC mp_obj_t str_caseconv(unichar (*op)(unichar), mp_obj_t self_in) {
     vstr_t vstr;
     vstr_init_len(&vstr, self_len);
     byte *data = (byte *)vstr.buf;
-    for (size_t i = 0; i < self_len; i++) {
-        *data++ = op(*self_data++);
+    size_t i = 0;
+    #if MICROPY_OPT_STR_FAST_SCAN
+    // Convert ASCII letters a word at a time by flipping bit 0x20 of each
+    // byte in the range lo to lo + 25.  vstr.buf is always aligned.
+    if (WORD_IS_ALIGNED(self_data)) {
+        mp_uint_t lo = op == unichar_tolower ? 'A' : 'a';
+        for (; i + sizeof(mp_uint_t) <= self_len; i += sizeof(mp_uint_t)) {
+            mp_uint_t w = *(const mp_uint_t *)(self_data + i);
+            mp_uint_t low7 = w & WORD_BYTES(0x7f);
+            mp_uint_t ge_lo = low7 + WORD_BYTES(0x80 - lo);
+            mp_uint_t gt_hi = low7 + WORD_BYTES(0x80 - lo - 26);
+            mp_uint_t in_range = ge_lo & ~gt_hi & ~w & WORD_BYTES(0x80);
+            *(mp_uint_t *)(data + i) = w ^ (in_range >> 2);
+        }
+    }
+    #endif
+    for (; i < self_len; i++) {
+        data[i] = op(self_data[i]);
     }
     return mp_obj_new_str_from_vstr(mp_obj_get_type(self_in), &vstr);
 }
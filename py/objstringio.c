@@ -94,8 +94,10 @@ STATIC mp_uint_t stringio_write(mp_obj_t o_in, const void *buf, mp_uint_t size,
     if (new_pos > o->vstr->alloc) {
         // Take all what's already allocated...
         o->vstr->len = o->vstr->alloc;
-        // ... and add more
-        vstr_add_len(o->vstr, new_pos - o->vstr->alloc);
+        // ... and add more, growing by at least half so that a sequence of
+        // small writes takes linear time overall
+        vstr_add_len(o->vstr, MAX(new_pos - o->vstr->alloc, o->vstr->alloc / 2));
+        o->vstr->len = org_len;
     }
     // If there was a seek past EOF, clear the hole
     if (o->pos > org_len) {
@@ -165,8 +167,25 @@ STATIC mp_uint_t stringio_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg,
 STATIC mp_obj_t stringio_getvalue(mp_obj_t self_in) {
     mp_obj_stringio_t *self = MP_OBJ_TO_PTR(self_in);
     check_stringio_is_open(self);
-    // TODO: Try to avoid copying string
-    return mp_obj_new_str_of_type(STREAM_TO_CONTENT_TYPE(self), (byte *)self->vstr->buf, self->vstr->len);
+    const mp_obj_type_t *type = STREAM_TO_CONTENT_TYPE(self);
+    if (self->vstr->fixed_buf) {
+        if (self->ref_obj != MP_OBJ_NULL && mp_obj_get_type(self->ref_obj) == type) {
+            // Nothing was written since the buffer was taken from this object
+            return self->ref_obj;
+        }
+        return mp_obj_new_str_of_type(type, (byte *)self->vstr->buf, self->vstr->len);
+    }
+
+    // Hand the buffer over to the new object without copying it, and keep
+    // reading from it until the next write copies it (see stringio_write).
+    size_t len = self->vstr->len;
+    mp_obj_t value = mp_obj_new_str_from_vstr(type, self->vstr);
+    size_t value_len;
+    const char *value_data = mp_obj_str_get_data(value, &value_len);
+    vstr_init_fixed_buf(self->vstr, len, (char *)value_data);
+    self->vstr->len = len;
+    self->ref_obj = value;
+    return value;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(stringio_getvalue_obj, stringio_getvalue);
 
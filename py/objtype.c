@@ -101,7 +101,24 @@ mp_obj_instance_t *mp_obj_new_instance(const mp_obj_type_t *class, const mp_obj_
     assert(num_native_bases < 2);
     mp_obj_instance_t *o = m_new_obj_var(mp_obj_instance_t, mp_obj_t, num_native_bases);
     o->base.type = class;
+    #if MICROPY_OPT_INSTANCE_SHAPES
+    // Preallocate as many slots as the instances populated since the previous
+    // one was created needed, so that a single instance with many attributes
+    // doesn't make all later ones larger.  This is only a hint, so it is
+    // updated without taking the layout mutex.
+    mp_obj_class_t *cls = (mp_obj_class_t *)class;
+    if (cls->slots_recent != 0) {
+        cls->slots_hint = cls->slots_recent;
+        cls->slots_recent = 0;
+    }
+    size_t alloc = cls->slots_hint;
+    o->members.used = 0;
+    o->members.alloc = alloc;
+    o->members.slots = alloc ? m_new(mp_obj_t, alloc) : NULL;
+    o->members.map = NULL;
+    #else
     mp_map_init(&o->members, 0);
+    #endif
     // Initialise the native base-class slot (should be 1 at most) with a valid
     // object.  It doesn't matter which object, so long as it can be uniquely
     // distinguished from a native class that is initialised.
@@ -111,6 +128,159 @@ mp_obj_instance_t *mp_obj_new_instance(const mp_obj_type_t *class, const mp_obj_
     return o;
 }
 
+#if MICROPY_OPT_INSTANCE_SHAPES
+
+#if MICROPY_OPT_MAP_LOOKUP_CACHE
+// Share the map lookup cache to remember the last slot an attribute was found
+// in.  A stale entry just falls back to the linear search.
+#define SLOT_CACHE_ENTRY(attr) (MP_STATE_VM(map_lookup_cache)[(attr) % MICROPY_OPT_MAP_LOOKUP_CACHE_SIZE])
+#define SLOT_CACHE_SET(attr, pos) SLOT_CACHE_ENTRY(attr) = (pos) & 0xff
+#else
+#define SLOT_CACHE_SET(attr, pos)
+#endif
+
+// The layout of a class is shared by instances used in any thread.  Without
+// the GIL, extending it is done under a mutex, and a full layout is replaced
+// instead of reallocated so that other threads can go on reading the old one
+// (entries are only ever appended, and the GC keeps it alive while in use).
+#if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+#define LAYOUT_ENTER() mp_thread_mutex_lock(&MP_STATE_VM(instance_layout_mutex), 1)
+#define LAYOUT_EXIT() mp_thread_mutex_unlock(&MP_STATE_VM(instance_layout_mutex))
+#else
+#define LAYOUT_ENTER()
+#define LAYOUT_EXIT()
+#endif
+
+STATIC int instance_find_slot(mp_obj_instance_t *self, qstr attr) {
+    const qstr *layout = ((const mp_obj_class_t *)self->base.type)->layout;
+    size_t used = self->members.used;
+    #if MICROPY_OPT_MAP_LOOKUP_CACHE
+    size_t pos = SLOT_CACHE_ENTRY(attr);
+    if (pos < used && layout[pos] == attr) {
+        return pos;
+    }
+    #endif
+    for (size_t i = 0; i < used; ++i) {
+        if (layout[i] == attr) {
+            SLOT_CACHE_SET(attr, i);
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Move the attributes of an instance from its slots to a map; used when the
+// instance no longer follows the layout of its class.
+STATIC mp_map_t *instance_members_to_map(mp_obj_instance_t *self) {
+    const qstr *layout = ((const mp_obj_class_t *)self->base.type)->layout;
+    mp_obj_instance_members_t *members = &self->members;
+    mp_map_t *map = m_new(mp_map_t, 1);
+    mp_map_init(map, members->used);
+    for (size_t i = 0; i < members->used; ++i) {
+        mp_map_lookup(map, MP_OBJ_NEW_QSTR(layout[i]), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = members->slots[i];
+    }
+    m_del(mp_obj_t, members->slots, members->alloc);
+    members->used = 0;
+    members->alloc = 0;
+    members->slots = NULL;
+    members->map = map;
+    return map;
+}
+
+mp_obj_t *mp_obj_instance_lookup_member(mp_obj_instance_t *self, qstr attr) {
+    if (self->members.map == NULL) {
+        int pos = instance_find_slot(self, attr);
+        return pos < 0 ? NULL : &self->members.slots[pos];
+    }
+    mp_map_elem_t *elem = mp_map_lookup(self->members.map, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP);
+    return elem == NULL ? NULL : &elem->value;
+}
+
+void mp_obj_instance_store_member(mp_obj_instance_t *self, qstr attr, mp_obj_t value) {
+    mp_obj_instance_members_t *members = &self->members;
+    mp_map_t *map = members->map;
+    if (map == NULL) {
+        int pos = instance_find_slot(self, attr);
+        if (pos >= 0) {
+            members->slots[pos] = value;
+            return;
+        }
+        // A new attribute can take the next slot if it is the next one in the
+        // layout, or extend the layout if this instance has all the others.
+        mp_obj_class_t *class = (mp_obj_class_t *)self->base.type;
+        size_t used = members->used;
+        LAYOUT_ENTER();
+        bool next = used < class->layout_len ? class->layout[used] == attr : used < 0xffff;
+        if (next && used == class->layout_len) {
+            if (class->layout_len == class->layout_alloc) {
+                size_t new_alloc = MIN(class->layout_alloc + 4, 0xffff);
+                qstr *layout = m_new_maybe(qstr, new_alloc);
+                if (layout == NULL) {
+                    LAYOUT_EXIT();
+                    m_malloc_fail(new_alloc * sizeof(qstr));
+                }
+                memcpy(layout, class->layout, class->layout_len * sizeof(qstr));
+                class->layout = layout;
+                class->layout_alloc = new_alloc;
+            }
+            class->layout[class->layout_len++] = attr;
+        }
+        if (next && used + 1 > class->slots_recent) {
+            class->slots_recent = used + 1;
+        }
+        LAYOUT_EXIT();
+        if (next) {
+            if (used == members->alloc) {
+                size_t new_alloc = MIN(members->alloc + 4, 0xffff);
+                members->slots = m_renew(mp_obj_t, members->slots, members->alloc, new_alloc);
+                members->alloc = new_alloc;
+            }
+            members->slots[used] = value;
+            members->used = used + 1;
+            SLOT_CACHE_SET(attr, used);
+            return;
+        }
+        map = instance_members_to_map(self);
+    }
+    mp_map_lookup(map, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+}
+
+bool mp_obj_instance_delete_member(mp_obj_instance_t *self, qstr attr) {
+    mp_obj_instance_members_t *members = &self->members;
+    mp_map_t *map = members->map;
+    if (map == NULL) {
+        int pos = instance_find_slot(self, attr);
+        if (pos < 0) {
+            return false;
+        }
+        if ((size_t)pos == members->used - 1u) {
+            // Deleting the most recent attribute keeps the layout.
+            members->slots[pos] = MP_OBJ_NULL;
+            members->used = pos;
+            return true;
+        }
+        map = instance_members_to_map(self);
+    }
+    return mp_map_lookup(map, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_REMOVE_IF_FOUND) != NULL;
+}
+
+#else
+
+mp_obj_t *mp_obj_instance_lookup_member(mp_obj_instance_t *self, qstr attr) {
+    mp_map_elem_t *elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP);
+    return elem == NULL ? NULL : &elem->value;
+}
+
+void mp_obj_instance_store_member(mp_obj_instance_t *self, qstr attr, mp_obj_t value) {
+    mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+}
+
+bool mp_obj_instance_delete_member(mp_obj_instance_t *self, qstr attr) {
+    return mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_REMOVE_IF_FOUND) != NULL;
+}
+
+#endif // MICROPY_OPT_INSTANCE_SHAPES
+
 // TODO
 // This implements depth-first left-to-right MRO, which is not compliant with Python3 MRO
 // http://python-history.blogspot.com/2010/06/method-resolution-order.html
@@ -393,8 +563,16 @@ STATIC mp_obj_t instance_unary_op(mp_unary_op_t op, mp_obj_t self_in) {
         const mp_obj_type_t *native_base;
         size_t num_native_bases = instance_count_native_bases(mp_obj_get_type(self_in), &native_base);
 
-        size_t sz = sizeof(*self) + sizeof(*self->subobj) * num_native_bases
-            + sizeof(*self->members.table) * self->members.alloc;
+        size_t sz = sizeof(*self) + sizeof(*self->subobj) * num_native_bases;
+        #if MICROPY_OPT_INSTANCE_SHAPES
+        if (self->members.map == NULL) {
+            sz += sizeof(mp_obj_t) * self->members.alloc;
+        } else {
+            sz += sizeof(mp_map_t) + sizeof(*self->members.map->table) * self->members.map->alloc;
+        }
+        #else
+        sz += sizeof(*self->members.table) * self->members.alloc;
+        #endif
         return MP_OBJ_NEW_SMALL_INT(sz);
     }
     #endif
@@ -580,20 +758,35 @@ STATIC void mp_obj_instance_load_attr(mp_obj_t self_in, qstr attr, mp_obj_t *des
     mp_obj_instance_t *self = MP_OBJ_TO_PTR(self_in);
 
     // Note: This is fast-path'ed in the VM for the MP_BC_LOAD_ATTR operation.
-    mp_map_elem_t *elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP);
-    if (elem != NULL) {
+    mp_obj_t *slot = mp_obj_instance_lookup_member(self, attr);
+    if (slot != NULL) {
         // object member, always treated as a value
-        dest[0] = elem->value;
+        dest[0] = *slot;
         return;
     }
     #if MICROPY_CPYTHON_COMPAT
     if (attr == MP_QSTR___dict__) {
         // Create a new dict with a copy of the instance's map items.
         // This creates, unlike CPython, a read-only __dict__ that can't be modified.
+        #if MICROPY_OPT_INSTANCE_SHAPES
+        if (self->members.map == NULL) {
+            const qstr *layout = ((const mp_obj_class_t *)self->base.type)->layout;
+            dest[0] = mp_obj_new_dict(self->members.used);
+            for (size_t i = 0; i < self->members.used; ++i) {
+                mp_obj_dict_store(dest[0], MP_OBJ_NEW_QSTR(layout[i]), self->members.slots[i]);
+            }
+        } else {
+            mp_obj_dict_t dict;
+            dict.base.type = &mp_type_dict;
+            dict.map = *self->members.map;
+            dest[0] = mp_obj_dict_copy(MP_OBJ_FROM_PTR(&dict));
+        }
+        #else
         mp_obj_dict_t dict;
         dict.base.type = &mp_type_dict;
         dict.map = self->members;
         dest[0] = mp_obj_dict_copy(MP_OBJ_FROM_PTR(&dict));
+        #endif
         mp_obj_dict_t *dest_dict = MP_OBJ_TO_PTR(dest[0]);
         dest_dict->map.is_fixed = 1;
         return;
@@ -785,11 +978,10 @@ skip_special_accessors:
 
     if (value == MP_OBJ_NULL) {
         // delete attribute
-        mp_map_elem_t *elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_REMOVE_IF_FOUND);
-        return elem != NULL;
+        return mp_obj_instance_delete_member(self, attr);
     } else {
         // store attribute
-        mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+        mp_obj_instance_store_member(self, attr, value);
         return true;
     }
 }
@@ -1141,7 +1333,11 @@ mp_obj_t mp_obj_new_type(qstr name, mp_obj_t bases_tuple, mp_obj_t locals_dict)
         #endif
     }
 
+    #if MICROPY_OPT_INSTANCE_SHAPES
+    mp_obj_type_t *o = &m_new0(mp_obj_class_t, 1)->type;
+    #else
     mp_obj_type_t *o = m_new0(mp_obj_type_t, 1);
+    #endif
     o->base.type = &mp_type_type;
     o->flags = base_flags;
     o->name = name;
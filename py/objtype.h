@@ -28,15 +28,51 @@
 
 #include "py/obj.h"
 
+#if MICROPY_OPT_INSTANCE_SHAPES
+// attribute storage of an instance
+// while the attributes were set in the order given by the layout of the
+// instance's class, slots[i] holds the value of attribute layout[i]; otherwise
+// map is non-NULL and holds all the attributes
+typedef struct _mp_obj_instance_members_t {
+    uint16_t used;
+    uint16_t alloc;
+    mp_obj_t *slots;
+    mp_map_t *map;
+} mp_obj_instance_members_t;
+
+// class object
+// a type created by Python code, along with the attribute layout shared by its
+// instances: the names of the attributes in the order they were first set
+// slots_hint is the number of slots preallocated for a new instance, and
+// slots_recent the most slots used by instances since the last one was created
+typedef struct _mp_obj_class_t {
+    mp_obj_type_t type;
+    uint16_t layout_len;
+    uint16_t layout_alloc;
+    uint16_t slots_hint;
+    uint16_t slots_recent;
+    qstr *layout;
+} mp_obj_class_t;
+#endif
+
 // instance object
 // creating an instance of a class makes one of these objects
 typedef struct _mp_obj_instance_t {
     mp_obj_base_t base;
+    #if MICROPY_OPT_INSTANCE_SHAPES
+    mp_obj_instance_members_t members;
+    #else
     mp_map_t members;
+    #endif
     mp_obj_t subobj[];
     // TODO maybe cache __getattr__ and __setattr__ for efficient lookup of them
 } mp_obj_instance_t;
 
+// access to the attributes stored in an instance (not its class)
+mp_obj_t *mp_obj_instance_lookup_member(mp_obj_instance_t *self, qstr attr);
+void mp_obj_instance_store_member(mp_obj_instance_t *self, qstr attr, mp_obj_t value);
+bool mp_obj_instance_delete_member(mp_obj_instance_t *self, qstr attr);
+
 #if MICROPY_CPYTHON_COMPAT
 // this is needed for object.__new__
 mp_obj_instance_t *mp_obj_new_instance(const mp_obj_type_t *cls, const mp_obj_type_t **native_base);
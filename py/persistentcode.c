@@ -546,14 +546,95 @@ STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader, qstr_window_t *qw) {
     return rc;
 }
 
+#if MICROPY_PERSISTENT_CODE_XIP
+
+STATIC const uint16_t *load_xip_qstr_table(mp_reader_t *reader) {
+    size_t n_qstr = read_uint(reader, NULL);
+    uint16_t *qstr_table = m_new(uint16_t, n_qstr);
+    for (size_t i = 0; i < n_qstr; ++i) {
+        size_t len = read_uint(reader, NULL);
+        if (len == 0) {
+            // static qstr
+            qstr_table[i] = read_byte(reader);
+            continue;
+        }
+        len >>= 1;
+        const char *str = (const char *)mp_reader_read_mapped(reader, len);
+        if (str != NULL) {
+            qstr_table[i] = qstr_from_strn(str, len);
+        } else {
+            char *buf = m_new(char, len);
+            read_bytes(reader, (byte *)buf, len);
+            qstr_table[i] = qstr_from_strn(buf, len);
+            m_del(char, buf, len);
+        }
+    }
+    return qstr_table;
+}
+
+// Load code saved with the execute-in-place layout.  The bytecode is used
+// where it is if the reader is mapped, otherwise it is copied as-is.
+STATIC mp_raw_code_t *load_raw_code_xip(mp_reader_t *reader, const uint16_t *qstr_table) {
+    size_t kind_len = read_uint(reader, NULL);
+    if ((kind_len & 3) != 0) {
+        // only bytecode can be saved with this layout
+        mp_raise_ValueError(MP_ERROR_TEXT("incompatible .mpy file"));
+    }
+    size_t fun_data_len = kind_len >> 2;
+    const byte *fun_data = mp_reader_read_mapped(reader, fun_data_len);
+    if (fun_data == NULL) {
+        byte *buf = m_new(byte, fun_data_len);
+        read_bytes(reader, buf, fun_data_len);
+        fun_data = buf;
+    }
+
+    const byte *ip = fun_data;
+    bytecode_prelude_t prelude;
+    extract_prelude(&ip, &prelude);
+
+    // Load constant table: argument names, objects and raw code children
+    size_t n_obj = read_uint(reader, NULL);
+    size_t n_raw_code = read_uint(reader, NULL);
+    mp_uint_t *const_table = m_new(mp_uint_t, prelude.n_pos_args + prelude.n_kwonly_args + n_obj + n_raw_code);
+    mp_uint_t *ct = const_table;
+    for (size_t i = 0; i < prelude.n_pos_args + prelude.n_kwonly_args; ++i) {
+        *ct++ = (mp_uint_t)MP_OBJ_NEW_QSTR(qstr_table[read_uint(reader, NULL)]);
+    }
+    for (size_t i = 0; i < n_obj; ++i) {
+        *ct++ = (mp_uint_t)load_obj(reader);
+    }
+    for (size_t i = 0; i < n_raw_code; ++i) {
+        *ct++ = (mp_uint_t)(uintptr_t)load_raw_code_xip(reader, qstr_table);
+    }
+
+    mp_raw_code_t *rc = mp_emit_glue_new_raw_code();
+    rc->qstr_table = qstr_table;
+    mp_emit_glue_assign_bytecode(rc, fun_data,
+        #if MICROPY_PERSISTENT_CODE_SAVE || MICROPY_DEBUG_PRINTERS
+        fun_data_len,
+        #endif
+        const_table,
+        #if MICROPY_PERSISTENT_CODE_SAVE
+        n_obj, n_raw_code,
+        #endif
+        prelude.scope_flags);
+    return rc;
+}
+
+#endif // MICROPY_PERSISTENT_CODE_XIP
+
 mp_raw_code_t *mp_raw_code_load(mp_reader_t *reader) {
     byte header[4];
     read_bytes(reader, header, sizeof(header));
+    byte flags = MPY_FEATURE_DECODE_FLAGS(header[2]);
+    #if MICROPY_PERSISTENT_CODE_XIP
+    bool xip = flags & MPY_FEATURE_XIP;
+    flags &= ~MPY_FEATURE_XIP;
+    #endif
     if (header[0] != 'M'
         || header[1] != MPY_VERSION
-        || MPY_FEATURE_DECODE_FLAGS(header[2]) != MPY_FEATURE_FLAGS
-        || header[3] > mp_small_int_bits()
-        || read_uint(reader, NULL) > QSTR_WINDOW_SIZE) {
+        || flags != MPY_FEATURE_FLAGS
+        || header[3] > mp_small_int_bits()) {
         mp_raise_ValueError(MP_ERROR_TEXT("incompatible .mpy file"));
     }
     if (MPY_FEATURE_DECODE_ARCH(header[2]) != MP_NATIVE_ARCH_NONE) {
@@ -562,9 +643,21 @@ mp_raw_code_t *mp_raw_code_load(mp_reader_t *reader) {
             mp_raise_ValueError(MP_ERROR_TEXT("incompatible .mpy arch"));
         }
     }
-    qstr_window_t qw;
-    qw.idx = 0;
-    mp_raw_code_t *rc = load_raw_code(reader, &qw);
+    mp_raw_code_t *rc;
+    #if MICROPY_PERSISTENT_CODE_XIP
+    if (xip) {
+        const uint16_t *qstr_table = load_xip_qstr_table(reader);
+        rc = load_raw_code_xip(reader, qstr_table);
+    } else
+    #endif
+    {
+        if (read_uint(reader, NULL) > QSTR_WINDOW_SIZE) {
+            mp_raise_ValueError(MP_ERROR_TEXT("incompatible .mpy file"));
+        }
+        qstr_window_t qw;
+        qw.idx = 0;
+        rc = load_raw_code(reader, &qw);
+    }
     reader->close(reader->data);
     return rc;
 }
@@ -579,7 +672,14 @@ mp_raw_code_t *mp_raw_code_load_mem(const byte *buf, size_t len) {
 
 mp_raw_code_t *mp_raw_code_load_file(const char *filename) {
     mp_reader_t reader;
-    mp_reader_new_file(&reader, filename);
+    #if MICROPY_PERSISTENT_CODE_XIP && MICROPY_READER_POSIX && !MICROPY_VFS
+    // Map the file so execute-in-place code can run from it; the mapping is
+    // released again if the file turns out to have the regular layout.
+    if (!mp_reader_new_file_mapped(&reader, filename))
+    #endif
+    {
+        mp_reader_new_file(&reader, filename);
+    }
     return mp_raw_code_load(&reader);
 }
 
@@ -774,6 +874,122 @@ STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc, qstr_window_t *q
     }
 }
 
+#if MICROPY_DYNAMIC_COMPILER
+
+// The execute-in-place layout stores the bytecode of each function exactly
+// as the VM runs it, except that each qstr is replaced by its index in a table
+// of all the qstrs of the module, which is saved before the code.  This lets
+// the bytecode be used directly from memory-mapped storage.
+
+typedef struct _xip_qstr_table_t {
+    size_t len;
+    size_t alloc;
+    qstr *qstrs;
+} xip_qstr_table_t;
+
+STATIC size_t xip_qstr_index(xip_qstr_table_t *qt, qstr qst) {
+    for (size_t i = 0; i < qt->len; ++i) {
+        if (qt->qstrs[i] == qst) {
+            return i;
+        }
+    }
+    if (qt->len >= 0xffff) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("too many qstrs"));
+    }
+    if (qt->len == qt->alloc) {
+        qt->qstrs = m_renew(qstr, qt->qstrs, qt->alloc, qt->alloc * 2);
+        qt->alloc *= 2;
+    }
+    qt->qstrs[qt->len] = qst;
+    return qt->len++;
+}
+
+STATIC void xip_patch_qstr(xip_qstr_table_t *qt, byte *p) {
+    size_t idx = xip_qstr_index(qt, p[0] | (p[1] << 8));
+    p[0] = idx;
+    p[1] = idx >> 8;
+}
+
+STATIC void save_raw_code_xip(mp_print_t *print, mp_raw_code_t *rc, xip_qstr_table_t *qt) {
+    if (rc->kind != MP_CODE_BYTECODE) {
+        mp_raise_ValueError(MP_ERROR_TEXT("can't save native code for execute-in-place"));
+    }
+    mp_print_uint(print, rc->fun_data_len << 2);
+
+    // Save a copy of the bytecode with qstrs in the prelude and opcodes patched
+    byte *code = m_new(byte, rc->fun_data_len);
+    memcpy(code, rc->fun_data, rc->fun_data_len);
+    const byte *ip = code;
+    bytecode_prelude_t prelude;
+    byte *ip_info = extract_prelude(&ip, &prelude);
+    xip_patch_qstr(qt, ip_info); // simple_name
+    xip_patch_qstr(qt, ip_info + 2); // source_file
+    const byte *ip_top = code + rc->fun_data_len;
+    while (ip < ip_top) {
+        size_t sz;
+        uint f = mp_opcode_format(ip, &sz, true);
+        if (f == MP_BC_FORMAT_QSTR) {
+            xip_patch_qstr(qt, (byte *)ip + 1);
+        }
+        ip += sz;
+    }
+    mp_print_bytes(print, code, rc->fun_data_len);
+    m_del(byte, code, rc->fun_data_len);
+
+    // Save constant table
+    mp_print_uint(print, rc->n_obj);
+    mp_print_uint(print, rc->n_raw_code);
+    const mp_uint_t *const_table = rc->const_table;
+    for (size_t i = 0; i < prelude.n_pos_args + prelude.n_kwonly_args; ++i) {
+        mp_print_uint(print, xip_qstr_index(qt, MP_OBJ_QSTR_VALUE((mp_obj_t)*const_table++)));
+    }
+    for (size_t i = 0; i < rc->n_obj; ++i) {
+        save_obj(print, (mp_obj_t)*const_table++);
+    }
+    for (size_t i = 0; i < rc->n_raw_code; ++i) {
+        save_raw_code_xip(print, (mp_raw_code_t *)(uintptr_t)*const_table++, qt);
+    }
+}
+
+STATIC void mp_raw_code_save_xip(mp_raw_code_t *rc, mp_print_t *print) {
+    // The code is saved first to collect its qstrs, then written after the
+    // header and the qstr table.
+    xip_qstr_table_t qt = {0, 16, m_new(qstr, 16)};
+    vstr_t code;
+    mp_print_t code_print;
+    vstr_init_print(&code, 256, &code_print);
+    save_raw_code_xip(&code_print, rc, &qt);
+
+    byte header[4] = {
+        'M',
+        MPY_VERSION,
+        MPY_FEATURE_ENCODE_FLAGS(MPY_FEATURE_FLAGS_DYNAMIC | MPY_FEATURE_XIP),
+        mp_dynamic_compiler.small_int_bits,
+    };
+    mp_print_bytes(print, header, sizeof(header));
+
+    // qstr table: static qstrs by number, others by their data
+    mp_print_uint(print, qt.len);
+    for (size_t i = 0; i < qt.len; ++i) {
+        qstr qst = qt.qstrs[i];
+        if (qst <= QSTR_LAST_STATIC) {
+            byte buf[2] = {0, qst & 0xff};
+            mp_print_bytes(print, buf, 2);
+        } else {
+            size_t len;
+            const byte *str = qstr_data(qst, &len);
+            mp_print_uint(print, len << 1);
+            mp_print_bytes(print, str, len);
+        }
+    }
+    mp_print_bytes(print, (const byte *)code.buf, code.len);
+
+    vstr_clear(&code);
+    m_del(qstr, qt.qstrs, qt.alloc);
+}
+
+#endif // MICROPY_DYNAMIC_COMPILER
+
 STATIC bool mp_raw_code_has_native(mp_raw_code_t *rc) {
     if (rc->kind != MP_CODE_BYTECODE) {
         return true;
@@ -797,6 +1013,13 @@ STATIC bool mp_raw_code_has_native(mp_raw_code_t *rc) {
 }
 
 void mp_raw_code_save(mp_raw_code_t *rc, mp_print_t *print) {
+    #if MICROPY_DYNAMIC_COMPILER
+    if (mp_dynamic_compiler.xip) {
+        mp_raw_code_save_xip(rc, print);
+        return;
+    }
+    #endif
+
     // header contains:
     //  byte  'M'
     //  byte  version
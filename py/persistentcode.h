@@ -47,6 +47,10 @@
 #define MPY_FEATURE_FLAGS ( \
     ((MICROPY_PY_BUILTINS_STR_UNICODE) << 1) \
     )
+// Position 0 of the feature flags marks a file saved with the execute-in-place
+// layout, see mp_raw_code_save.  Loaders without MICROPY_PERSISTENT_CODE_XIP
+// reject such files because the flags don't match.
+#define MPY_FEATURE_XIP (1)
 // This is a version of the flags that can be configured at runtime.
 #define MPY_FEATURE_FLAGS_DYNAMIC ( \
     ((MICROPY_PY_BUILTINS_STR_UNICODE_DYNAMIC) << 1) \
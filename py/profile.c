@@ -24,6 +24,8 @@
  * THE SOFTWARE.
  */
 
+#include <string.h>
+
 #include "py/profile.h"
 #include "py/bc0.h"
 #include "py/gc.h"
@@ -968,3 +970,235 @@ void mp_prof_print_instr(const byte *ip, mp_code_state_t *code_state) {
 #endif // MICROPY_PROF_INSTR_DEBUG_PRINT_ENABLE
 
 #endif // MICROPY_PY_SYS_SETTRACE
+
+#if MICROPY_PY_MICROPYTHON_PROFILE || MICROPY_PY_MICROPYTHON_ALLOC_STATS
+
+#include "py/bc.h"
+
+// Decode the function name, file and line of the instruction being executed.
+// This only reads the bytecode so it is safe to call from an interrupt.
+STATIC void prof_sample_frame(const mp_code_state_t *code_state, mp_prof_sample_frame_t *frame) {
+    const byte *ip = code_state->fun_bc->bytecode;
+    MP_BC_PRELUDE_SIG_DECODE(ip);
+    MP_BC_PRELUDE_SIZE_DECODE(ip);
+    const byte *bytecode_start = ip + n_info + n_cell;
+    #if !MICROPY_PERSISTENT_CODE
+    // so bytecode is aligned
+    bytecode_start = MP_ALIGN(bytecode_start, sizeof(mp_uint_t));
+    #endif
+    size_t bc = code_state->ip > bytecode_start ? code_state->ip - bytecode_start : 0;
+    #if MICROPY_PERSISTENT_CODE
+    frame->block_name = mp_obj_fun_bc_get_qstr(code_state->fun_bc, ip[0] | (ip[1] << 8));
+    frame->source_file = mp_obj_fun_bc_get_qstr(code_state->fun_bc, ip[2] | (ip[3] << 8));
+    ip += 4;
+    #else
+    frame->block_name = mp_decode_uint_value(ip);
+    ip = mp_decode_uint_skip(ip);
+    frame->source_file = mp_decode_uint_value(ip);
+    ip = mp_decode_uint_skip(ip);
+    #endif
+    frame->source_line = mp_bytecode_get_source_line(ip, bc);
+}
+
+#endif
+
+#if MICROPY_PY_MICROPYTHON_PROFILE
+
+// Decode up to max of the bytecode frames executing on this thread, innermost
+// first, and return the number of frames decoded.
+STATIC size_t prof_get_frames(mp_prof_sample_frame_t *frames, size_t max) {
+    size_t depth = 0;
+    #if MICROPY_PY_SYS_SETTRACE
+    for (const mp_code_state_t *cs = MP_STATE_THREAD(current_code_state);
+         cs != NULL && depth < max; cs = cs->prev_state) {
+        prof_sample_frame(cs, &frames[depth++]);
+    }
+    #else
+    for (const mp_prof_frame_link_t *link = MP_STATE_THREAD(prof_frame_top);
+         link != NULL && depth < max; link = link->prev) {
+        prof_sample_frame(link->code_state, &frames[depth++]);
+    }
+    #endif
+    return depth;
+}
+
+void mp_prof_sample(void) {
+    mp_prof_sample_t *samples = MP_STATE_VM(prof_samples);
+    if (samples == NULL || !MP_STATE_VM(prof_sample_running)) {
+        return;
+    }
+    #if MICROPY_PY_THREAD
+    if (mp_thread_get_state() == NULL) {
+        // not a MicroPython thread
+        return;
+    }
+    #endif
+
+    mp_prof_sample_t *sample = &samples[MP_STATE_VM(prof_sample_count) % MICROPY_PY_MICROPYTHON_PROFILE_SAMPLES];
+    size_t depth = prof_get_frames(sample->frames, MICROPY_PY_MICROPYTHON_PROFILE_DEPTH);
+    if (depth == 0) {
+        // not executing bytecode, eg in native code or the REPL
+        return;
+    }
+    sample->depth = depth;
+    MP_STATE_VM(prof_sample_count) += 1;
+}
+
+void mp_prof_sample_start(mp_uint_t period_us) {
+    mp_prof_sample_stop();
+    if (MP_STATE_VM(prof_samples) == NULL) {
+        MP_STATE_VM(prof_samples) = m_new(mp_prof_sample_t, MICROPY_PY_MICROPYTHON_PROFILE_SAMPLES);
+    }
+    MP_STATE_VM(prof_sample_count) = 0;
+    // the port may raise if its timer is unavailable
+    mp_prof_sample_timer_start(period_us);
+    MP_STATE_VM(prof_sample_running) = true;
+}
+
+void mp_prof_sample_stop(void) {
+    if (MP_STATE_VM(prof_sample_running)) {
+        mp_prof_sample_timer_stop();
+        MP_STATE_VM(prof_sample_running) = false;
+    }
+}
+
+// Return a dict mapping folded stacks (outermost frame first, frames separated
+// by ';') to the number of samples with that stack.
+mp_obj_t mp_prof_sample_dump(void) {
+    mp_obj_t dict = mp_obj_new_dict(0);
+    const mp_prof_sample_t *samples = MP_STATE_VM(prof_samples);
+    if (samples == NULL) {
+        return dict;
+    }
+    size_t n = MP_STATE_VM(prof_sample_count);
+    if (n > MICROPY_PY_MICROPYTHON_PROFILE_SAMPLES) {
+        n = MICROPY_PY_MICROPYTHON_PROFILE_SAMPLES;
+    }
+    vstr_t vstr;
+    mp_print_t print;
+    vstr_init_print(&vstr, 64, &print);
+    for (size_t i = 0; i < n; ++i) {
+        const mp_prof_sample_t *sample = &samples[i];
+        vstr_reset(&vstr);
+        for (size_t j = sample->depth; j-- > 0;) {
+            const mp_prof_sample_frame_t *frame = &sample->frames[j];
+            mp_printf(&print, "%q (%q:%u)%s", frame->block_name, frame->source_file,
+                (uint)frame->source_line, j > 0 ? ";" : "");
+        }
+        mp_obj_t key = mp_obj_new_str(vstr.buf, vstr.len);
+        mp_map_elem_t *elem = mp_map_lookup(mp_obj_dict_get_map(dict), key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+        if (elem->value == MP_OBJ_NULL) {
+            elem->value = MP_OBJ_NEW_SMALL_INT(1);
+        } else {
+            elem->value = MP_OBJ_NEW_SMALL_INT(MP_OBJ_SMALL_INT_VALUE(elem->value) + 1);
+        }
+    }
+    vstr_clear(&vstr);
+    return dict;
+}
+
+#endif // MICROPY_PY_MICROPYTHON_PROFILE
+
+#if MICROPY_PY_MICROPYTHON_ALLOC_STATS
+
+void mp_prof_alloc_clear(void) {
+    memset(MP_STATE_VM(alloc_sites), 0, sizeof(MP_STATE_VM(alloc_sites)));
+    memset(MP_STATE_VM(alloc_site_cache_ip), 0, sizeof(MP_STATE_VM(alloc_site_cache_ip)));
+}
+
+// Find (or create) the entry for the given frame in the table of allocation
+// sites.  Entry 0 is for allocations from unknown sites (or when the table is
+// full), the others are an open-addressed hash table with linear probing where
+// unused entries have a block_name of MP_QSTRnull.
+STATIC size_t prof_alloc_site_lookup(const mp_code_state_t *code_state) {
+    mp_prof_sample_frame_t frame;
+    prof_sample_frame(code_state, &frame);
+
+    mp_alloc_site_t *sites = MP_STATE_VM(alloc_sites);
+    const size_t n_slots = MICROPY_PY_MICROPYTHON_ALLOC_STATS_SITES - 1;
+    size_t pos = 1 + (frame.block_name * 31 + frame.source_file * 7 + frame.source_line) % n_slots;
+    for (size_t i = 0;; ++i) {
+        mp_alloc_site_t *site = &sites[pos];
+        if (site->block_name == MP_QSTRnull) {
+            site->block_name = frame.block_name;
+            site->source_file = frame.source_file;
+            site->source_line = frame.source_line;
+            return pos;
+        }
+        if (site->block_name == frame.block_name && site->source_line == frame.source_line
+            && site->source_file == frame.source_file) {
+            return pos;
+        }
+        if (i + 1 == n_slots) {
+            // table is full
+            return 0;
+        }
+        pos = pos == n_slots ? 1 : pos + 1;
+    }
+}
+
+void mp_prof_alloc_record(size_t n_bytes) {
+    const mp_code_state_t *code_state;
+    #if MICROPY_PY_SYS_SETTRACE
+    code_state = MP_STATE_THREAD(current_code_state);
+    #else
+    const mp_prof_frame_link_t *link = MP_STATE_THREAD(prof_frame_top);
+    code_state = link == NULL ? NULL : link->code_state;
+    #endif
+
+    size_t pos = 0;
+    if (code_state != NULL) {
+        // Decoding the source line of a frame is slow, so remember the site of
+        // recently seen instructions.  A cached ip may be stale if its code
+        // was freed and the memory reused, which at worst misattributes some
+        // allocations.
+        size_t idx = ((uintptr_t)code_state->ip >> 1) % MP_ALLOC_SITE_CACHE_SIZE;
+        if (MP_STATE_VM(alloc_site_cache_ip)[idx] == code_state->ip) {
+            pos = MP_STATE_VM(alloc_site_cache_pos)[idx];
+        } else {
+            pos = prof_alloc_site_lookup(code_state);
+            MP_STATE_VM(alloc_site_cache_ip)[idx] = code_state->ip;
+            MP_STATE_VM(alloc_site_cache_pos)[idx] = pos;
+        }
+    }
+    MP_STATE_VM(alloc_sites)[pos].count += 1;
+    MP_STATE_VM(alloc_sites)[pos].bytes += n_bytes;
+}
+
+// Return a list of the n allocation sites with the most bytes allocated, as
+// (file, function, line, count, bytes) tuples.  Allocations not made from
+// bytecode are reported with file and function set to None.
+mp_obj_t mp_prof_alloc_stats(size_t n) {
+    // Work on a copy of the table, so the allocations made while building the
+    // result don't change it.
+    mp_alloc_site_t *sites = m_new(mp_alloc_site_t, MICROPY_PY_MICROPYTHON_ALLOC_STATS_SITES);
+    memcpy(sites, MP_STATE_VM(alloc_sites), sizeof(MP_STATE_VM(alloc_sites)));
+
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    while (n-- > 0) {
+        // selection of the largest remaining entry, n is small
+        mp_alloc_site_t *best = NULL;
+        for (size_t i = 0; i < MICROPY_PY_MICROPYTHON_ALLOC_STATS_SITES; ++i) {
+            if (sites[i].count != 0 && (best == NULL || sites[i].bytes > best->bytes)) {
+                best = &sites[i];
+            }
+        }
+        if (best == NULL) {
+            break;
+        }
+        mp_obj_t items[5] = {
+            best->source_file == MP_QSTRnull ? mp_const_none : MP_OBJ_NEW_QSTR(best->source_file),
+            best->block_name == MP_QSTRnull ? mp_const_none : MP_OBJ_NEW_QSTR(best->block_name),
+            mp_obj_new_int_from_uint(best->source_line),
+            mp_obj_new_int_from_uint(best->count),
+            mp_obj_new_int_from_uint(best->bytes),
+        };
+        mp_obj_list_append(list, mp_obj_new_tuple(5, items));
+        best->count = 0;
+    }
+
+    m_del(mp_alloc_site_t, sites, MICROPY_PY_MICROPYTHON_ALLOC_STATS_SITES);
+    return list;
+}
+
+#endif // MICROPY_PY_MICROPYTHON_ALLOC_STATS
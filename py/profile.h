@@ -76,4 +76,57 @@ void mp_prof_print_instr(const byte *ip, mp_code_state_t *code_state);
 #endif
 
 #endif // MICROPY_PY_SYS_SETTRACE
+
+#if MICROPY_PROF_FRAME_CHAIN
+// Link in the per-thread chain of active bytecode frames, lives on the C stack
+// of mp_execute_bytecode.
+typedef struct _mp_prof_frame_link_t {
+    const mp_code_state_t *code_state;
+    struct _mp_prof_frame_link_t *prev;
+} mp_prof_frame_link_t;
+#endif
+
+#if MICROPY_PY_MICROPYTHON_PROFILE || MICROPY_PY_MICROPYTHON_ALLOC_STATS
+typedef struct _mp_prof_sample_frame_t {
+    qstr block_name;
+    qstr source_file;
+    size_t source_line;
+} mp_prof_sample_frame_t;
+#endif
+
+#if MICROPY_PY_MICROPYTHON_PROFILE
+
+// Frames are stored innermost first.
+typedef struct _mp_prof_sample_t {
+    size_t depth;
+    mp_prof_sample_frame_t frames[MICROPY_PY_MICROPYTHON_PROFILE_DEPTH];
+} mp_prof_sample_t;
+
+// Record the frames currently executing on this thread, may be called from a
+// timer interrupt or signal handler.
+void mp_prof_sample(void);
+
+// These are the implementation of micropython.profile_start/stop/dump.
+void mp_prof_sample_start(mp_uint_t period_us);
+void mp_prof_sample_stop(void);
+mp_obj_t mp_prof_sample_dump(void);
+
+// Provided by the port: periodically call mp_prof_sample while running.
+void mp_prof_sample_timer_start(mp_uint_t period_us);
+void mp_prof_sample_timer_stop(void);
+
+#endif // MICROPY_PY_MICROPYTHON_PROFILE
+
+#if MICROPY_PY_MICROPYTHON_ALLOC_STATS
+
+// Account an allocation of n_bytes to the bytecode line being executed, called
+// by gc_alloc with the GC locked.
+void mp_prof_alloc_record(size_t n_bytes);
+void mp_prof_alloc_clear(void);
+
+// This is the implementation of micropython.alloc_stats.
+mp_obj_t mp_prof_alloc_stats(size_t n);
+
+#endif // MICROPY_PY_MICROPYTHON_ALLOC_STATS
+
 #endif // MICROPY_INCLUDED_PY_PROFILING_H
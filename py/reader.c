@@ -67,6 +67,61 @@ void mp_reader_new_mem(mp_reader_t *reader, const byte *buf, size_t len, size_t
     reader->close = mp_reader_mem_close;
 }
 
+#if MICROPY_PERSISTENT_CODE_XIP
+
+typedef struct _mp_reader_mapped_t {
+    const byte *beg;
+    const byte *cur;
+    const byte *end;
+    bool used_in_place;
+    void (*unmap)(const byte *buf, size_t len);
+} mp_reader_mapped_t;
+
+STATIC mp_uint_t mp_reader_mapped_readbyte(void *data) {
+    mp_reader_mapped_t *reader = (mp_reader_mapped_t *)data;
+    if (reader->cur < reader->end) {
+        return *reader->cur++;
+    } else {
+        return MP_READER_EOF;
+    }
+}
+
+STATIC void mp_reader_mapped_close(void *data) {
+    mp_reader_mapped_t *reader = (mp_reader_mapped_t *)data;
+    if (!reader->used_in_place && reader->unmap != NULL) {
+        reader->unmap(reader->beg, reader->end - reader->beg);
+    }
+    m_del_obj(mp_reader_mapped_t, reader);
+}
+
+void mp_reader_new_mapped(mp_reader_t *reader, const byte *buf, size_t len, void (*unmap)(const byte *buf, size_t len)) {
+    mp_reader_mapped_t *rm = m_new_obj(mp_reader_mapped_t);
+    rm->beg = buf;
+    rm->cur = buf;
+    rm->end = buf + len;
+    rm->used_in_place = false;
+    rm->unmap = unmap;
+    reader->data = rm;
+    reader->readbyte = mp_reader_mapped_readbyte;
+    reader->close = mp_reader_mapped_close;
+}
+
+const byte *mp_reader_read_mapped(mp_reader_t *reader, size_t len) {
+    if (reader->readbyte != mp_reader_mapped_readbyte) {
+        return NULL;
+    }
+    mp_reader_mapped_t *rm = (mp_reader_mapped_t *)reader->data;
+    if (len > (size_t)(rm->end - rm->cur)) {
+        return NULL;
+    }
+    const byte *buf = rm->cur;
+    rm->cur += len;
+    rm->used_in_place = true;
+    return buf;
+}
+
+#endif
+
 #if MICROPY_READER_POSIX
 
 #include <sys/stat.h>
@@ -145,4 +200,34 @@ void mp_reader_new_file(mp_reader_t *reader, const char *filename) {
 }
 #endif
 
+#if MICROPY_PERSISTENT_CODE_XIP
+
+#include <sys/mman.h>
+
+STATIC void mp_reader_posix_munmap(const byte *buf, size_t len) {
+    munmap((void *)buf, len);
+}
+
+bool mp_reader_new_file_mapped(mp_reader_t *reader, const char *filename) {
+    MP_THREAD_GIL_EXIT();
+    int fd = open(filename, O_RDONLY, 0644);
+    struct stat st;
+    void *buf = MAP_FAILED;
+    if (fd >= 0) {
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            buf = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        // the mapping stays valid after the file is closed
+        close(fd);
+    }
+    MP_THREAD_GIL_ENTER();
+    if (buf == MAP_FAILED) {
+        return false;
+    }
+    mp_reader_new_mapped(reader, buf, st.st_size, mp_reader_posix_munmap);
+    return true;
+}
+
+#endif
+
 #endif
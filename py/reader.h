@@ -43,4 +43,16 @@ void mp_reader_new_mem(mp_reader_t *reader, const byte *buf, size_t len, size_t
 void mp_reader_new_file(mp_reader_t *reader, const char *filename);
 void mp_reader_new_file_from_fd(mp_reader_t *reader, int fd, bool close_fd);
 
+#if MICROPY_PERSISTENT_CODE_XIP
+// A mapped reader reads memory that stays at the same address for the lifetime
+// of the program (eg flash, or an mmap'd file), so mp_reader_read_mapped can
+// return data in place instead of it being copied out.  If none of the data is
+// used that way then unmap (if not NULL) is called when the reader is closed.
+void mp_reader_new_mapped(mp_reader_t *reader, const byte *buf, size_t len, void (*unmap)(const byte *buf, size_t len));
+// returns a pointer to the next len bytes and skips them, or NULL if the reader isn't mapped
+const byte *mp_reader_read_mapped(mp_reader_t *reader, size_t len);
+// maps a whole file (with MICROPY_READER_POSIX), returns false if that isn't possible
+bool mp_reader_new_file_mapped(mp_reader_t *reader, const char *filename);
+#endif
+
 #endif // MICROPY_INCLUDED_PY_READER_H
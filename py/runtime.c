@@ -43,6 +43,7 @@
 #include "py/builtin.h"
 #include "py/stackctrl.h"
 #include "py/gc.h"
+#include "py/profile.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
 #define DEBUG_PRINT (1)
@@ -93,6 +94,10 @@ void mp_init(void) {
     // init global module dict
     mp_obj_dict_init(&MP_STATE_VM(mp_loaded_modules_dict), MICROPY_LOADED_MODULES_DICT_SIZE);
 
+    #if MICROPY_MODULE_IMPORT_CACHE
+    mp_obj_dict_init(&MP_STATE_VM(import_cache), 0);
+    #endif
+
     // initialise the __main__ module
     mp_obj_dict_init(&MP_STATE_VM(dict_main), 1);
     mp_obj_dict_store(MP_OBJ_FROM_PTR(&MP_STATE_VM(dict_main)), MP_OBJ_NEW_QSTR(MP_QSTR___name__), MP_OBJ_NEW_QSTR(MP_QSTR___main__));
@@ -132,12 +137,33 @@ void mp_init(void) {
     MP_STATE_THREAD(current_code_state) = NULL;
     #endif
 
+    #if MICROPY_PROF_FRAME_CHAIN
+    MP_STATE_THREAD(prof_frame_top) = NULL;
+    #endif
+
+    #if MICROPY_PY_MICROPYTHON_PROFILE
+    MP_STATE_VM(prof_samples) = NULL;
+    MP_STATE_VM(prof_sample_count) = 0;
+    MP_STATE_VM(prof_sample_running) = false;
+    #endif
+
+    #if MICROPY_PY_MICROPYTHON_ALLOC_STATS
+    mp_prof_alloc_clear();
+    #endif
+
     #if MICROPY_PY_BLUETOOTH
     MP_STATE_VM(bluetooth) = MP_OBJ_NULL;
     #endif
 
+    #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL && MICROPY_OPT_INSTANCE_SHAPES
+    mp_thread_mutex_init(&MP_STATE_VM(instance_layout_mutex));
+    #endif
+
     #if MICROPY_PY_THREAD_GIL
     mp_thread_mutex_init(&MP_STATE_VM(gil_mutex));
+    #if MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL
+    mp_thread_gil_init();
+    #endif
     #endif
 
     // call port specific initialization if any
@@ -149,6 +175,10 @@ void mp_init(void) {
 }
 
 void mp_deinit(void) {
+    #if MICROPY_PY_MICROPYTHON_PROFILE
+    mp_prof_sample_stop();
+    #endif
+
     MP_THREAD_GIL_EXIT();
 
     // call port specific deinitialization if any
@@ -54,6 +54,13 @@ typedef struct _id_info_t {
     qstr qst;
 } id_info_t;
 
+// Hints about a scope, gathered during the scope pass to resolve MP_EMIT_OPT_NATIVE_AUTO
+enum {
+    SCOPE_HINT_LOOP = 0x01, // contains a loop, so is worth compiling to native code
+    SCOPE_HINT_BYTECODE = 0x02, // uses a feature the native emitter doesn't support
+    SCOPE_HINT_AUTO = 0x04, // the emitter was chosen automatically
+};
+
 #define SCOPE_IS_FUNC_LIKE(s) ((s) >= SCOPE_LAMBDA)
 #define SCOPE_IS_COMP_LIKE(s) (SCOPE_LIST_COMP <= (s) && (s) <= SCOPE_GEN_EXPR)
 
@@ -79,6 +86,7 @@ typedef struct _scope_t {
     uint16_t simple_name; // a qstr
     uint16_t scope_flags;  // see runtime0.h
     uint16_t emit_options; // see emitglue.h
+    uint16_t emit_hints; // see SCOPE_HINT_xxx
     uint16_t num_pos_args;
     uint16_t num_kwonly_args;
     uint16_t num_def_pos_args;
@@ -29,9 +29,18 @@
 
 #include "py/bc0.h"
 #include "py/bc.h"
+#include "py/emitglue.h"
 
 #if MICROPY_DEBUG_PRINTERS
 
+#if MICROPY_PERSISTENT_CODE_XIP
+// qstr table of the code being printed, if it was loaded execute-in-place
+STATIC const uint16_t *mp_showbc_qstr_table;
+#define SHOWBC_QSTR(q) (mp_showbc_qstr_table != NULL ? mp_showbc_qstr_table[q] : (q))
+#else
+#define SHOWBC_QSTR(q) (q)
+#endif
+
 #define DECODE_UINT { \
         unum = 0; \
         do { \
@@ -44,7 +53,7 @@
 #if MICROPY_PERSISTENT_CODE
 
 #define DECODE_QSTR \
-    qst = ip[0] | ip[1] << 8; \
+    qst = SHOWBC_QSTR(ip[0] | ip[1] << 8); \
     ip += 2;
 #define DECODE_PTR \
     DECODE_UINT; \
@@ -79,6 +88,9 @@ const mp_uint_t *mp_showbc_const_table;
 
 void mp_bytecode_print(const mp_print_t *print, const void *descr, const byte *ip, mp_uint_t len, const mp_uint_t *const_table) {
     mp_showbc_code_start = ip;
+    #if MICROPY_PERSISTENT_CODE_XIP
+    mp_showbc_qstr_table = ((const mp_raw_code_t *)descr)->qstr_table;
+    #endif
 
     // Decode prelude
     MP_BC_PRELUDE_SIG_DECODE(ip);
@@ -86,8 +98,8 @@ void mp_bytecode_print(const mp_print_t *print, const void *descr, const byte *i
     const byte *code_info = ip;
 
     #if MICROPY_PERSISTENT_CODE
-    qstr block_name = code_info[0] | (code_info[1] << 8);
-    qstr source_file = code_info[2] | (code_info[3] << 8);
+    qstr block_name = SHOWBC_QSTR(code_info[0] | (code_info[1] << 8));
+    qstr source_file = SHOWBC_QSTR(code_info[2] | (code_info[3] << 8));
     code_info += 4;
     #else
     qstr block_name = mp_decode_uint(&code_info);
@@ -148,6 +160,9 @@ void mp_bytecode_print(const mp_print_t *print, const void *descr, const byte *i
         }
     }
     mp_bytecode_print2(print, ip, len - prelude_size, const_table);
+    #if MICROPY_PERSISTENT_CODE_XIP
+    mp_showbc_qstr_table = NULL;
+    #endif
 }
 
 const byte *mp_bytecode_print_str(const mp_print_t *print, const byte *ip) {
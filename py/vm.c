@@ -66,9 +66,18 @@
 
 #if MICROPY_PERSISTENT_CODE
 
+#if MICROPY_PERSISTENT_CODE_XIP
+#define DECODE_QSTR \
+    qstr qst = ip[0] | ip[1] << 8; \
+    ip += 2; \
+    if (qstr_table != NULL) { \
+        qst = qstr_table[qst]; \
+    }
+#else
 #define DECODE_QSTR \
     qstr qst = ip[0] | ip[1] << 8; \
     ip += 2;
+#endif
 #define DECODE_PTR \
     DECODE_UINT; \
     void *ptr = (void*)(uintptr_t)code_state->fun_bc->const_table[unum]
@@ -172,6 +181,21 @@
     } \
 } while(0)
 
+#elif MICROPY_PROF_FRAME_CHAIN
+
+// Maintain the chain of active frames for the profilers.  The link is pushed
+// once per call of mp_execute_bytecode; with MICROPY_STACKLESS only the
+// innermost frame of a stackless call chain is visible to the profilers.
+#define FRAME_SETUP() do { \
+    prof_link.code_state = code_state; \
+} while (0)
+#define FRAME_ENTER()
+#define FRAME_LEAVE() do { \
+    MP_STATE_THREAD(prof_frame_top) = prof_link.prev; \
+} while (0)
+#define FRAME_UPDATE()
+#define TRACE_TICK(current_ip, current_sp, is_exception)
+
 #else // MICROPY_PY_SYS_SETTRACE
 #define FRAME_SETUP()
 #define FRAME_ENTER()
@@ -219,6 +243,11 @@ mp_vm_return_kind_t MICROPY_WRAP_MP_EXECUTE_BYTECODE(mp_execute_bytecode)(mp_cod
     // loop and the exception handler, leading to very obscure bugs.
     #define RAISE(o) do { nlr_pop(); nlr.ret_val = MP_OBJ_TO_PTR(o); goto exception_handler; } while (0)
 
+#if MICROPY_PROF_FRAME_CHAIN
+    mp_prof_frame_link_t prof_link = { code_state, MP_STATE_THREAD(prof_frame_top) };
+    MP_STATE_THREAD(prof_frame_top) = &prof_link;
+#endif
+
 #if MICROPY_STACKLESS
 run_code_state: ;
 #endif
@@ -237,6 +266,9 @@ FRAME_SETUP();
         fastn = &code_state->state[n_state - 1];
         exc_stack = (mp_exc_stack_t*)(code_state->state + n_state);
     }
+    #if MICROPY_PERSISTENT_CODE_XIP
+    const uint16_t * /*const*/ qstr_table = code_state->fun_bc->qstr_table;
+    #endif
 
     // variables that are visible to the exception handler (declared volatile)
     mp_exc_stack_t *volatile exc_sp = MP_CODE_STATE_EXC_SP_IDX_TO_PTR(exc_stack, code_state->exc_sp_idx); // stack grows up, exc_sp points to top of stack
@@ -369,13 +401,12 @@ dispatch_loop:
                     // and forwards to its members map. Attribute lookups on instance
                     // types are extremely common, so avoid all the other checks and
                     // calls that normally happen first.
-                    mp_map_elem_t *elem = NULL;
+                    mp_obj_t *slot = NULL;
                     if (mp_obj_is_instance_type(mp_obj_get_type(top))) {
-                        mp_obj_instance_t *self = MP_OBJ_TO_PTR(top);
-                        elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP);
+                        slot = mp_obj_instance_lookup_member(MP_OBJ_TO_PTR(top), qst);
                     }
-                    if (elem) {
-                        obj = elem->value;
+                    if (slot) {
+                        obj = *slot;
                     } else
                     #endif
                     {
@@ -1323,8 +1354,12 @@ pending_exception_check:
                     if (MP_STATE_VM(sched_state) == MP_SCHED_IDLE)
                     #endif
                     {
+                    #if MICROPY_PY_THREAD_GIL_SWITCH_INTERVAL
+                    mp_thread_gil_switch();
+                    #else
                     MP_THREAD_GIL_EXIT();
                     MP_THREAD_GIL_ENTER();
+                    #endif
                     }
                 }
                 #endif
@@ -1391,8 +1426,8 @@ unwind_loop:
                 #endif
                 size_t bc = code_state->ip - bytecode_start;
                 #if MICROPY_PERSISTENT_CODE
-                qstr block_name = ip[0] | (ip[1] << 8);
-                qstr source_file = ip[2] | (ip[3] << 8);
+                qstr block_name = mp_obj_fun_bc_get_qstr(code_state->fun_bc, ip[0] | (ip[1] << 8));
+                qstr source_file = mp_obj_fun_bc_get_qstr(code_state->fun_bc, ip[2] | (ip[3] << 8));
                 ip += 4;
                 #else
                 qstr block_name = mp_decode_uint_value(ip);
@@ -0,0 +1,75 @@
+# test instance attributes set in the same and in different orders
+
+if not hasattr(int, "__dict__"):
+    print("SKIP")
+    raise SystemExit
+
+
+class A:
+    def __init__(self, a, b):
+        self.a = a
+        self.b = b
+
+
+def dump(o):
+    return sorted(o.__dict__.items())
+
+
+# instances following the same order
+x = A(1, 2)
+y = A(3, 4)
+print(x.a, x.b, y.a, y.b)
+x.a = 5
+print(x.a, y.a)
+
+# extend one instance beyond the others
+x.c = 6
+print(dump(x), dump(y))
+z = A(7, 8)
+print(dump(z), hasattr(z, "c"))
+z.c = 9
+print(dump(z))
+
+# set attributes in a different order
+w = object.__new__(A)
+w.b = 10
+w.a = 11
+w.d = 12
+print(w.a, w.b, w.d, dump(w))
+
+# delete the most recent attribute and then add it back
+del z.c
+print(dump(z), hasattr(z, "c"))
+z.c = 13
+print(dump(z))
+
+# delete an attribute in the middle
+del z.a
+print(dump(z), hasattr(z, "a"))
+z.a = 14
+print(dump(z))
+
+try:
+    del y.c
+except AttributeError:
+    print("AttributeError")
+
+# many attributes
+o = A(0, 0)
+for i in range(300):
+    setattr(o, "attr%d" % i, i)
+print(sum(getattr(o, "attr%d" % i) for i in range(300)), len(o.__dict__))
+p = A(0, 0)
+for i in range(300):
+    setattr(p, "attr%d" % (299 - i), i)
+print(sum(getattr(p, "attr%d" % i) for i in range(300)), len(p.__dict__))
+
+# subclass with its own attributes
+class B(A):
+    def __init__(self):
+        self.e = 15
+        super().__init__(16, 17)
+
+
+b = B()
+print(dump(b), dump(A(18, 19)))
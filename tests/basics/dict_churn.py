@@ -0,0 +1,37 @@
+# test dicts under many insertions and deletions, to exercise resizing and
+# reuse of deleted slots
+
+# keys of different types, and a key that is removed and re-added many times
+d = {}
+for i in range(200):
+    d[i] = i
+    d[str(i)] = i
+    if i % 3 == 0:
+        del d[i // 2]
+    d["x"] = i
+    del d["x"]
+print(len(d), sorted(k for k in d if isinstance(k, int))[:20])
+print(sum(d[k] for k in d if isinstance(k, str)))
+
+# a window of keys moving through the dict
+d = {}
+for i in range(1000):
+    d[i] = i
+    if i >= 10:
+        del d[i - 10]
+print(len(d), sorted(d))
+
+# empty the dict completely and use it again
+for k in list(d):
+    del d[k]
+print(len(d), d)
+d[1] = 2
+print(d)
+
+# popitem until empty
+d = {i: -i for i in range(50)}
+n = 0
+while d:
+    k, v = d.popitem()
+    n += k + v
+print(n, d)
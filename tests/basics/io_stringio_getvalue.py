@@ -0,0 +1,53 @@
+# test that getvalue() results are not changed by later writes
+
+try:
+    import uio as io
+except ImportError:
+    import io
+
+# many small writes
+s = io.StringIO()
+for i in range(1000):
+    s.write("<%d>" % i)
+v = s.getvalue()
+print(len(v), v[:20], v[-20:])
+
+# write, read and seek after getvalue
+s.write("end")
+print(len(v), v[-10:], s.getvalue()[-10:])
+s.seek(0)
+print(s.read(10))
+s.seek(4)
+s.write("XX")
+v2 = s.getvalue()
+print(v[:10], v2[:10])
+print(s.getvalue() == v2, s.getvalue()[:10])
+
+# getvalue twice in a row, and with nothing written
+s = io.StringIO()
+print(repr(s.getvalue()), repr(s.getvalue()))
+s.write("abc")
+print(s.getvalue(), s.getvalue())
+s.write("def")
+print(s.getvalue())
+
+# initialised from a str or bytes
+s = io.StringIO("init")
+print(s.getvalue())
+s.seek(0, 2)
+s.write("ial")
+print(s.getvalue())
+b = io.BytesIO(b"\x00\x01")
+print(b.getvalue())
+b.write(b"\xff")
+v = b.getvalue()
+b.write(b"\xfe" * 100)
+print(v, len(b.getvalue()))
+
+# seek past the end and write, leaving a gap of zero bytes
+b = io.BytesIO()
+b.write(b"12")
+v = b.getvalue()
+b.seek(6)
+b.write(b"3")
+print(v, b.getvalue())
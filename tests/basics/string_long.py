@@ -0,0 +1,39 @@
+# test str and bytes methods on strings longer than a machine word, so that
+# matches fall at every offset within a word
+
+try:
+    str.count
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+s = "".join("ab" + str(i) + "c " for i in range(40)) + "Zz\tlast"
+b = bytes(s, "ascii")
+
+for x in (s, b):
+    t = type(x)
+    for needle in ("a", "c ", "b39c", "ab1", "Zz", "last", "t", "zz", "ab40", " "):
+        n = t(needle, "ascii") if t is bytes else needle
+        print(x.find(n), x.rfind(n), x.count(n), n in x)
+    print(x.find(t("c", "ascii") if t is bytes else "c", 17, 60))
+    print(x.count(t("b", "ascii") if t is bytes else "b", 5, 50))
+    print(x.split()[:3], x.split()[-3:], len(x.split()))
+    print(x.split(None, 2)[-1][:10])
+    print(x.replace(t("c ", "ascii") if t is bytes else "c ", t("-", "ascii") if t is bytes else "-")[:40])
+    print(x.upper()[-20:], x.lower()[-20:])
+
+# non-ASCII bytes are left alone by case conversion
+print(bytes(range(256)).upper() == bytes(c - 32 if 97 <= c <= 122 else c for c in range(256)))
+print(bytes(range(256)).lower() == bytes(c + 32 if 65 <= c <= 90 else c for c in range(256)))
+print(b"\xc1\xe1AZaz@[`{" * 5)
+print((b"\xc1\xe1AZaz@[`{" * 5).upper())
+print((b"\xc1\xe1AZaz@[`{" * 5).lower())
+
+# whitespace of every kind, long runs of it and long runs without
+w = " \t\n\r\v\f" * 3 + "x" * 20 + "\x0b" + "y" * 3 + "  "
+print(w.split())
+print(("word " * 30).split() == ["word"] * 30)
+print(w.strip(), len(w.lstrip()), len(w.rstrip()))
+
+# a byte that is not the start of a UTF-8 character
+print(b"\xc3\xa9\xc3\xa9".count(b"\xa9"), b"\xc3\xa9\xc3\xa9".find(b"\xa9\xc3"))
@@ -0,0 +1,57 @@
+# test ustruct.Struct objects and iter_unpack
+
+try:
+    import ustruct as struct
+except:
+    try:
+        import struct
+    except ImportError:
+        print("SKIP")
+        raise SystemExit
+try:
+    struct.Struct
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+s = struct.Struct("<hHb3sI")
+print(s.size, s.format)
+b = s.pack(-1, 2, 3, b"ab", 100)
+print(b)
+print(s.unpack(b))
+
+# native alignment is the same as for the module functions
+for fmt in ("@bi2h", "bhb", "<bi2h", ">2s2h", "0h2b", "10s"):
+    s = struct.Struct(fmt)
+    print(fmt, s.size == struct.calcsize(fmt))
+
+# unpack_from and pack_into with offsets
+s = struct.Struct(">HBb")
+buf = bytearray(10)
+s.pack_into(buf, 2, 0x1234, 0x56, -1)
+s.pack_into(buf, -4, 1, 2, 3)
+print(buf)
+print(s.unpack_from(buf, 2))
+print(s.unpack_from(buf, -4))
+print(s.unpack_from(buf))
+
+try:
+    s.unpack_from(buf, 8)
+except:
+    print("Exception")
+try:
+    s.pack_into(buf, -11, 1, 2, 3)
+except:
+    print("Exception")
+
+# iter_unpack
+s = struct.Struct("<hb")
+data = bytes(range(12))
+for x in s.iter_unpack(data):
+    print(x)
+print(list(struct.iter_unpack("<2H", data)))
+print(list(struct.iter_unpack("<2H", b"")))
+try:
+    s.iter_unpack(b"12345")
+except:
+    print("Exception")
@@ -0,0 +1,38 @@
+# test MicroPython-specific features of ustruct.Struct: unpacking into an
+# existing list or array
+
+try:
+    import ustruct as struct
+    import uarray as array
+
+    struct.Struct
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+s = struct.Struct("<hH2s")
+data = b"\xff\xff\x02\x00ab\x01\x00\x03\x00cd"
+
+out = [None] * 3
+r = s.unpack_from(data, 6, out)
+print(r is out, out)
+
+# the same list is filled in and returned on each iteration
+for r in s.iter_unpack(data, out):
+    print(r is out, out)
+
+# any object supporting item assignment can be used
+s = struct.Struct("<3h")
+a = array.array("h", [0, 0, 0])
+print(s.unpack_from(b"\x01\x00\x02\x00\x03\x00", 0, a))
+for r in s.iter_unpack(b"\x01\x00\x02\x00\x03\x00\xff\xff\xfe\xff\xfd\xff", a):
+    print(r)
+
+# None means return a new tuple
+print(s.unpack_from(b"\x01\x00\x02\x00\x03\x00", 0, None))
+
+# the list must be the right length
+try:
+    s.unpack_from(b"\x01\x00\x02\x00\x03\x00", 0, [0])
+except ValueError:
+    print("ValueError")
@@ -0,0 +1,61 @@
+# cmdline: -X emit=auto
+# test automatic selection of the native emitter
+
+
+# has a loop, so compiled to native code
+def loop(n):
+    s = 0
+    for i in range(n):
+        s += i
+    return s
+
+
+print(loop(0), loop(10))
+
+
+# a local that is unbound after a loop that doesn't run
+def loop_var(n):
+    for i in range(n):
+        pass
+    return i
+
+
+print(loop_var(3))
+try:
+    loop_var(0)
+except NameError:
+    print("NameError")
+
+
+# bare raise isn't supported by the native emitter, so this stays bytecode
+def reraise(n):
+    while n:
+        n -= 1
+    try:
+        raise ValueError(n)
+    except ValueError:
+        raise
+
+
+try:
+    reraise(2)
+except ValueError as er:
+    print("ValueError", er)
+
+
+# generators, methods, lambdas and comprehensions
+def gen(n):
+    i = 0
+    while i < n:
+        yield i
+        i += 1
+
+
+class A:
+    def __init__(self, n):
+        self.items = []
+        for i in range(n):
+            self.items.append(i * i)
+
+
+print(list(gen(4)), A(4).items, (lambda x: x + 1)(2), [x + 1 for x in range(3)])
@@ -0,0 +1,81 @@
+# test arrayops module
+
+try:
+    import arrayops
+    import array
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+# scalar and element-wise add, with saturation
+a = array.array("h", [1, -2, 30000, -30000])
+arrayops.add(a, 5000)
+print(a)
+arrayops.add(a, array.array("h", [-1, 2, 3, -4]))
+print(a)
+
+# multiply by int and float scalars
+arrayops.mul(a, 2)
+print(a)
+arrayops.mul(a, -1)
+print(a)
+
+# large scalars clamp rather than overflow
+b = array.array("I", [1, 4000000000])
+arrayops.mul(b, 10**30)
+print(b)
+arrayops.add(b, -(10**30))
+print(b)
+
+# clip
+a = array.array("b", [-128, -5, 0, 5, 127])
+arrayops.clip(a, -10, 10)
+print(a)
+arrayops.clip(a, -1000, 3)
+print(a)
+
+# reductions
+a = array.array("i", [2147483647] * 3 + [-5])
+print(arrayops.sum(a), arrayops.min(a), arrayops.max(a))
+a = array.array("H", [1, 2, 3])
+print(arrayops.dot(a, array.array("H", [4, 5, 6])))
+
+# bytearray and memoryview
+u = bytearray([250, 10, 0])
+arrayops.add(u, 10)
+print(u)
+arrayops.add(memoryview(u)[1:], -15)
+print(u)
+print(arrayops.sum(memoryview(u)), arrayops.sum(b""))
+
+# conversion between typecodes
+a = array.array("h", [-300, -1, 0, 1, 300])
+u = array.array("B", [0] * 5)
+arrayops.convert(u, a)
+print(u)
+arrayops.convert(a, u)
+print(a)
+arrayops.convert(u, b"\x01\x02\x03\x04\x05")
+print(u)
+
+# errors
+try:
+    arrayops.add(array.array("h", [1]), array.array("i", [1]))
+except TypeError:
+    print("TypeError")
+try:
+    arrayops.add(array.array("h", [1]), array.array("h", [1, 2]))
+except ValueError:
+    print("ValueError")
+try:
+    arrayops.convert(array.array("h", [1]), array.array("h", [1, 2]))
+except ValueError:
+    print("ValueError")
+try:
+    arrayops.max(bytearray())
+except ValueError:
+    print("ValueError")
+try:
+    arrayops.add(b"abc", 1)
+except TypeError:
+    print("TypeError")
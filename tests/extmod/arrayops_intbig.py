@@ -0,0 +1,26 @@
+# test arrayops results that don't fit in 64 bits, and exact int conversions
+
+try:
+    import arrayops
+    import array
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+# products and sums of 32-bit elements
+a = array.array("I", [0xFFFFFFFF])
+print(arrayops.dot(a, a))
+a = array.array("I", [0xFFFFFFFF] * 3)
+print(arrayops.dot(a, a), arrayops.sum(a))
+a = array.array("i", [-(2**31)] * 2)
+print(arrayops.dot(a, a))
+a = array.array("i", [-(2**31), 2**31 - 1, 5, -7])
+print(arrayops.dot(a, array.array("i", [3, -(2**31), -1, 9])))
+
+# conversions between integer typecodes are exact
+a = array.array("i", [0] * 3)
+arrayops.convert(a, array.array("I", [16777217, 0xFFFFFFFF, 2**31]))
+print(a)
+u = array.array("I", [0] * 3)
+arrayops.convert(u, array.array("i", [2147483647, 16777217, -5]))
+print(u)
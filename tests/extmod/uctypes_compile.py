@@ -0,0 +1,57 @@
+# test uctypes.compile: compiled descriptors behave the same as dicts
+
+try:
+    import uctypes
+
+    uctypes.compile
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+desc = {
+    "u8": uctypes.UINT8 | 0,
+    "i8": uctypes.INT8 | 1,
+    "u16": uctypes.UINT16 | 2,
+    "i32": uctypes.INT32 | 4,
+    "bf0": uctypes.BFUINT16 | 2 | 0 << uctypes.BF_POS | 4 << uctypes.BF_LEN,
+    "bf1": uctypes.BFUINT16 | 2 | 4 << uctypes.BF_POS | 8 << uctypes.BF_LEN,
+    "sub": (8, {"a": uctypes.UINT8 | 0, "b": uctypes.UINT16 | 2}),
+    "arr": (uctypes.ARRAY | 12, uctypes.UINT8 | 4),
+    "arr16": (uctypes.ARRAY | 12, uctypes.UINT16 | 2),
+    "arrs": (uctypes.ARRAY | 8, 2, {"a": uctypes.UINT8 | 0, "b": uctypes.UINT8 | 1}),
+}
+cdesc = uctypes.compile(desc)
+print(type(cdesc))
+print(uctypes.compile(cdesc) is cdesc)
+print(uctypes.sizeof(desc), uctypes.sizeof(cdesc))
+
+for layout in (uctypes.LITTLE_ENDIAN, uctypes.BIG_ENDIAN, uctypes.NATIVE):
+    buf1 = bytearray(range(16))
+    buf2 = bytearray(range(16))
+    s1 = uctypes.struct(uctypes.addressof(buf1), desc, layout)
+    s2 = uctypes.struct(uctypes.addressof(buf2), cdesc, layout)
+    print(uctypes.sizeof(s2))
+    for f in ("u8", "i8", "u16", "i32", "bf0", "bf1"):
+        print(f, getattr(s1, f) == getattr(s2, f))
+    for f, v in (("u8", 200), ("i8", -3), ("u16", 0x1234), ("i32", -100), ("bf0", 9), ("bf1", 0xAB)):
+        setattr(s1, f, v)
+        setattr(s2, f, v)
+        print(f, getattr(s2, f), buf1 == buf2)
+    print(s1.sub.a == s2.sub.a, s1.sub.b == s2.sub.b)
+    s2.sub.b = 0x4321
+    s1.sub.b = 0x4321
+    print(hex(s2.sub.b), buf1 == buf2)
+    print(s2.arr, s2.arr16[1] == s1.arr16[1], s2.arrs[1].b)
+
+try:
+    s2.missing
+except KeyError:
+    print("KeyError")
+try:
+    s2.sub = 1
+except TypeError:
+    print("TypeError")
+try:
+    uctypes.compile(1)
+except TypeError:
+    print("TypeError")
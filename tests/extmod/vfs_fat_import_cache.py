@@ -0,0 +1,69 @@
+# test that the import cache matches module names on FAT regardless of case
+
+import usys
+
+try:
+    import uos
+
+    uos.VfsFat
+    usys.path_importer_cache
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+
+class RAMFS:
+
+    SEC_SIZE = 512
+
+    def __init__(self, blocks):
+        self.data = bytearray(blocks * self.SEC_SIZE)
+
+    def readblocks(self, n, buf):
+        for i in range(len(buf)):
+            buf[i] = self.data[n * self.SEC_SIZE + i]
+
+    def writeblocks(self, n, buf):
+        for i in range(len(buf)):
+            self.data[n * self.SEC_SIZE + i] = buf[i]
+
+    def ioctl(self, op, arg):
+        if op == 4:  # MP_BLOCKDEV_IOCTL_BLOCK_COUNT
+            return len(self.data) // self.SEC_SIZE
+        if op == 5:  # MP_BLOCKDEV_IOCTL_BLOCK_SIZE
+            return self.SEC_SIZE
+
+
+try:
+    bdev = RAMFS(50)
+except MemoryError:
+    print("SKIP")
+    raise SystemExit
+
+uos.VfsFat.mkfs(bdev)
+uos.mount(uos.VfsFat(bdev), "/ramdisk")
+usys.path.append("/ramdisk")
+
+# 8.3 names are listed in upper case
+with open("/ramdisk/FATMOD1.PY", "w") as f:
+    f.write("print('in fatmod1')")
+uos.mkdir("/ramdisk/FATPKG")
+with open("/ramdisk/FATPKG/__INIT__.PY", "w") as f:
+    f.write("print('in fatpkg')")
+print(sorted(uos.listdir("/ramdisk")))
+
+import fatmod1
+import fatpkg
+
+# a new file is found, writing it invalidated the cache
+with open("/ramdisk/fatmod2.py", "w") as f:
+    f.write("print('in fatmod2')")
+import fatmod2
+
+try:
+    import fatmod3
+except ImportError:
+    print("ImportError")
+
+uos.umount("/ramdisk")
+usys.path.pop()
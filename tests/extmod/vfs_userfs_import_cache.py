@@ -0,0 +1,124 @@
+# test that imports from a user-defined filesystem use the import cache
+
+import usys
+
+try:
+    import uio
+
+    uio.IOBase
+    import uos
+
+    uos.mount
+    usys.path_importer_cache
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+
+class UserFile(uio.IOBase):
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def readinto(self, buf):
+        n = 0
+        while n < len(buf) and self.pos < len(self.data):
+            buf[n] = self.data[self.pos]
+            n += 1
+            self.pos += 1
+        return n
+
+    def ioctl(self, req, arg):
+        return 0
+
+
+class UserFSNoList:
+    def __init__(self, files):
+        self.files = files
+        self.mtime = 0
+
+    def mount(self, readonly, mksfs):
+        pass
+
+    def umount(self):
+        pass
+
+    def stat(self, path):
+        print("stat", path)
+        if path in self.files:
+            return (32768, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+        prefix = path.rstrip("/") + "/"
+        for f in self.files:
+            if f.startswith(prefix):
+                return (16384, 0, 0, 0, 0, 0, 0, 0, self.mtime, 0)
+        raise OSError
+
+    def open(self, path, mode):
+        print("open", path, mode)
+        return UserFile(self.files[path])
+
+
+class UserFS(UserFSNoList):
+    def add(self, path, data):
+        self.files[path] = data
+        self.mtime += 1
+
+    def ilistdir(self, path):
+        print("ilistdir", path)
+        prefix = path.rstrip("/") + "/"
+        names = set()
+        for f in self.files:
+            if f.startswith(prefix):
+                names.add(f[len(prefix) :].split("/")[0])
+        for name in sorted(names):
+            if prefix + name in self.files:
+                yield (name, 0x8000, 0)
+            else:
+                yield (name, 0x4000, 0)
+
+
+user_files = {
+    "/usermod1.py": b"print('in usermod1')\nimport usermod2",
+    "/usermod2.py": b"print('in usermod2')",
+    "/userpkg/__init__.py": b"print('in userpkg')",
+    "/userpkg/mod.py": b"print('in userpkg.mod')",
+}
+userfs = UserFS(user_files)
+uos.mount(userfs, "/userfs")
+usys.path.append("/userfs")
+
+# each directory is listed once, and stat'ed once per import to check that it
+# didn't change
+import usermod1
+import userpkg.mod
+
+# a module that doesn't exist is resolved from the cached listings
+try:
+    import usermod3
+except ImportError:
+    print("ImportError")
+
+# a module added behind the back of the cache is found when the directory
+# changes
+userfs.add("/usermod3.py", b"print('in usermod3')")
+import usermod3
+
+# clearing the cache lists the directory again
+usys.path_importer_cache.clear()
+del usys.modules["usermod2"]
+import usermod2
+
+# unmounting invalidates the cache
+uos.umount("/userfs")
+print("/userfs" in usys.path_importer_cache)
+usys.path.pop()
+
+
+# a filesystem without ilistdir is not cached, and imports from it only stat
+# the candidate files
+uos.mount(UserFSNoList({"/usermod4.py": b"print('in usermod4')"}), "/userfs")
+usys.path.append("/userfs")
+import usermod4
+
+uos.umount("/userfs")
+usys.path.pop()
@@ -0,0 +1,47 @@
+# test arrayops module with float arrays
+
+try:
+    import arrayops
+    import array
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+a = array.array("f", [1, 2, 3, 4])
+arrayops.add(a, 0.5)
+print(a)
+arrayops.mul(a, 2)
+print(a)
+arrayops.add(a, array.array("f", [1, 1, 1, 1]))
+print(a)
+arrayops.clip(a, 5, 8.5)
+print(a)
+print(arrayops.sum(a), arrayops.min(a), arrayops.max(a))
+print(arrayops.dot(a, a))
+
+# float scalar on an integer array is truncated and clamped
+h = array.array("h", [1000, -1000, 30000, -30000])
+arrayops.mul(h, 1.55)
+print(h)
+
+# conversion to and from float
+arrayops.convert(a, h)
+print(a)
+a = array.array("f", [-1e10, -1.9, 1.9, 1e10])
+h = array.array("h", [0] * 4)
+arrayops.convert(h, a)
+print(h)
+
+# out of range and nan saturate when stored into integer arrays
+a = array.array("i", [0] * 4)
+arrayops.convert(a, array.array("f", [3e9, -3e9, float("nan"), 1000.5]))
+print(a)
+u = array.array("I", [0] * 3)
+arrayops.convert(u, array.array("d", [5e9, -1.5, 0.5]))
+print(u)
+
+a = array.array("i", [2**29, -(2**29), 3])
+arrayops.mul(a, 8.0)
+print(a)
+arrayops.add(a, 1e12)
+print(a)
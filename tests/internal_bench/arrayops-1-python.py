@@ -0,0 +1,18 @@
+# Apply gain to 65536 16-bit audio samples and mix in a second track, in Python
+import bench
+import array
+
+
+def test(num):
+    n = 65536
+    voice = array.array("h", range(-n // 2, n // 2))
+    music = array.array("h", [1000] * n)
+    out = array.array("h", voice)
+    for i in iter(range(num // 1000000)):
+        out[:] = voice
+        for j in range(n):
+            v = (out[j] * 3 >> 2) + music[j]
+            out[j] = -32768 if v < -32768 else 32767 if v > 32767 else v
+
+
+bench.run(test)
@@ -0,0 +1,18 @@
+# Apply gain to 65536 16-bit audio samples and mix in a second track, with arrayops
+import bench
+import array
+import arrayops
+
+
+def test(num):
+    n = 65536
+    voice = array.array("h", range(-n // 2, n // 2))
+    music = array.array("h", [1000] * n)
+    out = array.array("h", voice)
+    for i in iter(range(num // 1000000)):
+        out[:] = voice
+        arrayops.mul(out, 0.75)
+        arrayops.add(out, music)
+
+
+bench.run(test)
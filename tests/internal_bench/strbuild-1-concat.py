@@ -0,0 +1,12 @@
+# Build a string from 10000 pieces with +=
+import bench
+
+
+def test(num):
+    for i in iter(range(num // 1000000)):
+        s = ""
+        for j in range(10000):
+            s += "<td>piece</td>"
+
+
+bench.run(test)
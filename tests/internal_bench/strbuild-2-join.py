@@ -0,0 +1,13 @@
+# Build a string from 10000 pieces collected in a list
+import bench
+
+
+def test(num):
+    for i in iter(range(num // 1000000)):
+        l = []
+        for j in range(10000):
+            l.append("<td>piece</td>")
+        s = "".join(l)
+
+
+bench.run(test)
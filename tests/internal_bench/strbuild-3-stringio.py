@@ -0,0 +1,14 @@
+# Build a string from 10000 pieces written to a StringIO
+import bench
+import uio
+
+
+def test(num):
+    for i in iter(range(num // 1000000)):
+        b = uio.StringIO()
+        for j in range(10000):
+            b.write("<td>piece</td>")
+        s = b.getvalue()
+
+
+bench.run(test)
@@ -0,0 +1,11 @@
+# str.find of a needle near the end of a large string
+import bench
+
+
+def test(num):
+    s = "abcdefgh" * 8192 + "needle"
+    for i in iter(range(num // 40000)):
+        s.find("needle")
+
+
+bench.run(test)
@@ -0,0 +1,11 @@
+# str.count of a single character in a large string
+import bench
+
+
+def test(num):
+    s = ("x" * 63 + "\n") * 1024
+    for i in iter(range(num // 40000)):
+        s.count("\n")
+
+
+bench.run(test)
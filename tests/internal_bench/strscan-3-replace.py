@@ -0,0 +1,11 @@
+# str.replace with a few matches in a large string
+import bench
+
+
+def test(num):
+    s = ("a" * 1023 + ";") * 64
+    for i in iter(range(num // 40000)):
+        s.replace(";", ",")
+
+
+bench.run(test)
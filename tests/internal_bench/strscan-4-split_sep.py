@@ -0,0 +1,11 @@
+# str.split on a separator, of a large string with long lines
+import bench
+
+
+def test(num):
+    s = ("y" * 255 + "\n") * 256
+    for i in iter(range(num // 40000)):
+        s.split("\n")
+
+
+bench.run(test)
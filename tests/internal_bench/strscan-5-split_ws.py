@@ -0,0 +1,11 @@
+# str.split on whitespace, of log lines with long fields
+import bench
+
+
+def test(num):
+    s = "2021-01-01T00:00:00 gateway[1234]: received_message_from_device_00112233 len=512\n" * 256
+    for i in iter(range(num // 40000)):
+        s.split()
+
+
+bench.run(test)
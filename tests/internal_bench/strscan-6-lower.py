@@ -0,0 +1,11 @@
+# str.lower of a large mixed-case string
+import bench
+
+
+def test(num):
+    s = "Mixed Case Text 0123; " * 2048
+    for i in iter(range(num // 40000)):
+        s.lower()
+
+
+bench.run(test)
@@ -0,0 +1,11 @@
+# bytes.strip of a large buffer padded with whitespace
+import bench
+
+
+def test(num):
+    s = b" \t" * 1024 + b"z" * 1024 + b"\r\n" * 1024
+    for i in iter(range(num // 40000)):
+        s.strip()
+
+
+bench.run(test)
@@ -0,0 +1,11 @@
+# str.join of many short pieces
+import bench
+
+
+def test(num):
+    l = ["piece%d" % i for i in range(4096)]
+    for i in iter(range(num // 40000)):
+        ",".join(l)
+
+
+bench.run(test)
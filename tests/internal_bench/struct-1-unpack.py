@@ -0,0 +1,13 @@
+# Unpack 100 sensor records with the ustruct.unpack_from function
+import bench
+import ustruct
+
+
+def test(num):
+    buf = bytes(range(256)) * 4
+    for i in iter(range(num // 10000)):
+        for off in range(0, 1000, 10):
+            ustruct.unpack_from("<hhhHH", buf, off)
+
+
+bench.run(test)
@@ -0,0 +1,14 @@
+# Unpack 100 sensor records with a precompiled ustruct.Struct
+import bench
+import ustruct
+
+
+def test(num):
+    buf = bytes(range(256)) * 4
+    s = ustruct.Struct("<hhhHH")
+    for i in iter(range(num // 10000)):
+        for off in range(0, 1000, 10):
+            s.unpack_from(buf, off)
+
+
+bench.run(test)
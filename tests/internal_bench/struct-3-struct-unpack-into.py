@@ -0,0 +1,15 @@
+# Unpack 100 sensor records into a preallocated list with ustruct.Struct
+import bench
+import ustruct
+
+
+def test(num):
+    buf = bytes(range(256)) * 4
+    s = ustruct.Struct("<hhhHH")
+    out = [0] * 5
+    for i in iter(range(num // 10000)):
+        for off in range(0, 1000, 10):
+            s.unpack_from(buf, off, out)
+
+
+bench.run(test)
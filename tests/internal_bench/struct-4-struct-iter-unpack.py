@@ -0,0 +1,15 @@
+# Unpack 100 sensor records into a preallocated list with Struct.iter_unpack
+import bench
+import ustruct
+
+
+def test(num):
+    buf = (bytes(range(256)) * 4)[:1000]
+    s = ustruct.Struct("<hhhHH")
+    out = [0] * 5
+    for i in iter(range(num // 10000)):
+        for x in s.iter_unpack(buf, out):
+            pass
+
+
+bench.run(test)
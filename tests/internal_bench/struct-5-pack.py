@@ -0,0 +1,12 @@
+# Pack 100 sensor records with the ustruct.pack function
+import bench
+import ustruct
+
+
+def test(num):
+    for i in iter(range(num // 10000)):
+        for j in range(100):
+            ustruct.pack("<hhhHH", j, -j, 100, 200, 300)
+
+
+bench.run(test)
@@ -0,0 +1,13 @@
+# Pack 100 sensor records with a precompiled ustruct.Struct
+import bench
+import ustruct
+
+
+def test(num):
+    s = ustruct.Struct("<hhhHH")
+    for i in iter(range(num // 10000)):
+        for j in range(100):
+            s.pack(j, -j, 100, 200, 300)
+
+
+bench.run(test)
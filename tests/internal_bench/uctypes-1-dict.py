@@ -0,0 +1,25 @@
+# Read and write scalar and bitfield fields of a register map described by a dict
+import bench
+import uctypes
+
+desc = {
+    "ctrl": uctypes.UINT32 | 0,
+    "status": uctypes.UINT16 | 4,
+    "count": uctypes.UINT16 | 6,
+    "data": uctypes.INT32 | 8,
+    "mode": uctypes.BFUINT32 | 0 | 4 << uctypes.BF_POS | 3 << uctypes.BF_LEN,
+    "enable": uctypes.BFUINT32 | 0 | 0 << uctypes.BF_POS | 1 << uctypes.BF_LEN,
+}
+
+
+def test(num):
+    buf = bytearray(16)
+    regs = uctypes.struct(uctypes.addressof(buf), desc, uctypes.LITTLE_ENDIAN)
+    for i in iter(range(num // 20)):
+        regs.enable = 1
+        regs.mode = regs.status & 7
+        regs.count = regs.count + 1
+        regs.data = regs.ctrl
+
+
+bench.run(test)
@@ -0,0 +1,31 @@
+# test micropython.alloc_stats
+
+import micropython
+
+try:
+    micropython.alloc_stats
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+
+def f():
+    for i in range(100):
+        bytearray(100)
+
+
+# reset the counters, then profile a known allocation site
+micropython.alloc_stats(0, True)
+f()
+stats = micropython.alloc_stats(1)
+print(len(stats))
+file, name, line, count, size = stats[0]
+print(name, count >= 100, size >= 100 * 100)
+
+# entries are sorted by size
+stats = micropython.alloc_stats(100)
+print(all(stats[i][4] >= stats[i + 1][4] for i in range(len(stats) - 1)))
+
+# clearing
+micropython.alloc_stats(0, True)
+print(sum(s[3] for s in micropython.alloc_stats(100)) < 10)
@@ -0,0 +1,27 @@
+# test that one instance with many attributes doesn't make later ones larger
+
+try:
+    import usys as sys
+
+    sys.getsizeof
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+
+class A:
+    def __init__(self, n):
+        for i in range(n):
+            setattr(self, "a%d" % i, i)
+
+
+A(2)
+small = sys.getsizeof(A(2))
+print(sys.getsizeof(A(2)) == small)
+
+# the instance created right after a large one may be preallocated for it,
+# but not the ones after that
+A(200)
+A(2)
+print(sys.getsizeof(A(2)) == small)
+print(sys.getsizeof(A(200)) > small)
@@ -0,0 +1,75 @@
+# test importing an .mpy file saved with the execute-in-place layout (mpy-cross -mxip)
+
+try:
+    import usys, uos
+
+    uos.remove
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+# generated by: mpy-cross -mxip -s xipmod.py xipmod.py
+# def f(a, b=2, *, c=3):
+#     return a + b + c
+#
+#
+# def g(n):
+#     x = "x"
+#     for i in range(n):
+#         yield x * i
+#
+#
+# class C:
+#     def __init__(self, v):
+#         self.v = v
+#
+#     def get(self):
+#         return self.v, 1.5, b"\x01"
+#
+#
+# def fail():
+#     raise ValueError("fail")
+mpy = (
+    b"M\x05\x03\x1f\x13\x00\x07\x12xipmod.py\x02c\x02f\x02g\x02C\x08fa"
+    b"il\x02a\x02b\x02x\x02n\x00\x17\x00\x16\x00\x1a\x00\x11\x00V\x02v"
+    b"\x00\x89\x007\x81L\x18\x16\x00\x00\x01\x00o e`\x8b\x08\x00\x82*"
+    b"\x01,\x00\x83\x10\x02\x00b3\x00\x16\x03\x002\x01\x16\x04\x00T2"
+    b"\x02\x10\x05\x004\x02\x16\x05\x002\x03\x16\x06\x00Qc\x00\x04H"
+    b"\xa2\x89\x80\x80@\x0c\x03\x00\x01\x00 \x00\xb0\xb1\xf2\xb2\xf2c"
+    b"\x00\x00\x07\x08\x02\x81 \xb1@\x12\x04\x00\x01\x00`@$'\x00\x10\t"
+    b"\x00\xc1\xb0\x80B\t\x80W\xc2\xb1\xb2\xf4gY\x81\xe5XZ\xd7C\xf1"
+    b"\x7fYYQc\x00\x00\n\x81\x08\x00\x10\x05\x00\x01\x00\x8c\x0be\x00"
+    b"\x11\x0b\x00\x16\x0c\x00\x10\x05\x00\x16\r\x002\x00\x16\x0e\x002"
+    b"\x01\x16\x0f\x00Qc\x00\x02@\x1a\x0e\x0e\x00\x01\x00\x80\x0c\x00"
+    b"\xb1\xb0\x18\x10\x00Qc\x00\x00\x11\x10P\x19\x0e\x0f\x00\x01\x00"
+    b"\x80\x0f\x00\xb0\x13\x10\x00#\x01#\x02*\x03c\x02\x00\x11f\x031.5"
+    b"b\x01\x01P\x08\x0e\x06\x00\x01\x00\x80\x13\x00\x12\x12\x00\x10"
+    b"\x06\x004\x01eQc\x00\x00"
+)
+
+try:
+    with open("import_mpy_xip_mod.mpy", "wb") as f:
+        f.write(mpy)
+except OSError:
+    print("SKIP")
+    raise SystemExit
+
+usys.path.insert(0, "")
+try:
+    import import_mpy_xip_mod as m
+except ValueError as er:
+    # port doesn't support execute-in-place .mpy files
+    print("SKIP")
+    raise SystemExit
+finally:
+    usys.path.pop(0)
+    uos.remove("import_mpy_xip_mod.mpy")
+
+print(m.f(1), m.f(1, 5, c=10))
+print(list(m.g(3)))
+print(m.C(4).get())
+print(m.f.__name__, m.C.__name__, m.C.get.__name__)
+try:
+    m.fail()
+except ValueError as er:
+    print("ValueError", er)
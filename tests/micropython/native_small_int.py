@@ -0,0 +1,60 @@
+# test the inline small-int paths of binary ops in natively compiled functions
+
+import micropython
+
+
+@micropython.native
+def ops(a, b):
+    return (a + b, a - b, a & b, a | b, a ^ b, a < b, a > b, a == b, a <= b, a >= b, a != b)
+
+
+@micropython.native
+def ops_const(a):
+    return (a + 1, 1 + a, a - 1, 1 - a, a & 6, a | 6, a ^ 6, a < 2, 2 < a, a == 2, a != 2)
+
+
+@micropython.native
+def inplace(a, b):
+    a += b
+    a -= 1
+    a &= -2
+    a |= 4
+    a ^= 8
+    return a
+
+
+# small ints, including values at the edge of the small-int range
+for a, b in ((1, 2), (-5, 3), (7, 7), (0, -1), (0x3FFFFFFF, 1), (-0x40000000, -1)):
+    print(ops(a, b), inplace(a, b))
+for a in (-3, 0, 2, 5, 0x3FFFFFFF, -0x40000000):
+    print(ops_const(a))
+
+# operands that aren't small ints
+for a, b in ((True, 1), (False, True)):
+    print(ops(a, b))
+
+
+@micropython.native
+def add_cmp(a, b):
+    return (a + b, a < b, a == b)
+
+
+print(add_cmp("a", "b"), add_cmp(1.5, 2), add_cmp(2, 2.0))
+try:
+    add_cmp("a", 1)
+except TypeError:
+    print("TypeError")
+
+
+# a loop counter and accumulator
+@micropython.native
+def loop(n):
+    s = 0
+    i = 0
+    while i < n:
+        s += i
+        i += 1
+    return s
+
+
+print(loop(0), loop(10), loop(1000))
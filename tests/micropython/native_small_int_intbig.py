@@ -0,0 +1,26 @@
+# test the inline small-int paths of binary ops in natively compiled functions,
+# when the operands or the result are big ints
+
+import micropython
+
+
+@micropython.native
+def ops(a, b):
+    return (a + b, a - b, a & b, a | b, a ^ b, a < b, a > b, a == b, a <= b, a >= b, a != b)
+
+
+@micropython.native
+def ops_const(a):
+    return (a + 1, 1 + a, a - 1, 1 - a, a & 6, a | 6, a ^ 6, a < 2, 2 < a, a == 2, a != 2)
+
+
+# results that overflow a small int on any port
+big = 1 << 62
+print(ops(big - 1, big - 1)[:2], ops(-big, big - 1)[:2], ops(big - 1, -big)[:2])
+print(ops(0x3FFFFFFF, 0x3FFFFFFF)[:2], ops(-0x40000000, 0x40000000)[:2])
+
+# big-int operands
+for a, b in ((1 << 70, 3), (3, 1 << 70), (1 << 70, 1 << 70)):
+    print(ops(a, b))
+print(ops_const(1 << 70))
+print(ops_const(-(1 << 70)))
@@ -0,0 +1,73 @@
+# test viper and native functions where the locals used in loops are kept in registers
+
+
+# a hot loop using some of the arguments, with the others only used once
+@micropython.viper
+def f5(a: int, b: int, c: int, d: int, e: int) -> int:
+    x = d
+    for i in range(e):
+        x += a * i + b - c
+    return x
+
+
+print(f5(1, 2, 3, 4, 10))
+print(f5(0, 0, 0, 0, 0))
+
+
+# more locals live in the loop than there are registers
+@micropython.viper
+def checksum(buf, n: int) -> int:
+    p = ptr8(buf)
+    s1 = 1
+    s2 = 0
+    i = 0
+    odd = 0
+    even = 0
+    while i < n:
+        v = p[i]
+        s1 = (s1 + v) % 65521
+        s2 = (s2 + s1) % 65521
+        if i & 1:
+            odd += v
+        else:
+            even += v
+        i += 1
+    return (s2 << 16 | s1) ^ (odd << 8) ^ even
+
+
+print(hex(checksum(b"Wikipedia", 9)))
+print(hex(checksum(bytearray(range(200)), 200)))
+
+
+# nested loops, and a continue back to the top of the inner one
+@micropython.viper
+def nested(n: int) -> int:
+    total = 0
+    unused = 100
+    for i in range(n):
+        for j in range(n):
+            if j == i:
+                continue
+            total += i * j
+    return total + unused
+
+
+print(nested(0), nested(1), nested(7))
+
+
+# locals of a native function, with the hot ones used after the loop
+@micropython.native
+def native_loop(lst):
+    a = 0
+    b = ""
+    c = None
+    for x in lst:
+        a += x
+        b += str(x)
+        c = x
+    d = [a, b, c]
+    return d
+
+
+print(native_loop([1, 2, 3]))
+print(native_loop([]))
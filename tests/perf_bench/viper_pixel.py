@@ -0,0 +1,44 @@
+# Convert an RGB888 image to RGB565 and checksum the result, a typical
+# viper pixel loop with more live locals than there are registers.
+
+
+@micropython.viper
+def rgb888_to_rgb565(src, dest, n: int) -> int:
+    s = ptr8(src)
+    d = ptr16(dest)
+    csum = 0
+    i = 0
+    j = 0
+    while j < n:
+        r = s[i]
+        g = s[i + 1]
+        b = s[i + 2]
+        p = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+        d[j] = p
+        csum = (csum + p) & 0xFFFF
+        i += 3
+        j += 1
+    return csum
+
+
+@micropython.native
+def run(src, dest, n, times):
+    csum = 0
+    for _ in range(times):
+        csum = rgb888_to_rgb565(src, dest, n)
+    return csum
+
+
+bm_params = {
+    (50, 10): (64, 10),
+    (100, 10): (256, 20),
+    (1000, 10): (1024, 50),
+    (5000, 10): (1024, 250),
+}
+
+
+def bm_setup(params):
+    n, times = params
+    src = bytearray((i * 7) & 0xFF for i in range(3 * n))
+    dest = bytearray(2 * n)
+    return lambda: run(src, dest, n, times), lambda: (n * times // 1000, None)
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+
+# This file is part of the MicroPython project, http://micropython.org/
+# The MIT License (MIT)
+
+# Measure the time taken to import a tree of packages, and the number of
+# filesystem queries needed to resolve those imports.  The tree is put at the
+# end of a sys.path with several other entries, like on a board with a few
+# library directories.  If the executable supports mounting a user filesystem
+# then the tree is accessed through a wrapper that counts stat and ilistdir
+# calls, otherwise only the time is reported.
+
+import os
+import subprocess
+import sys
+import argparse
+import tempfile
+
+if os.name == "nt":
+    MICROPYTHON = os.getenv("MICROPY_MICROPYTHON", "../ports/windows/micropython.exe")
+else:
+    MICROPYTHON = os.getenv("MICROPY_MICROPYTHON", "../ports/unix/micropython")
+
+DRIVER = """
+import usys, utime
+try:
+    import uos
+    uos.mount
+    uos.VfsPosix
+except (ImportError, AttributeError):
+    uos = None
+
+class CountingFS:
+    def __init__(self, fs):
+        self.fs = fs
+        self.n_stat = 0
+        self.n_ilistdir = 0
+    def mount(self, readonly, mkfs):
+        pass
+    def umount(self):
+        pass
+    def stat(self, path):
+        self.n_stat += 1
+        return self.fs.stat(path)
+    def ilistdir(self, path):
+        self.n_ilistdir += 1
+        return self.fs.ilistdir(path)
+    def open(self, path, mode):
+        return self.fs.open(path, mode)
+
+root = {root!r}
+fs = None
+if uos:
+    fs = CountingFS(uos.VfsPosix(root))
+    uos.mount(fs, "/bench")
+    root = "/bench"
+usys.path[:] = [root + "/missing%d" % i for i in range({n_extra})] + [root]
+t = utime.ticks_us()
+for i in range({n_pkg}):
+    __import__("pkg%d" % i)
+    for j in range({n_mod}):
+        __import__("pkg%d.mod%d" % (i, j))
+t = utime.ticks_diff(utime.ticks_us(), t)
+if fs:
+    print("%.3f %d %d" % (t / 1000, fs.n_stat, fs.n_ilistdir))
+else:
+    print("%.3f - -" % (t / 1000))
+"""
+
+
+def make_tree(root, n_pkg, n_mod):
+    for i in range(n_pkg):
+        pkg = os.path.join(root, "pkg%d" % i)
+        os.mkdir(pkg)
+        with open(os.path.join(pkg, "__init__.py"), "w") as f:
+            f.write("x = %d\n" % i)
+        for j in range(n_mod):
+            with open(os.path.join(pkg, "mod%d.py" % j), "w") as f:
+                f.write("def f():\n    return %d\n" % j)
+
+
+def main():
+    cmd_parser = argparse.ArgumentParser(description="Benchmark importing a package tree.")
+    cmd_parser.add_argument("-p", "--packages", type=int, default=10, help="number of packages")
+    cmd_parser.add_argument("-m", "--modules", type=int, default=10, help="modules per package")
+    cmd_parser.add_argument("-e", "--extra-paths", type=int, default=5, help="extra sys.path entries")
+    cmd_parser.add_argument("-n", "--runs", type=int, default=5, help="number of runs")
+    args = cmd_parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as root:
+        tree = os.path.join(root, "tree")
+        os.mkdir(tree)
+        make_tree(tree, args.packages, args.modules)
+        driver = os.path.join(root, "driver.py")
+        with open(driver, "w") as f:
+            f.write(
+                DRIVER.format(
+                    root=tree,
+                    n_extra=args.extra_paths,
+                    n_pkg=args.packages,
+                    n_mod=args.modules,
+                )
+            )
+
+        times = []
+        for _ in range(args.runs):
+            out = subprocess.check_output([MICROPYTHON, driver]).decode()
+            ms, n_stat, n_ilistdir = out.split()
+            times.append(float(ms))
+
+    print(
+        "{} modules, {} sys.path entries".format(
+            args.packages * (args.modules + 1), args.extra_paths + 1
+        )
+    )
+    print("import: {:.3f} ms (min of {} runs)".format(min(times), args.runs))
+    print("stat calls: {}".format(n_stat))
+    print("ilistdir calls: {}".format(n_ilistdir))
+
+
+if __name__ == "__main__":
+    main()
@@ -231,7 +231,7 @@ def main():
     )
     cmd_parser.add_argument("-a", "--average", default="8", help="averaging number")
     cmd_parser.add_argument(
-        "--emit", default="bytecode", help="MicroPython emitter to use (bytecode or native)"
+        "--emit", default="bytecode", help="MicroPython emitter to use (bytecode, native or auto)"
     )
     cmd_parser.add_argument("N", nargs=1, help="N parameter (approximate target CPU frequency)")
     cmd_parser.add_argument("M", nargs=1, help="M parameter (approximate target heap in kbytes)")
@@ -382,6 +382,7 @@ def run_tests(pyb, tests, args, result_dir, num_threads=1):
         "builtin_range",
         "class_super",
         "containment",
+        "dict_churn",
         "errno1",
         "fun_str",
         "generator1",
@@ -390,6 +391,7 @@ def run_tests(pyb, tests, args, result_dir, num_threads=1):
         "memoryview_gc",
         "object1",
         "python34",
+        "string_long",
         "struct_endian",
     )
 
@@ -520,7 +522,20 @@ def run_tests(pyb, tests, args, result_dir, num_threads=1):
         skip_tests.add(
             "micropython/opt_level_lineno.py"
         )  # native doesn't have proper traceback info
+        skip_tests.add("micropython/alloc_stats.py")  # native code has no frame to attribute to
         skip_tests.add("micropython/schedule.py")  # native code doesn't check pending events
+        skip_tests.add("unix/micropython_profile.py")  # the profiler only samples bytecode
+
+    # Functions that emit=auto compiles to native code share some of its limitations
+    if args.emit == "auto":
+        skip_tests.add(
+            "micropython/emg_exc.py"
+        )  # because native doesn't have proper traceback info
+        skip_tests.add("micropython/alloc_stats.py")  # native code has no frame to attribute to
+        skip_tests.add("misc/sys_settrace_features.py")  # settrace only traces bytecode
+        skip_tests.add("misc/sys_settrace_generator.py")  # settrace only traces bytecode
+        skip_tests.add("misc/sys_settrace_loop.py")  # settrace only traces bytecode
+        skip_tests.add("unix/micropython_profile.py")  # the profiler only samples bytecode
 
     def run_one_test(test_file):
         test_file = test_file.replace("\\", "/")
@@ -539,7 +554,7 @@ def run_tests(pyb, tests, args, result_dir, num_threads=1):
         is_native = (
             test_name.startswith("native_")
             or test_name.startswith("viper_")
-            or args.emit == "native"
+            or args.emit in ("native", "auto")
         )
         is_endian = test_name.endswith("_endian")
         is_int_big = test_name.startswith("int_big") or test_name.endswith("_intbig")
@@ -736,7 +751,9 @@ the last matching regex is used:
         "--list-tests", action="store_true", help="list tests instead of running them"
     )
     cmd_parser.add_argument(
-        "--emit", default="bytecode", help="MicroPython emitter to use (bytecode or native)"
+        "--emit",
+        default="bytecode",
+        help="MicroPython emitter to use (bytecode, native or auto)",
     )
     cmd_parser.add_argument("--heapsize", help="heapsize to use (use default if not specified)")
     cmd_parser.add_argument(
@@ -0,0 +1,62 @@
+# benchmark how quickly a thread doing I/O (here: sleeping) gets to run again
+# while another thread is busy executing bytecode
+#
+# With a GIL the compute thread must hand the GIL over when the sleeping thread
+# wakes up; the wake-up latency is bounded by the GIL switch interval.
+
+try:
+    import utime
+
+    sleep_ms = utime.sleep_ms
+    ticks_us = utime.ticks_us
+    ticks_diff = utime.ticks_diff
+except ImportError:
+    import time
+
+    sleep_ms = lambda t: time.sleep(t / 1000)
+    ticks_us = lambda: int(time.perf_counter() * 1000000)
+    ticks_diff = lambda a, b: a - b
+
+import _thread
+
+# set to True to print the measured latencies
+VERBOSE = False
+
+# use a 1ms switch interval if the port supports changing it
+if hasattr(_thread, "switch_interval"):
+    _thread.switch_interval(1000)
+
+N_WAKEUPS = 40
+SLEEP_MS = 2
+# generous bound on the mean latency so the test is robust on loaded machines
+MAX_MEAN_LATENCY_US = 20000
+
+io_done = False
+latencies = []
+
+
+def io_thread():
+    global io_done
+    for _ in range(N_WAKEUPS):
+        t0 = ticks_us()
+        sleep_ms(SLEEP_MS)
+        latencies.append(ticks_diff(ticks_us(), t0) - SLEEP_MS * 1000)
+    io_done = True
+
+
+# busy loop that never blocks, so only the VM can give up the GIL
+def compute():
+    x = 0
+    while not io_done:
+        for i in range(100):
+            x += i
+    return x
+
+
+_thread.start_new_thread(io_thread, ())
+compute()
+
+mean = sum(latencies) // len(latencies)
+if VERBOSE:
+    print("mean latency us:", mean, "max latency us:", max(latencies))
+print(len(latencies), mean < MAX_MEAN_LATENCY_US)
@@ -0,0 +1,44 @@
+# test concurrent creation of instances of a shared user class, which set
+# their attributes in different orders
+
+try:
+    import utime as time
+except ImportError:
+    import time
+import _thread
+
+# the shared user class
+class User:
+    pass
+
+
+# main thread function
+def th(k, n):
+    for i in range(n):
+        user = User()
+        names = ["attr_%u" % ((j * (k + 1) + i) % n_attr) for j in range(n_attr)]
+        for name in names:
+            setattr(user, name, name)
+        for name in names:
+            assert getattr(user, name) == name
+
+    with lock:
+        global n_finished
+        n_finished += 1
+
+
+lock = _thread.allocate_lock()
+n_thread = 4
+n_finished = 0
+n_attr = 40
+n_instance = 50  # make 500 for a more stressful test (uses more heap)
+
+# spawn threads
+for i in range(n_thread):
+    _thread.start_new_thread(th, (i, n_instance))
+
+# wait for threads to finish
+while n_finished < n_thread:
+    time.sleep(1)
+
+print("pass")
@@ -0,0 +1,48 @@
+# test the sampling profiler by profiling the raytracer benchmark
+
+import sys
+
+try:
+    from micropython import profile_start, profile_stop, profile_dump
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+sys.path.append(__file__.rsplit("/", 1)[0] + "/../perf_bench")
+import misc_raytrace
+
+# functions that do the actual work of the raytracer
+HOT = ("__init__", "__add__", "__sub__", "__mul__", "dot", "scale", "length", "normalise")
+HOT += ("intersect", "trace_ray", "trace_to_light", "calc_dir", "put_pix")
+
+run, result = misc_raytrace.bm_setup((40, 40, 3))
+
+profile_start(1000)
+run()
+run()
+profile_stop()
+stacks = profile_dump()
+
+# a stopped profiler doesn't record anything more
+run()
+print(profile_dump() == stacks)
+
+n_samples = 0
+n_traced = 0
+leaf_count = {}
+for stack, count in stacks.items():
+    n_samples += count
+    if "trace_scene (" in stack:
+        n_traced += count
+    leaf = stack.rsplit(";", 1)[-1].split(" ")[0]
+    leaf_count[leaf] = leaf_count.get(leaf, 0) + count
+
+# enough samples were taken
+print(n_samples >= 10)
+
+# nearly all the time is spent in trace_scene
+print(n_traced >= n_samples * 9 // 10)
+
+# the most sampled functions are the hot ones
+dominant = sorted(leaf_count.items(), key=lambda x: -x[1])[:3]
+print(all(name in HOT for name, _ in dominant))
@@ -28,6 +28,8 @@ from __future__ import print_function
 import sys
 import os
 import subprocess
+import hashlib
+import shutil
 
 
 ###########################################################################
@@ -196,6 +198,73 @@ def mkdir(filename):
         os.makedirs(path)
 
 
+def file_hash(filename):
+    with open(filename, "rb") as f:
+        return hashlib.sha256(f.read()).hexdigest()
+
+
+def mpy_cross_batch(mpy_cross, flags, jobs, rsp_file):
+    """Start an mpy-cross process that compiles all `jobs` (a list of
+    (infile, outfile, script, opt) tuples), passing the arguments in a
+    response file so the command line stays short."""
+    with open(rsp_file, "w") as f:
+        for infile, outfile, script, opt in jobs:
+            f.write('-O{} -o "{}" -s "{}" "{}"\n'.format(opt, outfile, script, infile))
+    return subprocess.Popen(
+        [mpy_cross] + flags + ["@" + rsp_file], stdout=subprocess.PIPE, stderr=subprocess.STDOUT
+    )
+
+
+def compile_mpy(mpy_cross, flags, jobs, build_dir, cache_dir, num_procs):
+    """Compile .py files to .mpy, running `num_procs` mpy-cross processes in
+    parallel that each compile a batch of files.  If `cache_dir` is given then
+    outputs are cached there keyed on a hash of the mpy-cross executable, the
+    flags and the input file, so unchanged files are never recompiled, even
+    after a clean or for a different board."""
+    todo = []
+    if cache_dir:
+        cache_key = hashlib.sha256()
+        cache_key.update(file_hash(mpy_cross).encode())
+        cache_key.update(" ".join(flags).encode())
+    for infile, outfile, script, opt in jobs:
+        print("MPY", script)
+        mkdir(outfile)
+        cached = None
+        if cache_dir:
+            key = cache_key.copy()
+            key.update("{} {} {}".format(script, opt, file_hash(infile)).encode())
+            key = key.hexdigest()
+            cached = os.path.join(cache_dir, key[:2], key + ".mpy")
+            if os.path.exists(cached):
+                shutil.copyfile(cached, outfile)
+                continue
+        todo.append((infile, outfile, script, opt, cached))
+
+    # Split the remaining files into batches, one per mpy-cross process
+    num_procs = min(num_procs, len(todo))
+    procs = []
+    for i in range(num_procs):
+        batch = [job[:4] for job in todo[i::num_procs]]
+        rsp_file = "{}/frozen_mpy/batch{}.rsp".format(build_dir, i)
+        procs.append(mpy_cross_batch(mpy_cross, flags, batch, rsp_file))
+    failed = False
+    for proc in procs:
+        out = proc.communicate()[0]
+        if proc.returncode != 0:
+            print("error compiling mpy:")
+            sys.stdout.buffer.write(out)
+            failed = True
+    if failed:
+        raise SystemExit(1)
+
+    # Save the new outputs in the cache
+    for infile, outfile, script, opt, cached in todo:
+        if cached:
+            mkdir(cached)
+            shutil.copyfile(outfile, cached + ".tmp")
+            os.replace(cached + ".tmp", cached)
+
+
 def freeze_internal(kind, path, script, opt):
     path = convert_path(path)
     if not os.path.isdir(path):
@@ -249,6 +318,14 @@ def main():
     )
     cmd_parser.add_argument("-v", "--var", action="append", help="variables to substitute")
     cmd_parser.add_argument("--mpy-tool-flags", default="", help="flags to pass to mpy-tool")
+    cmd_parser.add_argument(
+        "-j", "--jobs", type=int, default=os.cpu_count() or 1, help="number of mpy-cross processes"
+    )
+    cmd_parser.add_argument(
+        "--mpy-cross-cache",
+        default=os.getenv("MICROPY_MPYCROSS_CACHE"),
+        help="directory to cache compiled .mpy files in (empty to disable)",
+    )
     cmd_parser.add_argument("files", nargs="+", help="input manifest list")
     args = cmd_parser.parse_args()
 
@@ -270,6 +347,8 @@ def main():
         MPY_CROSS += ".exe"
     MPY_CROSS = os.getenv("MICROPY_MPYCROSS", MPY_CROSS)
     MPY_TOOL = VARS["MPY_DIR"] + "/tools/mpy-tool.py"
+    if args.mpy_cross_cache is None:
+        args.mpy_cross_cache = VARS["MPY_DIR"] + "/mpy-cross/build/cache"
 
     # Ensure mpy-cross is built
     if not os.path.exists(MPY_CROSS):
@@ -290,36 +369,40 @@ def main():
     # Process the manifest
     str_paths = []
     mpy_files = []
+    mpy_jobs = []
     ts_newest = 0
     for kind, path, script, opt in manifest_list:
         if kind == KIND_AS_STR:
             str_paths.append(path)
-            ts_outfile = get_timestamp_newest(path)
+            ts_newest = max(ts_newest, get_timestamp_newest(path))
         elif kind == KIND_AS_MPY:
             infile = "{}/{}".format(path, script)
             outfile = "{}/frozen_mpy/{}.mpy".format(args.build_dir, script[:-3])
             ts_infile = get_timestamp(infile)
             ts_outfile = get_timestamp(outfile, 0)
             if ts_infile >= ts_outfile:
-                print("MPY", script)
-                mkdir(outfile)
-                res, out = system(
-                    [MPY_CROSS]
-                    + args.mpy_cross_flags.split()
-                    + ["-o", outfile, "-s", script, "-O{}".format(opt), infile]
-                )
-                if res != 0:
-                    print("error compiling {}:".format(infile))
-                    sys.stdout.buffer.write(out)
-                    raise SystemExit(1)
-                ts_outfile = get_timestamp(outfile)
+                mpy_jobs.append((infile, outfile, script, opt))
             mpy_files.append(outfile)
         else:
             assert kind == KIND_MPY
             infile = "{}/{}".format(path, script)
             mpy_files.append(infile)
-            ts_outfile = get_timestamp(infile)
-        ts_newest = max(ts_newest, ts_outfile)
+            ts_newest = max(ts_newest, get_timestamp(infile))
+
+    # Compile the .py files that are out of date
+    if mpy_jobs:
+        compile_mpy(
+            MPY_CROSS,
+            args.mpy_cross_flags.split(),
+            mpy_jobs,
+            args.build_dir,
+            args.mpy_cross_cache,
+            args.jobs,
+        )
+    for kind, path, script, opt in manifest_list:
+        if kind == KIND_AS_MPY:
+            outfile = "{}/frozen_mpy/{}.mpy".format(args.build_dir, script[:-3])
+            ts_newest = max(ts_newest, get_timestamp(outfile))
 
     # Check if output file needs generating
     if ts_newest < get_timestamp(args.output, 0):
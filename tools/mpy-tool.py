@@ -786,6 +786,8 @@ def read_mpy(filename):
         if header[1] != config.MPY_VERSION:
             raise Exception("incompatible .mpy version")
         feature_byte = header[2]
+        if feature_byte & 1:
+            raise Exception("execute-in-place .mpy files can't be frozen")
         qw_size = read_uint(f)
         config.MICROPY_PY_BUILTINS_STR_UNICODE = (feature_byte & 2) != 0
         mpy_native_arch = feature_byte >> 2
@@ -2,6 +2,7 @@
 import argparse
 import os
 import os.path
+import subprocess
 
 argparser = argparse.ArgumentParser(description="Compile all .py files to .mpy recursively")
 argparser.add_argument("-o", "--out", help="output directory (default: input dir)")
@@ -21,6 +22,22 @@ if not args.out:
 
 path_prefix_len = len(args.dir) + 1
 
+# Each mpy-cross process compiles as many files as fit on its command line,
+# keeping well below the limits of the OS (32k characters on Windows)
+MAX_CMDLINE_LEN = 16384
+
+base_cmd = ["mpy-cross", "-v", "-v"] + TARGET_OPTS.get(args.target, "").split()
+base_len = sum(len(a) + 1 for a in base_cmd)
+
+
+def compile_batch(batch):
+    if batch:
+        res = subprocess.call(base_cmd + batch)
+        assert res == 0
+
+
+batch = []
+batch_len = base_len
 for path, subdirs, files in os.walk(args.dir):
     for f in files:
         if f.endswith(".py"):
@@ -30,12 +47,12 @@ for path, subdirs, files in os.walk(args.dir):
             out_dir = os.path.dirname(out_fpath)
             if not os.path.isdir(out_dir):
                 os.makedirs(out_dir)
-            cmd = "mpy-cross -v -v %s -s %s %s -o %s" % (
-                TARGET_OPTS.get(args.target, ""),
-                fpath[path_prefix_len:],
-                fpath,
-                out_fpath,
-            )
-            # print(cmd)
-            res = os.system(cmd)
-            assert res == 0
+            file_args = ["-s", fpath[path_prefix_len:], "-o", out_fpath, fpath]
+            file_len = sum(len(a) + 1 for a in file_args)
+            if batch and batch_len + file_len > MAX_CMDLINE_LEN:
+                compile_batch(batch)
+                batch = []
+                batch_len = base_len
+            batch += file_args
+            batch_len += file_len
+compile_batch(batch)